@@ -3,6 +3,7 @@
 #include "tinymath.h"
 #include "Define.hpp"
 #include "RasterAttributes.hpp"
+#include "VertexBuffer.hpp"
 #include "ShaderProgram.hpp"
 
 #define BUILD_CGL // todo: put it in makefile
@@ -76,6 +77,9 @@
 #define cglMat3Zero tinymath::kMat3x3Zero
 #define cglMat4Zero tinymath::kMat4x4Zero
 #define cglVert CpuRasterizer::Vertex
+#define cglVertexLayout CpuRasterizer::VertexLayout
+#define cglVertexBuffer CpuRasterizer::VertexBuffer
+#define cglIndexBuffer CpuRasterizer::IndexBuffer
 #define cglRenderTexture CpuRasterizer::RenderTexture
 #define cglPrint(...) Logger::log(Logger::Severity::kLog, __VA_ARGS__)
 #define cglError(...) Logger::log(Logger::Severity::kError, __VA_ARGS__)
@@ -86,6 +90,8 @@
 #define cglMultisampleFrequency MultiSampleFrequency
 #define cglTextureFormat TextureFormat
 #define cglFiltering Filtering
+#define cglMemoryLayout MemoryLayout
+#define cglResolveEncoding ResolveEncoding
 #define cglBlendOp BlendFunc
 #define cglWrapMode WrapMode
 #define cglStencilOp StencilOp
@@ -160,6 +166,10 @@ extern "C" {
 	CGL_EXTERN void cglSetViewPort(size_t x, size_t y, size_t width, size_t height);
 	CGL_EXTERN void cglGetViewport(size_t& x, size_t& y, size_t& width, size_t& height);
 	CGL_EXTERN void cglSetSubSampleCount(uint8_t count);
+	CGL_EXTERN void cglSetFrameBufferLayout(cglMemoryLayout layout);
+	CGL_EXTERN void cglSetResolveEncoding(cglResolveEncoding encoding);
+	CGL_EXTERN void cglSetOITPoolSize(size_t fragments_per_tile);
+	CGL_EXTERN void cglGetOITStatistics(size_t& fragment_count, size_t& overflow_count);
 	CGL_EXTERN uint8_t cglGetSubSampleCount();
 	CGL_EXTERN void cglSetMultisampleFrequency(cglMultisampleFrequency frequency);
 	CGL_EXTERN void cglSetClearColor(cglColor clear_color);
@@ -178,6 +188,8 @@ extern "C" {
 	// IB/VB
 	CGL_EXTERN size_t cglBindVertexBuffer(const std::vector<cglVert>& buffer);
 	CGL_EXTERN size_t cglBindIndexBuffer(const std::vector<size_t>& buffer);
+	CGL_EXTERN size_t cglBindPackedVertexBuffer(const cglVertexBuffer& buffer);
+	CGL_EXTERN size_t cglBindPackedIndexBuffer(const cglIndexBuffer& buffer);
 	CGL_EXTERN void cglUseVertexBuffer(cglResID id);
 	CGL_EXTERN void cglUseIndexBuffer(cglResID id);
 	CGL_EXTERN void cglFreeVertexBuffer(cglResID id);
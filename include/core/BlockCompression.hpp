@@ -0,0 +1,290 @@
+#pragma once
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <execution>
+#include "Define.hpp"
+#include "tinymath.h"
+#include "RawBuffer.hpp"
+
+namespace CpuRasterizer
+{
+	constexpr size_t kBlockDim = 4; // texels per block side
+	constexpr size_t kBlockTexels = kBlockDim * kBlockDim; // texel i of a block is (i / 4, i % 4)
+
+	// two 565 endpoints and 2 bit indices, rgb
+	struct bc1_block
+	{
+		typedef tinymath::color_rgb pixel_type;
+		uint16_t color0;
+		uint16_t color1;
+		uint32_t indices;
+	};
+
+	// two 8 bit endpoints and 3 bit indices, one channel
+	struct bc4_block
+	{
+		typedef tinymath::color_gray pixel_type;
+		uint8_t value0;
+		uint8_t value1;
+		uint8_t indices[6];
+	};
+
+	// bc4 alpha followed by a bc1 color block that always interpolates four colors
+	struct bc3_block
+	{
+		typedef tinymath::color_rgba pixel_type;
+		bc4_block alpha;
+		bc1_block color;
+	};
+
+	// two bc4 blocks, red and green
+	struct bc5_block
+	{
+		typedef tinymath::color_rg pixel_type;
+		bc4_block red;
+		bc4_block green;
+	};
+
+	static_assert(sizeof(bc1_block) == 8, "bc1 block layout changed");
+	static_assert(sizeof(bc4_block) == 8, "bc4 block layout changed");
+	static_assert(sizeof(bc3_block) == 16, "bc3 block layout changed");
+	static_assert(sizeof(bc5_block) == 16, "bc5 block layout changed");
+
+	inline bool is_block_format(TextureFormat format)
+	{
+		return format == TextureFormat::kBC1 || format == TextureFormat::kBC3 || format == TextureFormat::kBC4 || format == TextureFormat::kBC5;
+	}
+
+	// block format an 8 bit format is compressed to, other formats are kept as they are
+	inline TextureFormat compressed_format(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::kRGB: return TextureFormat::kBC1;
+		case TextureFormat::kRGBA: return TextureFormat::kBC3;
+		case TextureFormat::kGray: return TextureFormat::kBC4;
+		case TextureFormat::kRG: return TextureFormat::kBC5;
+		default: return format;
+		}
+	}
+
+	inline size_t block_count(size_t texels)
+	{
+		return (texels + kBlockDim - 1) / kBlockDim;
+	}
+
+	inline tinymath::color_rgb unpack_565(uint16_t c)
+	{
+		uint8_t r = (uint8_t)((c >> 11) & 0x1F);
+		uint8_t g = (uint8_t)((c >> 5) & 0x3F);
+		uint8_t b = (uint8_t)(c & 0x1F);
+		return { (uint8_t)((r << 3) | (r >> 2)), (uint8_t)((g << 2) | (g >> 4)), (uint8_t)((b << 3) | (b >> 2)) };
+	}
+
+	// entry index of the palette between two unpacked endpoints
+	inline tinymath::color_rgb bc1_color(const tinymath::color_rgb& c0, const tinymath::color_rgb& c1, uint32_t index, bool four_colors)
+	{
+		if (four_colors)
+		{
+			// weight of color0 in thirds for indices 0..3
+			static const uint32_t kWeights[4] = { 3, 0, 2, 1 };
+			uint32_t w0 = kWeights[index];
+			uint32_t w1 = 3 - w0;
+			return { (uint8_t)((c0.r * w0 + c1.r * w1 + 1) / 3), (uint8_t)((c0.g * w0 + c1.g * w1 + 1) / 3), (uint8_t)((c0.b * w0 + c1.b * w1 + 1) / 3) };
+		}
+
+		switch (index)
+		{
+		case 0: return c0;
+		case 1: return c1;
+		case 2: return { (uint8_t)((c0.r + c1.r + 1) / 2), (uint8_t)((c0.g + c1.g + 1) / 2), (uint8_t)((c0.b + c1.b + 1) / 2) };
+		default: return { 0, 0, 0 };
+		}
+	}
+
+	// entry index of the palette between two 565 endpoints, shared by the encoder and the decoder
+	inline tinymath::color_rgb bc1_color(uint16_t color0, uint16_t color1, uint32_t index, bool four_colors)
+	{
+		return bc1_color(unpack_565(color0), unpack_565(color1), index, four_colors);
+	}
+
+	inline uint8_t bc4_value(uint8_t value0, uint8_t value1, uint32_t index)
+	{
+		if (index < 2)
+		{
+			return index == 0 ? value0 : value1;
+		}
+		if (value0 > value1)
+		{
+			return (uint8_t)(((8 - index) * value0 + (index - 1) * value1 + 3) / 7);
+		}
+		if (index < 6)
+		{
+			return (uint8_t)(((6 - index) * value0 + (index - 1) * value1 + 2) / 5);
+		}
+		return index == 6 ? 0 : 255;
+	}
+
+	// the 16 3 bit indices of a block
+	inline uint64_t bc4_indices(const bc4_block& block)
+	{
+		uint64_t bits = 0;
+		for (size_t i = 0; i < 6; i++)
+		{
+			bits |= (uint64_t)block.indices[i] << (8 * i);
+		}
+		return bits;
+	}
+
+	inline uint32_t bc4_index(const bc4_block& block, size_t texel)
+	{
+		return (uint32_t)((bc4_indices(block) >> (3 * texel)) & 7);
+	}
+
+	// single texel decoders for the sampler, a fetch touches one 8 or 16 byte block
+	inline tinymath::color_rgb decode_texel(const bc1_block& block, size_t texel)
+	{
+		return bc1_color(block.color0, block.color1, (block.indices >> (2 * texel)) & 3, block.color0 > block.color1);
+	}
+
+	inline tinymath::color_gray decode_texel(const bc4_block& block, size_t texel)
+	{
+		tinymath::color_gray ret;
+		ret.gray = bc4_value(block.value0, block.value1, bc4_index(block, texel));
+		return ret;
+	}
+
+	inline tinymath::color_rgba decode_texel(const bc3_block& block, size_t texel)
+	{
+		tinymath::color_rgb c = bc1_color(block.color.color0, block.color.color1, (block.color.indices >> (2 * texel)) & 3, true);
+		return { c.r, c.g, c.b, bc4_value(block.alpha.value0, block.alpha.value1, bc4_index(block.alpha, texel)) };
+	}
+
+	inline tinymath::color_rg decode_texel(const bc5_block& block, size_t texel)
+	{
+		tinymath::color_rg ret;
+		ret.r = bc4_value(block.red.value0, block.red.value1, bc4_index(block.red, texel));
+		ret.g = bc4_value(block.green.value0, block.green.value1, bc4_index(block.green, texel));
+		return ret;
+	}
+
+	// the 2x2 texels from texel to texel + kBlockDim + 1 for bilinear footprints inside one block,
+	// the endpoints and indices are read once for the four
+	constexpr size_t kQuadTexels[4] = { 0, 1, kBlockDim, kBlockDim + 1 };
+
+	inline void decode_quad(const bc1_block& block, size_t texel, tinymath::color_rgb (&ret)[4])
+	{
+		tinymath::color_rgb c0 = unpack_565(block.color0);
+		tinymath::color_rgb c1 = unpack_565(block.color1);
+		bool four_colors = block.color0 > block.color1;
+		for (size_t i = 0; i < 4; i++)
+		{
+			ret[i] = bc1_color(c0, c1, (block.indices >> (2 * (texel + kQuadTexels[i]))) & 3, four_colors);
+		}
+	}
+
+	inline void decode_quad(const bc4_block& block, size_t texel, tinymath::color_gray (&ret)[4])
+	{
+		uint64_t bits = bc4_indices(block);
+		for (size_t i = 0; i < 4; i++)
+		{
+			ret[i].gray = bc4_value(block.value0, block.value1, (uint32_t)((bits >> (3 * (texel + kQuadTexels[i]))) & 7));
+		}
+	}
+
+	inline void decode_quad(const bc3_block& block, size_t texel, tinymath::color_rgba (&ret)[4])
+	{
+		tinymath::color_rgb c0 = unpack_565(block.color.color0);
+		tinymath::color_rgb c1 = unpack_565(block.color.color1);
+		uint64_t bits = bc4_indices(block.alpha);
+		for (size_t i = 0; i < 4; i++)
+		{
+			size_t t = texel + kQuadTexels[i];
+			tinymath::color_rgb c = bc1_color(c0, c1, (block.color.indices >> (2 * t)) & 3, true);
+			ret[i] = { c.r, c.g, c.b, bc4_value(block.alpha.value0, block.alpha.value1, (uint32_t)((bits >> (3 * t)) & 7)) };
+		}
+	}
+
+	inline void decode_quad(const bc5_block& block, size_t texel, tinymath::color_rg (&ret)[4])
+	{
+		uint64_t red = bc4_indices(block.red);
+		uint64_t green = bc4_indices(block.green);
+		for (size_t i = 0; i < 4; i++)
+		{
+			size_t t = texel + kQuadTexels[i];
+			ret[i].r = bc4_value(block.red.value0, block.red.value1, (uint32_t)((red >> (3 * t)) & 7));
+			ret[i].g = bc4_value(block.green.value0, block.green.value1, (uint32_t)((green >> (3 * t)) & 7));
+		}
+	}
+
+	// offline encoders used when textures are imported
+	class BlockCompression
+	{
+	public:
+		// principal axis endpoints refined by a least squares pass
+		static void encode(const tinymath::color_rgb* texels, bc1_block& block);
+		static void encode(const tinymath::color_rgba* texels, bc3_block& block);
+		static void encode(const tinymath::color_gray* texels, bc4_block& block);
+		static void encode(const tinymath::color_rg* texels, bc5_block& block);
+
+		// blocks of a width x height image, edge blocks repeat the last row and column
+		template<typename Block>
+		static std::shared_ptr<RawBuffer<Block>> compress(const RawBuffer<typename Block::pixel_type>& image);
+
+		// row major pixels of a width x height image
+		template<typename Block>
+		static std::vector<typename Block::pixel_type> decompress(const RawBuffer<Block>& blocks, size_t width, size_t height);
+	};
+
+	template<typename Block>
+	inline std::shared_ptr<RawBuffer<Block>> BlockCompression::compress(const RawBuffer<typename Block::pixel_type>& image)
+	{
+		size_t width = image.get_width();
+		size_t height = image.get_height();
+		auto blocks = RawBuffer<Block>::create(block_count(width), block_count(height));
+		if (width == 0 || height == 0)
+		{
+			return blocks;
+		}
+
+		std::vector<size_t> block_rows(block_count(height));
+		std::iota(block_rows.begin(), block_rows.end(), (size_t)0);
+		std::for_each(
+			std::execution::par,
+			block_rows.begin(),
+			block_rows.end(),
+			[&](size_t block_row)
+		{
+			typename Block::pixel_type texels[kBlockTexels];
+			for (size_t block_col = 0; block_col < block_count(width); block_col++)
+			{
+				for (size_t i = 0; i < kBlockTexels; i++)
+				{
+					size_t row = tinymath::min(block_row * kBlockDim + i / kBlockDim, height - 1);
+					size_t col = tinymath::min(block_col * kBlockDim + i % kBlockDim, width - 1);
+					texels[i] = image.at(row, col);
+				}
+				encode(texels, blocks->at(block_row, block_col));
+			}
+		});
+		return blocks;
+	}
+
+	template<typename Block>
+	inline std::vector<typename Block::pixel_type> BlockCompression::decompress(const RawBuffer<Block>& blocks, size_t width, size_t height)
+	{
+		std::vector<typename Block::pixel_type> pixels(width * height);
+		for (size_t row = 0; row < height; row++)
+		{
+			for (size_t col = 0; col < width; col++)
+			{
+				const Block& block = blocks.at(row / kBlockDim, col / kBlockDim);
+				pixels[row * width + col] = decode_texel(block, (row % kBlockDim) * kBlockDim + col % kBlockDim);
+			}
+		}
+		return pixels;
+	}
+}
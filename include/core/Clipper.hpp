@@ -18,6 +18,7 @@ namespace CpuRasterizer
 		static bool backface_culling_ndc(const tinymath::vec3f& normal);
 		static bool backface_culling_ndc(const tinymath::vec3f& c1, const tinymath::vec3f& c2, const tinymath::vec3f& c3);
 		static bool frustum_culling_sphere(const tinymath::Frustum& frustum, const tinymath::Sphere& bounding_sphere);
+		static bool frustum_culling_aabb(const tinymath::Frustum& frustum, const tinymath::AxisAlignedBoundingBox& bounds);
 		static bool conservative_frustum_culling(const tinymath::Frustum& frustum, const Vertex& v1, const Vertex& v2, const Vertex& v3);
 	};
 }
\ No newline at end of file
@@ -2,10 +2,16 @@
 #include <stdint.h>
 #include "Marcos.h"
 #include <type_traits>
+#include <atomic>
 
 
 constexpr int kMaxMip = 8;
 constexpr int kBoundsPadding = 1;
+constexpr int kSubpixelBits = 8; // fixed point precision of snapped screen positions
+constexpr int kSubpixelStep = 1 << kSubpixelBits;
+constexpr size_t kTileBits = 4;
+constexpr size_t kTileSize = 1 << kTileBits;
+constexpr size_t kCacheLineSize = 64; // RawBuffer storage and texture cache levels start on this boundary
 
 typedef size_t resource_id;
 typedef float depth_t;
@@ -13,6 +19,12 @@ typedef uint8_t stencil_t;
 typedef uint8_t coverage_t;
 typedef uint32_t property_name;
 
+constexpr uint8_t kMaxSubsampleCount = 16;
+constexpr size_t kDefaultOITPoolSize = kTileSize * kTileSize * 8; // fragments per tile, 8 layers on average
+// state of a multisampled pixel, kept in the coverage of its first sample
+constexpr coverage_t kSamplesCompressed = 0; // every sample has the color of the first one
+constexpr coverage_t kSamplesExpanded = 1;
+
 // pbr
 const property_name albedo_prop = 0; //"texture_diffuse/albedo";
 const property_name normal_prop = 1; // "texture_normal";
@@ -75,7 +87,14 @@ struct GraphicsStatistic
 	size_t triangle_count;
 	size_t culled_triangle_count;
 	size_t culled_backface_triangle_count;
+	size_t culled_coverage_triangle_count; // bounding box contains no sample
+	size_t micro_triangle_count; // covers at most two 2x2 blocks
 	size_t earlyz_optimized;
+	size_t culled_renderer_count; // outside the camera frustum
+	size_t culled_shadow_caster_count; // outside the light frustum
+	size_t occluded_renderer_count; // hidden behind the occluders
+	std::atomic<size_t> oit_fragment_count; // fragments sorted through the tile fragment pools
+	std::atomic<size_t> oit_overflow_count; // times a full tile pool was composited early, its fragments are sorted in separate batches
 };
 
 typedef uint8_t image_ubyte;
@@ -103,10 +122,27 @@ enum class TextureFormat
 	kRG = 3,
 	kGray = 4,
 	kRGB16 = 5,
-	kRGBA16 = 6
+	kRGBA16 = 6,
+	kBC1 = 7, // rgb, 8 bytes per 4x4 block
+	kBC3 = 8, // rgba, 16 bytes per 4x4 block
+	kBC4 = 9, // gray, 8 bytes per 4x4 block
+	kBC5 = 10 // rg, 16 bytes per 4x4 block
 };
 
 // pipeline defines
+enum class MemoryLayout
+{
+	kLinear,
+	kTiled // square tiles stored contiguously, morton order inside a tile
+};
+
+// encode applied while resolving a multisampled target
+enum class ResolveEncoding
+{
+	kNone,
+	kSRGB
+};
+
 enum class RasterizerStrategy
 {
 	kScanblock,
@@ -207,7 +243,9 @@ enum class PipelineFeature
 	kBlending = 1 << 4,
 	kFaceCulling = 1 << 5,
 	kZWrite = 1 << 6,
-	kMSAA = 1 << 7
+	kMSAA = 1 << 7,
+	kPostAA = 1 << 8, // fxaa on the resolved color buffer after each fence
+	kOIT = 1 << 9 // blended fragments are sorted per pixel in the tile instead of blended in draw order
 };
 
 enum class BufferFlag
@@ -13,6 +13,9 @@ namespace CpuRasterizer
 	template<typename T>
 	class RawBuffer;
 
+	// blend state compiled into a function on 8-bit unorm colors
+	typedef tinymath::color_rgba (*BlendFunction)(const tinymath::color_rgba& src, const tinymath::color_rgba& dst);
+
 	class FrameBuffer
 	{
 	public:
@@ -38,16 +41,25 @@ namespace CpuRasterizer
 		bool read_stencil(float u, float v, stencil_t& stencil);
 		bool read_coverage(float u, float v, coverage_t& coverage);
 
+		// copy a block of the contents in flag that both buffers have
+		void copy_region(const FrameBuffer& src, FrameContent flag, size_t src_row, size_t src_col, size_t dst_row, size_t dst_col, size_t rows, size_t cols);
+
 		void clear(FrameContent flag);
+		void clear(FrameContent flag, size_t row, size_t col, size_t rows, size_t cols);
 		void set_clear_color(const tinymath::color_rgba& color);
+		tinymath::color_rgba get_clear_color() const { return clear_color; }
 
 		void resize(size_t w, size_t h);
 		size_t get_width() const  { return width; }
 		size_t get_height() const  { return height; }
 		void get_size(size_t& w, size_t& h) const  { w = width; h = height; }
 		FrameContent get_flag() const { return content_flag; }
+		void set_layout(MemoryLayout layout);
+		MemoryLayout get_layout() const { return layout; }
 
 		RawBuffer<tinymath::color_rgba>* get_color_raw_buffer() const ;
+		RawBuffer<coverage_t>* get_coverage_raw_buffer() const { return coverage_buffer.get(); }
+		// always row-major, a tiled color buffer is linearized here for present/readback
 		tinymath::color_rgba* get_color_buffer_ptr() const ;
 
 
@@ -80,12 +92,16 @@ namespace CpuRasterizer
 							  BlendFactor src_factor, 
 							  BlendFactor dst_factor, 
 							  const BlendFunc& op);
+		static BlendFunction compile_blend(BlendFactor src_factor, BlendFactor dst_factor, BlendFunc op);
+		// byte mask of the channels color_mask lets through, in color_rgba memory order
+		static uint32_t compile_color_mask(ColorMask color_mask);
 
 	private:
 		FrameContent content_flag;
 		size_t width;
 		size_t height;
 		Filtering filtering;
+		MemoryLayout layout;
 
 		tinymath::color_rgba clear_color;
 
@@ -97,5 +113,7 @@ namespace CpuRasterizer
 		std::unique_ptr<RawBuffer<stencil_t>> stencil_buffer;
 		// 8-bit coverage buffer
 		std::unique_ptr<RawBuffer<coverage_t>> coverage_buffer;
+		// row-major copy of the color buffer, only used by tiled layout
+		std::unique_ptr<RawBuffer<tinymath::color_rgba>> linear_color_buffer;
 	};
 }
\ No newline at end of file
@@ -24,11 +24,18 @@ namespace CpuRasterizer {
 			pcf_on = true;
 			enable_ibl = false;
 			enable_gizmos = true;
+			enable_oit = false;
+			enable_occlusion_culling = false;
+			shadow_lod_bias = 1;
 			width = 800;
 			height = 600;
 
 			// raster
 			enable_mipmap = false;
+			texture_layout = MemoryLayout::kLinear;
+			texture_compression = false;
+			texture_streaming = true;
+			texture_streaming_budget = 256 * 1024 * 1024;
 			msaa_dirty = true;
 			color_space = ColorSpace::kGamma;
 		}
@@ -50,8 +57,15 @@ namespace CpuRasterizer {
 		bool pcf_on;
 		float shadow_bias;
 		bool enable_gizmos;
+		bool enable_oit;
+		bool enable_occlusion_culling;
+		size_t shadow_lod_bias; // levels added to the camera lod in the shadow pass
 
 		bool enable_mipmap;
+		MemoryLayout texture_layout; // layout texture assets are stored in when they are loaded
+		bool texture_compression; // bc compression for texture assets whose meta doesn't say
+		bool texture_streaming; // cached textures with mips keep their tail resident and stream the finer levels
+		size_t texture_streaming_budget; // bytes of streamed levels resident at once
 		bool msaa_dirty;
 	};
 }
@@ -3,6 +3,7 @@
 #include "Define.hpp"
 #include "tinymath.h"
 #include "RasterAttributes.hpp"
+#include "FrameBuffer.hpp"
 
 namespace CpuRasterizer
 {
@@ -33,6 +34,10 @@ namespace CpuRasterizer
 		// color mask
 		ColorMask color_mask;
 
+		// compiled from the blend and color mask state in draw_primitive
+		BlendFunction blend_function;
+		uint32_t color_write_mask;
+
 		// culling
 		FaceCulling face_culling;
 		VertexOrder vertex_order;
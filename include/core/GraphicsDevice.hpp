@@ -6,6 +6,7 @@
 #include <future>
 #include "Define.hpp"
 #include "RasterAttributes.hpp"
+#include "VertexBuffer.hpp"
 #include "RenderTexture.hpp"
 #include "TileBasedManager.hpp"
 #include "RasterAttributes.hpp"
@@ -17,7 +18,8 @@
 
 namespace CpuRasterizer
 {
-	struct SubsampleParam;
+	struct SampleCoverage;
+	struct TileTarget;
 
 	class GraphicsDevice
 	{
@@ -47,6 +49,8 @@ namespace CpuRasterizer
 		// VB/IB
 		resource_id bind_vertex_buffer(const std::vector<Vertex>& buffer);
 		resource_id bind_index_buffer(const std::vector<size_t>& buffer);
+		resource_id bind_vertex_buffer(const VertexBuffer& buffer);
+		resource_id bind_index_buffer(const IndexBuffer& buffer);
 		void delete_vertex_buffer(resource_id id);
 		void delete_index_buffer(resource_id id);
 		void use_vertex_buffer(resource_id id);
@@ -58,6 +62,9 @@ namespace CpuRasterizer
 		tinymath::color_rgba* get_target_color_buffer() const  { return target_rendertexture->get_color_buffer_ptr(); }
 		void set_active_rendertexture(resource_id id);
 		void reset_active_rendertexture() ;
+		void set_framebuffer_layout(MemoryLayout layout);
+		void set_resolve_encoding(ResolveEncoding encoding);
+		void set_oit_pool_size(size_t fragments_per_tile);
 		
 		// msaa
 		void set_subsample_count(uint8_t multiplier);
@@ -108,19 +115,20 @@ namespace CpuRasterizer
 		void input2vertex(const GraphicsContext& context, const Vertex& v1, const Vertex& v2, const Vertex& v3);
 		void clip2raster(const GraphicsContext& context, const Vertex& c1, const Vertex& c2, const Vertex& c3);
 		void rasterize_tile(const tinymath::Rect& rect, SafeQueue<TileTask>& task_queue);
-		void resolve_tile(const tinymath::Rect& rect, SafeQueue<TileTask>& task_queue);
-		void rasterize(const tinymath::Rect& rect, const GraphicsContext& context, const Triangle& tri);
+		TileTarget load_tile(const RenderTexture& rt, const tinymath::Rect& rect, bool msaa_on);
+		void store_tile(RenderTexture& rt, const tinymath::Rect& rect, const TileTarget& target);
+		void resolve_tile(RenderTexture& rt, const tinymath::Rect& rect, FrameBuffer& msaa_buffer, size_t origin_row, size_t origin_col);
+		void post_process_aa();
+		void rasterize(const TileTarget& target, const tinymath::Rect& rect, const GraphicsContext& context, const Triangle& tri);
+		void rasterize_micro(const TileTarget& target, const tinymath::Rect& rect, const GraphicsContext& context, const Triangle& tri);
+		void rasterize_block(const TileTarget& target, RenderTexture& rt, const GraphicsContext& context, const Triangle& tri, const PixelBlock& block);
 		void rasterize_pixel_block(const Triangle& tri, 
 								   const GraphicsContext& context,
-								   const RenderTexture& rt, 
-								   const Pixel& px1,
-								   const Pixel& px2,
-								   const Pixel& px3,
-								   const Pixel& px4,
-								   SubsampleParam& p1,
-								   SubsampleParam& p2,
-								   SubsampleParam& p3,
-								   SubsampleParam& p4);
+								   FrameBuffer& fb, 
+								   size_t origin_row,
+								   size_t origin_col,
+								   const PixelBlock& block,
+								   const SampleCoverage* coverage);
 		void rasterize(const Triangle& tri, const GraphicsContext& context, RasterizerStrategy strategy);
 		void scanblock(const Triangle& tri, const GraphicsContext& context);
 		void scanline(const Triangle& tri, const GraphicsContext& context);
@@ -128,7 +136,9 @@ namespace CpuRasterizer
 		void resize(size_t w, size_t h);
 
 		bool fragment_stage(FrameBuffer& rt, const Vertex& v, const Vertex& ddx, const Vertex& ddy, size_t row, size_t col, const GraphicsContext& context);
-		bool multisample_fragment_stage(FrameBuffer& rt, const Vertex& v, const Vertex& ddx, const Vertex& ddy, size_t row, size_t col, const GraphicsContext& context, SubsampleParam& subsample_param);
+		bool multisample_fragment_stage(FrameBuffer& rt, const Vertex& v, const Vertex& ddx, const Vertex& ddy, size_t row, size_t col, const SampleCoverage& coverage, const GraphicsContext& context);
+		bool depth_stencil_stage(FrameBuffer& rt, size_t row, size_t col, float z, const GraphicsContext& context);
+		tinymath::color_rgba output_merge(FrameBuffer& rt, size_t row, size_t col, const tinymath::Color& fragment_result, const GraphicsContext& context);
 
 	public:
 		GraphicsStatistic statistics;
@@ -144,11 +154,16 @@ namespace CpuRasterizer
 
 		// VB/IB
 		std::vector<std::shared_ptr<RenderTexture>> rendertextures;
-		std::vector<std::vector<Vertex>> vertex_buffer_table;
-		std::vector<std::vector<size_t>> index_buffer_table;
+		std::vector<VertexBuffer> vertex_buffer_table;
+		std::vector<IndexBuffer> index_buffer_table;
 
 		std::vector<ShaderProgram*> shader_programs;
 
 		bool msaa_dirty;
+		MemoryLayout framebuffer_layout;
+		ResolveEncoding resolve_encoding;
+		uint8_t resolve_lut[256];
+		size_t oit_pool_size;
+		std::unique_ptr<RawBuffer<tinymath::color_rgba>> post_aa_source;
 	};
 }
\ No newline at end of file
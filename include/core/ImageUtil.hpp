@@ -1,10 +1,32 @@
 #pragma once
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <execution>
+#include <type_traits>
 #include "tinymath.h"
 #include "Define.hpp"
 #include "RawBuffer.hpp"
 
 namespace CpuRasterizer
 {
+	// channel layout of the pixel structs, only the color channels of 8 bit formats are gamma encoded
+	template<typename T>
+	struct PixelTraits;
+
+	template<>
+	struct PixelTraits<tinymath::color_rgb> { typedef uint8_t channel_type; static constexpr size_t kChannels = 3; static constexpr size_t kColorChannels = 3; };
+	template<>
+	struct PixelTraits<tinymath::color_rgba> { typedef uint8_t channel_type; static constexpr size_t kChannels = 4; static constexpr size_t kColorChannels = 3; };
+	template<>
+	struct PixelTraits<tinymath::color_rg> { typedef uint8_t channel_type; static constexpr size_t kChannels = 2; static constexpr size_t kColorChannels = 0; };
+	template<>
+	struct PixelTraits<tinymath::color_gray> { typedef uint8_t channel_type; static constexpr size_t kChannels = 1; static constexpr size_t kColorChannels = 1; };
+	template<>
+	struct PixelTraits<tinymath::color_rgb16f> { typedef float channel_type; static constexpr size_t kChannels = 3; static constexpr size_t kColorChannels = 0; };
+	template<>
+	struct PixelTraits<tinymath::color_rgba16f> { typedef float channel_type; static constexpr size_t kChannels = 4; static constexpr size_t kColorChannels = 0; };
+
 	class ImageUtil
 	{
 	public:
@@ -23,8 +45,48 @@ namespace CpuRasterizer
 		static void resize(RawBuffer<T>& image, size_t width, size_t height, size_t layer_count, Filtering filtering);
 
 		static void resize(RawBuffer<stencil_t>& image, size_t width, size_t height, Filtering filtering);
+
+		// 2x2 box filter of the previous mip level into dst, both linear with the same layer count and dst half the size of src.
+		// srgb filters the color channels in linear space, rows are filtered in parallel
+		template<typename T>
+		static void downsample(const RawBuffer<T>& src, RawBuffer<T>& dst, bool srgb);
+
+	private:
+		template<typename C, size_t kChannels, size_t kColorChannels, bool kSRGB>
+		static void downsample_row(const C* row0, const C* row1, C* out, size_t width, size_t layer_count);
 	};
 
+	// gamma 2.2, the same curve the shaders and the srgb resolve use
+	constexpr size_t kLinearToSRGBSteps = 65536;
+
+	inline const float* srgb_to_linear_table()
+	{
+		static const std::vector<float> table = []()
+		{
+			std::vector<float> ret(256);
+			for (size_t idx = 0; idx < ret.size(); ++idx)
+			{
+				ret[idx] = tinymath::pow((float)idx / 255.0f, 2.2f);
+			}
+			return ret;
+		}();
+		return table.data();
+	}
+
+	inline const uint8_t* linear_to_srgb_table()
+	{
+		static const std::vector<uint8_t> table = []()
+		{
+			std::vector<uint8_t> ret(kLinearToSRGBSteps);
+			for (size_t idx = 0; idx < ret.size(); ++idx)
+			{
+				ret[idx] = (uint8_t)(tinymath::pow((float)idx / (float)(kLinearToSRGBSteps - 1), 1.0f / 2.2f) * 255.0f + 0.5f);
+			}
+			return ret;
+		}();
+		return table.data();
+	}
+
 	inline void uv2pixel(size_t width, size_t height, size_t layer_count, float u, float v, float w, size_t& row, size_t& col, size_t& layer, float& row_frac, float& col_frac, float& layer_frac)
 	{
 		float rowf = v * (float)height;
@@ -105,10 +167,23 @@ namespace CpuRasterizer
 		uv2pixel(image.get_width(), image.get_height(), u, v, row, col, frac_row, frac_col);
 
 		T c00, c01, c11, c10;
-		bool flag1 = image.read(row, col, c00);
-		bool flag2 = image.read(row + 1ull, col, c01);
-		bool flag3 = image.read(row + 1ull, col + 1ull, c11);
-		bool flag4 = image.read(row, col + 1ull, c10);
+		bool flag1, flag2, flag3, flag4;
+		if (row + 1ull < image.get_height() && col + 1ull < image.get_width())
+		{
+			// interior footprint, at() follows the buffer layout so a tiled quad mostly stays in one block
+			c00 = image.at(row, col);
+			c01 = image.at(row + 1ull, col);
+			c11 = image.at(row + 1ull, col + 1ull);
+			c10 = image.at(row, col + 1ull);
+			flag1 = flag2 = flag3 = flag4 = true;
+		}
+		else
+		{
+			flag1 = image.read(row, col, c00);
+			flag2 = image.read(row + 1ull, col, c01);
+			flag3 = image.read(row + 1ull, col + 1ull, c11);
+			flag4 = image.read(row, col + 1ull, c10);
+		}
 
 		T a = c00 * (flag1 ? (1.0f - frac_row) : 0.0f) + c10 * (flag4 ? frac_row : 0.0f);
 		T b = c01 * (flag2 ? (1.0f - frac_row) : 0.0f) + c11 * (flag3 ? frac_row : 0.0f);
@@ -213,4 +288,86 @@ namespace CpuRasterizer
 			}
 		}
 	}
-}
\ No newline at end of file
+
+	template<typename C, size_t kChannels, size_t kColorChannels, bool kSRGB>
+	inline void ImageUtil::downsample_row(const C* row0, const C* row1, C* out, size_t width, size_t layer_count)
+	{
+		// layers are interleaved, the horizontal neighbour of a texel is a whole column further
+		size_t column = kChannels * layer_count;
+		const float* to_linear = kSRGB ? srgb_to_linear_table() : nullptr;
+		const uint8_t* to_srgb = kSRGB ? linear_to_srgb_table() : nullptr;
+		for (size_t col = 0; col < width; ++col)
+		{
+			const C* a = row0 + 2 * col * column;
+			const C* b = row1 + 2 * col * column;
+			C* o = out + col * column;
+			for (size_t idx = 0; idx < column; ++idx)
+			{
+				if constexpr (std::is_floating_point_v<C>)
+				{
+					o[idx] = (a[idx] + a[idx + column] + b[idx] + b[idx + column]) * 0.25f;
+				}
+				else if constexpr (kSRGB)
+				{
+					if (idx % kChannels < kColorChannels)
+					{
+						float sum = to_linear[a[idx]] + to_linear[a[idx + column]] + to_linear[b[idx]] + to_linear[b[idx + column]];
+						o[idx] = to_srgb[(size_t)(sum * 0.25f * (float)(kLinearToSRGBSteps - 1) + 0.5f)];
+					}
+					else
+					{
+						o[idx] = (C)(((uint32_t)a[idx] + a[idx + column] + b[idx] + b[idx + column] + 2) >> 2);
+					}
+				}
+				else
+				{
+					o[idx] = (C)(((uint32_t)a[idx] + a[idx + column] + b[idx] + b[idx + column] + 2) >> 2);
+				}
+			}
+		}
+	}
+
+	template<typename T>
+	inline void ImageUtil::downsample(const RawBuffer<T>& src, RawBuffer<T>& dst, bool srgb)
+	{
+		typedef PixelTraits<T> Traits;
+		typedef typename Traits::channel_type C;
+
+		size_t width = dst.get_width();
+		size_t height = dst.get_height();
+		size_t layer_count = dst.get_layer_count();
+		if (width == 0 || height == 0)
+		{
+			return;
+		}
+
+		// an odd source drops its last row or column, like width >> 1 does
+		size_t src_stride = src.get_width() * layer_count * Traits::kChannels;
+		size_t dst_stride = width * layer_count * Traits::kChannels;
+		const C* src_data = (const C*)src.get_ptr();
+		size_t dst_size;
+		C* dst_data = (C*)dst.get_ptr(dst_size);
+		bool gamma = srgb && Traits::kColorChannels > 0;
+
+		std::vector<size_t> rows(height);
+		std::iota(rows.begin(), rows.end(), (size_t)0);
+		std::for_each(
+			std::execution::par,
+			rows.begin(),
+			rows.end(),
+			[&](size_t row)
+		{
+			const C* row0 = src_data + 2 * row * src_stride;
+			const C* row1 = row0 + src_stride;
+			C* out = dst_data + row * dst_stride;
+			if (gamma)
+			{
+				downsample_row<C, Traits::kChannels, Traits::kColorChannels, true>(row0, row1, out, width, layer_count);
+			}
+			else
+			{
+				downsample_row<C, Traits::kChannels, Traits::kColorChannels, false>(row0, row1, out, width, layer_count);
+			}
+		});
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "tinymath.h"
+#include "RawBuffer.hpp"
+
+namespace CpuRasterizer
+{
+	class PostProcess
+	{
+	public:
+		// fxaa over the pixels of rect, src must not alias dst since neighbors are read across rect borders
+		static void fxaa(const RawBuffer<tinymath::color_rgba>& src, RawBuffer<tinymath::color_rgba>& dst, const tinymath::Rect& rect);
+
+	private:
+		static float luma(const tinymath::color_rgba& c);
+		static const tinymath::color_rgba& fetch(const RawBuffer<tinymath::color_rgba>& src, int row, int col);
+		static tinymath::color_rgba lerp(const tinymath::color_rgba& lhs, const tinymath::color_rgba& rhs, float t);
+	};
+}
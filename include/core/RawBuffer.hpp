@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <memory>
 #include <functional>
+#include "Define.hpp"
 
 namespace CpuRasterizer
 {
@@ -31,6 +32,10 @@ namespace CpuRasterizer
 		bool read(size_t row, size_t col, T& out) const;
 		bool write(size_t row, size_t col, const T& data);
 
+		// unchecked access for inner loops
+		T& at(size_t row, size_t col) { return buffer[index(row, col)]; }
+		const T& at(size_t row, size_t col) const { return buffer[index(row, col)]; }
+
 		bool read(size_t row, size_t col, size_t layer, T& out) const;
 		bool write(size_t row, size_t col, size_t layer, const T& data);
 
@@ -51,13 +56,36 @@ namespace CpuRasterizer
 
 		inline size_t get_width() const { return width; }
 		inline size_t get_height() const { return height; }
+		inline size_t get_layer_count() const { return layer_count; }
+
+		// tiled layout is only supported for single layer buffers, existing content is preserved
+		void set_layout(MemoryLayout layout, size_t tile_bits);
+		// the storage already holds the pixels in this layout (e.g. an adopted cache file), nothing is moved
+		void adopt_layout(MemoryLayout layout, size_t tile_bits);
+		MemoryLayout get_layout() const { return layout; }
+		size_t get_tile_bits() const { return tile_bits; }
+		size_t index(size_t row, size_t col) const;
+		void linearize(T* dst) const;
+		// copy a rows x cols block from src, the block is clamped to both buffers
+		void copy_region(const RawBuffer<T>& src, size_t src_row, size_t src_col, size_t dst_row, size_t dst_col, size_t rows, size_t cols);
 
 		void clear(const T& val);
+		void clear(const T& val, size_t row, size_t col, size_t rows, size_t cols);
 		T* get_ptr(size_t& size);
+		const T* get_ptr() const { return buffer; }
 
 		RawBuffer(const RawBuffer<T>& other);
 		RawBuffer<T>& operator = (const RawBuffer<T>& other);
 
+	private:
+		size_t allocation_length() const;
+		// owned storage starts on a cache line, so a tile of the tiled layout touches as few lines as it can
+		static T* allocate(size_t length);
+		static void deallocate(T* ptr);
+		// index(row, col) == row_offset(row) + col_offset(col) in both layouts, so row loops compute the row part once
+		size_t row_offset(size_t row) const;
+		size_t col_offset(size_t col) const;
+
 	private:
 		T* buffer;
 		void (*deletor)(T* ptr);
@@ -65,7 +93,54 @@ namespace CpuRasterizer
 		size_t height;
 		size_t layer_count;
 		size_t buffer_length;
+		MemoryLayout layout;
+		size_t tile_bits;
+		size_t tile_cols;
+	};
+
+	// elements a buffer of this size needs in the layout, tiled buffers are padded to whole tiles
+	inline size_t layout_length(size_t width, size_t height, size_t layer_count, MemoryLayout layout, size_t tile_bits)
+	{
+		if (layout == MemoryLayout::kTiled)
+		{
+			size_t tile_size = (size_t)1 << tile_bits;
+			size_t tile_rows = (height + tile_size - 1) >> tile_bits;
+			size_t tile_cols = (width + tile_size - 1) >> tile_bits;
+			return tile_rows * tile_cols * tile_size * tile_size;
+		}
+		return width * height * layer_count;
+	}
+
+	// the bits of a byte moved to the even bit positions
+	struct MortonSpreadTable
+	{
+		uint16_t values[256];
+
+		constexpr MortonSpreadTable() : values()
+		{
+			for (size_t v = 0; v < 256; ++v)
+			{
+				uint16_t bits = 0;
+				for (size_t bit = 0; bit < 8; ++bit)
+				{
+					bits |= (uint16_t)(((v >> bit) & 1) << (bit * 2));
+				}
+				values[v] = bits;
+			}
+		}
 	};
+
+	inline constexpr MortonSpreadTable kMortonSpread;
+
+	// interleaves the bits of row and col, so every 2x2 quad (and every 4x4 block...) is contiguous
+	inline size_t morton_encode(size_t row, size_t col)
+	{
+		auto spread = [](size_t v)
+		{
+			return (size_t)kMortonSpread.values[v & 0xFF] | ((size_t)kMortonSpread.values[(v >> 8) & 0xFF] << 16);
+		};
+		return spread(col) | (spread(row) << 1);
+	}
 }
 
 #include "detail/RawBuffer.inl"
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <vector>
 #include <functional>
 #include "tinymath.h"
 #include "Define.hpp"
@@ -35,18 +36,28 @@ namespace CpuRasterizer
 
 		void foreach_pixel_block (const tinymath::Rect& rect, std::function<void(RenderTexture& buffer, const PixelBlock& pixel)> pixel_block_func);
 
-		Pixel get_subpixel(size_t row, size_t col, uint8_t x_subsample_idx, uint8_t y_subsample_idx);
+		static PixelBlock get_pixel_block(size_t row, size_t col);
+		// fixed sample positions in sub-pixel units from the pixel corner, sample i is stored at (i / axis, i % axis)
+		static const tinymath::vec2i* get_sample_offsets(uint8_t subsample_count);
 
+		// clears are recorded per tile and filled in when the tile is first touched
 		void clear(FrameContent flag);
 		void set_clear_color(const tinymath::color_rgba color);
+		FrameContent consume_pending_clear(const tinymath::Rect& tile);
+		FrameContent consume_pending_msaa_clear(const tinymath::Rect& tile);
+		FrameContent get_pending_msaa_clear(const tinymath::Rect& tile) const;
+		void resolve_pending_clear(const tinymath::Rect& tile);
+		void resolve_pending_clears();
 
 		void resize(size_t w, size_t h);
+		void set_layout(MemoryLayout layout);
+		MemoryLayout get_layout() const { return layout; }
 		size_t get_width() const  { return framebuffer->get_width(); }
 		size_t get_height() const  { return framebuffer->get_height(); }
 		void get_size(size_t& w, size_t& h) const  { w = framebuffer->get_width(); h = framebuffer->get_height(); }
 
 		RawBuffer<tinymath::color_rgba>* get_color_raw_buffer() const  { return framebuffer->get_color_raw_buffer(); }
-		tinymath::color_rgba* get_color_buffer_ptr() const  { return framebuffer->get_color_buffer_ptr(); };
+		tinymath::color_rgba* get_color_buffer_ptr() { resolve_pending_clears(); return framebuffer->get_color_buffer_ptr(); };
 		
 		RawBuffer<tinymath::color_rgba>* get_msaa_color_raw_buffer() const  { return msaa_framebuffer->get_color_raw_buffer(); }
 		tinymath::color_rgba* get_msaa_color_buffer_ptr() const  { return msaa_framebuffer->get_color_buffer_ptr(); };
@@ -61,7 +72,10 @@ namespace CpuRasterizer
 		uint8_t get_subsamples_per_axis() { return subsamples_per_axis; }
 
 	private:
+		static uint8_t normalize_subsample_count(uint8_t subsample_count);
 		void reset_msaa_buffer();
+		void reset_pending_clears();
+		size_t get_tile_index(const tinymath::Rect& tile) const;
 
 	public:
 		MultiSampleFrequency multi_sample_frequency; // here I use pixel frequency by default
@@ -71,7 +85,15 @@ namespace CpuRasterizer
 		std::unique_ptr<FrameBuffer> msaa_framebuffer;
 		std::unique_ptr<TileBasedManager> tile_based_manager;
 
+		// per tile contents waiting for a clear
+		std::vector<FrameContent> pending_clears;
+		std::vector<FrameContent> pending_msaa_clears;
+		size_t tile_rows;
+		size_t tile_cols;
+		bool has_pending_clear;
+
 		bool has_msaa_buffer;
+		MemoryLayout layout;
 		uint8_t msaa_subsample_count;
 		uint8_t subsamples_per_axis;
 	};
@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "Define.hpp"
+#include "tinymath.h"
+
+namespace CpuRasterizer
+{
+	class Sampler;
+
+	typedef void (*SampleFunction)(const Sampler& sampler, float u, float v, float lod, tinymath::Color& ret);
+
+	// one mip level as the kernels see it, the pixels stay owned by the texture
+	struct SamplerLevel
+	{
+		const void* data;
+		size_t width;
+		size_t height;
+		size_t tile_cols;
+		float fwidth;
+		float fheight;
+	};
+
+	// sampler feedback, bit i is set once level i was asked for since the last take.
+	// the line is only written the first time a level shows up, later samples just read it
+	inline void record_level_request(std::atomic<uint32_t>& requests, size_t level)
+	{
+		uint32_t bit = 1u << level;
+		if ((requests.load(std::memory_order_relaxed) & bit) == 0)
+		{
+			requests.fetch_or(bit, std::memory_order_relaxed);
+		}
+	}
+
+	// a texture resolved for sampling, raw level pointers and a kernel specialized on format,
+	// wrap mode, filtering and layout. resolved once per draw, it doesn't keep the texture alive
+	class Sampler
+	{
+	public:
+		Sampler() : levels(), level_count(0), base_level(0), tile_bits(0), feedback(nullptr), function(nullptr) {}
+
+		static SampleFunction compile(TextureFormat format, WrapMode wrap_mode, Filtering filtering, MemoryLayout layout);
+
+		bool valid() const { return function != nullptr; }
+
+		// base level
+		void sample(float u, float v, tinymath::Color& ret) const { function(*this, u, v, 0.0f, ret); }
+		// blends the two levels around lod, uvs are wrapped once for both
+		void sample(float u, float v, float lod, tinymath::Color& ret) const { function(*this, u, v, lod, ret); }
+		// lod from the uv derivatives of the quad
+		void sample(float u, float v, const tinymath::vec2f& ddx, const tinymath::vec2f& ddy, tinymath::Color& ret) const;
+
+	public:
+		SamplerLevel levels[kMaxMip];
+		size_t level_count;
+		size_t base_level; // finest level in memory, levels below it only have their size
+		size_t tile_bits;
+		std::atomic<uint32_t>* feedback; // levels the kernels were asked for, null when the texture isn't streamed
+		SampleFunction function;
+	};
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include "RawBuffer.hpp"
 
 namespace CpuRasterizer
@@ -10,6 +11,9 @@ namespace CpuRasterizer
 		static void dda(RawBuffer<T>* buffer, int x0, int y0, int x1, int y1, const T& c);
 		template<typename T>
 		static void bresenham(RawBuffer<T>* buffer, int x0, int y0, int x1, int y1, const T& c);
+		// only writes the pixels inside rows [row_start, row_end) and cols [col_start, col_end)
+		template<typename T>
+		static void bresenham(RawBuffer<T>* buffer, int x0, int y0, int x1, int y1, const T& c, int row_start, int row_end, int col_start, int col_end);
 	};
 
 	template<typename T>
@@ -41,6 +45,17 @@ namespace CpuRasterizer
 	void SegmentDrawer::bresenham(RawBuffer<T>* buffer, int x0, int y0, int x1, int y1, const T& c)
 	{
 		assert(buffer != nullptr);
+		bresenham(buffer, x0, y0, x1, y1, c, 0, (int)buffer->get_height(), 0, (int)buffer->get_width());
+	}
+
+	template<typename T>
+	void SegmentDrawer::bresenham(RawBuffer<T>* buffer, int x0, int y0, int x1, int y1, const T& c, int row_start, int row_end, int col_start, int col_end)
+	{
+		assert(buffer != nullptr);
+		row_start = std::max(row_start, 0);
+		col_start = std::max(col_start, 0);
+		row_end = std::min(row_end, (int)buffer->get_height());
+		col_end = std::min(col_end, (int)buffer->get_width());
 		int dx = std::abs(x1 - x0);
 		int dy = std::abs(y1 - y0);
 		int sx = x0 < x1 ? 1 : -1;
@@ -50,9 +65,7 @@ namespace CpuRasterizer
 		int dy2 = 2 * dy;
 		int col = x0;
 		int row = y0;
-		int w = (int)buffer->get_width();
-		int h = (int)buffer->get_height();
-		while (((row >= 0 && row < h &&  col >= 0 && col < w) && buffer->write((size_t)row, (size_t)col, c)), (col != x1 || row != y1))
+		while (((row >= row_start && row < row_end && col >= col_start && col < col_end) && buffer->write((size_t)row, (size_t)col, c)), (col != x1 || row != y1))
 		{
 			int e = bias;
 			if (e > -dx2)
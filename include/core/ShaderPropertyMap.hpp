@@ -3,6 +3,7 @@
 #include <memory>
 #include "Define.hpp"
 #include "tinymath.h"
+#include "Sampler.hpp"
 
 namespace CpuRasterizer
 {
@@ -25,6 +26,8 @@ namespace CpuRasterizer
 		std::unordered_map<property_name, uint32_t> name2tex_id;
 		std::unordered_map<property_name, uint32_t> name2cubemap_id;
 		std::unordered_map<property_name, uint32_t> name2rendertexture_id;
+		// resolved from name2tex whenever a texture is set or the map is assigned, i.e. once per draw
+		std::unordered_map<property_name, Sampler> name2sampler;
 
 		ShaderPropertyMap() {}
 		ShaderPropertyMap(const ShaderPropertyMap& other);
@@ -49,6 +52,8 @@ namespace CpuRasterizer
 		float get_float(property_name name) const;
 		tinymath::mat4x4 get_mat4x4(property_name name) const;
 		std::shared_ptr<Texture> get_texture(property_name name) const;
+		// nullptr when there is no 2d texture under the name
+		const Sampler* get_sampler(property_name name) const;
 		std::shared_ptr<CubeMap> get_cubemap(property_name name) const;
 		std::shared_ptr<RenderTexture> get_framebuffer(property_name name) const;
 
@@ -3,13 +3,23 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <atomic>
 #include "Define.hpp"
 #include "tinymath.h"
+#include "Sampler.hpp"
+#include "TextureCache.hpp"
 
 namespace CpuRasterizer
 {
 	template<typename T>
 	class RawBuffer;
+	struct bc1_block;
+	struct bc3_block;
+	struct bc4_block;
+	struct bc5_block;
+
+	constexpr size_t kTextureTileBits = 2; // 4x4 texel blocks when a texture uses the tiled layout
+	constexpr size_t kStreamingTailSize = 64; // streamed textures keep every level up to this size in memory
 
 	class Texture
 	{
@@ -33,6 +43,13 @@ namespace CpuRasterizer
 
 		void reload(const char* texture_path);
 		void generate_mipmap(int mip_count);
+		// moves every level into the layout, tiled keeps bilinear footprints within a few cache lines
+		void set_layout(MemoryLayout target_layout);
+		// encodes every level of an 8 bit texture to the matching bc format, the texture is read only afterwards
+		void compress();
+
+		// 2d textures only, the sampler points into the current levels and is invalidated by reload, resize or set_layout
+		Sampler get_sampler() const;
 
 		// sample pixel 2d
 		bool sample(float u, float v, tinymath::Color& ret) const;
@@ -91,11 +108,29 @@ namespace CpuRasterizer
 		void release();
 		void copy(const Texture& other);
 
+		// storage of the base level in the texture's layout
 		void* get_ptr();
 
 		// save to disk
 		static void export_image(const Texture& tex, const std::string& path);
 
+		// streaming. levels from resident_level on are in memory, the ones before it are read back from the cache file.
+		// only call these between frames, samplers keep raw pointers into the levels
+		bool is_streamed() const { return stream_levels.size() > 0; }
+		size_t get_resident_level() const { return resident_level; }
+		size_t get_tail_level() const { return tail_level; }
+		const TextureLevel& get_stream_level(size_t level) const { return stream_levels[level]; }
+		const std::string& get_stream_file() const { return stream_file; }
+		const TextureCacheInfo& get_stream_info() const { return stream_info; }
+		// bytes of the streamed levels in memory, the tail is not counted
+		size_t get_streamed_bytes() const;
+		// takes a new uint8_t[] holding the level right before the resident one
+		void stream_in(size_t level, uint8_t* data);
+		// drops the finest resident level, the tail is never dropped
+		void stream_out();
+		// levels sampled since the last call, bit i for level i
+		uint32_t take_level_requests() { return level_requests.exchange(0, std::memory_order_relaxed); }
+
 		Texture(const Texture& other);
 		Texture& operator =(const Texture& other);
 
@@ -103,6 +138,11 @@ namespace CpuRasterizer
 		void wrap(float& u, float& v) const;
 		void wrap(float& u, float& v, float& w) const;
 		void clear();
+		bool read_block(size_t row, size_t col, int mip, tinymath::Color& ret) const;
+		bool load_cache(const char* texture_path);
+		void save_cache(const char* texture_path);
+		void begin_streaming(const std::string& cache_file, const TextureCacheInfo& info, const std::vector<TextureLevel>& levels);
+		static std::string cache_path(const char* texture_path);
 
 	public:
 		WrapMode wrap_mode;
@@ -115,6 +155,10 @@ namespace CpuRasterizer
 		size_t layer_count;
 		int mip_count;
 		bool enable_mip;
+		MemoryLayout layout;
+		bool enable_compression; // compress on import, cached textures are stored compressed
+		bool srgb; // gamma encoded color, mips are filtered in linear space
+		bool enable_streaming; // cached textures with mips only load their tail, finer levels are streamed in
 
 	private:
 		std::shared_ptr<RawBuffer<tinymath::color_rgb16f>> rgb16f_buffer;
@@ -129,5 +173,21 @@ namespace CpuRasterizer
 		std::vector< std::shared_ptr<RawBuffer<tinymath::color_rg>>> rg_mipmaps;
 		std::vector< std::shared_ptr<RawBuffer<tinymath::color_rgb16f>>> rgb16f_mipmaps;
 		std::vector< std::shared_ptr<RawBuffer<tinymath::color_rgba16f>>> rgba16f_mipmaps;
+		// block formats, one element per 4x4 block
+		std::shared_ptr<RawBuffer<bc1_block>> bc1_buffer;
+		std::shared_ptr<RawBuffer<bc3_block>> bc3_buffer;
+		std::shared_ptr<RawBuffer<bc4_block>> bc4_buffer;
+		std::shared_ptr<RawBuffer<bc5_block>> bc5_buffer;
+		std::vector< std::shared_ptr<RawBuffer<bc1_block>>> bc1_mipmaps;
+		std::vector< std::shared_ptr<RawBuffer<bc3_block>>> bc3_mipmaps;
+		std::vector< std::shared_ptr<RawBuffer<bc4_block>>> bc4_mipmaps;
+		std::vector< std::shared_ptr<RawBuffer<bc5_block>>> bc5_mipmaps;
+		std::shared_ptr<const void> cache_storage; // mapped cache file the buffers were adopted from
+		std::vector<TextureLevel> stream_levels; // where each level is in the cache file, empty when not streamed
+		std::string stream_file;
+		TextureCacheInfo stream_info; // what the cache file held when streaming began, checked on every read
+		size_t resident_level;
+		size_t tail_level;
+		mutable std::atomic<uint32_t> level_requests; // sampler feedback
 	};
 }
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdint.h>
+#include "Define.hpp"
+
+class MappedFile;
+
+namespace CpuRasterizer
+{
+	constexpr uint32_t kTextureCacheMagic = 0x58455443; // "CTEX"
+	constexpr uint32_t kTextureCacheVersion = 4; // bump whenever the decoded pixels or the layout below change
+	constexpr size_t kTextureCacheAlignment = kCacheLineSize; // every level starts on this boundary, so mapped tiles start on cache lines
+
+	// file layout, little endian: TextureCacheHeader, TextureCacheLevel[level_count], then the aligned levels.
+	// levels are stored in the texture format and memory layout, level 0 is the full resolution image.
+	// sizes are in texels, block formats store whole 4x4 blocks
+	struct TextureCacheHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t format; // TextureFormat
+		uint32_t filtering; // Filtering of the texture when it was cached
+		uint32_t width;
+		uint32_t height;
+		uint32_t level_count;
+		uint16_t layout; // MemoryLayout
+		uint8_t tile_bits;
+		uint8_t srgb; // the mips were filtered in linear space
+	};
+
+	struct TextureCacheLevel
+	{
+		uint32_t width;
+		uint32_t height;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	static_assert(sizeof(TextureCacheHeader) == 32, "texture cache header layout changed");
+	static_assert(sizeof(TextureCacheLevel) == 24, "texture cache level layout changed");
+
+	struct TextureCacheInfo
+	{
+		TextureFormat format;
+		Filtering filtering;
+		MemoryLayout layout;
+		size_t tile_bits;
+		bool srgb;
+	};
+
+	struct TextureLevel
+	{
+		size_t width;
+		size_t height;
+		void* data;
+		size_t offset; // where the level is in the file, set by load
+		size_t size;
+	};
+
+	// decoded textures with their mip chain, loaded levels point into a copy on write mapping of the file
+	class TextureCache
+	{
+	public:
+		// bytes per texel, or per block for block formats
+		static size_t pixel_size(TextureFormat format);
+		static size_t level_size(TextureFormat format, size_t width, size_t height, MemoryLayout layout, size_t tile_bits);
+		static bool save(const std::string& path, const TextureCacheInfo& info, const std::vector<TextureLevel>& levels);
+		// false for missing, outdated or malformed files. the levels stay valid as long as file is alive
+		static bool load(const std::string& path, TextureCacheInfo& info, std::vector<TextureLevel>& levels, std::shared_ptr<MappedFile>& file);
+		// reads level index described by load into dst without mapping the file, safe on any thread.
+		// false when the file no longer holds that level as info and level describe it, e.g. it was rewritten since
+		static bool read_level(const std::string& path, const TextureCacheInfo& info, size_t index, const TextureLevel& level, void* dst);
+	};
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <future>
+#include <mutex>
+#include "Define.hpp"
+#include "Singleton.hpp"
+
+#define CpuRasterTextureStreamer Singleton<CpuRasterizer::TextureStreamer>::get()
+
+namespace CpuRasterizer
+{
+	class Texture;
+
+	constexpr size_t kMaxStreamingLoads = 4; // level reads in flight at once
+	constexpr uint64_t kStreamingKeepFrames = 30; // a level sampled this recently is still wanted
+	constexpr uint64_t kStreamingEvictFrames = 600; // unsampled levels are dropped after this, or earlier when over budget
+
+	// streams the levels of streamed textures in and out of memory from the sampler feedback.
+	// levels are read from the texture cache on background threads and handed to the textures in update,
+	// finer levels only come in once the coarser ones are resident so the resident levels stay a suffix of the chain
+	class TextureStreamer
+	{
+	public:
+		TextureStreamer();
+		~TextureStreamer();
+
+		// safe on any thread, the texture is picked up by the next update
+		void add(const std::shared_ptr<Texture>& texture);
+		// once per frame while nothing samples, e.g. at the start of Scene::update
+		void update();
+
+		size_t get_resident_bytes() const { return resident_bytes; }
+		size_t get_texture_count() const { return textures.size(); }
+
+	private:
+		struct StreamedTexture
+		{
+			const Texture* key;
+			std::weak_ptr<Texture> texture;
+			uint64_t last_requested[kMaxMip]; // frame each level was last sampled in, 0 for never
+			size_t wanted_level; // finest level sampled within kStreamingKeepFrames
+			bool loading;
+			bool stale; // a level couldn't be read back, the texture keeps what it has
+		};
+
+		struct LevelLoad
+		{
+			const Texture* key;
+			std::weak_ptr<Texture> texture;
+			size_t level;
+			size_t size;
+			std::future<std::unique_ptr<uint8_t[]>> data;
+		};
+
+		void finish_loads();
+		void read_feedback();
+		void evict_unused();
+		// evicts levels nobody wants, least recently sampled first, until size fits the budget
+		bool make_room(size_t size, const Texture* keep);
+		void start_loads();
+
+	private:
+		std::vector<StreamedTexture> textures;
+		std::vector<StreamedTexture> added;
+		std::mutex added_mutex;
+		std::vector<LevelLoad> loads;
+		uint64_t frame;
+		size_t resident_bytes;
+		size_t loading_bytes;
+	};
+}
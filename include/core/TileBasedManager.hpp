@@ -11,8 +11,6 @@
 
 namespace CpuRasterizer
 {
-	constexpr size_t kTileSize = 16;
-
 	struct TileTask
 	{
 		Triangle triangle;
@@ -1,4 +1,5 @@
 #pragma once
+#include <stdint.h>
 #include <vector>
 #include "tinymath/Vector2.h"
 #include "tinymath/Vector3.h"
@@ -7,12 +8,39 @@
 
 namespace CpuRasterizer
 {
+	// edge function in sub-pixel fixed point: e(x, y) = a * x + b * y + c
+	struct EdgeFunction
+	{
+		int64_t a;
+		int64_t b;
+		int64_t c;
+		int64_t bias; // top-left fill rule, 0 for top/left edges, -1 otherwise
+
+		void setup(const tinymath::vec2i& v0, const tinymath::vec2i& v1);
+		int64_t evaluate(int64_t x, int64_t y) const { return a * x + b * y + c; }
+	};
+
+	// pixel bounds in screen space, max is exclusive
+	struct RasterBounds
+	{
+		int min_x;
+		int min_y;
+		int max_x;
+		int max_y;
+
+		bool empty() const { return min_x >= max_x || min_y >= max_y; }
+	};
+
 	struct Triangle
 	{
 		Vertex vertices[3];
 		bool flip;
 		bool culled;
 		float cached_area;
+		EdgeFunction edges[3];
+		int64_t fixed_area;
+		RasterBounds raster_bounds;
+		bool micro; // covers at most two 2x2 pixel blocks
 
 	public:
 		Triangle();
@@ -25,6 +53,10 @@ namespace CpuRasterizer
 		float area() const;
 		float area_double() const;
 		bool barycentric_interpolate(const tinymath::vec2f& pos, Vertex& interpolated_vert) const;
+		bool setup_edges(bool multisample);
+		bool edge_interpolate(const tinymath::vec2f& pos, Vertex& interpolated_vert) const;
+		uint32_t coverage_mask(size_t row, size_t col, const tinymath::vec2i* sample_offsets, uint8_t sample_count, float* sample_depths) const;
+		static tinymath::vec2i snap(const tinymath::vec2f& pos);
 		static float area_double(const tinymath::vec2f& v1, const tinymath::vec2f& v2, const tinymath::vec2f& v3);
 		static float area_double(const tinymath::vec3f& v1, const tinymath::vec3f& v2, const tinymath::vec3f& v3);
 		static float area(const tinymath::vec3f& v1, const tinymath::vec3f& v2, const tinymath::vec3f& v3);
@@ -0,0 +1,114 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <stdint.h>
+#include "tinymath.h"
+#include "RasterAttributes.hpp"
+
+namespace CpuRasterizer
+{
+	// attributes a vertex buffer stores, everything else in Vertex is produced by the pipeline
+	enum class VertexAttribute : uint8_t
+	{
+		kPosition,
+		kNormal,
+		kUV,
+		kTangent,
+		kColor,
+		kCount
+	};
+
+	constexpr size_t kVertexAttributeCount = (size_t)VertexAttribute::kCount;
+
+	enum class VertexFormat : uint8_t
+	{
+		kNone, // not stored, decodes to zero
+		kFloat2,
+		kFloat3,
+		kFloat4,
+		kHalf2,
+		kHalf4,
+		kSnorm16x4, // components in [-1, 1]
+		kUnorm16x2, // components in [0, 1]
+		kUnorm8x4, // components in [0, 1]
+		kOctahedral16, // unit vector folded onto an octahedron, two snorm16
+	};
+
+	enum class IndexFormat : uint8_t
+	{
+		kUInt16,
+		kUInt32
+	};
+
+	struct VertexLayout
+	{
+		VertexFormat formats[kVertexAttributeCount];
+		uint32_t offsets[kVertexAttributeCount];
+		uint32_t stride;
+
+		VertexLayout();
+		VertexLayout(VertexFormat position, VertexFormat normal, VertexFormat uv, VertexFormat tangent, VertexFormat color);
+
+		void encode(const Vertex& vertex, uint8_t* dst) const;
+		void decode(const uint8_t* src, Vertex& vertex) const;
+		tinymath::vec3f decode_position(const uint8_t* src) const;
+
+		static size_t format_size(VertexFormat format);
+
+		// lossless for every attribute a2v reads
+		static VertexLayout full();
+		// float positions and uvs, octahedral normal and tangent, half color
+		static VertexLayout standard();
+		// also quantizes uvs to unorm16 and color to unorm8, uvs have to stay in [0, 1]
+		static VertexLayout compact();
+	};
+
+	// vertices packed with a layout, decoded one at a time at vertex fetch.
+	// the packed data is immutable and shared between copies, storage keeps it alive
+	class VertexBuffer
+	{
+	public:
+		VertexBuffer();
+		VertexBuffer(const std::vector<Vertex>& vertices, const VertexLayout& layout);
+		// wraps data that is already packed, e.g. a mapped cache file
+		VertexBuffer(const VertexLayout& layout, const uint8_t* data, size_t count, std::shared_ptr<const void> storage);
+
+		size_t size() const { return count; }
+		size_t byte_size() const { return count * layout.stride; }
+		const uint8_t* get_data() const { return data; }
+		const VertexLayout& get_layout() const { return layout; }
+		Vertex operator[](size_t index) const;
+		tinymath::vec3f position(size_t index) const { return layout.decode_position(data + index * layout.stride); }
+		std::vector<Vertex> decode() const;
+
+	private:
+		VertexLayout layout;
+		const uint8_t* data;
+		size_t count;
+		std::shared_ptr<const void> storage;
+	};
+
+	// 16 bit whenever every index fits, shared between copies like VertexBuffer
+	class IndexBuffer
+	{
+	public:
+		IndexBuffer();
+		explicit IndexBuffer(const std::vector<size_t>& indices);
+		IndexBuffer(IndexFormat format, const void* data, size_t count, std::shared_ptr<const void> storage);
+
+		size_t size() const { return count; }
+		size_t byte_size() const { return count * index_size(format); }
+		const void* get_data() const { return data; }
+		IndexFormat get_format() const { return format; }
+		size_t operator[](size_t index) const { return format == IndexFormat::kUInt16 ? (size_t)((const uint16_t*)data)[index] : (size_t)((const uint32_t*)data)[index]; }
+		std::vector<size_t> decode() const;
+
+		static size_t index_size(IndexFormat format) { return format == IndexFormat::kUInt16 ? sizeof(uint16_t) : sizeof(uint32_t); }
+
+	private:
+		IndexFormat format;
+		const void* data;
+		size_t count;
+		std::shared_ptr<const void> storage;
+	};
+}
@@ -1,5 +1,6 @@
 #include "tinymath.h"
 #include <type_traits>
+#include <new>
 #include "RawBuffer.hpp"
 #include "ImageUtil.hpp"
 
@@ -14,6 +15,9 @@ namespace CpuRasterizer
 		this->buffer_length = 0;
 		this->buffer = nullptr;
 		this->deletor = nullptr;
+		this->layout = MemoryLayout::kLinear;
+		this->tile_bits = 0;
+		this->tile_cols = 0;
 	}
 
 	template<typename T>
@@ -22,12 +26,12 @@ namespace CpuRasterizer
 		this->width = w;
 		this->height = h;
 		this->layer_count = lc;
-		this->deletor = [](T* ptr)
-		{
-			delete[] ptr;
-		};
+		this->deletor = &RawBuffer<T>::deallocate;
+		this->layout = MemoryLayout::kLinear;
+		this->tile_bits = 0;
+		this->tile_cols = 0;
 		buffer_length = w * h * lc;
-		this->buffer = new T[buffer_length];
+		this->buffer = allocate(buffer_length);
 	}
 
 	template<typename T>
@@ -43,6 +47,9 @@ namespace CpuRasterizer
 		this->buffer_length = w * h * lc;
 		this->deletor = deletor;
 		this->buffer = (T*)_buffer;
+		this->layout = MemoryLayout::kLinear;
+		this->tile_bits = 0;
+		this->tile_cols = 0;
 	}
 
 	template<typename T>
@@ -52,7 +59,10 @@ namespace CpuRasterizer
 	template<typename T>
 	RawBuffer<T>::~RawBuffer()
 	{
-		deletor(buffer);
+		if (deletor != nullptr)
+		{
+			deletor(buffer);
+		}
 	}
 
 	template<typename T>
@@ -88,13 +98,20 @@ namespace CpuRasterizer
 	template<typename T>
 	bool RawBuffer<T>::read(float u, float v, T& out) const
 	{
-		return read(buffer, u, v, width, height, out);
+		size_t row, col;
+		uv2pixel(width, height, u, v, row, col);
+		return read(row, col, out);
 	}
 
 	template<typename T>
 	bool RawBuffer<T>::read(size_t row, size_t col, T& out) const
 	{
-		return read(buffer, row, col, width, height, out);
+		if (row >= height || col >= width)
+		{
+			return false;
+		}
+		out = buffer[index(row, col)];
+		return true;
 	}
 
 	template<typename T>
@@ -106,7 +123,9 @@ namespace CpuRasterizer
 	template<typename T>
 	bool RawBuffer<T>::write(float u, float v, const T& data)
 	{
-		return write(buffer, u, v, width, height, data);
+		size_t row, col;
+		uv2pixel(width, height, u, v, row, col);
+		return write(row, col, data);
 	}
 
 	template<typename T>
@@ -124,7 +143,12 @@ namespace CpuRasterizer
 	template<typename T>
 	bool RawBuffer<T>::write(size_t row, size_t col, const T& data)
 	{
-		return write(buffer, row, col, width, height, data);
+		if (row >= height || col >= width)
+		{
+			return false;
+		}
+		buffer[index(row, col)] = data;
+		return true;
 	}
 
 	template<typename T>
@@ -217,12 +241,18 @@ namespace CpuRasterizer
 	template<typename T>
 	void RawBuffer<T>::reallocate(size_t w, size_t h, size_t lc)
 	{
+		assert(layout == MemoryLayout::kLinear || lc == 1);
 		this->width = w;
 		this->height = h;
 		this->layer_count = lc;
-		this->buffer_length = w * h * lc;
-		delete[] buffer;
-		buffer = new T[buffer_length];
+		this->tile_cols = layout == MemoryLayout::kTiled ? (w + ((size_t)1 << tile_bits) - 1) >> tile_bits : 0;
+		this->buffer_length = allocation_length();
+		if (deletor != nullptr)
+		{
+			deletor(buffer);
+		}
+		buffer = allocate(buffer_length);
+		deletor = &RawBuffer<T>::deallocate;
 	}
 
 	template<typename T>
@@ -231,53 +261,280 @@ namespace CpuRasterizer
 		reallocate(w, h, 1ull);
 	}
 
+	template<typename T>
+	T* RawBuffer<T>::allocate(size_t length)
+	{
+		// the aligned delete below doesn't run destructors
+		static_assert(std::is_trivially_destructible_v<T>);
+		return new (std::align_val_t(kCacheLineSize)) T[length];
+	}
+
+	template<typename T>
+	void RawBuffer<T>::deallocate(T* ptr)
+	{
+		::operator delete[](ptr, std::align_val_t(kCacheLineSize));
+	}
+
+	template<typename T>
+	size_t RawBuffer<T>::allocation_length() const
+	{
+		return layout_length(width, height, layer_count, layout, tile_bits);
+	}
+
+	template<typename T>
+	size_t RawBuffer<T>::index(size_t row, size_t col) const
+	{
+		return row_offset(row) + col_offset(col);
+	}
+
+	// in the tiled layout the row and col parts are the tile index and the odd and even morton bits, they never overlap
+	template<typename T>
+	size_t RawBuffer<T>::row_offset(size_t row) const
+	{
+		if (layout == MemoryLayout::kLinear)
+		{
+			return row * width;
+		}
+
+		size_t mask = ((size_t)1 << tile_bits) - 1;
+		return (((row >> tile_bits) * tile_cols) << (tile_bits * 2)) | morton_encode(row & mask, 0);
+	}
+
+	template<typename T>
+	size_t RawBuffer<T>::col_offset(size_t col) const
+	{
+		if (layout == MemoryLayout::kLinear)
+		{
+			return col;
+		}
+
+		size_t mask = ((size_t)1 << tile_bits) - 1;
+		return ((col >> tile_bits) << (tile_bits * 2)) | morton_encode(0, col & mask);
+	}
+
+	template<typename T>
+	void RawBuffer<T>::set_layout(MemoryLayout target_layout, size_t target_tile_bits)
+	{
+		if (target_layout == MemoryLayout::kLinear)
+		{
+			target_tile_bits = 0;
+		}
+
+		if (target_layout == layout && target_tile_bits == tile_bits)
+		{
+			return;
+		}
+
+		assert(target_layout == MemoryLayout::kLinear || layer_count == 1);
+
+		T* prev_buffer = buffer;
+		RawBuffer<T> prev_image;
+		prev_image.buffer = buffer;
+		prev_image.width = width;
+		prev_image.height = height;
+		prev_image.layer_count = layer_count;
+		prev_image.layout = layout;
+		prev_image.tile_bits = tile_bits;
+		prev_image.tile_cols = tile_cols;
+		prev_image.deletor = deletor;
+
+		layout = target_layout;
+		tile_bits = target_tile_bits;
+		size_t tile_size = (size_t)1 << tile_bits;
+		tile_cols = layout == MemoryLayout::kTiled ? (width + tile_size - 1) >> tile_bits : 0;
+		buffer_length = allocation_length();
+		buffer = allocate(buffer_length);
+		deletor = &RawBuffer<T>::deallocate;
+
+		if (prev_buffer != nullptr)
+		{
+			for (size_t row = 0; row < height; ++row)
+			{
+				for (size_t col = 0; col < width; ++col)
+				{
+					buffer[index(row, col)] = prev_buffer[prev_image.index(row, col)];
+				}
+			}
+		}
+		// prev_image releases the previous storage with its own deletor
+	}
+
+	template<typename T>
+	void RawBuffer<T>::adopt_layout(MemoryLayout target_layout, size_t target_tile_bits)
+	{
+		assert(target_layout == MemoryLayout::kLinear || layer_count == 1);
+		layout = target_layout;
+		tile_bits = layout == MemoryLayout::kTiled ? target_tile_bits : 0;
+		size_t tile_size = (size_t)1 << tile_bits;
+		tile_cols = layout == MemoryLayout::kTiled ? (width + tile_size - 1) >> tile_bits : 0;
+		buffer_length = allocation_length();
+	}
+
+	template<typename T>
+	void RawBuffer<T>::copy_region(const RawBuffer<T>& src, size_t src_row, size_t src_col, size_t dst_row, size_t dst_col, size_t rows, size_t cols)
+	{
+		if (src_row >= src.height || src_col >= src.width || dst_row >= height || dst_col >= width)
+		{
+			return;
+		}
+
+		rows = tinymath::min(rows, tinymath::min(src.height - src_row, height - dst_row));
+		cols = tinymath::min(cols, tinymath::min(src.width - src_col, width - dst_col));
+
+		if (layout == MemoryLayout::kLinear && src.layout == MemoryLayout::kLinear)
+		{
+			for (size_t row = 0; row < rows; ++row)
+			{
+				memcpy(buffer + (dst_row + row) * width + dst_col, src.buffer + (src_row + row) * src.width + src_col, cols * sizeof(T));
+			}
+			return;
+		}
+
+		// whole tiles of two buffers with the same tiling are one contiguous block in both
+		size_t tile_size = (size_t)1 << tile_bits;
+		size_t tile_mask = tile_size - 1;
+		if (layout == MemoryLayout::kTiled && src.layout == MemoryLayout::kTiled && tile_bits == src.tile_bits &&
+			((src_row | src_col | dst_row | dst_col | rows | cols) & tile_mask) == 0)
+		{
+			for (size_t row = 0; row < rows; row += tile_size)
+			{
+				for (size_t col = 0; col < cols; col += tile_size)
+				{
+					memcpy(buffer + index(dst_row + row, dst_col + col), src.buffer + src.index(src_row + row, src_col + col), tile_size * tile_size * sizeof(T));
+				}
+			}
+			return;
+		}
+
+		for (size_t row = 0; row < rows; ++row)
+		{
+			size_t dst_offset = row_offset(dst_row + row);
+			size_t src_offset = src.row_offset(src_row + row);
+			for (size_t col = 0; col < cols; ++col)
+			{
+				buffer[dst_offset + col_offset(dst_col + col)] = src.buffer[src_offset + src.col_offset(src_col + col)];
+			}
+		}
+	}
+
+	template<typename T>
+	void RawBuffer<T>::linearize(T* dst) const
+	{
+		if (layout == MemoryLayout::kLinear)
+		{
+			memcpy(dst, buffer, width * height * sizeof(T));
+			return;
+		}
+
+		// walk tile by tile, so the source is read sequentially
+		size_t tile_size = (size_t)1 << tile_bits;
+		for (size_t tile_row = 0; tile_row < height; tile_row += tile_size)
+		{
+			for (size_t tile_col = 0; tile_col < width; tile_col += tile_size)
+			{
+				size_t row_end = tinymath::min(tile_row + tile_size, height);
+				size_t col_end = tinymath::min(tile_col + tile_size, width);
+				for (size_t row = tile_row; row < row_end; ++row)
+				{
+					size_t offset = row_offset(row);
+					for (size_t col = tile_col; col < col_end; ++col)
+					{
+						dst[row * width + col] = buffer[offset + col_offset(col)];
+					}
+				}
+			}
+		}
+	}
+
 	template<typename T>
 	void RawBuffer<T>::clear(const T& val)
 	{
-		size_t size = width * height;
-		std::fill(buffer, buffer + size, val);
+		std::fill(buffer, buffer + buffer_length, val);
+	}
+
+	template<typename T>
+	void RawBuffer<T>::clear(const T& val, size_t row, size_t col, size_t rows, size_t cols)
+	{
+		if (row >= height || col >= width)
+		{
+			return;
+		}
+
+		size_t row_end = tinymath::min(row + rows, height);
+		size_t col_end = tinymath::min(col + cols, width);
+
+		if (layout == MemoryLayout::kLinear)
+		{
+			for (size_t r = row; r < row_end; ++r)
+			{
+				std::fill(buffer + r * width + col, buffer + r * width + col_end, val);
+			}
+			return;
+		}
+
+		for (size_t r = row; r < row_end; ++r)
+		{
+			size_t offset = row_offset(r);
+			for (size_t c = col; c < col_end; ++c)
+			{
+				buffer[offset + col_offset(c)] = val;
+			}
+		}
 	}
 
 	template<typename T>
 	T* RawBuffer<T>::get_ptr(size_t& size)
 	{
-		size = (size_t)width * (size_t)height * (size_t)layer_count * sizeof(T);
+		size = buffer_length * sizeof(T);
 		return buffer;
 	}
 
 	template<typename T>
 	RawBuffer<T>& RawBuffer<T>::operator = (const RawBuffer<T>& other)
 	{
-		this->buffer_length = other.width * other.height * other.layer_count;
-		if (width == other.width && height == other.height && layer_count == other.layer_count)
+		this->layout = other.layout;
+		this->tile_bits = other.tile_bits;
+		this->tile_cols = other.tile_cols;
+		if (buffer_length == other.buffer_length)
 		{
 			// copy
 			memcpy(buffer, other.buffer, buffer_length * sizeof(T));
-			this->deletor = other.deletor;
+			this->width = other.width;
+			this->height = other.height;
+			this->layer_count = other.layer_count;
 			return *this;
 		}
 		else
 		{
-			// reallocate and copy
-			delete[] buffer;
-			buffer = new T[buffer_length];
+			// reallocate and copy, the storage is our own from now on whoever provided the old one
+			this->buffer_length = other.buffer_length;
+			if (deletor != nullptr)
+			{
+				deletor(buffer);
+			}
+			buffer = allocate(buffer_length);
+			deletor = &RawBuffer<T>::deallocate;
 			memcpy(buffer, other.buffer, buffer_length * sizeof(T));
 			this->width = other.width;
 			this->height = other.height;
 			this->layer_count = other.layer_count;
-			this->deletor = other.deletor;
+			return *this;
 		}
 	}
 
 	template<typename T>
 	RawBuffer<T>::RawBuffer(const RawBuffer<T>& other) 
 	{
-		this->buffer_length = other.width * other.height * other.layer_count;
-		buffer = new T[buffer_length];
+		this->buffer_length = other.buffer_length;
+		buffer = allocate(buffer_length);
 		memcpy(buffer, other.buffer, buffer_length * sizeof(T));
 		this->width = other.width;
 		this->height = other.height;
 		this->layer_count = other.layer_count;
-		this->deletor = other.deletor;
+		this->layout = other.layout;
+		this->tile_bits = other.tile_bits;
+		this->tile_cols = other.tile_cols;
+		// the copy always owns its allocation, even when other adopted an external buffer
+		this->deletor = &RawBuffer<T>::deallocate;
 	}
 }
\ No newline at end of file
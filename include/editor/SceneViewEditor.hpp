@@ -8,5 +8,8 @@ namespace CpuRasterizer
 	public:
 		SceneViewEditor(int x, int y, int w, int h);
 		virtual void on_gui();
+
+	private:
+		void pick(const ImVec2& mouse, const ImVec2& image_min, const ImVec2& image_size);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <unordered_map>
+#include "Define.hpp"
+#include "Singleton.hpp"
+
+#define CpuRasterAssetLoader Singleton<CpuRasterizer::AssetLoader>::get()
+
+namespace CpuRasterizer
+{
+	class Texture;
+	class CubeMap;
+	class Model;
+	class Material;
+
+	// resolves to nullptr when the asset failed to load
+	template<typename T>
+	using AssetHandle = std::shared_future<std::shared_ptr<T>>;
+
+	template<typename T>
+	inline bool is_ready(const AssetHandle<T>& handle)
+	{
+		return handle.valid() && handle.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	// loads assets on a pool of worker threads, one task per file.
+	// a model resolves once its mesh is loaded and its material initialized in update,
+	// the textures of the material are loaded in parallel and bound as they arrive, until then the material renders without them
+	class AssetLoader
+	{
+	public:
+		// one worker per hardware thread
+		AssetLoader();
+		explicit AssetLoader(size_t worker_count);
+		~AssetLoader();
+
+		AssetHandle<Model> load_model(const std::string& path);
+		AssetHandle<Texture> load_texture(const std::string& path);
+		AssetHandle<CubeMap> load_cubemap(const std::string& path);
+
+		// once per frame on the main thread while nothing renders, finishes models and binds loaded textures
+		void update();
+		size_t get_pending_count();
+		size_t get_worker_count() const { return workers.size(); }
+
+	private:
+		struct ModelResult
+		{
+			std::shared_ptr<Model> model;
+			std::vector<std::pair<property_name, AssetHandle<Texture>>> textures;
+		};
+
+		struct ModelLoad
+		{
+			std::shared_future<ModelResult> result;
+			std::promise<std::shared_ptr<Model>> model;
+		};
+
+		struct TextureBinding
+		{
+			std::weak_ptr<Material> material;
+			property_name name;
+			AssetHandle<Texture> texture;
+		};
+
+		template<typename R>
+		std::future<R> submit(std::function<R()> task);
+		void work();
+
+	private:
+		std::vector<std::thread> workers;
+		std::deque<std::function<void()>> tasks;
+		std::mutex task_mutex;
+		std::condition_variable task_ready;
+		bool stopping;
+
+		// requests come from the workers too
+		std::mutex request_mutex;
+		std::unordered_map<std::string, AssetHandle<Texture>> texture_loads;
+		std::vector<std::shared_ptr<ModelLoad>> model_loads;
+		std::vector<TextureBinding> bindings;
+	};
+}
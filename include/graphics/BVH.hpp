@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "tinymath.h"
+
+namespace CpuRasterizer
+{
+	class Renderer;
+
+	constexpr int32_t kNullProxy = -1;
+
+	// dynamic aabb tree over renderer bounds
+	// leaves keep a fattened box, so a renderer only moves in the tree once its bounds leave that box
+	class BVH
+	{
+	public:
+		BVH();
+
+		int32_t insert(Renderer* renderer, const tinymath::AxisAlignedBoundingBox& bounds);
+		void remove(int32_t proxy);
+		bool move(int32_t proxy, const tinymath::AxisAlignedBoundingBox& bounds);
+		void clear();
+		size_t size() const { return leaf_count; }
+
+		// queries append to out
+		void query(const tinymath::AxisAlignedBoundingBox& box, std::vector<Renderer*>& out) const;
+		void query(const tinymath::Frustum& frustum, std::vector<Renderer*>& out) const;
+		// renderers whose boxes the ray enters, with the distance along the ray where it enters
+		void query(const tinymath::Ray& ray, std::vector<std::pair<float, Renderer*>>& out) const;
+
+	private:
+		struct Node
+		{
+			tinymath::vec3f min;
+			tinymath::vec3f max;
+			int32_t parent; // next free node when the node is unused
+			int32_t left;
+			int32_t right;
+			int32_t height; // -1 for free nodes
+			Renderer* renderer;
+
+			bool is_leaf() const { return left == kNullProxy; }
+		};
+
+		int32_t allocate_node();
+		void free_node(int32_t node);
+		void insert_leaf(int32_t leaf);
+		void remove_leaf(int32_t leaf);
+		int32_t balance(int32_t node);
+		void refit(int32_t node);
+		void collect(int32_t node, std::vector<Renderer*>& out) const;
+
+	private:
+		std::vector<Node> nodes;
+		int32_t root;
+		int32_t free_list;
+		size_t leaf_count;
+	};
+}
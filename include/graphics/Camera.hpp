@@ -25,6 +25,7 @@ namespace CpuRasterizer
 		void initialize(const tinymath::vec3f& _position, const tinymath::FrustumParam& frustum);
 		tinymath::mat4x4 view_matrix() const;
 		const tinymath::mat4x4 projection_matrix() const;
+		tinymath::Ray viewport_point_to_ray(const tinymath::vec2f& viewport_pos) const;
 		void focus(const tinymath::vec3f& position);
 		void set_near(float _near);
 		void set_far(float _far);
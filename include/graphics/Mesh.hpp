@@ -2,20 +2,33 @@
 #include <vector>
 #include "Object.hpp"
 #include "RasterAttributes.hpp"
+#include "VertexBuffer.hpp"
+#include "tinymath.h"
 
 namespace CpuRasterizer
 {
+	constexpr size_t kMaxLODCount = 4;
+	constexpr float kLODTriangleRatio = 0.5f; // triangles kept from one level to the next
+
 	class Mesh : public Object
 	{
 	public:
-		std::vector<Vertex> vertices;
-		std::vector<size_t> indices;
+		VertexBuffer vertices;
+		IndexBuffer indices;
+		tinymath::AxisAlignedBoundingBox bounds; // local space
+		tinymath::Sphere bounding_sphere; // local space
+		std::vector<IndexBuffer> lods; // coarser index lists over the same vertices, lods[0] is level 1
 
 	public:
 		Mesh();
 		Mesh(const Mesh& other);
-		Mesh(const std::vector<Vertex>& _vertices, const std::vector<size_t>& _indices);
+		Mesh(const std::vector<Vertex>& _vertices, const std::vector<size_t>& _indices, const VertexLayout& layout = VertexLayout::standard());
 		~Mesh();
 		Mesh& operator= (const Mesh& other);
+		void compute_bounds();
+		void generate_lods(size_t max_lod_count);
+		size_t lod_count() const { return lods.size() + 1; }
+		size_t byte_size() const;
+		const IndexBuffer& lod_indices(size_t lod) const { return lod == 0 ? indices : lods[lod - 1]; }
 	};
 }
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "Mesh.hpp"
+
+namespace CpuRasterizer
+{
+	constexpr uint32_t kMeshCacheMagic = 0x48534d43; // "CMSH"
+	constexpr uint32_t kMeshCacheVersion = 1; // bump whenever the importer output or the layout below changes
+	constexpr size_t kMeshCacheAlignment = 16; // every stream starts on this boundary
+
+	// file layout, little endian:
+	// MeshCacheHeader, MeshCacheEntry[mesh_count], MeshCacheLOD[] for all meshes, then the aligned streams.
+	// offsets are from the start of the file so the streams can be used in place from a mapping
+	struct MeshCacheHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t mesh_count;
+		uint32_t reserved;
+	};
+
+	struct MeshCacheEntry
+	{
+		uint8_t vertex_formats[kVertexAttributeCount];
+		uint8_t index_format;
+		uint8_t padding[2];
+		uint32_t vertex_stride;
+		uint32_t lod_count; // levels after the full index list
+		uint64_t vertex_count;
+		uint64_t vertex_offset;
+		uint64_t index_count;
+		uint64_t index_offset;
+		uint64_t lod_offset; // first MeshCacheLOD of this mesh
+		uint64_t meshlet_count; // reserved, meshes are not split into meshlets yet
+		uint64_t meshlet_offset;
+		float bounds_min[3];
+		float bounds_max[3];
+		float sphere[4]; // center, radius
+	};
+
+	struct MeshCacheLOD
+	{
+		uint8_t index_format;
+		uint8_t padding[7];
+		uint64_t index_count;
+		uint64_t index_offset;
+	};
+
+	static_assert(sizeof(MeshCacheHeader) == 16, "mesh cache header layout changed");
+	static_assert(sizeof(MeshCacheEntry) == 112, "mesh cache entry layout changed");
+	static_assert(sizeof(MeshCacheLOD) == 24, "mesh cache lod layout changed");
+
+	// binary container for imported meshes, loaded meshes reference the mapped file instead of copying it
+	class MeshCache
+	{
+	public:
+		static bool save(const std::string& path, const std::vector<Mesh>& meshes);
+		// false for missing, outdated or malformed files, meshes is left untouched then
+		static bool load(const std::string& path, std::vector<Mesh>& meshes);
+	};
+}
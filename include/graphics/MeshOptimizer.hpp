@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+#include "RasterAttributes.hpp"
+
+namespace CpuRasterizer
+{
+	constexpr size_t kVertexCacheSize = 16; // fifo cache the acmr is measured against
+	constexpr float kOverdrawThreshold = 1.05f; // acmr a cluster may lose so the clusters can be reordered for overdraw
+
+	// import time reordering, the passes keep the mesh drawing the same triangles
+	class MeshOptimizer
+	{
+	public:
+		// all passes in order, logs acmr and overdraw before and after
+		static void optimize(std::vector<Vertex>& vertices, std::vector<size_t>& indices);
+
+		// index of the first bitwise identical vertex for every vertex, tangents can be left out of the comparison
+		static std::vector<size_t> generate_vertex_remap(const std::vector<Vertex>& vertices, bool match_tangents);
+		// triangle order for post transform cache hits, forsyth's linear speed algorithm
+		static void optimize_vertex_cache(std::vector<size_t>& indices, size_t vertex_count);
+		// reorders the clusters of a cache optimized list so outward facing ones are drawn first
+		static void optimize_overdraw(std::vector<size_t>& indices, const std::vector<Vertex>& vertices, float threshold);
+		// vertices in the order the indices first reach them, unused ones are dropped
+		static void optimize_vertex_fetch(std::vector<Vertex>& vertices, std::vector<size_t>& indices);
+
+		// average cache misses per triangle
+		static float analyze_vertex_cache(const std::vector<size_t>& indices, size_t vertex_count, size_t cache_size);
+		// shaded pixels over covered pixels, averaged over the six axis views
+		static float analyze_overdraw(const std::vector<size_t>& indices, const std::vector<Vertex>& vertices);
+	};
+}
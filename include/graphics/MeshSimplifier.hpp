@@ -0,0 +1,15 @@
+#pragma once
+#include <vector>
+#include "RasterAttributes.hpp"
+
+namespace CpuRasterizer
+{
+	// quadric error edge collapse, vertices are only ever collapsed onto their neighbours
+	// so the simplified indices stay valid for the original vertex buffer
+	class MeshSimplifier
+	{
+	public:
+		// error is the largest collapse cost, a squared object space distance
+		static std::vector<size_t> simplify(const std::vector<Vertex>& vertices, const std::vector<size_t>& indices, size_t target_index_count, float& error);
+	};
+}
@@ -27,6 +27,10 @@ namespace CpuRasterizer
 		std::string raw_path;
 		std::string meta_path;
 		bool flip_uv;
+		tinymath::AxisAlignedBoundingBox bounds; // local space, all meshes
+		tinymath::Sphere bounding_sphere;
+		bool occluder; // rasterized into the occlusion buffer
+		std::shared_ptr<Mesh> occluder_mesh; // simplified proxy for the occlusion buffer, the meshes are used when null
 
 	public:
 		Model();
@@ -36,6 +40,10 @@ namespace CpuRasterizer
 		void load_raw(std::string path, bool flip_uv);
 		const Transform* get_transform() const;
 		void set_transform(Transform* _transform);
+		void compute_bounds();
+		void generate_lods();
+		size_t lod_count() const;
+		size_t byte_size() const; // packed vertex and index data of all meshes
 
 		Model& operator= (const Model& other);
 		static std::shared_ptr<Model> load_raw(const std::vector<Vertex>& vertices, const std::vector<size_t>& indices, std::shared_ptr<Material> material);
@@ -43,6 +51,8 @@ namespace CpuRasterizer
 	private:
 		Model(const std::vector<Vertex>& vertices, const std::vector<size_t>& indices, std::shared_ptr<Material> material);
 		void load_vertices(aiMesh* ai_mesh);
+		bool load_cache(const std::string& path, bool flip);
+		static std::string cache_path(const std::string& path, bool flip);
 		void reload_mesh(aiNode* node, const aiScene* Scene);	
 	};
 }
\ No newline at end of file
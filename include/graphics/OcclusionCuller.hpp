@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "tinymath.h"
+
+namespace CpuRasterizer
+{
+	class Mesh;
+
+	constexpr size_t kOcclusionBufferWidth = 256;
+
+	// occluders are rasterized into a small depth buffer, each covered pixel keeps the farthest depth the occluder
+	// reaches inside it. anything whose screen bounds lie behind the buffer everywhere is hidden
+	class OcclusionCuller
+	{
+	public:
+		OcclusionCuller();
+		OcclusionCuller(size_t width, size_t height);
+
+		void resize(size_t width, size_t height);
+		void begin(const tinymath::mat4x4& view_projection);
+		void rasterize_occluder(const Mesh& mesh, const tinymath::mat4x4& model);
+		bool is_occluded(const tinymath::AxisAlignedBoundingBox& world_bounds) const;
+
+		size_t get_width() const { return width; }
+		size_t get_height() const { return height; }
+		const std::vector<float>& get_depth_buffer() const { return depth; }
+
+	private:
+		void rasterize_triangle(const tinymath::vec4f& c0, const tinymath::vec4f& c1, const tinymath::vec4f& c2);
+		tinymath::vec3f to_screen(const tinymath::vec4f& clip) const;
+
+	private:
+		size_t width;
+		size_t height;
+		tinymath::mat4x4 view_projection;
+		std::vector<float> depth;
+	};
+}
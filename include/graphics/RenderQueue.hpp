@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "tinymath.h"
+
+namespace CpuRasterizer
+{
+	class Renderer;
+
+	// draw order of a list of renderers, sorted by one 64-bit key per draw
+	// opaque:      queue(16) | pass(1) | shader(12) | material(11) | depth(24), front to back within a material
+	// transparent: queue(16) | pass(1) | depth(24) | shader(12) | material(11), back to front
+	class RenderQueue
+	{
+	public:
+		RenderQueue(bool transparent);
+
+		// rebuilds the keys and sorts again only when they changed since the last call
+		const std::vector<uint32_t>& sort(const std::vector<Renderer*>& renderers, const tinymath::mat4x4& view, float z_near, float z_far);
+		const std::vector<uint32_t>& get_order() const { return order; }
+
+		static uint64_t make_key(int32_t render_queue, bool transparent, uint64_t shader_id, uint64_t material_id, float view_depth, float z_near, float z_far);
+
+	private:
+		void radix_sort();
+
+	private:
+		bool transparent;
+		std::vector<uint64_t> keys;
+		std::vector<uint64_t> sorted_keys;
+		std::vector<uint64_t> sort_keys;
+		std::vector<uint64_t> key_scratch;
+		std::vector<uint32_t> order;
+		std::vector<uint32_t> order_scratch;
+	};
+}
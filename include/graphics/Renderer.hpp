@@ -11,10 +11,15 @@ namespace CpuRasterizer
 {
 	class Model;
 
+	constexpr float kLODScreenSize = 0.5f; // projected radius over half the screen height where level 1 starts, halves per level
+	constexpr float kLODHysteresis = 0.1f; // a level is only left once the size is this far past its threshold
+
 	class Renderer : public Object
 	{
 	public:
 		std::shared_ptr<Model> target;
+		int32_t bvh_proxy; // leaf in the scene bvh, -1 when not in a tree
+		size_t lod; // level drawn in the object pass
 
 	public:
 		Renderer();
@@ -26,6 +31,9 @@ namespace CpuRasterizer
 		virtual tinymath::mat4x4 view_matrix(RenderPass render_pass) const;
 		virtual tinymath::mat4x4 projection_matrix(RenderPass render_pass) const;
 		virtual tinymath::mat4x4 model_matrix() const;
+		virtual bool frustum_culling(const tinymath::Frustum& frustum) const;
+		virtual bool raycast(const tinymath::Ray& ray, float& distance) const;
+		void update_lod(const tinymath::vec3f& camera_pos, float projection_scale);
 		virtual void render_shadow() const;
 		virtual void render() const;
 		virtual void before_render() const {};
@@ -39,7 +47,7 @@ namespace CpuRasterizer
 
 	protected:
 		std::vector<size_t> vertex_buffer_ids;
-		std::vector<size_t> index_buffer_ids;
+		std::vector<std::vector<size_t>> index_buffer_ids; // per mesh, one per lod
 
 	protected:
 		bool gizmos;
@@ -3,6 +3,8 @@
 #include <vector>
 #include <memory>
 #include "Define.hpp"
+#include "tinymath.h"
+#include "AssetLoader.hpp"
 
 namespace CpuRasterizer
 {
@@ -14,6 +16,17 @@ namespace CpuRasterizer
 	class Transform;
 	class Model;
 	class CubeMap;
+	class RenderQueue;
+	class BVH;
+	class OcclusionCuller;
+
+	// a model that joins the scene with its transform once it has loaded
+	struct PendingModel
+	{
+		std::string path;
+		AssetHandle<Model> model;
+		std::unique_ptr<Transform> transform;
+	};
 
 	class Scene
 	{
@@ -33,6 +46,11 @@ namespace CpuRasterizer
 		std::unique_ptr<SkyboxRenderer> skybox;
 		std::shared_ptr<CubeMap> cubemap;
 
+		// still loading, saved with the scene by their meta paths
+		std::vector<PendingModel> pending_models;
+		AssetHandle<CubeMap> pending_cubemap;
+		std::string pending_cubemap_path;
+
 		// cam
 		std::unique_ptr<Camera> main_cam;
 
@@ -52,6 +70,8 @@ namespace CpuRasterizer
 		~Scene();
 		void initialize();
 		void add(std::shared_ptr<Model> model);
+		// loads the model asynchronously, it joins the scene with this transform once it has loaded
+		void add(const std::string& path, Transform* transform);
 		void update();
 		void set_main_light(const DirectionalLight& light);
 		void add_point_light(const PointLight& light);
@@ -62,13 +82,33 @@ namespace CpuRasterizer
 		void debug_scene();
 		void resize_shadowmap(size_t w, size_t h);
 		void get_shadowmap_size(size_t& w, size_t& h);
+		// the current cubemap stays until the new one has loaded
 		void set_cubemap(std::string path);
 		std::string get_asset_path() { return asset_path; }
 		static Scene* current() { return current_scene; }
 		static void open_scene(const char* path);
 
+		// spatial queries, served by the scene bvh
+		Renderer* pick(const tinymath::Ray& ray, float& distance);
+		void query(const tinymath::AxisAlignedBoundingBox& box, std::vector<Renderer*>& out);
+
+	private:
+		void update_bvh();
+		void frustum_culling();
+		void occlusion_culling();
+		void select_lods();
+		void add_loaded_assets();
+
 	private:
 		resource_id shadowmap_id;
+		std::unique_ptr<BVH> opaque_bvh;
+		std::unique_ptr<BVH> transparent_bvh;
+		std::unique_ptr<OcclusionCuller> occlusion_culler;
+		std::vector<Renderer*> visible_objects;
+		std::vector<Renderer*> visible_transparent_objects;
+		std::vector<Renderer*> visible_shadow_casters;
+		std::unique_ptr<RenderQueue> opaque_queue;
+		std::unique_ptr<RenderQueue> transparent_queue;
 		static Scene* current_scene;
 	};
 }
\ No newline at end of file
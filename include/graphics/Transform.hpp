@@ -15,12 +15,17 @@ namespace CpuRasterizer
 		tinymath::vec3f local_rotation;
 		tinymath::vec3f local_scale;
 		tinymath::mat4x4 world_trs;
+		tinymath::AxisAlignedBoundingBox world_bounds; // bounds of the model, follows world_trs
+		tinymath::Sphere world_sphere;
+		bool world_bounds_dirty; // set whenever the world bounds change, cleared by the scene bvh
 		tinymath::vec3f rotation_axis;
 		float rotation_angle;
 		bool selected;
 
 	private:
 		Model* model; 
+		tinymath::AxisAlignedBoundingBox local_bounds;
+		tinymath::Sphere local_sphere;
 		Transform* parent;
 		std::vector<Transform*> children;
 
@@ -57,6 +62,8 @@ namespace CpuRasterizer
 		void rotate(const tinymath::vec3f& _axis, float angle);
 		void rotate_self(float yaw_offset, float pitch_offset, float roll_offset);
 		void sync();
+		void set_local_bounds(const tinymath::AxisAlignedBoundingBox& bounds, const tinymath::Sphere& sphere);
+		void update_world_bounds();
 		Transform* access_child(size_t index) const { return children[index]; }
 		size_t child_count() const { return children.size(); }
 		Transform& operator =(const Transform& other);
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// one mutex per key, e.g. per cache file, so work on the same key is serialized across threads
+class KeyedMutex
+{
+private:
+	std::unordered_map<std::string, std::unique_ptr<std::mutex>> key2mutex;
+	std::mutex map_mutex;
+
+public:
+	// the mutex lives as long as the KeyedMutex
+	std::mutex& get(const std::string& key)
+	{
+		std::lock_guard<std::mutex> lock(map_mutex);
+		auto& mutex = key2mutex[key];
+		if (mutex == nullptr)
+		{
+			mutex = std::make_unique<std::mutex>();
+		}
+		return *mutex;
+	}
+};
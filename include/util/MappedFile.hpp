@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <stdint.h>
+
+// read only view of a whole file, unmapped when the last reference goes away
+class MappedFile
+{
+public:
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// nullptr when the file cannot be opened or is empty.
+	// copy on write views can be written, touched pages become private copies and the file never changes
+	static std::shared_ptr<MappedFile> open(const std::string& path, bool copy_on_write = false);
+
+	const uint8_t* data() const { return view; }
+	uint8_t* writable_data() const { return writable ? view : nullptr; }
+	size_t size() const { return length; }
+
+private:
+	MappedFile();
+
+	uint8_t* view;
+	size_t length;
+	bool writable;
+#if (defined(WIN32) || defined(_WIN32))
+	void* file_handle;
+	void* mapping_handle;
+#endif
+};
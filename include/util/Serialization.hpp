@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 #include <filesystem>
+#include <mutex>
 #include "rapidjson/document.h"
 #include "rapidjson/prettywriter.h"
 #include "rapidjson/stringbuffer.h"
@@ -227,6 +228,7 @@ namespace CpuRasterizer
 			Serializer::deserialize(v["local_rotation"].GetObject(), t.local_rotation);
 			Serializer::deserialize(v["local_scale"].GetObject(), t.local_scale);
 			Serializer::deserialize(v["world_trs"].GetObject(), t.world_trs);
+			t.update_world_bounds();
 			Serializer::deserialize(v["rotation_axis"].GetObject(), t.rotation_axis);
 			t.rotation_angle = v["rotation_angle"].GetFloat();
 			const rapidjson::Value& children_objs = v["children"].GetArray();
@@ -340,6 +342,9 @@ namespace CpuRasterizer
 			doc.AddMember("height", (uint32_t)tex.height, doc.GetAllocator());
 			doc.AddMember("mip_count", (uint32_t)tex.mip_count, doc.GetAllocator());
 			doc.AddMember("enable_mip", (int32_t)tex.enable_mip, doc.GetAllocator());
+			doc.AddMember("compression", tex.enable_compression, doc.GetAllocator());
+			doc.AddMember("streaming", tex.enable_streaming, doc.GetAllocator());
+			doc.AddMember("srgb", tex.srgb, doc.GetAllocator());
 
 			std::filesystem::path abs_path(ASSETS_PATH + path);
 			if (!std::filesystem::exists(abs_path.parent_path()))
@@ -387,6 +392,10 @@ namespace CpuRasterizer
 				tex.mip_count = doc["mip_count"].GetUint();
 				//tex.enable_mip = doc["enable_mip"].GetBool();
 				tex.enable_mip = true; // force enable mip, todo: serialize it
+				tex.layout = CpuRasterSharedData.texture_layout;
+				tex.srgb = doc.HasMember("srgb") && doc["srgb"].GetBool();
+				tex.enable_compression = doc.HasMember("compression") ? doc["compression"].GetBool() : CpuRasterSharedData.texture_compression;
+				tex.enable_streaming = doc.HasMember("streaming") ? doc["streaming"].GetBool() : CpuRasterSharedData.texture_streaming;
 				tex.reload(tex.raw_path.c_str());
 			
 				LOG("read textures: {}", path.c_str());
@@ -521,7 +530,8 @@ namespace CpuRasterizer
 			doc.AddMember("name2tex", name2tex, doc.GetAllocator());
 		}
 
-		static void deserialize(rapidjson::Document& doc, ShaderPropertyMap& properties)
+		// textures go to deferred_textures instead of being loaded when it is set
+		static void deserialize(rapidjson::Document& doc, ShaderPropertyMap& properties, std::vector<std::pair<property_name, std::string>>* deferred_textures = nullptr)
 		{
 			rapidjson::Value name2int, name2float, name2float4, name2tex;
 			name2int = doc["name2int"].GetArray();
@@ -551,6 +561,11 @@ namespace CpuRasterizer
 			{
 				const rapidjson::Value& pair = name2tex[idx].GetArray();
 				const char* tex_path = pair[1].GetString();
+				if (deferred_textures != nullptr)
+				{
+					deferred_textures->emplace_back(pair[0].GetUint(), tex_path);
+					continue;
+				}
 				properties.name2tex[pair[0].GetUint()] = Texture::load_asset(tex_path);
 			}
 		}
@@ -614,7 +629,9 @@ namespace CpuRasterizer
 			}
 		}
 
-		static void deserialize(std::string path, Material& material)
+		// with deferred_textures set nothing touches the device, so it can run on a worker.
+		// the caller binds the textures and calls material.initialize on the main thread
+		static void deserialize(std::string path, Material& material, std::vector<std::pair<property_name, std::string>>* deferred_textures = nullptr)
 		{
 			std::filesystem::path abs_path(ASSETS_PATH + path);
 			std::FILE* fd = fopen(abs_path.string().c_str(), "r");
@@ -659,8 +676,11 @@ namespace CpuRasterizer
 				material.material_name = doc["material_name"].GetString();
 				material.meta_path = doc["meta_path"].GetString();
 				material.target_shader = ShaderLab::get_shader(doc["target_shader"].GetString());
-				deserialize(doc, material.local_properties);
-				material.initialize();
+				deserialize(doc, material.local_properties, deferred_textures);
+				if (deferred_textures == nullptr)
+				{
+					material.initialize();
+				}
 
 				fclose(fd);
 			}
@@ -708,20 +728,34 @@ namespace CpuRasterizer
 
 			rapidjson::Value indices;
 			indices.SetArray();
-			for (auto& i : mesh.indices)
+			for (size_t idx = 0; idx < mesh.indices.size(); ++idx)
 			{
-				indices.PushBack(i, doc.GetAllocator());
+				indices.PushBack(mesh.indices[idx], doc.GetAllocator());
 			}
 
 			rapidjson::Value vertices;
 			vertices.SetArray();
-			for (auto& vert : mesh.vertices)
+			for (size_t idx = 0; idx < mesh.vertices.size(); ++idx)
 			{
-				vertices.PushBack(Serializer::serialize(doc, vert), doc.GetAllocator());
+				vertices.PushBack(Serializer::serialize(doc, mesh.vertices[idx]), doc.GetAllocator());
+			}
+
+			rapidjson::Value lods;
+			lods.SetArray();
+			for (auto& lod : mesh.lods)
+			{
+				rapidjson::Value lod_indices;
+				lod_indices.SetArray();
+				for (size_t idx = 0; idx < lod.size(); ++idx)
+				{
+					lod_indices.PushBack(lod[idx], doc.GetAllocator());
+				}
+				lods.PushBack(lod_indices, doc.GetAllocator());
 			}
 
 			v.AddMember("indices", indices, doc.GetAllocator());
 			v.AddMember("vertices", vertices, doc.GetAllocator());
+			v.AddMember("lods", lods, doc.GetAllocator());
 
 			return v;
 		}
@@ -731,21 +765,41 @@ namespace CpuRasterizer
 			auto indices_array = v["indices"].GetArray();
 			auto vertices_array = v["vertices"].GetArray();
 
-			mesh.indices.clear();
-			mesh.vertices.clear();
-			mesh.indices.reserve(indices_array.Size());
-			mesh.vertices.reserve(vertices_array.Size());
+			std::vector<size_t> indices;
+			std::vector<Vertex> vertices;
+			indices.reserve(indices_array.Size());
+			vertices.reserve(vertices_array.Size());
 
 			for (rapidjson::SizeType idx = 0; idx < indices_array.Size(); idx++)
 			{
-				mesh.indices.emplace_back(indices_array[idx].GetUint());
+				indices.emplace_back(indices_array[idx].GetUint());
 			}
 
 			for (rapidjson::SizeType idx = 0; idx < vertices_array.Size(); idx++)
 			{
 				Vertex vertex;
 				Serializer::deserialize(vertices_array[idx].GetObject(), vertex);
-				mesh.vertices.emplace_back(vertex);
+				vertices.emplace_back(vertex);
+			}
+
+			// packed with the default layout, which also computes the bounds
+			mesh = Mesh(vertices, indices);
+
+			mesh.lods.clear();
+			if (v.HasMember("lods"))
+			{
+				auto lods_array = v["lods"].GetArray();
+				for (rapidjson::SizeType lod = 0; lod < lods_array.Size(); lod++)
+				{
+					std::vector<size_t> lod_indices;
+					auto lod_array = lods_array[lod].GetArray();
+					lod_indices.reserve(lod_array.Size());
+					for (rapidjson::SizeType idx = 0; idx < lod_array.Size(); idx++)
+					{
+						lod_indices.emplace_back(lod_array[idx].GetUint());
+					}
+					mesh.lods.emplace_back(IndexBuffer(lod_indices));
+				}
 			}
 		}
 		// Mesh
@@ -796,6 +850,7 @@ namespace CpuRasterizer
 			doc.AddMember("transform", Serializer::serialize(doc, *model.transform), doc.GetAllocator());
 
 			doc.AddMember("flip_uv", model.flip_uv, doc.GetAllocator());
+			doc.AddMember("occluder", model.occluder, doc.GetAllocator());
 
 			std::filesystem::path abs_path(ASSETS_PATH + path);
 			if (!std::filesystem::exists(abs_path.parent_path()))
@@ -818,10 +873,11 @@ namespace CpuRasterizer
 			}
 		}
 
-		static void deserialize(std::string path, Model& model)
+		static void deserialize(std::string path, Model& model, std::vector<std::pair<property_name, std::string>>* deferred_textures = nullptr)
 		{
 			static std::vector<int> free_names;
 			static int current_name;
+			static std::mutex name_mutex;
 			std::FILE* fd = fopen((ASSETS_PATH + path).c_str(), "r");
 			if (fd != nullptr)
 			{
@@ -834,6 +890,8 @@ namespace CpuRasterizer
 				model.name = doc["name"].GetString();
 				if (model.name == "")
 				{
+					// models are deserialized on the asset loader workers
+					std::lock_guard<std::mutex> lock(name_mutex);
 					if (free_names.size() > 0)
 					{
 						int num = free_names.back();
@@ -848,6 +906,7 @@ namespace CpuRasterizer
 				model.raw_path = doc["raw_path"].GetString();
 				model.meta_path = doc["meta_path"].GetString();
 				model.flip_uv = doc["flip_uv"].GetBool();
+				model.occluder = doc.HasMember("occluder") && doc["occluder"].GetBool();
 				std::string material_path = doc["material"].GetString();
 
 				if (model.raw_path != "")
@@ -868,7 +927,7 @@ namespace CpuRasterizer
 				if (material_path != "")
 				{
 					Material* mat = new Material();
-					Serializer::deserialize(material_path, *mat);
+					Serializer::deserialize(material_path, *mat, deferred_textures);
 					model.material = std::shared_ptr<Material>(mat);
 				}
 				else
@@ -882,6 +941,7 @@ namespace CpuRasterizer
 				model.transform->name = model.name;
 
 				model.transform->set_model(&model);
+				model.compute_bounds();
 			}
 			else
 			{
@@ -1026,6 +1086,23 @@ namespace CpuRasterizer
 				models.PushBack(model_instance, doc.GetAllocator());
 			}
 
+			for (auto& pending : scene.pending_models)
+			{
+				rapidjson::Value meta_path;
+				meta_path.SetString(pending.path.c_str(), doc.GetAllocator());
+
+				rapidjson::Value transform;
+				transform = serialize(doc, *pending.transform.get());
+
+				rapidjson::Value model_instance;
+				model_instance.SetArray();
+
+				model_instance.PushBack(meta_path, doc.GetAllocator());
+				model_instance.PushBack(transform, doc.GetAllocator());
+
+				models.PushBack(model_instance, doc.GetAllocator());
+			}
+
 			doc.AddMember("models", models, doc.GetAllocator());
 			doc.AddMember("enable_ibl", scene.enable_skybox, doc.GetAllocator());
 			doc.AddMember("enable_shadow", scene.enable_shadow, doc.GetAllocator());
@@ -1034,10 +1111,12 @@ namespace CpuRasterizer
 			doc.AddMember("color_space", (int32_t)scene.color_space, doc.GetAllocator());
 			doc.AddMember("work_flow", (int32_t)scene.work_flow, doc.GetAllocator());
 
-			if (scene.cubemap != nullptr)
+			// a cubemap still loading replaces the current one
+			std::string hdri_path = scene.pending_cubemap.valid() ? scene.pending_cubemap_path : (scene.cubemap != nullptr ? scene.cubemap->meta_path : "");
+			if (hdri_path != "")
 			{
 				rapidjson::Value cubemap_path;
-				cubemap_path.SetString(scene.cubemap->meta_path.c_str(), doc.GetAllocator());
+				cubemap_path.SetString(hdri_path.c_str(), doc.GetAllocator());
 				doc.AddMember("hdri_path", cubemap_path, doc.GetAllocator());
 			}
 
@@ -1108,16 +1187,12 @@ namespace CpuRasterizer
 					rapidjson::Value model_transform = pair[1].GetObject();
 					Transform* transform = new Transform();
 					deserialize(model_transform, *transform);
-					Model* model = new Model();
-					Serializer::deserialize(model_path, *model);
-					model->set_transform(transform);
-					scene.add(std::shared_ptr<Model>(model));
+					scene.add(model_path, transform);
 				}
 
-				const char* cubemap_path = doc["hdri_path"].GetString();
-				if (cubemap_path != nullptr)
+				if (doc.HasMember("hdri_path"))
 				{
-					scene.cubemap = std::shared_ptr<CubeMap>(new CubeMap(cubemap_path));
+					scene.set_cubemap(doc["hdri_path"].GetString());
 				}
 
 				scene.enable_skybox = doc["enable_ibl"].GetBool();
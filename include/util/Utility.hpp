@@ -22,10 +22,23 @@ namespace CpuRasterizer {
 #endif
 		return replace(ret, "\\", "/");
 	}
+
+	// a cache file is used while it is at least as new as its source, a missing source keeps it valid
+	static bool is_cache_current(const std::string& source_path, const std::string& cache_path) {
+		std::error_code error;
+		if (!std::filesystem::exists(cache_path, error)) {
+			return false;
+		}
+		if (!std::filesystem::exists(source_path, error)) {
+			return true;
+		}
+		return std::filesystem::last_write_time(source_path, error) <= std::filesystem::last_write_time(cache_path, error);
+	}
 #pragma warning(pop)
 
 
 #define APP_PATH cur_path()
 #define RES_PATH (APP_PATH + "/res/raw")
 #define ASSETS_PATH (APP_PATH + "/res/assets")
+#define CACHE_PATH (APP_PATH + "/res/cache")
 }
\ No newline at end of file
@@ -322,10 +322,400 @@ function setupLightingProject()
       targetdir (solution_dir .. "/bin/release")
 end
 
+function setupFillRuleProject()
+   project "FillRule"
+   kind "ConsoleApp"
+   language "C++"
+
+   files { 
+      src_dir .. "/*.*", 
+      src_dir .. "/util/*.*",
+      src_dir .. "/core/*.*",
+      src_dir .. "/graphics/*.*",
+      src_dir .. "/editor/*.*",
+      include_dir .. "/*.*", 
+      include_dir .. "/detail/*.*", 
+      include_dir .. "/util/*.*",
+      include_dir .. "/util/detail/*.*",
+      include_dir .. "/core/*.*",
+      include_dir .. "/graphics/*.*",
+      include_dir .. "/core/detail/*.*",
+      include_dir .. "/editor/*.*",
+      shader_dir  .. "/*.*",
+      third_party_dir .. "/*.*",
+      third_party_dir .. "/assimp/*.*",
+      third_party_dir .. "/stb_image/*.*",
+      third_party_dir .. "/rapidjson/*.*",
+      third_party_dir .. "/imgui/*.*",
+      third_party_dir .. "/imgui/backends/*.*",
+      third_party_dir .. "/gl3w/GL/*.*",
+      third_party_dir .. "/glfw/GLFW/*.*",
+      third_party_dir .. "/tinymath/*.*",
+      third_party_dir .. "/tinymath/detail/*.*",
+      third_party_dir .. "/tinymath/primitives/*.*",
+      third_party_dir .. "/tinymath/color/*.*",
+      sample_dir .. "/FillRule/FillRule.cpp",
+      sample_dir .. "/FillRule/FillRuleShader.hpp"
+   }
+
+   filter { "configurations:Debug*" }
+      targetdir (solution_dir .. "/bin/Debug")
+
+   filter { "configurations:Release*" }
+      targetdir (solution_dir .. "/bin/release")
+end
+
+function setupFrameBufferLayoutProject()
+   project "FrameBufferLayout"
+   kind "ConsoleApp"
+   language "C++"
+
+   files { 
+      src_dir .. "/*.*", 
+      src_dir .. "/util/*.*",
+      src_dir .. "/core/*.*",
+      src_dir .. "/graphics/*.*",
+      src_dir .. "/editor/*.*",
+      include_dir .. "/*.*", 
+      include_dir .. "/detail/*.*", 
+      include_dir .. "/util/*.*",
+      include_dir .. "/util/detail/*.*",
+      include_dir .. "/core/*.*",
+      include_dir .. "/graphics/*.*",
+      include_dir .. "/core/detail/*.*",
+      include_dir .. "/editor/*.*",
+      shader_dir  .. "/*.*",
+      third_party_dir .. "/*.*",
+      third_party_dir .. "/assimp/*.*",
+      third_party_dir .. "/stb_image/*.*",
+      third_party_dir .. "/rapidjson/*.*",
+      third_party_dir .. "/imgui/*.*",
+      third_party_dir .. "/imgui/backends/*.*",
+      third_party_dir .. "/gl3w/GL/*.*",
+      third_party_dir .. "/glfw/GLFW/*.*",
+      third_party_dir .. "/tinymath/*.*",
+      third_party_dir .. "/tinymath/detail/*.*",
+      third_party_dir .. "/tinymath/primitives/*.*",
+      third_party_dir .. "/tinymath/color/*.*",
+      sample_dir .. "/FrameBufferLayout/FrameBufferLayout.cpp",
+      sample_dir .. "/FrameBufferLayout/FrameBufferLayoutShader.hpp"
+   }
+
+   filter { "configurations:Debug*" }
+      targetdir (solution_dir .. "/bin/Debug")
+
+   filter { "configurations:Release*" }
+      targetdir (solution_dir .. "/bin/release")
+end
+
+function setupAntiAliasingProject()
+   project "AntiAliasing"
+   kind "ConsoleApp"
+   language "C++"
+
+   files { 
+      src_dir .. "/*.*", 
+      src_dir .. "/util/*.*",
+      src_dir .. "/core/*.*",
+      src_dir .. "/graphics/*.*",
+      src_dir .. "/editor/*.*",
+      include_dir .. "/*.*", 
+      include_dir .. "/detail/*.*", 
+      include_dir .. "/util/*.*",
+      include_dir .. "/util/detail/*.*",
+      include_dir .. "/core/*.*",
+      include_dir .. "/graphics/*.*",
+      include_dir .. "/core/detail/*.*",
+      include_dir .. "/editor/*.*",
+      shader_dir  .. "/*.*",
+      third_party_dir .. "/*.*",
+      third_party_dir .. "/assimp/*.*",
+      third_party_dir .. "/stb_image/*.*",
+      third_party_dir .. "/rapidjson/*.*",
+      third_party_dir .. "/imgui/*.*",
+      third_party_dir .. "/imgui/backends/*.*",
+      third_party_dir .. "/gl3w/GL/*.*",
+      third_party_dir .. "/glfw/GLFW/*.*",
+      third_party_dir .. "/tinymath/*.*",
+      third_party_dir .. "/tinymath/detail/*.*",
+      third_party_dir .. "/tinymath/primitives/*.*",
+      third_party_dir .. "/tinymath/color/*.*",
+      sample_dir .. "/AntiAliasing/AntiAliasing.cpp",
+      sample_dir .. "/AntiAliasing/AntiAliasingShader.hpp"
+   }
+
+   filter { "configurations:Debug*" }
+      targetdir (solution_dir .. "/bin/Debug")
+
+   filter { "configurations:Release*" }
+      targetdir (solution_dir .. "/bin/release")
+end
+
+function setupOcclusionCullingProject()
+   project "OcclusionCulling"
+   kind "ConsoleApp"
+   language "C++"
+
+   files { 
+      src_dir .. "/*.*", 
+      src_dir .. "/util/*.*",
+      src_dir .. "/core/*.*",
+      src_dir .. "/graphics/*.*",
+      src_dir .. "/editor/*.*",
+      include_dir .. "/*.*", 
+      include_dir .. "/detail/*.*", 
+      include_dir .. "/util/*.*",
+      include_dir .. "/util/detail/*.*",
+      include_dir .. "/core/*.*",
+      include_dir .. "/graphics/*.*",
+      include_dir .. "/core/detail/*.*",
+      include_dir .. "/editor/*.*",
+      shader_dir  .. "/*.*",
+      third_party_dir .. "/*.*",
+      third_party_dir .. "/assimp/*.*",
+      third_party_dir .. "/stb_image/*.*",
+      third_party_dir .. "/rapidjson/*.*",
+      third_party_dir .. "/imgui/*.*",
+      third_party_dir .. "/imgui/backends/*.*",
+      third_party_dir .. "/gl3w/GL/*.*",
+      third_party_dir .. "/glfw/GLFW/*.*",
+      third_party_dir .. "/tinymath/*.*",
+      third_party_dir .. "/tinymath/detail/*.*",
+      third_party_dir .. "/tinymath/primitives/*.*",
+      third_party_dir .. "/tinymath/color/*.*",
+      sample_dir .. "/OcclusionCulling/OcclusionCulling.cpp"
+   }
+
+   filter { "configurations:Debug*" }
+      targetdir (solution_dir .. "/bin/Debug")
+
+   filter { "configurations:Release*" }
+      targetdir (solution_dir .. "/bin/release")
+end
+
+function setupVertexFormatsProject()
+   project "VertexFormats"
+   kind "ConsoleApp"
+   language "C++"
+
+   files { 
+      src_dir .. "/*.*", 
+      src_dir .. "/util/*.*",
+      src_dir .. "/core/*.*",
+      src_dir .. "/graphics/*.*",
+      src_dir .. "/editor/*.*",
+      include_dir .. "/*.*", 
+      include_dir .. "/detail/*.*", 
+      include_dir .. "/util/*.*",
+      include_dir .. "/util/detail/*.*",
+      include_dir .. "/core/*.*",
+      include_dir .. "/graphics/*.*",
+      include_dir .. "/core/detail/*.*",
+      include_dir .. "/editor/*.*",
+      shader_dir  .. "/*.*",
+      third_party_dir .. "/*.*",
+      third_party_dir .. "/assimp/*.*",
+      third_party_dir .. "/stb_image/*.*",
+      third_party_dir .. "/rapidjson/*.*",
+      third_party_dir .. "/imgui/*.*",
+      third_party_dir .. "/imgui/backends/*.*",
+      third_party_dir .. "/gl3w/GL/*.*",
+      third_party_dir .. "/glfw/GLFW/*.*",
+      third_party_dir .. "/tinymath/*.*",
+      third_party_dir .. "/tinymath/detail/*.*",
+      third_party_dir .. "/tinymath/primitives/*.*",
+      third_party_dir .. "/tinymath/color/*.*",
+      sample_dir .. "/VertexFormats/VertexFormats.cpp"
+   }
+
+   filter { "configurations:Debug*" }
+      targetdir (solution_dir .. "/bin/Debug")
+
+   filter { "configurations:Release*" }
+      targetdir (solution_dir .. "/bin/release")
+end
+
+function setupTextureSamplingProject()
+   project "TextureSampling"
+   kind "ConsoleApp"
+   language "C++"
+
+   files { 
+      src_dir .. "/*.*", 
+      src_dir .. "/util/*.*",
+      src_dir .. "/core/*.*",
+      src_dir .. "/graphics/*.*",
+      src_dir .. "/editor/*.*",
+      include_dir .. "/*.*", 
+      include_dir .. "/detail/*.*", 
+      include_dir .. "/util/*.*",
+      include_dir .. "/util/detail/*.*",
+      include_dir .. "/core/*.*",
+      include_dir .. "/graphics/*.*",
+      include_dir .. "/core/detail/*.*",
+      include_dir .. "/editor/*.*",
+      shader_dir  .. "/*.*",
+      third_party_dir .. "/*.*",
+      third_party_dir .. "/assimp/*.*",
+      third_party_dir .. "/stb_image/*.*",
+      third_party_dir .. "/rapidjson/*.*",
+      third_party_dir .. "/imgui/*.*",
+      third_party_dir .. "/imgui/backends/*.*",
+      third_party_dir .. "/gl3w/GL/*.*",
+      third_party_dir .. "/glfw/GLFW/*.*",
+      third_party_dir .. "/tinymath/*.*",
+      third_party_dir .. "/tinymath/detail/*.*",
+      third_party_dir .. "/tinymath/primitives/*.*",
+      third_party_dir .. "/tinymath/color/*.*",
+      sample_dir .. "/TextureSampling/TextureSampling.cpp"
+   }
+
+   filter { "configurations:Debug*" }
+      targetdir (solution_dir .. "/bin/Debug")
+
+   filter { "configurations:Release*" }
+      targetdir (solution_dir .. "/bin/release")
+end
+
+function setupMipGenerationProject()
+   project "MipGeneration"
+   kind "ConsoleApp"
+   language "C++"
+
+   files { 
+      src_dir .. "/*.*", 
+      src_dir .. "/util/*.*",
+      src_dir .. "/core/*.*",
+      src_dir .. "/graphics/*.*",
+      src_dir .. "/editor/*.*",
+      include_dir .. "/*.*", 
+      include_dir .. "/detail/*.*", 
+      include_dir .. "/util/*.*",
+      include_dir .. "/util/detail/*.*",
+      include_dir .. "/core/*.*",
+      include_dir .. "/graphics/*.*",
+      include_dir .. "/core/detail/*.*",
+      include_dir .. "/editor/*.*",
+      shader_dir  .. "/*.*",
+      third_party_dir .. "/*.*",
+      third_party_dir .. "/assimp/*.*",
+      third_party_dir .. "/stb_image/*.*",
+      third_party_dir .. "/rapidjson/*.*",
+      third_party_dir .. "/imgui/*.*",
+      third_party_dir .. "/imgui/backends/*.*",
+      third_party_dir .. "/gl3w/GL/*.*",
+      third_party_dir .. "/glfw/GLFW/*.*",
+      third_party_dir .. "/tinymath/*.*",
+      third_party_dir .. "/tinymath/detail/*.*",
+      third_party_dir .. "/tinymath/primitives/*.*",
+      third_party_dir .. "/tinymath/color/*.*",
+      sample_dir .. "/MipGeneration/MipGeneration.cpp"
+   }
+
+   filter { "configurations:Debug*" }
+      targetdir (solution_dir .. "/bin/Debug")
+
+   filter { "configurations:Release*" }
+      targetdir (solution_dir .. "/bin/release")
+end
+
+function setupTextureStreamingProject()
+   project "TextureStreaming"
+   kind "ConsoleApp"
+   language "C++"
+
+   files { 
+      src_dir .. "/*.*", 
+      src_dir .. "/util/*.*",
+      src_dir .. "/core/*.*",
+      src_dir .. "/graphics/*.*",
+      src_dir .. "/editor/*.*",
+      include_dir .. "/*.*", 
+      include_dir .. "/detail/*.*", 
+      include_dir .. "/util/*.*",
+      include_dir .. "/util/detail/*.*",
+      include_dir .. "/core/*.*",
+      include_dir .. "/graphics/*.*",
+      include_dir .. "/core/detail/*.*",
+      include_dir .. "/editor/*.*",
+      shader_dir  .. "/*.*",
+      third_party_dir .. "/*.*",
+      third_party_dir .. "/assimp/*.*",
+      third_party_dir .. "/stb_image/*.*",
+      third_party_dir .. "/rapidjson/*.*",
+      third_party_dir .. "/imgui/*.*",
+      third_party_dir .. "/imgui/backends/*.*",
+      third_party_dir .. "/gl3w/GL/*.*",
+      third_party_dir .. "/glfw/GLFW/*.*",
+      third_party_dir .. "/tinymath/*.*",
+      third_party_dir .. "/tinymath/detail/*.*",
+      third_party_dir .. "/tinymath/primitives/*.*",
+      third_party_dir .. "/tinymath/color/*.*",
+      sample_dir .. "/TextureStreaming/TextureStreaming.cpp"
+   }
+
+   filter { "configurations:Debug*" }
+      targetdir (solution_dir .. "/bin/Debug")
+
+   filter { "configurations:Release*" }
+      targetdir (solution_dir .. "/bin/release")
+end
+
+function setupAsyncLoadingProject()
+   project "AsyncLoading"
+   kind "ConsoleApp"
+   language "C++"
+
+   files { 
+      src_dir .. "/*.*", 
+      src_dir .. "/util/*.*",
+      src_dir .. "/core/*.*",
+      src_dir .. "/graphics/*.*",
+      src_dir .. "/editor/*.*",
+      include_dir .. "/*.*", 
+      include_dir .. "/detail/*.*", 
+      include_dir .. "/util/*.*",
+      include_dir .. "/util/detail/*.*",
+      include_dir .. "/core/*.*",
+      include_dir .. "/graphics/*.*",
+      include_dir .. "/core/detail/*.*",
+      include_dir .. "/editor/*.*",
+      shader_dir  .. "/*.*",
+      third_party_dir .. "/*.*",
+      third_party_dir .. "/assimp/*.*",
+      third_party_dir .. "/stb_image/*.*",
+      third_party_dir .. "/rapidjson/*.*",
+      third_party_dir .. "/imgui/*.*",
+      third_party_dir .. "/imgui/backends/*.*",
+      third_party_dir .. "/gl3w/GL/*.*",
+      third_party_dir .. "/glfw/GLFW/*.*",
+      third_party_dir .. "/tinymath/*.*",
+      third_party_dir .. "/tinymath/detail/*.*",
+      third_party_dir .. "/tinymath/primitives/*.*",
+      third_party_dir .. "/tinymath/color/*.*",
+      sample_dir .. "/AsyncLoading/AsyncLoading.cpp"
+   }
+
+   filter { "configurations:Debug*" }
+      targetdir (solution_dir .. "/bin/Debug")
+
+   filter { "configurations:Release*" }
+      targetdir (solution_dir .. "/bin/release")
+end
+
 setupIncludeDirs()
 setupSlotion()
 setupViewerProject()
 setuoHelloTriangle()
 setupTextureProject()
 setupTexture3DProject()
-setupLightingProject()
\ No newline at end of file
+setupLightingProject()
+setupFillRuleProject()
+setupFrameBufferLayoutProject()
+setupAntiAliasingProject()
+setupOcclusionCullingProject()
+setupVertexFormatsProject()
+setupTextureSamplingProject()
+setupMipGenerationProject()
+setupTextureStreamingProject()
+setupAsyncLoadingProject()
\ No newline at end of file
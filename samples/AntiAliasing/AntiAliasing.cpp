@@ -0,0 +1,181 @@
+#include <random>
+#include <algorithm>
+#include <cfloat>
+#include "CGL.h"
+#include "Logger.hpp"
+#include "Time.hpp"
+#include "RenderTexture.hpp"
+#include "AntiAliasingShader.hpp"
+
+// renders one scene without anti-aliasing, with fxaa and with 4x msaa and compares each image to a 16x msaa reference,
+// the edge error is the rms difference over the pixels where the aliased image and the reference disagree,
+// returns 1 when fxaa or msaa does not bring the edges closer to the reference than no anti-aliasing
+
+constexpr size_t kWidth = 960;
+constexpr size_t kHeight = 540;
+constexpr size_t kTriangleCount = 2000;
+constexpr size_t kTimedFrames = 3;
+
+struct AntiAliasingCase
+{
+	const char* name;
+	uint8_t subsample_count;
+	bool post_aa;
+};
+
+static void build_scene(std::vector<cglVert>& vertices, std::vector<size_t>& indices)
+{
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> radius(0.02f, 0.12f);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	for (size_t idx = 0; idx < kTriangleCount; ++idx)
+	{
+		float x = position(rng);
+		float y = position(rng);
+		float r = radius(rng);
+		float z = unit(rng) * 0.9f;
+		cglVec2 uv(unit(rng), unit(rng));
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			float angle = unit(rng) * 6.2831853f;
+			vertices.emplace_back(cglVert(cglVec4(x + cosf(angle) * r, y + sinf(angle) * r, z, 1.0f), cglVec3Zero, uv));
+			indices.push_back(vertices.size() - 1);
+		}
+	}
+}
+
+static float render_frame(resource_id shader_id, size_t vid, size_t iid)
+{
+	Time::start_watch();
+	cglClearBuffer(cglFrameContent::kColor | cglFrameContent::kDepth | cglFrameContent::kStencil);
+	cglUseProgram(shader_id);
+	cglUseVertexBuffer(vid);
+	cglUseIndexBuffer(iid);
+	cglDrawPrimitive();
+	cglFencePrimitives();
+	cglFencePixels();
+	return Time::stop_watch();
+}
+
+static void read_image(cglRenderTexture& rt, std::vector<tinymath::color_rgba>& image)
+{
+	const tinymath::color_rgba* pixels = rt.get_color_buffer_ptr();
+	image.assign(pixels, pixels + kWidth * kHeight);
+}
+
+static float pixel_error(const tinymath::color_rgba& lhs, const tinymath::color_rgba& rhs)
+{
+	float r = (float)lhs.r - (float)rhs.r;
+	float g = (float)lhs.g - (float)rhs.g;
+	float b = (float)lhs.b - (float)rhs.b;
+	return r * r + g * g + b * b;
+}
+
+// rms error over the edge pixels only, the flat interiors are equal in every mode
+static float edge_error(const std::vector<tinymath::color_rgba>& image, const std::vector<tinymath::color_rgba>& reference, const std::vector<size_t>& edges)
+{
+	float sum = 0.0f;
+	for (size_t idx : edges)
+	{
+		sum += pixel_error(image[idx], reference[idx]);
+	}
+
+	return edges.empty() ? 0.0f : sqrtf(sum / (edges.size() * 3));
+}
+
+int main()
+{
+	AntiAliasingShader shader;
+	cglSetViewPort(0, 0, kWidth, kHeight);
+	resource_id shader_id = cglCreateProgram(&shader);
+	resource_id target_id = cglCreateBuffer(kWidth, kHeight, cglFrameContent::kColor | cglFrameContent::kDepth | cglFrameContent::kStencil);
+	std::shared_ptr<cglRenderTexture> target;
+	cglGetBuffer(target_id, target);
+
+	cglDisable(cglPipelineFeature::kBlending);
+	cglDisable(cglPipelineFeature::kFaceCulling);
+	cglEnable(cglPipelineFeature::kDepthTest);
+	cglEnable(cglPipelineFeature::kZWrite);
+	cglDepthFunc(cglCompareFunc::kLess);
+	cglSetClearColor(tinymath::kColorBlack);
+
+	std::vector<cglVert> vertices;
+	std::vector<size_t> indices;
+	build_scene(vertices, indices);
+	auto vid = cglBindVertexBuffer(vertices);
+	auto iid = cglBindIndexBuffer(indices);
+	cglSetActiveRenderTarget(target_id);
+
+	// 16x msaa reference
+	std::vector<tinymath::color_rgba> reference;
+	cglDisable(cglPipelineFeature::kPostAA);
+	cglSetSubSampleCount(16);
+	render_frame(shader_id, vid, iid);
+	read_image(*target, reference);
+
+	std::vector<AntiAliasingCase> cases =
+	{
+		{ "no aa", 0, false },
+		{ "fxaa", 0, true },
+		{ "msaa 4x", 4, false }
+	};
+
+	int failed = 0;
+	float aliased_error = 0.0f;
+	std::vector<size_t> edges;
+	std::vector<tinymath::color_rgba> image;
+	for (auto& test : cases)
+	{
+		cglSetSubSampleCount(test.subsample_count);
+		if (test.post_aa)
+		{
+			cglEnable(cglPipelineFeature::kPostAA);
+		}
+		else
+		{
+			cglDisable(cglPipelineFeature::kPostAA);
+		}
+
+		// the first frame allocates the msaa and tile working buffers
+		render_frame(shader_id, vid, iid);
+		float best_frame = FLT_MAX;
+		for (size_t frame = 0; frame < kTimedFrames; ++frame)
+		{
+			best_frame = std::min(best_frame, render_frame(shader_id, vid, iid));
+		}
+
+		read_image(*target, image);
+		if (edges.empty())
+		{
+			// the first case is rendered without anti-aliasing, it decides which pixels are edges
+			for (size_t idx = 0; idx < image.size(); ++idx)
+			{
+				if (pixel_error(image[idx], reference[idx]) > 0.0f)
+				{
+					edges.push_back(idx);
+				}
+			}
+		}
+
+		float error = edge_error(image, reference, edges);
+		cglPrint("{}, frame ms {}, edge rms error against 16x msaa {}", test.name, best_frame, error);
+
+		if (test.subsample_count == 0 && !test.post_aa)
+		{
+			aliased_error = error;
+		}
+		else if (error >= aliased_error)
+		{
+			failed = 1;
+			cglError("{} does not reduce the edge error, aliased error {}", test.name, aliased_error);
+		}
+	}
+
+	cglPrint("edge pixels {}", edges.size());
+	cglResetActiveRenderTarget();
+	cglFreeVertexBuffer(vid);
+	cglFreeIndexBuffer(iid);
+	return failed;
+}
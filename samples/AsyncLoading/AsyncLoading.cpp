@@ -0,0 +1,126 @@
+#include <string>
+#include <thread>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+#include "CGL.h"
+#include "Logger.hpp"
+#include "Time.hpp"
+#include "Texture.hpp"
+#include "AssetLoader.hpp"
+#include "Utility.hpp"
+
+// cold open of the bundled pbr textures on the asset loader with 1, 2, 4 .. workers, up to the hardware threads.
+// textures are cached per process and on disk, so without arguments the sample runs itself once per worker count and
+// every run deletes the cache files of its textures when done, the next run imports them from the raw images again.
+// the first run only clears cache files left from earlier runs and is not reported.
+// a 16 ms frame loop calls update on the main thread until every texture arrived,
+// returns 1 when a texture fails to load
+
+using namespace CpuRasterizer;
+
+constexpr size_t kFrameMs = 16;
+
+static const char* kTextures[] =
+{
+	"/helmet/albedo.texture",
+	"/helmet/metallic.texture",
+	"/helmet/roughness.texture",
+	"/backpack/ao.texture",
+	"/common_textures/Metal_ScavengerMetal_2k_alb_1.texture",
+	"/common_textures/Metal_ScavengerMetal_2k_ao_1.texture",
+	"/common_textures/Metal_ScavengerMetal_2k_g_1.texture",
+	"/common_textures/Metal_ScavengerMetal_2k_n_1.texture",
+	"/common_textures/wood_AlternatingSquareTiles_2k_alb_1.texture",
+	"/common_textures/wood_AlternatingSquareTiles_2k_ao_1.texture",
+	"/common_textures/wood_AlternatingSquareTiles_2k_g_1.texture",
+	"/common_textures/wood_AlternatingSquareTiles_2k_n_1.texture"
+};
+
+static int load_textures(size_t worker_count, bool report)
+{
+	AssetLoader loader(worker_count);
+
+	Time::start_watch();
+	std::vector<AssetHandle<Texture>> handles;
+	for (const char* path : kTextures)
+	{
+		handles.emplace_back(loader.load_texture(path));
+	}
+	float request = Time::stop_watch();
+
+	// the frame loop of a scene, only update runs on the main thread
+	float total = 0.0f;
+	float slowest_update = 0.0f;
+	size_t frames = 0;
+	while (true)
+	{
+		Time::start_watch();
+		loader.update();
+		size_t ready = 0;
+		for (auto& handle : handles)
+		{
+			ready += is_ready(handle) ? 1 : 0;
+		}
+		float update = Time::stop_watch();
+		slowest_update = std::max(slowest_update, update);
+		total += update;
+		frames++;
+		if (ready == handles.size())
+		{
+			break;
+		}
+
+		Time::start_watch();
+		std::this_thread::sleep_for(std::chrono::milliseconds(kFrameMs));
+		total += Time::stop_watch();
+	}
+
+	int failed = 0;
+	for (size_t idx = 0; idx < handles.size(); ++idx)
+	{
+		auto texture = handles[idx].get();
+		if (texture == nullptr || texture->width == 0)
+		{
+			failed = 1;
+			cglError("texture failed to load: {}", kTextures[idx]);
+			continue;
+		}
+
+		// the next run opens cold
+		std::error_code error;
+		std::filesystem::remove(CACHE_PATH + texture->raw_path + ".tex", error);
+	}
+
+	if (report)
+	{
+		cglPrint("workers {}, {} textures, frames {}, request ms {}, slowest update ms {}, all loaded ms {}",
+			loader.get_worker_count(), handles.size(), frames, request, slowest_update, request + total);
+	}
+	return failed;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1)
+	{
+		std::string arg(argv[1]);
+		return arg == "clear" ? load_textures(std::thread::hardware_concurrency(), false) : load_textures(std::stoul(arg), true);
+	}
+
+	size_t hardware = std::max((size_t)std::thread::hardware_concurrency(), (size_t)1);
+	cglPrint("hardware threads {}", hardware);
+
+	std::string self = std::string("\"") + argv[0] + "\"";
+	int failed = std::system((self + " clear").c_str()) != 0 ? 1 : 0;
+	size_t max_workers = std::max(hardware, (size_t)4);
+	for (size_t workers = 1; workers <= max_workers; workers *= 2)
+	{
+		failed |= std::system((self + " " + std::to_string(workers)).c_str()) != 0 ? 1 : 0;
+		if (workers < hardware && workers * 2 > hardware)
+		{
+			failed |= std::system((self + " " + std::to_string(hardware)).c_str()) != 0 ? 1 : 0;
+		}
+	}
+	return failed;
+}
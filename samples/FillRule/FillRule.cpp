@@ -0,0 +1,186 @@
+#include <random>
+#include "CGL.h"
+#include "Logger.hpp"
+#include "RenderTexture.hpp"
+#include "FillRuleShader.hpp"
+
+// renders a closed plane with additive blending and checks that every sample is shaded exactly once,
+// returns 1 when a sample on a shared edge is shaded twice or falls between two triangles
+
+enum class GridMode
+{
+	kJittered, // interior vertices moved off the grid by a random sub-pixel amount
+	kPixelCenters // square cells with the vertices on pixel centers, the diagonals run through sample positions
+};
+
+struct FillRuleCase
+{
+	size_t cols;
+	size_t rows;
+	GridMode mode;
+	uint8_t subsample_count;
+};
+
+static void build_plane(size_t w, size_t h, const FillRuleCase& test, std::vector<cglVert>& vertices, std::vector<size_t>& indices)
+{
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> jitter(-0.25f, 0.25f);
+	float cell_w = (float)w / test.cols;
+	float cell_h = (float)h / test.rows;
+
+	vertices.clear();
+	indices.clear();
+	for (size_t row = 0; row <= test.rows; ++row)
+	{
+		for (size_t col = 0; col <= test.cols; ++col)
+		{
+			// the border stays on the edges of the viewport so the plane covers every pixel
+			float x = col * cell_w;
+			float y = row * cell_h;
+			bool interior = row > 0 && row < test.rows && col > 0 && col < test.cols;
+			if (interior && test.mode == GridMode::kJittered)
+			{
+				x += jitter(rng) * cell_w;
+				y += jitter(rng) * cell_h;
+			}
+			else if (interior && test.mode == GridMode::kPixelCenters)
+			{
+				x = floorf(x) + 0.5f;
+				y = floorf(y) + 0.5f;
+			}
+
+			cglVec4 pos(x / w * 2.0f - 1.0f, y / h * 2.0f - 1.0f, 0.0f, 1.0f);
+			vertices.emplace_back(cglVert(pos, cglVec3Zero, cglVec2Zero));
+		}
+	}
+
+	// alternate the diagonal so both directions of shared edges are covered
+	size_t stride = test.cols + 1;
+	for (size_t row = 0; row < test.rows; ++row)
+	{
+		for (size_t col = 0; col < test.cols; ++col)
+		{
+			size_t v0 = row * stride + col;
+			size_t v1 = v0 + 1;
+			size_t v2 = v0 + stride;
+			size_t v3 = v2 + 1;
+			if ((row + col) & 1)
+			{
+				indices.insert(indices.end(), { v0, v1, v3, v0, v3, v2 });
+			}
+			else
+			{
+				indices.insert(indices.end(), { v0, v1, v2, v1, v3, v2 });
+			}
+		}
+	}
+}
+
+// counts the samples that are not exactly one fragment of the shader over the black clear color
+static size_t count_bad_samples(cglRenderTexture& rt, uint8_t expected)
+{
+	size_t bad = 0;
+	if (rt.has_msaa_buf())
+	{
+		const RawBuffer<tinymath::color_rgba>& samples = *rt.get_msaa_color_raw_buffer();
+		const RawBuffer<coverage_t>& states = *rt.get_msaa_framebuffer()->get_coverage_raw_buffer();
+		size_t axis = (size_t)rt.get_subsamples_per_axis();
+		for (size_t row = 0; row < samples.get_height(); ++row)
+		{
+			for (size_t col = 0; col < samples.get_width(); ++col)
+			{
+				// compressed pixels only keep the first sample
+				size_t first_row = row - row % axis;
+				size_t first_col = col - col % axis;
+				bool compressed = states.at(first_row, first_col) == kSamplesCompressed;
+				const tinymath::color_rgba& color = compressed ? samples.at(first_row, first_col) : samples.at(row, col);
+				bad += color.r != expected ? 1 : 0;
+			}
+		}
+	}
+	else
+	{
+		const RawBuffer<tinymath::color_rgba>& pixels = *rt.get_color_raw_buffer();
+		for (size_t row = 0; row < pixels.get_height(); ++row)
+		{
+			for (size_t col = 0; col < pixels.get_width(); ++col)
+			{
+				bad += pixels.at(row, col).r != expected ? 1 : 0;
+			}
+		}
+	}
+
+	return bad;
+}
+
+int main()
+{
+	size_t w = 256;
+	size_t h = 192;
+	cglSetViewPort(0, 0, w, h);
+
+	FillRuleShader shader;
+	resource_id shader_id = cglCreateProgram(&shader);
+	resource_id target_id = cglCreateBuffer(w, h, cglFrameContent::kColor | cglFrameContent::kDepth | cglFrameContent::kStencil);
+	std::shared_ptr<cglRenderTexture> target;
+	cglGetBuffer(target_id, target);
+
+	cglEnable(cglPipelineFeature::kBlending);
+	cglSetBlendFactor(cglBlendFactor::kOne, cglBlendFactor::kOne);
+	cglSetBlendFunc(cglBlendFunc::kAdd);
+	cglDisable(cglPipelineFeature::kDepthTest);
+	cglDisable(cglPipelineFeature::kZWrite);
+	cglDisable(cglPipelineFeature::kFaceCulling);
+	cglSetClearColor(tinymath::kColorBlack);
+
+	uint8_t expected = ColorEncoding::encode_rgba(shader.fragment_shader(v2f())).r;
+
+	std::vector<FillRuleCase> cases =
+	{
+		{ 16, 12, GridMode::kJittered, 0 },
+		{ 128, 96, GridMode::kJittered, 0 },
+		{ 32, 24, GridMode::kPixelCenters, 0 },
+		{ 16, 12, GridMode::kJittered, 4 },
+		{ 128, 96, GridMode::kJittered, 4 },
+		{ 32, 24, GridMode::kPixelCenters, 4 }
+	};
+
+	int failed = 0;
+	std::vector<cglVert> vertices;
+	std::vector<size_t> indices;
+	for (auto& test : cases)
+	{
+		build_plane(w, h, test, vertices, indices);
+		auto vid = cglBindVertexBuffer(vertices);
+		auto iid = cglBindIndexBuffer(indices);
+
+		cglSetActiveRenderTarget(target_id);
+		cglSetSubSampleCount(test.subsample_count);
+		cglClearBuffer(cglFrameContent::kColor | cglFrameContent::kDepth | cglFrameContent::kStencil);
+
+		cglUseProgram(shader_id);
+		cglUseVertexBuffer(vid);
+		cglUseIndexBuffer(iid);
+		cglDrawPrimitive();
+		cglFencePrimitives();
+		cglFencePixels();
+
+		target->resolve_pending_clears();
+		size_t bad = count_bad_samples(*target, expected);
+		if (bad > 0)
+		{
+			failed = 1;
+			cglError("fill rule failed, {}x{} cells, mode {}, subsamples {}, samples not shaded exactly once: {}", test.cols, test.rows, (int)test.mode, (int)test.subsample_count, bad);
+		}
+		else
+		{
+			cglPrint("fill rule ok, {}x{} cells, mode {}, subsamples {}", test.cols, test.rows, (int)test.mode, (int)test.subsample_count);
+		}
+
+		cglResetActiveRenderTarget();
+		cglFreeVertexBuffer(vid);
+		cglFreeIndexBuffer(iid);
+	}
+
+	return failed;
+}
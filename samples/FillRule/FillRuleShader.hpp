@@ -0,0 +1,25 @@
+#pragma once
+#include "ShaderProgram.hpp"
+
+using namespace CpuRasterizer;
+using namespace tinymath;
+
+// every fragment adds the same amount, a sample shaded twice ends up brighter
+class FillRuleShader : public ShaderProgram
+{
+public:
+	FillRuleShader() : ShaderProgram("fill_rule_shader") {}
+
+	v2f vertex_shader(const a2v& input) const
+	{
+		v2f o;
+		o.position = vec4f(input.position.x, input.position.y, input.position.z, 1.0f);
+		return o;
+	}
+
+	Color fragment_shader(const v2f& input) const
+	{
+		UNUSED(input);
+		return Color(0.25f, 0.25f, 0.25f, 0.25f);
+	}
+};
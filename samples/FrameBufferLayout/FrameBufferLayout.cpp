@@ -0,0 +1,141 @@
+#include <random>
+#include <algorithm>
+#include <cfloat>
+#include "CGL.h"
+#include "Logger.hpp"
+#include "Time.hpp"
+#include "RenderTexture.hpp"
+#include "FrameBufferLayoutShader.hpp"
+
+// renders the same depth tested scene into row-major and tiled frame buffers at 1080p and 4k,
+// reports the best frame time and the cost of linearizing the color buffer for present/readback,
+// returns 1 when the two layouts do not produce the same image
+
+constexpr size_t kTriangleCount = 3000;
+constexpr size_t kTimedFrames = 3;
+
+struct LayoutCase
+{
+	size_t width;
+	size_t height;
+};
+
+static void build_scene(std::vector<cglVert>& vertices, std::vector<size_t>& indices)
+{
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> radius(0.01f, 0.08f);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	for (size_t idx = 0; idx < kTriangleCount; ++idx)
+	{
+		float x = position(rng);
+		float y = position(rng);
+		float r = radius(rng);
+		float z = unit(rng) * 0.9f;
+		cglVec2 uv(unit(rng), unit(rng));
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			float angle = unit(rng) * 6.2831853f;
+			vertices.emplace_back(cglVert(cglVec4(x + cosf(angle) * r, y + sinf(angle) * r, z, 1.0f), cglVec3Zero, uv));
+			indices.push_back(vertices.size() - 1);
+		}
+	}
+}
+
+static float render_frame(resource_id shader_id, size_t vid, size_t iid)
+{
+	Time::start_watch();
+	cglClearBuffer(cglFrameContent::kColor | cglFrameContent::kDepth | cglFrameContent::kStencil);
+	cglUseProgram(shader_id);
+	cglUseVertexBuffer(vid);
+	cglUseIndexBuffer(iid);
+	cglDrawPrimitive();
+	cglFencePrimitives();
+	cglFencePixels();
+	return Time::stop_watch();
+}
+
+int main()
+{
+	FrameBufferLayoutShader shader;
+	cglSetViewPort(0, 0, 64, 64);
+	resource_id shader_id = cglCreateProgram(&shader);
+
+	cglDisable(cglPipelineFeature::kBlending);
+	cglDisable(cglPipelineFeature::kFaceCulling);
+	cglEnable(cglPipelineFeature::kDepthTest);
+	cglEnable(cglPipelineFeature::kZWrite);
+	cglDepthFunc(cglCompareFunc::kLess);
+	cglSetSubSampleCount(0);
+	cglSetClearColor(tinymath::kColorBlack);
+
+	std::vector<cglVert> vertices;
+	std::vector<size_t> indices;
+	build_scene(vertices, indices);
+	auto vid = cglBindVertexBuffer(vertices);
+	auto iid = cglBindIndexBuffer(indices);
+
+	std::vector<LayoutCase> cases =
+	{
+		{ 1920, 1080 },
+		{ 3840, 2160 }
+	};
+
+	int failed = 0;
+	for (auto& test : cases)
+	{
+		std::vector<tinymath::color_rgba> linear_image;
+		for (auto layout : { cglMemoryLayout::kLinear, cglMemoryLayout::kTiled })
+		{
+			cglSetFrameBufferLayout(layout);
+			cglSetViewPort(0, 0, test.width, test.height);
+			resource_id target_id = cglCreateBuffer(test.width, test.height, cglFrameContent::kColor | cglFrameContent::kDepth | cglFrameContent::kStencil);
+			std::shared_ptr<cglRenderTexture> target;
+			cglGetBuffer(target_id, target);
+			cglSetActiveRenderTarget(target_id);
+
+			// the first frame allocates the tile working buffers
+			render_frame(shader_id, vid, iid);
+			float best_frame = FLT_MAX;
+			for (size_t frame = 0; frame < kTimedFrames; ++frame)
+			{
+				best_frame = std::min(best_frame, render_frame(shader_id, vid, iid));
+			}
+
+			// row-major buffers hand out their storage, tiled ones are linearized here
+			Time::start_watch();
+			const tinymath::color_rgba* pixels = target->get_color_buffer_ptr();
+			float present = Time::stop_watch();
+
+			const char* name = layout == cglMemoryLayout::kLinear ? "row-major" : "tiled";
+			cglPrint("{}x{} {}, frame ms {}, present ms {}", test.width, test.height, name, best_frame, present);
+
+			std::vector<tinymath::color_rgba> image(pixels, pixels + test.width * test.height);
+			if (layout == cglMemoryLayout::kLinear)
+			{
+				linear_image = std::move(image);
+			}
+			else
+			{
+				size_t mismatch = 0;
+				for (size_t idx = 0; idx < image.size(); ++idx)
+				{
+					mismatch += memcmp(&image[idx], &linear_image[idx], sizeof(tinymath::color_rgba)) != 0 ? 1 : 0;
+				}
+
+				if (mismatch > 0)
+				{
+					failed = 1;
+					cglError("{}x{} tiled image differs from row-major, pixels: {}", test.width, test.height, mismatch);
+				}
+			}
+
+			cglResetActiveRenderTarget();
+		}
+	}
+
+	cglFreeVertexBuffer(vid);
+	cglFreeIndexBuffer(iid);
+	return failed;
+}
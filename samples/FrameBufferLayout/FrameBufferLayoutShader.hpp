@@ -0,0 +1,25 @@
+#pragma once
+#include "ShaderProgram.hpp"
+
+using namespace CpuRasterizer;
+using namespace tinymath;
+
+// flat color from the uv, the benchmark measures frame buffer traffic rather than shading
+class FrameBufferLayoutShader : public ShaderProgram
+{
+public:
+	FrameBufferLayoutShader() : ShaderProgram("frame_buffer_layout_shader") {}
+
+	v2f vertex_shader(const a2v& input) const
+	{
+		v2f o;
+		o.position = vec4f(input.position.x, input.position.y, input.position.z, 1.0f);
+		o.uv = input.uv;
+		return o;
+	}
+
+	Color fragment_shader(const v2f& input) const
+	{
+		return Color(input.uv.x, input.uv.y, 0.5f, 1.0f);
+	}
+};
@@ -29,9 +29,10 @@ public:
 		// sample texture
 		Color c;
 		property_name tex_prop = 123;
-		if (local_properties.has_texture(tex_prop))
+		const Sampler* sampler = local_properties.get_sampler(tex_prop);
+		if (sampler != nullptr)
 		{
-			local_properties.get_texture(tex_prop)->sample(input.uv.x, input.uv.y, c);
+			sampler->sample(input.uv.x, input.uv.y, c);
 		}
 
 		return c;
@@ -0,0 +1,185 @@
+#include <random>
+#include <algorithm>
+#include <cfloat>
+#include "CGL.h"
+#include "Logger.hpp"
+#include "Time.hpp"
+#include "Texture.hpp"
+#include "ImageUtil.hpp"
+
+// times generate_mipmap for each pixel format against the previous way of resizing a copy of the base level
+// for every mip, and checks every level is the 2x2 box filter of the one before it,
+// returns 1 when a texel is off by more than the rounding of its format
+
+using namespace CpuRasterizer;
+using namespace tinymath;
+
+constexpr size_t kTimedRuns = 3;
+
+struct MipCase
+{
+	const char* name;
+	TextureFormat format;
+	size_t size;
+	bool srgb;
+};
+
+template<typename T>
+static T* create_pixels(size_t size)
+{
+	typedef typename PixelTraits<T>::channel_type C;
+	T* pixels = new T[size * size];
+	C* channels = (C*)pixels;
+	std::mt19937 rng(9);
+	for (size_t idx = 0; idx < size * size * PixelTraits<T>::kChannels; ++idx)
+	{
+		if constexpr (std::is_floating_point_v<C>)
+		{
+			channels[idx] = (float)(rng() % 4096) / 1024.0f;
+		}
+		else
+		{
+			channels[idx] = (C)(rng() & 0xFF);
+		}
+	}
+	return pixels;
+}
+
+// one texel of the level below, computed the slow way
+template<typename T>
+static float reference_channel(const typename PixelTraits<T>::channel_type* texels[4], size_t channel, bool srgb)
+{
+	typedef typename PixelTraits<T>::channel_type C;
+	if constexpr (std::is_floating_point_v<C>)
+	{
+		return (texels[0][channel] + texels[1][channel] + texels[2][channel] + texels[3][channel]) * 0.25f;
+	}
+	else
+	{
+		if (srgb && channel < PixelTraits<T>::kColorChannels)
+		{
+			float sum = 0.0f;
+			for (size_t idx = 0; idx < 4; ++idx)
+			{
+				sum += powf((float)texels[idx][channel] / 255.0f, 2.2f);
+			}
+			return floorf(powf(sum * 0.25f, 1.0f / 2.2f) * 255.0f + 0.5f);
+		}
+		return (float)(((uint32_t)texels[0][channel] + texels[1][channel] + texels[2][channel] + texels[3][channel] + 2) >> 2);
+	}
+}
+
+// largest difference between a level and the box filter of the level before it
+template<typename T>
+static float max_level_error(const Sampler& sampler, bool srgb)
+{
+	typedef typename PixelTraits<T>::channel_type C;
+	constexpr size_t kChannels = PixelTraits<T>::kChannels;
+	float error = 0.0f;
+	for (size_t level = 1; level < sampler.level_count; ++level)
+	{
+		const SamplerLevel& src = sampler.levels[level - 1];
+		const SamplerLevel& dst = sampler.levels[level];
+		const C* src_data = (const C*)src.data;
+		const C* dst_data = (const C*)dst.data;
+		for (size_t row = 0; row < dst.height; ++row)
+		{
+			for (size_t col = 0; col < dst.width; ++col)
+			{
+				const C* texels[4] =
+				{
+					src_data + ((2 * row) * src.width + 2 * col) * kChannels,
+					src_data + ((2 * row) * src.width + 2 * col + 1) * kChannels,
+					src_data + ((2 * row + 1) * src.width + 2 * col) * kChannels,
+					src_data + ((2 * row + 1) * src.width + 2 * col + 1) * kChannels
+				};
+				const C* texel = dst_data + (row * dst.width + col) * kChannels;
+				for (size_t channel = 0; channel < kChannels; ++channel)
+				{
+					error = max(error, abs((float)texel[channel] - reference_channel<T>(texels, channel, srgb)));
+				}
+			}
+		}
+	}
+	return error;
+}
+
+// what generate_mipmap did before, every level resized from a full copy of the base level
+template<typename T>
+static float resize_chain(const T* pixels, size_t size)
+{
+	RawBuffer<T> base(size, size);
+	size_t bytes;
+	memcpy(base.get_ptr(bytes), pixels, size * size * sizeof(T));
+
+	Time::start_watch();
+	for (size_t level = 1; level < kMaxMip; ++level)
+	{
+		RawBuffer<T> mip(base);
+		ImageUtil::resize(mip, size >> level, size >> level, Filtering::kBilinear);
+	}
+	return Time::stop_watch();
+}
+
+template<typename T>
+static bool run_case(const MipCase& test)
+{
+	T* pixels = create_pixels<T>(test.size);
+	float previous = resize_chain(pixels, test.size);
+
+	// the texture owns the pixels from here
+	Texture texture(pixels, test.size, test.size, test.format);
+	texture.srgb = test.srgb;
+	texture.enable_mip = true;
+	float best = FLT_MAX;
+	for (size_t run = 0; run < kTimedRuns; ++run)
+	{
+		Time::start_watch();
+		texture.generate_mipmap((int)kMaxMip);
+		best = std::min(best, Time::stop_watch());
+	}
+
+	// 8 bit srgb goes through lookup tables, one step of rounding either way
+	float tolerance = std::is_floating_point_v<typename PixelTraits<T>::channel_type> ? 1e-5f : (test.srgb ? 1.0f : 0.0f);
+	float error = max_level_error<T>(texture.get_sampler(), test.srgb);
+	cglPrint("{} {}x{}, box filter chain ms {}, resize chain ms {}, max error {}", test.name, test.size, test.size, best, previous, error);
+	if (error > tolerance)
+	{
+		cglError("{} mip levels are off, allowed error {}", test.name, tolerance);
+		return false;
+	}
+	return true;
+}
+
+int main()
+{
+	std::vector<MipCase> cases =
+	{
+		{ "rgb", TextureFormat::kRGB, 4096, false },
+		{ "rgba", TextureFormat::kRGBA, 4096, false },
+		{ "rgba srgb", TextureFormat::kRGBA, 4096, true },
+		{ "rg", TextureFormat::kRG, 4096, false },
+		{ "gray", TextureFormat::kGray, 4096, false },
+		{ "rgb16f", TextureFormat::kRGB16, 2048, false },
+		{ "rgba16f", TextureFormat::kRGBA16, 2048, false }
+	};
+
+	int failed = 0;
+	for (auto& test : cases)
+	{
+		bool ok = false;
+		switch (test.format)
+		{
+		case TextureFormat::kRGB: ok = run_case<color_rgb>(test); break;
+		case TextureFormat::kRGBA: ok = run_case<color_rgba>(test); break;
+		case TextureFormat::kRG: ok = run_case<color_rg>(test); break;
+		case TextureFormat::kGray: ok = run_case<color_gray>(test); break;
+		case TextureFormat::kRGB16: ok = run_case<color_rgb16f>(test); break;
+		case TextureFormat::kRGBA16: ok = run_case<color_rgba16f>(test); break;
+		default: break;
+		}
+		failed = ok ? failed : 1;
+	}
+
+	return failed;
+}
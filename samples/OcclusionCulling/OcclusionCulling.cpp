@@ -0,0 +1,189 @@
+#include <random>
+#include <algorithm>
+#include <cfloat>
+#include "CGL.h"
+#include "Logger.hpp"
+#include "Time.hpp"
+#include "Mesh.hpp"
+#include "OcclusionCuller.hpp"
+
+// a street of walls with boxes scattered behind them, times rasterizing the occluders and testing the boxes,
+// returns 1 when a box is reported hidden although the segment from the camera to one of its corners or its center
+// passes no wall
+
+using namespace CpuRasterizer;
+using namespace tinymath;
+
+constexpr size_t kBoxCount = 20000;
+constexpr size_t kTimedRuns = 50;
+
+struct Wall
+{
+	vec3f min;
+	vec3f max;
+};
+
+static Mesh build_box(const Wall& wall)
+{
+	std::vector<Vertex> vertices;
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		vec4f pos((corner & 1) ? wall.max.x : wall.min.x, (corner & 2) ? wall.max.y : wall.min.y, (corner & 4) ? wall.max.z : wall.min.z, 1.0f);
+		vertices.emplace_back(Vertex(pos, kVec3fZero, kVec2fZero));
+	}
+
+	std::vector<size_t> indices =
+	{
+		0, 1, 3, 0, 3, 2,
+		4, 6, 7, 4, 7, 5,
+		0, 4, 5, 0, 5, 1,
+		2, 3, 7, 2, 7, 6,
+		0, 2, 6, 0, 6, 4,
+		1, 5, 7, 1, 7, 3
+	};
+	return Mesh(vertices, indices);
+}
+
+// slab test of the segment from origin to target against a wall, the target itself is excluded
+static bool segment_hits_wall(const vec3f& origin, const vec3f& target, const Wall& wall)
+{
+	float t_min = 0.0f;
+	float t_max = 0.999f;
+	float o[3] = { origin.x, origin.y, origin.z };
+	float d[3] = { target.x - origin.x, target.y - origin.y, target.z - origin.z };
+	float lo[3] = { wall.min.x, wall.min.y, wall.min.z };
+	float hi[3] = { wall.max.x, wall.max.y, wall.max.z };
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (tinymath::abs(d[axis]) < 1e-9f)
+		{
+			if (o[axis] < lo[axis] || o[axis] > hi[axis])
+			{
+				return false;
+			}
+			continue;
+		}
+
+		float t0 = (lo[axis] - o[axis]) / d[axis];
+		float t1 = (hi[axis] - o[axis]) / d[axis];
+		if (t0 > t1)
+		{
+			std::swap(t0, t1);
+		}
+
+		t_min = tinymath::max(t_min, t0);
+		t_max = tinymath::min(t_max, t1);
+		if (t_min > t_max)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool point_visible(const vec3f& eye, const vec3f& point, const std::vector<Wall>& walls)
+{
+	for (auto& wall : walls)
+	{
+		if (segment_hits_wall(eye, point, wall))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	vec3f eye(0.0f, 1.5f, 0.0f);
+	mat4x4 view = lookat(eye, vec3f(0.0f, 1.5f, 1.0f), kVec3fUp);
+	mat4x4 proj = perspective(60.0f, 16.0f / 9.0f, 0.1f, 300.0f);
+	mat4x4 view_projection = proj * view;
+
+	std::vector<Wall> walls =
+	{
+		{ vec3f(-30.0f, -1.0f, 15.0f), vec3f(-2.0f, 6.0f, 15.5f) },
+		{ vec3f(2.0f, -1.0f, 15.0f), vec3f(30.0f, 6.0f, 15.5f) },
+		{ vec3f(-60.0f, -1.0f, 40.0f), vec3f(60.0f, 6.0f, 40.5f) },
+		{ vec3f(-60.0f, -1.0f, 0.0f), vec3f(-8.0f, 6.0f, 200.0f) },
+		{ vec3f(8.0f, -1.0f, 0.0f), vec3f(60.0f, 6.0f, 200.0f) }
+	};
+
+	std::vector<Mesh> occluders;
+	for (auto& wall : walls)
+	{
+		occluders.emplace_back(build_box(wall));
+	}
+
+	// the scene frustum culls before the occlusion test, only boxes in front of the camera reach the culler
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> x(-60.0f, 60.0f);
+	std::uniform_real_distribution<float> y(0.0f, 3.0f);
+	std::uniform_real_distribution<float> z(2.0f, 200.0f);
+	std::uniform_real_distribution<float> size(0.5f, 2.0f);
+	std::vector<AxisAlignedBoundingBox> boxes;
+	for (size_t idx = 0; idx < kBoxCount; ++idx)
+	{
+		vec3f center(x(rng), y(rng), z(rng));
+		float extent = size(rng);
+		vec4f clip = view_projection * vec4f(center.x, center.y, center.z, 1.0f);
+		if (clip.w > 0.1f && tinymath::abs(clip.x) < clip.w && tinymath::abs(clip.y) < clip.w)
+		{
+			boxes.emplace_back(AxisAlignedBoundingBox(center, vec3f(extent, extent, extent)));
+		}
+	}
+
+	OcclusionCuller culler(kOcclusionBufferWidth, kOcclusionBufferWidth * 9 / 16);
+	float best_raster = FLT_MAX;
+	float best_test = FLT_MAX;
+	size_t hidden = 0;
+	for (size_t run = 0; run < kTimedRuns; ++run)
+	{
+		Time::start_watch();
+		culler.begin(view_projection);
+		for (auto& occluder : occluders)
+		{
+			culler.rasterize_occluder(occluder, kMat4x4Identity);
+		}
+		best_raster = tinymath::min(best_raster, Time::stop_watch());
+
+		Time::start_watch();
+		hidden = 0;
+		for (auto& box : boxes)
+		{
+			hidden += culler.is_occluded(box) ? 1 : 0;
+		}
+		best_test = tinymath::min(best_test, Time::stop_watch());
+	}
+
+	cglPrint("buffer {}x{}, occluder triangles {}, raster ms {}", culler.get_width(), culler.get_height(), occluders.size() * 12, best_raster);
+	cglPrint("boxes tested {}, hidden {}, test ms {}", boxes.size(), hidden, best_test);
+
+	// the culler is conservative, a hidden box must not have a corner or its center in sight
+	size_t wrong = 0;
+	for (auto& box : boxes)
+	{
+		if (!culler.is_occluded(box))
+		{
+			continue;
+		}
+
+		vec3f bmin = box.min();
+		vec3f bmax = box.max();
+		bool visible = point_visible(eye, box.center, walls);
+		for (int corner = 0; corner < 8 && !visible; ++corner)
+		{
+			vec3f pos((corner & 1) ? bmax.x : bmin.x, (corner & 2) ? bmax.y : bmin.y, (corner & 4) ? bmax.z : bmin.z);
+			visible = point_visible(eye, pos, walls);
+		}
+		wrong += visible ? 1 : 0;
+	}
+
+	if (wrong > 0)
+	{
+		cglError("boxes culled while visible: {}", wrong);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,210 @@
+#include <random>
+#include <algorithm>
+#include <cfloat>
+#include "CGL.h"
+#include "Logger.hpp"
+#include "Time.hpp"
+#include "Texture.hpp"
+#include "Sampler.hpp"
+#include "TextureCache.hpp"
+
+// texture bound benchmark, a 1920x1080 screen is shaded in 2x2 quads over one 4k texture with trilinear filtering.
+// the same content is sampled from a row-major, a tiled and a block compressed copy under rotations and minifications,
+// returns 1 when the two layouts do not return the same colors, when compression saves less than 4x memory
+// or when the compressed samples drift too far from the uncompressed ones
+
+using namespace CpuRasterizer;
+using namespace tinymath;
+
+constexpr size_t kTextureSize = 4096;
+constexpr size_t kScreenWidth = 1920;
+constexpr size_t kScreenHeight = 1080;
+constexpr size_t kTimedRuns = 5;
+constexpr size_t kCompareSamples = 200000;
+constexpr float kMinCompressionRatio = 4.0f; // bc3 against rgba, bc1 against rgb saves 6x
+constexpr float kMaxCompressionError = 0.08f; // rms over the channels in [0, 1], the per texel noise is the hard case for bc
+
+struct SamplingCase
+{
+	const char* name;
+	float angle;
+	float texels_per_pixel;
+};
+
+static std::shared_ptr<Texture> create_texture(TextureFormat format)
+{
+	size_t channels = format == TextureFormat::kRGBA ? 4 : 3;
+	uint8_t* pixels = channels == 4 ? (uint8_t*)new color_rgba[kTextureSize * kTextureSize] : (uint8_t*)new color_rgb[kTextureSize * kTextureSize];
+
+	// stripes with some noise, so neighbouring texels differ and the filter has real work
+	std::mt19937 rng(3);
+	for (size_t row = 0; row < kTextureSize; ++row)
+	{
+		for (size_t col = 0; col < kTextureSize; ++col)
+		{
+			for (size_t channel = 0; channel < channels; ++channel)
+			{
+				size_t value = (row >> 3) * (channel + 1) + (col >> 2) * (3 - channel % 3) + (rng() & 15);
+				pixels[(row * kTextureSize + col) * channels + channel] = (uint8_t)(value & 0xFF);
+			}
+		}
+	}
+
+	auto texture = std::make_shared<Texture>(pixels, kTextureSize, kTextureSize, format);
+	texture->filtering = Filtering::kBilinear;
+	texture->wrap_mode = WrapMode::kRepeat;
+	texture->enable_mip = true;
+	texture->generate_mipmap((int)kMaxMip);
+	return texture;
+}
+
+// shades the screen tile by tile in 2x2 quads like the rasterizer, the lod comes from the uv derivatives
+static float shade_screen(const Sampler& sampler, const SamplingCase& test, float& checksum)
+{
+	float scale = test.texels_per_pixel / (float)kTextureSize;
+	vec2f ddx(cosf(test.angle) * scale, sinf(test.angle) * scale);
+	vec2f ddy(-ddx.y, ddx.x);
+
+	float sum = 0.0f;
+	Color color;
+	Time::start_watch();
+	for (size_t tile_row = 0; tile_row < kScreenHeight; tile_row += kTileSize)
+	{
+		for (size_t tile_col = 0; tile_col < kScreenWidth; tile_col += kTileSize)
+		{
+			for (size_t quad = 0; quad < kTileSize * kTileSize; quad += 4)
+			{
+				size_t quad_col = tile_col + (quad / 2) % kTileSize;
+				size_t quad_row = tile_row + (quad / 2) / kTileSize * 2;
+				for (size_t pixel = 0; pixel < 4; ++pixel)
+				{
+					size_t x = quad_col + (pixel & 1);
+					size_t y = quad_row + (pixel >> 1);
+					float u = 0.13f + x * ddx.x + y * ddy.x;
+					float v = 0.27f + x * ddx.y + y * ddy.y;
+					sampler.sample(u, v, ddx, ddy, color);
+					sum += color.r;
+				}
+			}
+		}
+	}
+	float cost = Time::stop_watch();
+	checksum += sum;
+	return cost;
+}
+
+// the layouts hold the same texels, every sample has to match exactly
+static size_t count_mismatches(const Sampler& lhs, const Sampler& rhs)
+{
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> uv(-0.5f, 2.5f);
+	std::uniform_real_distribution<float> lod(0.0f, (float)kMaxMip);
+	size_t mismatch = 0;
+	for (size_t idx = 0; idx < kCompareSamples; ++idx)
+	{
+		float u = uv(rng);
+		float v = uv(rng);
+		float level = lod(rng);
+		Color a, b;
+		lhs.sample(u, v, level, a);
+		rhs.sample(u, v, level, b);
+		mismatch += (a.r != b.r || a.g != b.g || a.b != b.b || a.a != b.a) ? 1 : 0;
+	}
+	return mismatch;
+}
+
+// rms difference of the compressed samples, the bc formats are lossy
+static float compression_error(const Sampler& reference, const Sampler& compressed)
+{
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> uv(-0.5f, 2.5f);
+	std::uniform_real_distribution<float> lod(0.0f, (float)kMaxMip);
+	double sum = 0.0;
+	for (size_t idx = 0; idx < kCompareSamples; ++idx)
+	{
+		float u = uv(rng);
+		float v = uv(rng);
+		float level = lod(rng);
+		Color a, b;
+		reference.sample(u, v, level, a);
+		compressed.sample(u, v, level, b);
+		sum += (a.r - b.r) * (a.r - b.r) + (a.g - b.g) * (a.g - b.g) + (a.b - b.b) * (a.b - b.b) + (a.a - b.a) * (a.a - b.a);
+	}
+	return (float)sqrt(sum / (kCompareSamples * 4));
+}
+
+// bytes of every level the sampler sees
+static size_t texture_bytes(const Texture& texture, const Sampler& sampler)
+{
+	size_t bytes = 0;
+	for (size_t level = 0; level < sampler.level_count; ++level)
+	{
+		bytes += TextureCache::level_size(texture.format, sampler.levels[level].width, sampler.levels[level].height, MemoryLayout::kLinear, 0);
+	}
+	return bytes;
+}
+
+int main()
+{
+	std::vector<SamplingCase> cases =
+	{
+		{ "axis aligned 1:1", 0.0f, 1.0f },
+		{ "rotated 30 1:1", 0.52f, 1.0f },
+		{ "rotated 90 1:1", 1.5708f, 1.0f },
+		{ "rotated 30 1:2.5", 0.52f, 2.5f },
+		{ "rotated 30 1:8", 0.52f, 8.0f }
+	};
+
+	int failed = 0;
+	float checksum = 0.0f;
+	for (TextureFormat format : { TextureFormat::kRGBA, TextureFormat::kRGB })
+	{
+		const char* format_name = format == TextureFormat::kRGBA ? "rgba" : "rgb";
+		auto linear = create_texture(format);
+		auto tiled = create_texture(format);
+		tiled->set_layout(MemoryLayout::kTiled);
+		auto compressed = create_texture(format);
+		compressed->compress();
+
+		Sampler linear_sampler = linear->get_sampler();
+		Sampler tiled_sampler = tiled->get_sampler();
+		Sampler compressed_sampler = compressed->get_sampler();
+		size_t mismatch = count_mismatches(linear_sampler, tiled_sampler);
+		if (mismatch > 0)
+		{
+			failed = 1;
+			cglError("{} tiled samples differ from row-major: {}", format_name, mismatch);
+		}
+
+		size_t linear_bytes = texture_bytes(*linear, linear_sampler);
+		size_t compressed_bytes = texture_bytes(*compressed, compressed_sampler);
+		float ratio = (float)linear_bytes / (float)compressed_bytes;
+		float error = compression_error(linear_sampler, compressed_sampler);
+		cglPrint("{} memory, uncompressed bytes {}, bc bytes {}, ratio {}", format_name, linear_bytes, compressed_bytes, ratio);
+		cglPrint("{} bc rms error {}", format_name, error);
+		if (ratio < kMinCompressionRatio || error > kMaxCompressionError)
+		{
+			failed = 1;
+			cglError("{} compression out of bounds, ratio {}, rms error {}", format_name, ratio, error);
+		}
+
+		for (auto& test : cases)
+		{
+			// interleaved so every copy sees the same machine state
+			float linear_cost = FLT_MAX;
+			float tiled_cost = FLT_MAX;
+			float compressed_cost = FLT_MAX;
+			for (size_t run = 0; run < kTimedRuns; ++run)
+			{
+				linear_cost = std::min(linear_cost, shade_screen(linear_sampler, test, checksum));
+				tiled_cost = std::min(tiled_cost, shade_screen(tiled_sampler, test, checksum));
+				compressed_cost = std::min(compressed_cost, shade_screen(compressed_sampler, test, checksum));
+			}
+			cglPrint("{} {}, row-major ms {}, tiled ms {}, bc ms {}", format_name, test.name, linear_cost, tiled_cost, compressed_cost);
+		}
+	}
+
+	// keeps the samples from being optimized away
+	cglPrint("checksum {}", checksum);
+	return failed;
+}
@@ -0,0 +1,139 @@
+#include <string>
+#include <cstdlib>
+#include "CGL.h"
+#include "Logger.hpp"
+#include "Time.hpp"
+#include "Texture.hpp"
+#include "TextureCache.hpp"
+#include "Singleton.hpp"
+#include "GlobalShaderParams.hpp"
+
+#if (defined(WIN32) || defined(_WIN32))
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+// startup cost of the bundled pbr textures with texture streaming off and on. peak rss is per process, so without
+// arguments the sample runs itself once per mode: "full" loads every level, "stream" only the mip tails.
+// the first run imports the raw images into the texture cache, both modes then load from it.
+// returns 1 when a texture fails to load or streaming does not keep fewer bytes resident
+
+using namespace CpuRasterizer;
+
+static const char* kTextures[] =
+{
+	"/helmet/albedo.texture",
+	"/helmet/metallic.texture",
+	"/helmet/roughness.texture",
+	"/backpack/ao.texture",
+	"/common_textures/Metal_ScavengerMetal_2k_alb_1.texture",
+	"/common_textures/Metal_ScavengerMetal_2k_ao_1.texture",
+	"/common_textures/Metal_ScavengerMetal_2k_g_1.texture",
+	"/common_textures/Metal_ScavengerMetal_2k_n_1.texture",
+	"/common_textures/wood_AlternatingSquareTiles_2k_alb_1.texture",
+	"/common_textures/wood_AlternatingSquareTiles_2k_ao_1.texture",
+	"/common_textures/wood_AlternatingSquareTiles_2k_g_1.texture",
+	"/common_textures/wood_AlternatingSquareTiles_2k_n_1.texture"
+};
+
+static size_t peak_rss_bytes()
+{
+#if (defined(WIN32) || defined(_WIN32))
+	PROCESS_MEMORY_COUNTERS counters;
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return (size_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+// bytes of the levels in memory, a streamed texture starts at its resident level.
+// cached levels are mapped and only count towards rss once read, so every resident byte is read here
+// like a frame that samples the texture at every lod it has
+static size_t touch_resident_levels(const Texture& texture, size_t& chain_bytes, uint32_t& checksum)
+{
+	Sampler sampler = texture.get_sampler();
+	size_t bytes = 0;
+	for (size_t level = 0; level < sampler.level_count; ++level)
+	{
+		size_t size = TextureCache::level_size(texture.format, sampler.levels[level].width, sampler.levels[level].height, MemoryLayout::kLinear, 0);
+		chain_bytes += size;
+		if (level < sampler.base_level)
+		{
+			continue;
+		}
+
+		const uint8_t* data = (const uint8_t*)sampler.levels[level].data;
+		for (size_t idx = 0; idx < size; idx += 64)
+		{
+			checksum += data[idx];
+		}
+		bytes += size;
+	}
+	return bytes;
+}
+
+static int load_textures(bool streaming)
+{
+	CpuRasterSharedData.texture_streaming = streaming;
+
+	Time::start_watch();
+	std::vector<std::shared_ptr<Texture>> textures;
+	for (const char* path : kTextures)
+	{
+		textures.emplace_back(Texture::load_asset(path));
+	}
+	float load = Time::stop_watch();
+
+	int failed = 0;
+	size_t streamed = 0;
+	size_t resident = 0;
+	size_t chain = 0;
+	uint32_t checksum = 0;
+	for (size_t idx = 0; idx < textures.size(); ++idx)
+	{
+		auto& texture = textures[idx];
+		if (texture == nullptr || texture->width == 0 || !texture->get_sampler().valid())
+		{
+			failed = 1;
+			cglError("texture failed to load: {}", kTextures[idx]);
+			continue;
+		}
+		streamed += texture->is_streamed() ? 1 : 0;
+		resident += touch_resident_levels(*texture, chain, checksum);
+	}
+
+	const char* mode = streaming ? "stream" : "full";
+	cglPrint("{}: {} textures, {} streamed, load ms {}", mode, textures.size(), streamed, load);
+	cglPrint("{}: resident KB {} of {}, peak rss KB {}", mode, resident / 1024, chain / 1024, peak_rss_bytes() / 1024);
+	cglPrint("{}: checksum {}", mode, checksum);
+
+	if (streaming && resident >= chain)
+	{
+		failed = 1;
+		cglError("stream: every level stayed resident, bytes {}", resident);
+	}
+	return failed;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1)
+	{
+		return load_textures(std::string(argv[1]) == "stream");
+	}
+
+	// the first run fills the texture cache, the next two are timed against it
+	std::string self = std::string("\"") + argv[0] + "\"";
+	int failed = 0;
+	for (const char* mode : { "full", "full", "stream" })
+	{
+		failed |= std::system((self + " " + mode).c_str()) != 0 ? 1 : 0;
+	}
+	return failed;
+}
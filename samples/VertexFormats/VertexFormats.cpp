@@ -0,0 +1,208 @@
+#include <random>
+#include <algorithm>
+#include "CGL.h"
+#include "Logger.hpp"
+#include "VertexBuffer.hpp"
+
+// packs random vertices with each vertex format and decodes them again, checks the error of every attribute against
+// the precision of its format and that index buffers pick 16 or 32 bit indices by their largest index,
+// returns 1 when any check fails
+
+using namespace CpuRasterizer;
+using namespace tinymath;
+
+constexpr size_t kVertexCount = 100000;
+constexpr float kHalfEpsilon = 1.0f / 2048.0f; // half has 11 significant bits, rounding is off by at most half a step
+constexpr float kOctahedralMaxAngle = 2e-4f; // radians, two snorm16 on the octahedron
+
+static int failed = 0;
+
+static void report(const char* name, float error, float bound)
+{
+	if (error > bound)
+	{
+		failed = 1;
+		cglError("{} failed, max error {}, allowed {}", name, error, bound);
+	}
+	else
+	{
+		cglPrint("{} ok, max error {}", name, error);
+	}
+}
+
+static vec3f random_unit(std::mt19937& rng)
+{
+	std::normal_distribution<float> gauss(0.0f, 1.0f);
+	vec3f v(gauss(rng), gauss(rng), gauss(rng));
+	return normalize(v);
+}
+
+static std::vector<Vertex> build_vertices()
+{
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> uv(-8.0f, 8.0f);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	// axes and the folds of the octahedron are where the encoding has its edge cases
+	std::vector<vec3f> directions =
+	{
+		vec3f(1.0f, 0.0f, 0.0f), vec3f(-1.0f, 0.0f, 0.0f),
+		vec3f(0.0f, 1.0f, 0.0f), vec3f(0.0f, -1.0f, 0.0f),
+		vec3f(0.0f, 0.0f, 1.0f), vec3f(0.0f, 0.0f, -1.0f),
+		normalize(vec3f(1.0f, 1.0f, 0.0f)), normalize(vec3f(-1.0f, 1.0f, -1e-4f)), normalize(vec3f(1.0f, -1.0f, -1.0f))
+	};
+
+	std::vector<Vertex> vertices;
+	for (size_t idx = 0; idx < kVertexCount; ++idx)
+	{
+		Vertex vertex;
+		vertex.position = vec4f(position(rng), position(rng), position(rng), 1.0f);
+		vertex.normal = idx < directions.size() ? directions[idx] : random_unit(rng);
+		vertex.tangent = idx < directions.size() ? directions[directions.size() - 1 - idx] : random_unit(rng);
+		vertex.uv = vec2f(uv(rng), uv(rng));
+		vertex.color = vec4f(unit(rng), unit(rng), unit(rng), unit(rng));
+		vertices.emplace_back(vertex);
+	}
+	return vertices;
+}
+
+static float max_component_error(const vec4f& lhs, const vec4f& rhs)
+{
+	return max(max(abs(lhs.x - rhs.x), abs(lhs.y - rhs.y)), max(abs(lhs.z - rhs.z), abs(lhs.w - rhs.w)));
+}
+
+// from the chord between the unit vectors, acos of the dot product loses all precision near zero
+static float angle_between(const vec3f& lhs, const vec3f& rhs)
+{
+	return 2.0f * asinf(min(length(lhs, rhs) * 0.5f, 1.0f));
+}
+
+static void check_full(const std::vector<Vertex>& vertices)
+{
+	VertexBuffer buffer(vertices, VertexLayout::full());
+	float error = 0.0f;
+	for (size_t idx = 0; idx < vertices.size(); ++idx)
+	{
+		Vertex decoded = buffer[idx];
+		error = max(error, max_component_error(decoded.position, vertices[idx].position));
+		error = max(error, max_component_error(vec4f(decoded.normal.x, decoded.normal.y, decoded.normal.z, 0.0f), vec4f(vertices[idx].normal.x, vertices[idx].normal.y, vertices[idx].normal.z, 0.0f)));
+		error = max(error, max_component_error(vec4f(decoded.uv.x, decoded.uv.y, 0.0f, 0.0f), vec4f(vertices[idx].uv.x, vertices[idx].uv.y, 0.0f, 0.0f)));
+		error = max(error, max_component_error(vec4f(decoded.tangent.x, decoded.tangent.y, decoded.tangent.z, 0.0f), vec4f(vertices[idx].tangent.x, vertices[idx].tangent.y, vertices[idx].tangent.z, 0.0f)));
+		error = max(error, max_component_error(decoded.color, vertices[idx].color));
+	}
+	report("full layout", error, 0.0f);
+}
+
+static void check_directions(const std::vector<Vertex>& vertices)
+{
+	VertexBuffer octahedral(vertices, VertexLayout(VertexFormat::kFloat3, VertexFormat::kOctahedral16, VertexFormat::kNone, VertexFormat::kOctahedral16, VertexFormat::kNone));
+	VertexBuffer snorm(vertices, VertexLayout(VertexFormat::kFloat3, VertexFormat::kSnorm16x4, VertexFormat::kNone, VertexFormat::kSnorm16x4, VertexFormat::kNone));
+
+	float normal_angle = 0.0f;
+	float tangent_angle = 0.0f;
+	float snorm_error = 0.0f;
+	for (size_t idx = 0; idx < vertices.size(); ++idx)
+	{
+		const Vertex& src = vertices[idx];
+		Vertex oct = octahedral[idx];
+		normal_angle = max(normal_angle, angle_between(oct.normal, src.normal));
+		tangent_angle = max(tangent_angle, angle_between(oct.tangent, src.tangent));
+
+		Vertex sn = snorm[idx];
+		snorm_error = max(snorm_error, max_component_error(vec4f(sn.normal.x, sn.normal.y, sn.normal.z, 0.0f), vec4f(src.normal.x, src.normal.y, src.normal.z, 0.0f)));
+		snorm_error = max(snorm_error, max_component_error(vec4f(sn.tangent.x, sn.tangent.y, sn.tangent.z, 0.0f), vec4f(src.tangent.x, src.tangent.y, src.tangent.z, 0.0f)));
+	}
+
+	report("octahedral normals (radians)", normal_angle, kOctahedralMaxAngle);
+	report("octahedral tangents (radians)", tangent_angle, kOctahedralMaxAngle);
+	report("snorm16 normals and tangents", snorm_error, 0.5f / 32767.0f + 1e-6f);
+}
+
+static void check_uvs(const std::vector<Vertex>& vertices)
+{
+	VertexBuffer half(vertices, VertexLayout(VertexFormat::kFloat3, VertexFormat::kNone, VertexFormat::kHalf2, VertexFormat::kNone, VertexFormat::kNone));
+
+	// unorm16 only holds [0, 1], the uvs are wrapped into it first
+	std::vector<Vertex> wrapped = vertices;
+	for (auto& vertex : wrapped)
+	{
+		vertex.uv = vec2f(vertex.uv.x - floorf(vertex.uv.x), vertex.uv.y - floorf(vertex.uv.y));
+	}
+	VertexBuffer unorm(wrapped, VertexLayout(VertexFormat::kFloat3, VertexFormat::kNone, VertexFormat::kUnorm16x2, VertexFormat::kNone, VertexFormat::kNone));
+
+	float half_error = 0.0f;
+	float unorm_error = 0.0f;
+	for (size_t idx = 0; idx < vertices.size(); ++idx)
+	{
+		// half precision is relative to the magnitude
+		vec2f src = vertices[idx].uv;
+		vec2f decoded = half[idx].uv;
+		half_error = max(half_error, abs(decoded.x - src.x) / max(abs(src.x), 1.0f));
+		half_error = max(half_error, abs(decoded.y - src.y) / max(abs(src.y), 1.0f));
+
+		vec2f wrapped_uv = wrapped[idx].uv;
+		vec2f unorm_uv = unorm[idx].uv;
+		unorm_error = max(unorm_error, max(abs(unorm_uv.x - wrapped_uv.x), abs(unorm_uv.y - wrapped_uv.y)));
+	}
+
+	report("half uvs (relative)", half_error, kHalfEpsilon);
+	report("unorm16 uvs", unorm_error, 0.5f / 65535.0f + 1e-6f);
+}
+
+static void check_colors(const std::vector<Vertex>& vertices)
+{
+	VertexBuffer half(vertices, VertexLayout(VertexFormat::kFloat3, VertexFormat::kNone, VertexFormat::kNone, VertexFormat::kNone, VertexFormat::kHalf4));
+	VertexBuffer unorm(vertices, VertexLayout(VertexFormat::kFloat3, VertexFormat::kNone, VertexFormat::kNone, VertexFormat::kNone, VertexFormat::kUnorm8x4));
+
+	float half_error = 0.0f;
+	float unorm_error = 0.0f;
+	for (size_t idx = 0; idx < vertices.size(); ++idx)
+	{
+		half_error = max(half_error, max_component_error(half[idx].color, vertices[idx].color));
+		unorm_error = max(unorm_error, max_component_error(unorm[idx].color, vertices[idx].color));
+	}
+
+	report("half colors", half_error, kHalfEpsilon);
+	report("unorm8 colors", unorm_error, 0.5f / 255.0f + 1e-6f);
+}
+
+static void check_indices(size_t largest_index, IndexFormat expected)
+{
+	std::vector<size_t> indices;
+	for (size_t idx = 0; idx < 3000; ++idx)
+	{
+		indices.push_back((idx * 7919) % (largest_index + 1));
+	}
+	indices.push_back(largest_index);
+
+	IndexBuffer buffer(indices);
+	bool format_ok = buffer.get_format() == expected;
+	bool size_ok = buffer.byte_size() == indices.size() * IndexBuffer::index_size(expected);
+	bool values_ok = buffer.decode() == indices;
+	if (!format_ok || !size_ok || !values_ok)
+	{
+		failed = 1;
+		cglError("index buffer failed, largest index {}, format {}, byte size {}, values equal {}", largest_index, (int)buffer.get_format(), buffer.byte_size(), values_ok);
+	}
+	else
+	{
+		cglPrint("index buffer ok, largest index {}, bytes per index {}", largest_index, IndexBuffer::index_size(buffer.get_format()));
+	}
+}
+
+int main()
+{
+	std::vector<Vertex> vertices = build_vertices();
+	check_full(vertices);
+	check_directions(vertices);
+	check_uvs(vertices);
+	check_colors(vertices);
+
+	check_indices(UINT16_MAX, IndexFormat::kUInt16);
+	check_indices((size_t)UINT16_MAX + 1, IndexFormat::kUInt32);
+	check_indices(1000000, IndexFormat::kUInt32);
+
+	cglPrint("bytes per vertex, full {}, standard {}, compact {}", VertexLayout::full().stride, VertexLayout::standard().stride, VertexLayout::compact().stride);
+	return failed;
+}
@@ -21,8 +21,8 @@ namespace CpuRasterizer
 		{
 			const float gamma = 2.2f;
 			Color scene_color, bloom_color;
-			local_properties.get_texture(scene_color_prop)->sample(input.uv.x, input.uv.y, scene_color);
-			local_properties.get_texture(bloom_bright_color_prop)->sample(input.uv.x, input.uv.y, bloom_color);
+			local_properties.get_sampler(scene_color_prop)->sample(input.uv.x, input.uv.y, scene_color);
+			local_properties.get_sampler(bloom_bright_color_prop)->sample(input.uv.x, input.uv.y, bloom_color);
 			float exposure = local_properties.get_float(exposure_prop);
 			vec4f ret = vec4f(1.0f) - tinymath::exp(-scene_color * exposure);   
 			ret = ret / (ret + tinymath::kColorWhite);
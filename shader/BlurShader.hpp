@@ -23,8 +23,9 @@ namespace CpuRasterizer
 		{
 			vec4f screen_param = local_properties.get_float4(screen_param_prop);
 			vec2f tex_offset = 1.0f / vec2f(screen_param.x, screen_param.y);
+			const Sampler* bright_color = local_properties.get_sampler(bloom_bright_color_prop);
 			Color ret;
-			local_properties.get_texture(bloom_bright_color_prop)->sample(input.uv.x, input.uv.y, ret);
+			bright_color->sample(input.uv.x, input.uv.y, ret);
 			ret *= gaussian_weights[0];
 			
 			int horizontal = local_properties.get_int(124);
@@ -34,8 +35,8 @@ namespace CpuRasterizer
 				for (int i = 1; i < 5; ++i)
 				{
 					Color c1, c2;
-					local_properties.get_texture(bloom_bright_color_prop)->sample(input.uv.x + tex_offset.x * i, input.uv.y, c1);
-					local_properties.get_texture(bloom_bright_color_prop)->sample(input.uv.x - tex_offset.x * i, input.uv.y, c2);
+					bright_color->sample(input.uv.x + tex_offset.x * i, input.uv.y, c1);
+					bright_color->sample(input.uv.x - tex_offset.x * i, input.uv.y, c2);
 					ret += c1 * gaussian_weights[i]; 
 					ret += c2 * gaussian_weights[i];
 				}
@@ -45,8 +46,8 @@ namespace CpuRasterizer
 				for (int i = 1; i < 5; ++i)
 				{
 					Color c1, c2;
-					local_properties.get_texture(bloom_bright_color_prop)->sample(input.uv.x, input.uv.y + tex_offset.y * i, c1);
-					local_properties.get_texture(bloom_bright_color_prop)->sample(input.uv.x, input.uv.y - tex_offset.y * i, c2);
+					bright_color->sample(input.uv.x, input.uv.y + tex_offset.y * i, c1);
+					bright_color->sample(input.uv.x, input.uv.y - tex_offset.y * i, c2);
 					ret += c1 * gaussian_weights[i];
 					ret += c2 * gaussian_weights[i];
 				}
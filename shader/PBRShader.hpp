@@ -85,6 +85,14 @@ namespace CpuRasterizer
 		{
 			auto uv = input.uv;
 
+			const Sampler* normal_sampler = local_properties.get_sampler(normal_prop);
+			const Sampler* albedo_sampler = local_properties.get_sampler(albedo_prop);
+			const Sampler* metallic_sampler = local_properties.get_sampler(metallic_prop);
+			const Sampler* roughness_sampler = local_properties.get_sampler(roughness_prop);
+			const Sampler* specular_sampler = local_properties.get_sampler(specular_prop);
+			const Sampler* ao_sampler = local_properties.get_sampler(ao_prop);
+			const Sampler* emission_sampler = local_properties.get_sampler(emission_prop);
+
 			auto roughness_color = tinymath::kColorBlack;
 			auto metallic_color = tinymath::kColorBlack;
 			auto ao_color = tinymath::kColorBlack;
@@ -96,30 +104,30 @@ namespace CpuRasterizer
 			material_data.ao = 1.0f;
 
 			tinymath::Color normal_tex = tinymath::Color(0.0f, 1.0f, 0.0f, 1.0f);
-			if (local_properties.has_texture(normal_prop))
+			if (normal_sampler != nullptr)
 			{
 				if (CpuRasterSharedData.enable_mipmap)
 				{
-					local_properties.get_texture(normal_prop)->sample(input.uv.x, input.uv.y, input.ddx.uv, input.ddy.uv, normal_tex);
+					normal_sampler->sample(input.uv.x, input.uv.y, input.ddx.uv, input.ddy.uv, normal_tex);
 				}
 				else
 				{
-					local_properties.get_texture(normal_prop)->sample(input.uv.x, input.uv.y, normal_tex);
+					normal_sampler->sample(input.uv.x, input.uv.y, normal_tex);
 				}
 
 				auto packed_normal = tinymath::vec3f(normal_tex.r, normal_tex.g, normal_tex.b);
 				material_data.unpacked_normal = tinymath::normalize(packed_normal * 2.0f - 1.0f);
 			}
 
-			if (local_properties.has_texture(albedo_prop))
+			if (albedo_sampler != nullptr)
 			{
 				if (CpuRasterSharedData.enable_mipmap)
 				{
-					local_properties.get_texture(albedo_prop)->sample(input.uv.x, input.uv.y, input.ddx.uv, input.ddy.uv, material_data.albedo_color);
+					albedo_sampler->sample(input.uv.x, input.uv.y, input.ddx.uv, input.ddy.uv, material_data.albedo_color);
 				}
 				else
 				{
-					local_properties.get_texture(albedo_prop)->sample(input.uv.x, input.uv.y, material_data.albedo_color);
+					albedo_sampler->sample(input.uv.x, input.uv.y, material_data.albedo_color);
 				}
 
 				if (CpuRasterSharedData.color_space == ColorSpace::kLinear)
@@ -128,15 +136,15 @@ namespace CpuRasterizer
 				}
 			}
 
-			if (local_properties.has_texture(metallic_prop))
+			if (metallic_sampler != nullptr)
 			{
 				if (CpuRasterSharedData.enable_mipmap)
 				{
-					local_properties.get_texture(metallic_prop)->sample(uv.x, uv.y, input.ddx.uv, input.ddy.uv, metallic_color);
+					metallic_sampler->sample(uv.x, uv.y, input.ddx.uv, input.ddy.uv, metallic_color);
 				}
 				else
 				{
-					local_properties.get_texture(metallic_prop)->sample(uv.x, uv.y, metallic_color);
+					metallic_sampler->sample(uv.x, uv.y, metallic_color);
 				}
 
 				material_data.metallic = metallic_color.r;
@@ -144,69 +152,69 @@ namespace CpuRasterizer
 
 			if (CpuRasterSharedData.workflow == PBRWorkFlow::kMetallic)
 			{
-				if (local_properties.has_texture(roughness_prop))
+				if (roughness_sampler != nullptr)
 				{
 					if (CpuRasterSharedData.enable_mipmap)
 					{
-						local_properties.get_texture(roughness_prop)->sample(uv.x, uv.y, input.ddx.uv, input.ddy.uv, roughness_color);
+						roughness_sampler->sample(uv.x, uv.y, input.ddx.uv, input.ddy.uv, roughness_color);
 					}
 					else
 					{
-						local_properties.get_texture(roughness_prop)->sample(uv.x, uv.y, roughness_color);
+						roughness_sampler->sample(uv.x, uv.y, roughness_color);
 					}
 					material_data.roughness = roughness_color.r;
 				}
-				else if (local_properties.has_texture(specular_prop))
+				else if (specular_sampler != nullptr)
 				{
 					if (CpuRasterSharedData.enable_mipmap)
 					{
-						local_properties.get_texture(specular_prop)->sample(uv.x, uv.y, input.ddx.uv, input.ddy.uv, material_data.specular_color);
+						specular_sampler->sample(uv.x, uv.y, input.ddx.uv, input.ddy.uv, material_data.specular_color);
 					}
 					else
 					{
-						local_properties.get_texture(specular_prop)->sample(uv.x, uv.y, material_data.specular_color);
+						specular_sampler->sample(uv.x, uv.y, material_data.specular_color);
 					}
 					material_data.roughness = 1.0f - material_data.specular_color.r;
 				}
 			}
 			else
 			{
-				if (local_properties.has_texture(specular_prop))
+				if (specular_sampler != nullptr)
 				{
 					if (CpuRasterSharedData.enable_mipmap)
 					{
-						local_properties.get_texture(specular_prop)->sample(uv.x, uv.y, input.ddx.uv, input.ddy.uv, material_data.specular_color);
+						specular_sampler->sample(uv.x, uv.y, input.ddx.uv, input.ddy.uv, material_data.specular_color);
 					}
 					else
 					{
-						local_properties.get_texture(specular_prop)->sample(uv.x, uv.y, material_data.specular_color);
+						specular_sampler->sample(uv.x, uv.y, material_data.specular_color);
 					}
 					material_data.roughness = 1.0f - material_data.specular_color.r;
 				}
 			}
 
-			if (local_properties.has_texture(ao_prop))
+			if (ao_sampler != nullptr)
 			{
 				if (CpuRasterSharedData.enable_mipmap)
 				{
-					local_properties.get_texture(ao_prop)->sample(input.uv.x, input.uv.y, input.ddx.uv, input.ddy.uv, ao_color);
+					ao_sampler->sample(input.uv.x, input.uv.y, input.ddx.uv, input.ddy.uv, ao_color);
 				}
 				else
 				{
-					local_properties.get_texture(ao_prop)->sample(input.uv.x, input.uv.y, ao_color);
+					ao_sampler->sample(input.uv.x, input.uv.y, ao_color);
 				}
 				material_data.ao = ao_color.r;
 			}
 
-			if (local_properties.has_texture(emission_prop))
+			if (emission_sampler != nullptr)
 			{
 				if (CpuRasterSharedData.enable_mipmap)
 				{
-					local_properties.get_texture(emission_prop)->sample(input.uv.x, input.uv.y, input.ddx.uv, input.ddy.uv, material_data.emission_color);
+					emission_sampler->sample(input.uv.x, input.uv.y, input.ddx.uv, input.ddy.uv, material_data.emission_color);
 				}
 				else
 				{
-					local_properties.get_texture(emission_prop)->sample(input.uv.x, input.uv.y, material_data.emission_color);
+					emission_sampler->sample(input.uv.x, input.uv.y, material_data.emission_color);
 				}
 			}
 
@@ -122,6 +122,16 @@ size_t cglBindIndexBuffer(const std::vector<size_t>& buffer)
 	return CpuRasterDevice.bind_index_buffer(buffer);
 }
 
+size_t cglBindPackedVertexBuffer(const cglVertexBuffer& buffer)
+{
+	return CpuRasterDevice.bind_vertex_buffer(buffer);
+}
+
+size_t cglBindPackedIndexBuffer(const cglIndexBuffer& buffer)
+{
+	return CpuRasterDevice.bind_index_buffer(buffer);
+}
+
 void cglUseVertexBuffer(cglResID id)
 {
 	CpuRasterDevice.use_vertex_buffer(id);
@@ -264,6 +274,27 @@ void* cglGetActiveColorBuffer()
 	return CpuRasterDevice.get_active_color_buffer();
 }
 
+void cglSetFrameBufferLayout(cglMemoryLayout layout)
+{
+	CpuRasterDevice.set_framebuffer_layout(layout);
+}
+
+void cglSetResolveEncoding(cglResolveEncoding encoding)
+{
+	CpuRasterDevice.set_resolve_encoding(encoding);
+}
+
+void cglSetOITPoolSize(size_t fragments_per_tile)
+{
+	CpuRasterDevice.set_oit_pool_size(fragments_per_tile);
+}
+
+void cglGetOITStatistics(size_t& fragment_count, size_t& overflow_count)
+{
+	fragment_count = CpuRasterDevice.statistics.oit_fragment_count;
+	overflow_count = CpuRasterDevice.statistics.oit_overflow_count;
+}
+
 void cglSetSubSampleCount(uint8_t count)
 {
 	CpuRasterDevice.set_subsample_count(count);
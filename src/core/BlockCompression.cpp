@@ -0,0 +1,242 @@
+#include "BlockCompression.hpp"
+#include <cmath>
+#include <cfloat>
+#include <climits>
+#include <cstdlib>
+
+namespace CpuRasterizer
+{
+	static uint16_t pack_565(float r, float g, float b)
+	{
+		uint16_t r5 = (uint16_t)tinymath::clamp((int)std::round(r * 31.0f / 255.0f), 0, 31);
+		uint16_t g6 = (uint16_t)tinymath::clamp((int)std::round(g * 63.0f / 255.0f), 0, 63);
+		uint16_t b5 = (uint16_t)tinymath::clamp((int)std::round(b * 31.0f / 255.0f), 0, 31);
+		return (uint16_t)((r5 << 11) | (g6 << 5) | b5);
+	}
+
+	static int color_distance(const tinymath::color_rgb& a, const tinymath::color_rgb& b)
+	{
+		int dr = (int)a.r - (int)b.r;
+		int dg = (int)a.g - (int)b.g;
+		int db = (int)a.b - (int)b.b;
+		return dr * dr + dg * dg + db * db;
+	}
+
+	// picks the nearest entry of the four color palette for every texel, returns the squared error of the block
+	static int fit_bc1_indices(const tinymath::color_rgb* texels, bc1_block& block)
+	{
+		tinymath::color_rgb palette[4];
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			palette[i] = bc1_color(block.color0, block.color1, i, true);
+		}
+
+		int error = 0;
+		block.indices = 0;
+		for (size_t t = 0; t < kBlockTexels; t++)
+		{
+			uint32_t best = 0;
+			int best_distance = color_distance(texels[t], palette[0]);
+			for (uint32_t i = 1; i < 4; i++)
+			{
+				int distance = color_distance(texels[t], palette[i]);
+				if (distance < best_distance)
+				{
+					best = i;
+					best_distance = distance;
+				}
+			}
+			block.indices |= best << (2 * t);
+			error += best_distance;
+		}
+		return error;
+	}
+
+	// color0 > color1 selects the four color palette, which is also the only one bc3 has
+	static void set_bc1_endpoints(bc1_block& block, uint16_t a, uint16_t b)
+	{
+		block.color0 = tinymath::max(a, b);
+		block.color1 = tinymath::min(a, b);
+	}
+
+	void BlockCompression::encode(const tinymath::color_rgb* texels, bc1_block& block)
+	{
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (size_t t = 0; t < kBlockTexels; t++)
+		{
+			mean[0] += texels[t].r;
+			mean[1] += texels[t].g;
+			mean[2] += texels[t].b;
+		}
+		for (float& m : mean)
+		{
+			m /= (float)kBlockTexels;
+		}
+
+		float covariance[6] = {};
+		for (size_t t = 0; t < kBlockTexels; t++)
+		{
+			float r = texels[t].r - mean[0];
+			float g = texels[t].g - mean[1];
+			float b = texels[t].b - mean[2];
+			covariance[0] += r * r;
+			covariance[1] += r * g;
+			covariance[2] += r * b;
+			covariance[3] += g * g;
+			covariance[4] += g * b;
+			covariance[5] += b * b;
+		}
+
+		// power iteration for the principal axis
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 4; iteration++)
+		{
+			float x = axis[0] * covariance[0] + axis[1] * covariance[1] + axis[2] * covariance[2];
+			float y = axis[0] * covariance[1] + axis[1] * covariance[3] + axis[2] * covariance[4];
+			float z = axis[0] * covariance[2] + axis[1] * covariance[4] + axis[2] * covariance[5];
+			float length = tinymath::max(tinymath::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+			if (length < 1e-6f)
+			{
+				break;
+			}
+			axis[0] = x / length;
+			axis[1] = y / length;
+			axis[2] = z / length;
+		}
+
+		size_t min_texel = 0;
+		size_t max_texel = 0;
+		float min_projection = FLT_MAX;
+		float max_projection = -FLT_MAX;
+		for (size_t t = 0; t < kBlockTexels; t++)
+		{
+			float projection = texels[t].r * axis[0] + texels[t].g * axis[1] + texels[t].b * axis[2];
+			if (projection < min_projection)
+			{
+				min_projection = projection;
+				min_texel = t;
+			}
+			if (projection > max_projection)
+			{
+				max_projection = projection;
+				max_texel = t;
+			}
+		}
+
+		const tinymath::color_rgb& lo = texels[min_texel];
+		const tinymath::color_rgb& hi = texels[max_texel];
+		set_bc1_endpoints(block, pack_565(hi.r, hi.g, hi.b), pack_565(lo.r, lo.g, lo.b));
+		if (block.color0 == block.color1)
+		{
+			// a single color, every index 0 decodes the same in both palette modes
+			block.indices = 0;
+			return;
+		}
+		int error = fit_bc1_indices(texels, block);
+
+		// least squares endpoints for the chosen indices
+		static const float kWeights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[3] = {}, bx[3] = {};
+		for (size_t t = 0; t < kBlockTexels; t++)
+		{
+			float w = kWeights[(block.indices >> (2 * t)) & 3];
+			float x[3] = { (float)texels[t].r, (float)texels[t].g, (float)texels[t].b };
+			aa += w * w;
+			ab += w * (1.0f - w);
+			bb += (1.0f - w) * (1.0f - w);
+			for (int c = 0; c < 3; c++)
+			{
+				ax[c] += w * x[c];
+				bx[c] += (1.0f - w) * x[c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) > 1e-6f)
+		{
+			float a[3], b[3];
+			for (int c = 0; c < 3; c++)
+			{
+				a[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+				b[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+			}
+
+			bc1_block refined;
+			set_bc1_endpoints(refined, pack_565(a[0], a[1], a[2]), pack_565(b[0], b[1], b[2]));
+			if (refined.color0 != refined.color1)
+			{
+				int refined_error = fit_bc1_indices(texels, refined);
+				if (refined_error < error)
+				{
+					block = refined;
+				}
+			}
+		}
+	}
+
+	void BlockCompression::encode(const tinymath::color_gray* texels, bc4_block& block)
+	{
+		uint8_t lo = 255;
+		uint8_t hi = 0;
+		for (size_t t = 0; t < kBlockTexels; t++)
+		{
+			lo = tinymath::min(lo, texels[t].gray);
+			hi = tinymath::max(hi, texels[t].gray);
+		}
+
+		// eight value mode needs value0 > value1, a flat block is all index 0
+		block.value0 = hi;
+		block.value1 = lo;
+		uint64_t bits = 0;
+		if (hi != lo)
+		{
+			for (size_t t = 0; t < kBlockTexels; t++)
+			{
+				uint32_t best = 0;
+				int best_distance = INT_MAX;
+				for (uint32_t i = 0; i < 8; i++)
+				{
+					int distance = std::abs((int)bc4_value(hi, lo, i) - (int)texels[t].gray);
+					if (distance < best_distance)
+					{
+						best = i;
+						best_distance = distance;
+					}
+				}
+				bits |= (uint64_t)best << (3 * t);
+			}
+		}
+
+		for (size_t i = 0; i < 6; i++)
+		{
+			block.indices[i] = (uint8_t)(bits >> (8 * i));
+		}
+	}
+
+	void BlockCompression::encode(const tinymath::color_rgba* texels, bc3_block& block)
+	{
+		tinymath::color_rgb colors[kBlockTexels];
+		tinymath::color_gray alphas[kBlockTexels];
+		for (size_t t = 0; t < kBlockTexels; t++)
+		{
+			colors[t] = { texels[t].r, texels[t].g, texels[t].b };
+			alphas[t].gray = texels[t].a;
+		}
+		encode(colors, block.color);
+		encode(alphas, block.alpha);
+	}
+
+	void BlockCompression::encode(const tinymath::color_rg* texels, bc5_block& block)
+	{
+		tinymath::color_gray red[kBlockTexels];
+		tinymath::color_gray green[kBlockTexels];
+		for (size_t t = 0; t < kBlockTexels; t++)
+		{
+			red[t].gray = texels[t].r;
+			green[t].gray = texels[t].g;
+		}
+		encode(red, block.red);
+		encode(green, block.green);
+	}
+}
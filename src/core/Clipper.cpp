@@ -209,15 +209,32 @@ namespace CpuRasterizer
 		return ndv < 0.0f;
 	}
 
-	// todo: frustum & aabb, frustum & obb, etc.
+	// todo: frustum & obb
+	// planes extracted from a matrix are not normalized, the distance is scaled back by the normal length
 	bool Clipper::frustum_culling_sphere(const tinymath::Frustum& frustum, const tinymath::Sphere& bounding_sphere)
 	{
 		for (int i = 0; i < 6; i++)
 		{
 			auto& plane = frustum[i];
 			auto d = plane.distance(bounding_sphere.center);
-			auto r = bounding_sphere.radius;
-			if (d < 0 && -d < r)
+			auto r = bounding_sphere.radius * tinymath::magnitude(plane.normal);
+			if (d < -r)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// culled when the corner furthest along a plane normal is still behind that plane
+	bool Clipper::frustum_culling_aabb(const tinymath::Frustum& frustum, const tinymath::AxisAlignedBoundingBox& bounds)
+	{
+		for (int i = 0; i < 6; i++)
+		{
+			auto& plane = frustum[i];
+			auto d = plane.distance(bounds.center);
+			auto r = tinymath::abs(plane.normal.x) * bounds.extents.x + tinymath::abs(plane.normal.y) * bounds.extents.y + tinymath::abs(plane.normal.z) * bounds.extents.z;
+			if (d < -r)
 			{
 				return true;
 			}
@@ -7,7 +7,7 @@ namespace CpuRasterizer
 {
 	FrameBuffer::FrameBuffer(size_t w, size_t h, FrameContent flag) : 
 		content_flag(flag),
-		width(w), height(h), filtering(Filtering::kBilinear)
+		width(w), height(h), filtering(Filtering::kBilinear), layout(MemoryLayout::kLinear)
 	{
 		clear_color = {0, 0, 0, 0};
 		resize(w, h);
@@ -159,75 +159,40 @@ namespace CpuRasterizer
 		return pass;
 	}
 
-	// todo: alpha factor
-	tinymath::Color FrameBuffer::blend(const tinymath::Color& src_color,
-									   const tinymath::Color& dst_color,
-									   BlendFactor src_factor, 
-									   BlendFactor dst_factor, 
-									   const BlendFunc& op)
+	static tinymath::Color blend_factor(BlendFactor factor, const tinymath::Color& src_color, const tinymath::Color& dst_color)
 	{
-		tinymath::Color lhs, rhs;
-		switch (src_factor)
+		switch (factor)
 		{
 		case BlendFactor::kOne:
-			lhs = src_color;
-			break;
-		case BlendFactor::kSrcAlpha:
-			lhs = src_color * src_color.a;
-			break;
+			return tinymath::Color(1.0f, 1.0f, 1.0f, 1.0f);
 		case BlendFactor::kSrcColor:
-			lhs = src_color * src_color;
-			break;
-		case BlendFactor::kOneMinusSrcAlpha:
-			lhs = src_color * (1.0f - src_color);
-			break;
-		case BlendFactor::kOneMinusSrcColor:
-			lhs = src_color * (1.0f - dst_color);
-			break;
-		case BlendFactor::kDstAlpha:
-			lhs = src_color * dst_color.a;
-			break;
-		case BlendFactor::kDstColor:
-			lhs = src_color * dst_color;
-			break;
-		case BlendFactor::kOneMinusDstAlpha:
-			lhs = src_color * (1.0f - dst_color.a);
-			break;
-		case BlendFactor::kOneMinusDstColor:
-			lhs = src_color * (1.0f - dst_color);
-			break;
-		}
-
-		switch (dst_factor)
-		{
-		case BlendFactor::kOne:
-			rhs = src_color;
-			break;
+			return src_color;
 		case BlendFactor::kSrcAlpha:
-			rhs = dst_color * src_color.a;
-			break;
-		case BlendFactor::kSrcColor:
-			rhs = dst_color * src_color;
-			break;
+			return tinymath::Color(src_color.a, src_color.a, src_color.a, src_color.a);
 		case BlendFactor::kOneMinusSrcAlpha:
-			rhs = dst_color * (1.0f - src_color);
-			break;
+			return tinymath::Color(1.0f - src_color.a, 1.0f - src_color.a, 1.0f - src_color.a, 1.0f - src_color.a);
 		case BlendFactor::kOneMinusSrcColor:
-			rhs = dst_color * (1.0f - dst_color);
-			break;
-		case BlendFactor::kDstAlpha:
-			rhs = dst_color * dst_color.a;
-			break;
+			return tinymath::Color(1.0f, 1.0f, 1.0f, 1.0f) - src_color;
 		case BlendFactor::kDstColor:
-			rhs = dst_color * dst_color;
-			break;
+			return dst_color;
+		case BlendFactor::kDstAlpha:
+			return tinymath::Color(dst_color.a, dst_color.a, dst_color.a, dst_color.a);
 		case BlendFactor::kOneMinusDstAlpha:
-			rhs = dst_color * (1.0f - dst_color.a);
-			break;
+			return tinymath::Color(1.0f - dst_color.a, 1.0f - dst_color.a, 1.0f - dst_color.a, 1.0f - dst_color.a);
 		case BlendFactor::kOneMinusDstColor:
-			rhs = dst_color * (1.0f - dst_color);
-			break;
+			return tinymath::Color(1.0f, 1.0f, 1.0f, 1.0f) - dst_color;
 		}
+		return tinymath::Color(1.0f, 1.0f, 1.0f, 1.0f);
+	}
+
+	tinymath::Color FrameBuffer::blend(const tinymath::Color& src_color,
+									   const tinymath::Color& dst_color,
+									   BlendFactor src_factor, 
+									   BlendFactor dst_factor, 
+									   const BlendFunc& op)
+	{
+		tinymath::Color lhs = src_color * blend_factor(src_factor, src_color, dst_color);
+		tinymath::Color rhs = dst_color * blend_factor(dst_factor, src_color, dst_color);
 
 		switch (op)
 		{
@@ -239,6 +204,119 @@ namespace CpuRasterizer
 		return lhs + rhs;
 	}
 
+	// x * f / 255 with rounding, exact for 8-bit unorm
+	static inline uint32_t mul_unorm8(uint32_t x, uint32_t f)
+	{
+		uint32_t t = x * f + 128u;
+		return (t + (t >> 8)) >> 8;
+	}
+
+	template<BlendFactor kFactor>
+	static inline void blend_factor_rgba8(const uint8_t* src, const uint8_t* dst, uint8_t* factor)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			if constexpr (kFactor == BlendFactor::kOne) factor[i] = 255;
+			else if constexpr (kFactor == BlendFactor::kSrcColor) factor[i] = src[i];
+			else if constexpr (kFactor == BlendFactor::kSrcAlpha) factor[i] = src[3];
+			else if constexpr (kFactor == BlendFactor::kOneMinusSrcAlpha) factor[i] = 255 - src[3];
+			else if constexpr (kFactor == BlendFactor::kOneMinusSrcColor) factor[i] = 255 - src[i];
+			else if constexpr (kFactor == BlendFactor::kDstColor) factor[i] = dst[i];
+			else if constexpr (kFactor == BlendFactor::kDstAlpha) factor[i] = dst[3];
+			else if constexpr (kFactor == BlendFactor::kOneMinusDstAlpha) factor[i] = 255 - dst[3];
+			else factor[i] = 255 - dst[i];
+		}
+	}
+
+	// one instance per blend state, the factor and op branches are resolved at compile time
+	// and the four channels are processed as a quad of 8-bit unorm values
+	template<BlendFactor kSrcFactor, BlendFactor kDstFactor, BlendFunc kOp>
+	static tinymath::color_rgba blend_rgba8(const tinymath::color_rgba& src_color, const tinymath::color_rgba& dst_color)
+	{
+		uint8_t src[4];
+		uint8_t dst[4];
+		memcpy(src, &src_color, 4);
+		memcpy(dst, &dst_color, 4);
+
+		uint8_t src_factor[4];
+		uint8_t dst_factor[4];
+		blend_factor_rgba8<kSrcFactor>(src, dst, src_factor);
+		blend_factor_rgba8<kDstFactor>(src, dst, dst_factor);
+
+		uint8_t out[4];
+		for (int i = 0; i < 4; ++i)
+		{
+			int lhs = (int)mul_unorm8(src[i], src_factor[i]);
+			int rhs = (int)mul_unorm8(dst[i], dst_factor[i]);
+			if constexpr (kOp == BlendFunc::kAdd)
+			{
+				out[i] = (uint8_t)tinymath::min(lhs + rhs, 255);
+			}
+			else
+			{
+				out[i] = (uint8_t)tinymath::max(lhs - rhs, 0);
+			}
+		}
+
+		tinymath::color_rgba ret;
+		memcpy(&ret, out, 4);
+		return ret;
+	}
+
+	template<BlendFactor kSrcFactor, BlendFactor kDstFactor>
+	static BlendFunction compile_blend_op(BlendFunc op)
+	{
+		return op == BlendFunc::kSub ? &blend_rgba8<kSrcFactor, kDstFactor, BlendFunc::kSub> : &blend_rgba8<kSrcFactor, kDstFactor, BlendFunc::kAdd>;
+	}
+
+	template<BlendFactor kSrcFactor>
+	static BlendFunction compile_blend_dst(BlendFactor dst_factor, BlendFunc op)
+	{
+		switch (dst_factor)
+		{
+		case BlendFactor::kOne: return compile_blend_op<kSrcFactor, BlendFactor::kOne>(op);
+		case BlendFactor::kSrcColor: return compile_blend_op<kSrcFactor, BlendFactor::kSrcColor>(op);
+		case BlendFactor::kSrcAlpha: return compile_blend_op<kSrcFactor, BlendFactor::kSrcAlpha>(op);
+		case BlendFactor::kOneMinusSrcAlpha: return compile_blend_op<kSrcFactor, BlendFactor::kOneMinusSrcAlpha>(op);
+		case BlendFactor::kOneMinusSrcColor: return compile_blend_op<kSrcFactor, BlendFactor::kOneMinusSrcColor>(op);
+		case BlendFactor::kDstColor: return compile_blend_op<kSrcFactor, BlendFactor::kDstColor>(op);
+		case BlendFactor::kDstAlpha: return compile_blend_op<kSrcFactor, BlendFactor::kDstAlpha>(op);
+		case BlendFactor::kOneMinusDstAlpha: return compile_blend_op<kSrcFactor, BlendFactor::kOneMinusDstAlpha>(op);
+		case BlendFactor::kOneMinusDstColor: return compile_blend_op<kSrcFactor, BlendFactor::kOneMinusDstColor>(op);
+		}
+		return compile_blend_op<kSrcFactor, BlendFactor::kOne>(op);
+	}
+
+	BlendFunction FrameBuffer::compile_blend(BlendFactor src_factor, BlendFactor dst_factor, BlendFunc op)
+	{
+		switch (src_factor)
+		{
+		case BlendFactor::kOne: return compile_blend_dst<BlendFactor::kOne>(dst_factor, op);
+		case BlendFactor::kSrcColor: return compile_blend_dst<BlendFactor::kSrcColor>(dst_factor, op);
+		case BlendFactor::kSrcAlpha: return compile_blend_dst<BlendFactor::kSrcAlpha>(dst_factor, op);
+		case BlendFactor::kOneMinusSrcAlpha: return compile_blend_dst<BlendFactor::kOneMinusSrcAlpha>(dst_factor, op);
+		case BlendFactor::kOneMinusSrcColor: return compile_blend_dst<BlendFactor::kOneMinusSrcColor>(dst_factor, op);
+		case BlendFactor::kDstColor: return compile_blend_dst<BlendFactor::kDstColor>(dst_factor, op);
+		case BlendFactor::kDstAlpha: return compile_blend_dst<BlendFactor::kDstAlpha>(dst_factor, op);
+		case BlendFactor::kOneMinusDstAlpha: return compile_blend_dst<BlendFactor::kOneMinusDstAlpha>(dst_factor, op);
+		case BlendFactor::kOneMinusDstColor: return compile_blend_dst<BlendFactor::kOneMinusDstColor>(dst_factor, op);
+		}
+		return compile_blend_dst<BlendFactor::kOne>(dst_factor, op);
+	}
+
+	uint32_t FrameBuffer::compile_color_mask(ColorMask color_mask)
+	{
+		tinymath::color_rgba mask;
+		mask.r = (color_mask & ColorMask::kRed) != ColorMask::kZero ? 0xFF : 0x00;
+		mask.g = (color_mask & ColorMask::kGreen) != ColorMask::kZero ? 0xFF : 0x00;
+		mask.b = (color_mask & ColorMask::kBlue) != ColorMask::kZero ? 0xFF : 0x00;
+		mask.a = (color_mask & ColorMask::kAlpha) != ColorMask::kZero ? 0xFF : 0x00;
+
+		uint32_t ret;
+		memcpy(&ret, &mask, 4);
+		return ret;
+	}
+
 	void FrameBuffer::write_color(size_t row, size_t col, const tinymath::color_rgba& color)
 	{
 		if ((content_flag & FrameContent::kColor) != FrameContent::kNone)
@@ -408,6 +486,29 @@ namespace CpuRasterizer
 		}
 	}
 
+	void FrameBuffer::clear(FrameContent flag, size_t row, size_t col, size_t rows, size_t cols)
+	{
+		if ((flag & content_flag & FrameContent::kColor) != FrameContent::kNone)
+		{
+			color_buffer->clear(clear_color, row, col, rows, cols);
+		}
+
+		if ((flag & content_flag & FrameContent::kDepth) != FrameContent::kNone)
+		{
+			depth_buffer->clear(kFarZ, row, col, rows, cols);
+		}
+
+		if ((flag & content_flag & FrameContent::kStencil) != FrameContent::kNone)
+		{
+			stencil_buffer->clear(kDefaultStencil, row, col, rows, cols);
+		}
+
+		if ((flag & content_flag & FrameContent::kCoverage) != FrameContent::kNone)
+		{
+			coverage_buffer->clear((coverage_t)0, row, col, rows, cols);
+		}
+	}
+
 	void FrameBuffer::set_clear_color(const tinymath::color_rgba& color)
 	{
 		clear_color = color;
@@ -423,6 +524,7 @@ namespace CpuRasterizer
 			if (color_buffer == nullptr)
 			{
 				color_buffer = std::make_unique<RawBuffer<tinymath::color_rgba>>(w, h);
+				color_buffer->set_layout(layout, kTileBits);
 			}
 			else
 			{
@@ -435,6 +537,7 @@ namespace CpuRasterizer
 			if (depth_buffer == nullptr)
 			{
 				depth_buffer = std::make_unique<RawBuffer<depth_t>>(w, h);
+				depth_buffer->set_layout(layout, kTileBits);
 			}
 			else
 			{
@@ -447,6 +550,7 @@ namespace CpuRasterizer
 			if (stencil_buffer == nullptr)
 			{
 				stencil_buffer = std::make_unique<RawBuffer<stencil_t>>(w, h);
+				stencil_buffer->set_layout(layout, kTileBits);
 			}
 			else
 			{
@@ -459,12 +563,65 @@ namespace CpuRasterizer
 			if (coverage_buffer == nullptr)
 			{
 				coverage_buffer = std::make_unique<RawBuffer<coverage_t>>(w, h);
+				coverage_buffer->set_layout(layout, kTileBits);
 			}
 			else
 			{
 				ImageUtil::resize(*coverage_buffer.get(), w, h, filtering);
 			}
 		}
+
+		if (linear_color_buffer != nullptr)
+		{
+			linear_color_buffer->reallocate(w, h);
+		}
+	}
+
+	void FrameBuffer::copy_region(const FrameBuffer& src, FrameContent flag, size_t src_row, size_t src_col, size_t dst_row, size_t dst_col, size_t rows, size_t cols)
+	{
+		if ((flag & FrameContent::kColor) != FrameContent::kNone && color_buffer != nullptr && src.color_buffer != nullptr)
+		{
+			color_buffer->copy_region(*src.color_buffer, src_row, src_col, dst_row, dst_col, rows, cols);
+		}
+
+		if ((flag & FrameContent::kDepth) != FrameContent::kNone && depth_buffer != nullptr && src.depth_buffer != nullptr)
+		{
+			depth_buffer->copy_region(*src.depth_buffer, src_row, src_col, dst_row, dst_col, rows, cols);
+		}
+
+		if ((flag & FrameContent::kStencil) != FrameContent::kNone && stencil_buffer != nullptr && src.stencil_buffer != nullptr)
+		{
+			stencil_buffer->copy_region(*src.stencil_buffer, src_row, src_col, dst_row, dst_col, rows, cols);
+		}
+
+		if ((flag & FrameContent::kCoverage) != FrameContent::kNone && coverage_buffer != nullptr && src.coverage_buffer != nullptr)
+		{
+			coverage_buffer->copy_region(*src.coverage_buffer, src_row, src_col, dst_row, dst_col, rows, cols);
+		}
+	}
+
+	void FrameBuffer::set_layout(MemoryLayout target_layout)
+	{
+		if (layout == target_layout)
+		{
+			return;
+		}
+
+		layout = target_layout;
+
+		if (color_buffer != nullptr) color_buffer->set_layout(layout, kTileBits);
+		if (depth_buffer != nullptr) depth_buffer->set_layout(layout, kTileBits);
+		if (stencil_buffer != nullptr) stencil_buffer->set_layout(layout, kTileBits);
+		if (coverage_buffer != nullptr) coverage_buffer->set_layout(layout, kTileBits);
+
+		if (layout == MemoryLayout::kTiled && color_buffer != nullptr)
+		{
+			linear_color_buffer = std::make_unique<RawBuffer<tinymath::color_rgba>>(width, height);
+		}
+		else
+		{
+			linear_color_buffer.reset();
+		}
 	}
 
 	RawBuffer<tinymath::color_rgba>* FrameBuffer::get_color_raw_buffer() const  
@@ -474,6 +631,13 @@ namespace CpuRasterizer
 
 	tinymath::color_rgba* FrameBuffer::get_color_buffer_ptr() const 
 	{ 
-		size_t size;  return color_buffer->get_ptr(size); 
+		size_t size;
+		if (linear_color_buffer != nullptr)
+		{
+			tinymath::color_rgba* dst = linear_color_buffer->get_ptr(size);
+			color_buffer->linearize(dst);
+			return dst;
+		}
+		return color_buffer->get_ptr(size); 
 	}
 }
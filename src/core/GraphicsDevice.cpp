@@ -16,6 +16,7 @@
 #include "GlobalShaderParams.hpp"
 #include "tinymath/primitives/Rect.h"
 #include "SegmentDrawer.hpp"
+#include "PostProcess.hpp"
 #include "Sampling.hpp"
 #include "ShaderProgram.hpp"
 
@@ -23,22 +24,222 @@ namespace CpuRasterizer
 {
 	constexpr resource_id kDefaultRenderTextureID = 0;
 
-	struct SubsampleParam
+	// per-sample coverage of one pixel, bit i is sample i of the fixed sample pattern
+	struct SampleCoverage
 	{
-		tinymath::color_rgba pixel_color;
-		bool pixel_color_calculated;
+		uint32_t mask;
+		uint8_t subsample_count;
+		uint8_t subsamples_per_axis;
+		float depths[kMaxSubsampleCount];
 	};
 
+	// working buffers of one tile, rows and cols of the buffers are relative to the tile origin
+	struct TileTarget
+	{
+		FrameBuffer* framebuffer;
+		FrameBuffer* msaa_framebuffer; // nullptr when msaa is off
+		size_t row;
+		size_t col;
+		size_t rows;
+		size_t cols;
+		size_t subsamples_per_axis;
+	};
+
+	// each worker thread keeps its own tile sized buffers
+	static thread_local std::unique_ptr<FrameBuffer> tile_framebuffer;
+	static thread_local std::unique_ptr<FrameBuffer> tile_msaa_framebuffer;
+
+	// the tile buffer follows the layout of the target, a tiled target then loads and stores each buffer with one copy
+	static FrameBuffer* acquire_tile_buffer(std::unique_ptr<FrameBuffer>& buffer, size_t size, FrameContent flag, MemoryLayout layout)
+	{
+		if (buffer == nullptr || buffer->get_width() != size || buffer->get_flag() != flag)
+		{
+			buffer = std::make_unique<FrameBuffer>(size, size, flag);
+		}
+		buffer->set_layout(layout);
+		return buffer.get();
+	}
+
+	constexpr uint32_t kOITListEnd = 0xFFFFFFFFu;
+
+	// blended fragment kept back for sorting, the fragments of one pixel are linked through next
+	struct OITFragment
+	{
+		float depth;
+		tinymath::color_rgba color;
+		uint32_t write_mask;
+		uint32_t next;
+		BlendFunction blend_function;
+	};
+
+	// per-pixel fragment lists of the tile in flight, allocated from a pool of fixed size
+	struct OITTilePool
+	{
+		std::vector<uint32_t> heads;
+		std::vector<OITFragment> fragments;
+		size_t cols = 0;
+		size_t pixel_count = 0;
+		size_t capacity = 0;
+		size_t count = 0;
+		size_t composited = 0; // fragments already blended by earlier flushes of this tile
+		size_t overflow = 0;
+		FrameBuffer* target = nullptr;
+		bool active = false;
+		bool used = false;
+	};
+
+	static thread_local OITTilePool oit_pool;
+
+	static void begin_oit_tile(FrameBuffer& target, size_t rows, size_t cols, size_t capacity)
+	{
+		oit_pool.target = &target;
+		oit_pool.cols = cols;
+		oit_pool.pixel_count = rows * cols;
+		oit_pool.capacity = tinymath::min(capacity, (size_t)kOITListEnd);
+		oit_pool.count = 0;
+		oit_pool.composited = 0;
+		oit_pool.overflow = 0;
+		oit_pool.active = true;
+		oit_pool.used = false;
+	}
+
+	// blend and color mask on packed colors, blend_function is nullptr when blending is off
+	static tinymath::color_rgba merge_color(const tinymath::color_rgba& src, const tinymath::color_rgba& dst, BlendFunction blend_function, uint32_t write_mask)
+	{
+		tinymath::color_rgba ret = blend_function != nullptr ? blend_function(src, dst) : src;
+
+		if (write_mask != 0xFFFFFFFFu)
+		{
+			uint32_t src_bits, dst_bits;
+			memcpy(&src_bits, &ret, 4);
+			memcpy(&dst_bits, &dst, 4);
+			src_bits = (src_bits & write_mask) | (dst_bits & ~write_mask);
+			memcpy(&ret, &src_bits, 4);
+		}
+
+		return ret;
+	}
+
+	// blends every pixel's list back to front onto the tile buffer and empties the lists
+	static void composite_oit_lists()
+	{
+		static thread_local std::vector<const OITFragment*> sorted;
+
+		if (!oit_pool.used || oit_pool.count == 0)
+		{
+			return;
+		}
+
+		FrameBuffer& buffer = *oit_pool.target;
+		for (size_t pixel = 0; pixel < oit_pool.pixel_count; ++pixel)
+		{
+			uint32_t head = oit_pool.heads[pixel];
+			if (head == kOITListEnd)
+			{
+				continue;
+			}
+
+			// lists are built newest first, reversed so equal depths keep draw order
+			sorted.clear();
+			for (uint32_t idx = head; idx != kOITListEnd; idx = oit_pool.fragments[idx].next)
+			{
+				sorted.push_back(&oit_pool.fragments[idx]);
+			}
+			std::reverse(sorted.begin(), sorted.end());
+			std::stable_sort(sorted.begin(), sorted.end(), [](const OITFragment* lhs, const OITFragment* rhs) { return lhs->depth > rhs->depth; });
+
+			oit_pool.heads[pixel] = kOITListEnd;
+			size_t row = pixel / oit_pool.cols;
+			size_t col = pixel % oit_pool.cols;
+			tinymath::color_rgba dst;
+			if (!buffer.read_color(row, col, dst))
+			{
+				continue;
+			}
+
+			for (auto fragment : sorted)
+			{
+				dst = merge_color(fragment->color, dst, fragment->blend_function, fragment->write_mask);
+			}
+			buffer.write_color(row, col, dst);
+		}
+
+		oit_pool.composited += oit_pool.count;
+		oit_pool.count = 0;
+	}
+
+	// composites what is left and closes the tile
+	static void composite_oit_tile()
+	{
+		composite_oit_lists();
+		oit_pool.active = false;
+	}
+
+	// false when no tile is in flight and the fragment has to be blended right away
+	static bool append_oit_fragment(size_t row, size_t col, float depth, const tinymath::color_rgba& color, const GraphicsContext& ctx)
+	{
+		if (!oit_pool.active || oit_pool.capacity == 0)
+		{
+			return false;
+		}
+
+		// the lists are only set up once a tile actually receives a blended fragment
+		if (!oit_pool.used)
+		{
+			oit_pool.heads.assign(oit_pool.pixel_count, kOITListEnd);
+			if (oit_pool.fragments.size() < oit_pool.capacity)
+			{
+				oit_pool.fragments.resize(oit_pool.capacity);
+			}
+			oit_pool.used = true;
+		}
+
+		// a full pool is composited and emptied first. everything in it was drawn earlier,
+		// so the later fragments land on top of it and only the sort across the two batches is lost
+		if (oit_pool.count >= oit_pool.capacity)
+		{
+			composite_oit_lists();
+			oit_pool.overflow++;
+		}
+
+		size_t pixel = row * oit_pool.cols + col;
+		OITFragment& fragment = oit_pool.fragments[oit_pool.count];
+		fragment.depth = depth;
+		fragment.color = color;
+		fragment.write_mask = ctx.color_write_mask;
+		fragment.blend_function = ctx.blend_function;
+		fragment.next = oit_pool.heads[pixel];
+		oit_pool.heads[pixel] = (uint32_t)oit_pool.count;
+		oit_pool.count++;
+		return true;
+	}
+
+	// blended fragments go to the tile pool instead of the color buffer
+	static bool is_oit_fragment(const GraphicsContext& ctx)
+	{
+		return GraphicsDevice::is_flag_enabled(ctx, PipelineFeature::kOIT) && GraphicsDevice::is_flag_enabled(ctx, PipelineFeature::kBlending);
+	}
+
 	GraphicsDevice::GraphicsDevice()
 	{
 		active_frame_buffer_id = kDefaultRenderTextureID;
 		statistics.culled_backface_triangle_count = 0;
 		statistics.culled_triangle_count = 0;
+		statistics.culled_coverage_triangle_count = 0;
+		statistics.micro_triangle_count = 0;
 		statistics.earlyz_optimized = 0;
 		statistics.triangle_count = 0;
+		statistics.oit_fragment_count = 0;
+		statistics.oit_overflow_count = 0;
+		statistics.culled_renderer_count = 0;
+		statistics.culled_shadow_caster_count = 0;
+		statistics.occluded_renderer_count = 0;
+		oit_pool_size = kDefaultOITPoolSize;
 		multi_thread = true;
 		tile_based = true;
 		msaa_dirty = false;
+		framebuffer_layout = MemoryLayout::kLinear;
+		set_resolve_encoding(ResolveEncoding::kNone);
 		context = GraphicsContext();
 		context.msaa_subsample_count = 4;
 		context.multi_sample_frequency = MultiSampleFrequency::kPixelFrequency;
@@ -61,8 +262,10 @@ namespace CpuRasterizer
 		context.src_factor = BlendFactor::kSrcAlpha;
 		context.dst_factor = BlendFactor::kOneMinusSrcAlpha;
 		context.blend_op = BlendFunc::kAdd;
-		vertex_buffer_table.push_back(std::vector<Vertex>()); // dummy buffer
-		index_buffer_table.push_back(std::vector<size_t>()); // dummy buffer
+		context.blend_function = FrameBuffer::compile_blend(context.src_factor, context.dst_factor, context.blend_op);
+		context.color_write_mask = FrameBuffer::compile_color_mask(context.color_mask);
+		vertex_buffer_table.push_back(VertexBuffer()); // dummy buffer
+		index_buffer_table.push_back(IndexBuffer()); // dummy buffer
 		shader_programs.push_back(nullptr); // dummy shader
 		rendertextures.push_back(nullptr); // dummy rt
 		context.current_index_buffer_id = 0;
@@ -82,6 +285,7 @@ namespace CpuRasterizer
 			target_rendertexture = std::make_unique<RenderTexture>(w, h, FrameContent::kColor | FrameContent::kDepth | FrameContent::kStencil, 
 																   is_flag_enabled(context, PipelineFeature::kMSAA),
 																   context.msaa_subsample_count);
+			target_rendertexture->set_layout(framebuffer_layout);
 		}
 		else
 		{
@@ -115,6 +319,7 @@ namespace CpuRasterizer
 	resource_id GraphicsDevice::create_buffer(size_t w, size_t h, FrameContent content)
 	{
 		auto buffer = std::make_shared<RenderTexture>(w, h, content);
+		buffer->set_layout(framebuffer_layout);
 		resource_id id = static_cast<resource_id>(rendertextures.size());
 		rendertextures.emplace_back(buffer);
 		return id;
@@ -134,6 +339,43 @@ namespace CpuRasterizer
 		active_frame_buffer_id = kDefaultRenderTextureID;
 	}
 
+	void GraphicsDevice::set_resolve_encoding(ResolveEncoding encoding)
+	{
+		resolve_encoding = encoding;
+		for (int idx = 0; idx < 256; ++idx)
+		{
+			float val = (float)idx / 255.0f;
+			if (encoding == ResolveEncoding::kSRGB)
+			{
+				val = tinymath::pow(val, 1.0f / 2.2f);
+			}
+			resolve_lut[idx] = (uint8_t)(val * 255.0f + 0.5f);
+		}
+	}
+
+	void GraphicsDevice::set_oit_pool_size(size_t fragments_per_tile)
+	{
+		oit_pool_size = fragments_per_tile;
+	}
+
+	void GraphicsDevice::set_framebuffer_layout(MemoryLayout layout)
+	{
+		framebuffer_layout = layout;
+
+		if (target_rendertexture != nullptr)
+		{
+			target_rendertexture->set_layout(layout);
+		}
+
+		for (auto& rt : rendertextures)
+		{
+			if (rt != nullptr)
+			{
+				rt->set_layout(layout);
+			}
+		}
+	}
+
 	bool GraphicsDevice::get_buffer(resource_id id, std::shared_ptr<RenderTexture>& buffer) const
 	{
 		buffer = nullptr;
@@ -147,14 +389,25 @@ namespace CpuRasterizer
 		return false;
 	}
 
+	// raw vertices are packed with the standard layout
 	resource_id GraphicsDevice::bind_vertex_buffer(const std::vector<Vertex>& buffer)
+	{
+		return bind_vertex_buffer(VertexBuffer(buffer, VertexLayout::standard()));
+	}
+
+	resource_id GraphicsDevice::bind_index_buffer(const std::vector<size_t>& buffer)
+	{
+		return bind_index_buffer(IndexBuffer(buffer));
+	}
+
+	resource_id GraphicsDevice::bind_vertex_buffer(const VertexBuffer& buffer)
 	{
 		resource_id id = static_cast<resource_id>(vertex_buffer_table.size());
 		vertex_buffer_table.emplace_back(buffer);
 		return id;
 	}
 
-	resource_id GraphicsDevice::bind_index_buffer(const std::vector<size_t>& buffer)
+	resource_id GraphicsDevice::bind_index_buffer(const IndexBuffer& buffer)
 	{
 		resource_id id = static_cast<resource_id>(index_buffer_table.size());
 		index_buffer_table.emplace_back(buffer);
@@ -340,6 +593,10 @@ namespace CpuRasterizer
 
 		auto& ib = index_buffer_table[context.current_index_buffer_id];
 
+		// blend state is compiled once per draw
+		context.blend_function = FrameBuffer::compile_blend(context.src_factor, context.dst_factor, context.blend_op);
+		context.color_write_mask = FrameBuffer::compile_color_mask(context.color_mask);
+
 		for (size_t idx = 0; idx < ib.size(); idx += 3)
 		{
 			context.indices[0] = ib[idx];
@@ -351,6 +608,12 @@ namespace CpuRasterizer
 
 	void GraphicsDevice::fence_primitives()
 	{
+		// direct rasterization writes the render target, fill in pending clears first
+		if (!tile_based)
+		{
+			get_active_rendertexture()->resolve_pending_clears();
+		}
+
 		std::for_each(
 			std::execution::par_unseq,
 			contexts.begin(),
@@ -358,9 +621,10 @@ namespace CpuRasterizer
 			[this](auto&& ctx)
 		{
 			auto& vb = vertex_buffer_table[ctx.current_vertex_buffer_id];
-			auto& v1 = vb[ctx.indices[0]];
-			auto& v2 = vb[ctx.indices[1]];
-			auto& v3 = vb[ctx.indices[2]];
+			// decoded from the packed layout at fetch
+			Vertex v1 = vb[ctx.indices[0]];
+			Vertex v2 = vb[ctx.indices[1]];
+			Vertex v3 = vb[ctx.indices[2]];
 			input2vertex(ctx, v1, v2, v3);
 		});
 
@@ -369,14 +633,44 @@ namespace CpuRasterizer
 
 	void GraphicsDevice::fence_pixels()
 	{
+		statistics.oit_fragment_count = 0;
+		statistics.oit_overflow_count = 0;
+
 		get_active_rendertexture()->get_tile_based_manager()->foreach_tile(
 			[this](auto&& rect, auto&& task_queue)
 		{
 			this->rasterize_tile(rect, task_queue);
-			if (is_flag_enabled(context, PipelineFeature::kMSAA))
-			{
-				this->resolve_tile(rect, task_queue);
-			}
+		});
+
+		if (is_flag_enabled(context, PipelineFeature::kPostAA))
+		{
+			post_process_aa();
+		}
+	}
+
+	void GraphicsDevice::post_process_aa()
+	{
+		RenderTexture& rt = *get_active_rendertexture();
+		RawBuffer<tinymath::color_rgba>* color_buffer = rt.get_color_raw_buffer();
+		if (color_buffer == nullptr)
+		{
+			return;
+		}
+
+		// neighbors are read across tile borders, so tiles read from a snapshot of the frame
+		size_t w = color_buffer->get_width();
+		size_t h = color_buffer->get_height();
+		if (post_aa_source == nullptr || post_aa_source->get_width() != w || post_aa_source->get_height() != h)
+		{
+			post_aa_source = std::make_unique<RawBuffer<tinymath::color_rgba>>(w, h);
+		}
+		post_aa_source->copy_region(*color_buffer, 0, 0, 0, 0, h, w);
+
+		rt.get_tile_based_manager()->foreach_tile(
+			[this, color_buffer](auto&& rect, auto&& task_queue)
+		{
+			UNUSED(task_queue);
+			PostProcess::fxaa(*post_aa_source, *color_buffer, rect);
 		});
 	}
 
@@ -392,6 +686,8 @@ namespace CpuRasterizer
 
 		statistics.culled_triangle_count = 0;
 		statistics.culled_backface_triangle_count = 0;
+		statistics.culled_coverage_triangle_count = 0;
+		statistics.micro_triangle_count = 0;
 		statistics.triangle_count = 0;
 		statistics.earlyz_optimized = 0;
 	}
@@ -473,16 +769,34 @@ namespace CpuRasterizer
 		Vertex s2 = Pipeline::ndc2screen(w, h, ndc2);
 		Vertex s3 = Pipeline::ndc2screen(w, h, ndc3);
 
-		// triangle assembly
-		std::vector<Triangle> assembled_triangles = Triangle(s1, s2, s3).horizontally_split();
-		for (auto triangle = assembled_triangles.begin(); triangle != assembled_triangles.end(); triangle++)
+		if (this->tile_based)
 		{
-			if (this->tile_based)
+			// triangle setup, the edge function rasterizer does not need horizontal split
+			Triangle triangle(s1, s2, s3);
+			bool multisample = is_flag_enabled(ctx, PipelineFeature::kMSAA) && get_active_rendertexture()->has_msaa_buf();
+			if (!triangle.setup_edges(multisample)) { statistics.culled_triangle_count++; return; }
+
+			// bounding box contains no sample
+			if (triangle.raster_bounds.empty()) { statistics.culled_coverage_triangle_count++; return; }
+
+			// micro triangles are still binned, the tiles load the target into per thread working buffers and store them back,
+			// so a triangle written straight into the target here would be overwritten by the store of its tile and would
+			// lose its place in the draw order that blending, depth and stencil rely on.
+			// the bin is one tile, or two when the blocks straddle a tile edge, and rasterize_micro walks only the blocks
+			// instead of the 16x16 tile
+			if (triangle.micro)
 			{
-				// push rasterization task
-				get_active_rendertexture()->get_tile_based_manager()->push_draw_task(*triangle, ctx);
+				statistics.micro_triangle_count++;
 			}
-			else
+
+			// push rasterization task
+			get_active_rendertexture()->get_tile_based_manager()->push_draw_task(triangle, ctx);
+		}
+		else
+		{
+			// triangle assembly
+			std::vector<Triangle> assembled_triangles = Triangle(s1, s2, s3).horizontally_split();
+			for (auto triangle = assembled_triangles.begin(); triangle != assembled_triangles.end(); triangle++)
 			{
 				// rasterize triangle directly
 				rasterize(*triangle, ctx, RasterizerStrategy::kScanline);
@@ -492,22 +806,70 @@ namespace CpuRasterizer
 
 	void GraphicsDevice::rasterize_tile(const tinymath::Rect& rect, SafeQueue<TileTask>& task_queue)
 	{
-		while (!task_queue.empty())
+		RenderTexture& rt = *get_active_rendertexture();
+		bool msaa_on = is_flag_enabled(context, PipelineFeature::kMSAA) && rt.has_msaa_buf();
+		std::vector<Triangle> wireframes;
+
+		if (!task_queue.empty())
 		{
-			TileTask task;
-			if (task_queue.try_consume(task))
+			// load the tile into the working buffers of this thread, all binned triangles run against them
+			TileTarget target = load_tile(rt, rect, msaa_on);
+			FrameBuffer& color_target = target.msaa_framebuffer != nullptr ? *target.msaa_framebuffer : *target.framebuffer;
+			begin_oit_tile(color_target, target.rows * target.subsamples_per_axis, target.cols * target.subsamples_per_axis, oit_pool_size);
+
+			while (!task_queue.empty())
 			{
-				rasterize(rect, task.context, task.triangle);
+				TileTask task;
+				if (task_queue.try_consume(task))
+				{
+					if (task.triangle.micro)
+					{
+						rasterize_micro(target, rect, task.context, task.triangle);
+					}
+					else
+					{
+						rasterize(target, rect, task.context, task.triangle);
+					}
 
-				// wireframe
-				if ((CpuRasterSharedData.debug_flag & RenderFlag::kWireFrame) != RenderFlag::kNone)
+					if ((CpuRasterSharedData.debug_flag & RenderFlag::kWireFrame) != RenderFlag::kNone)
+					{
+						wireframes.emplace_back(task.triangle);
+					}
+				}
+			}
+
+			// transparent fragments are sorted and blended before the tile is stored
+			composite_oit_tile();
+			if (oit_pool.composited > 0 || oit_pool.overflow > 0)
+			{
+				statistics.oit_fragment_count += oit_pool.composited;
+				statistics.oit_overflow_count += oit_pool.overflow;
+			}
+
+			// store back and resolve once per tile
+			store_tile(rt, rect, target);
+
+			// wireframe, clipped to this tile so the stores of the neighbouring tiles can not overwrite it
+			auto wire_color = ColorEncoding::encode_rgba(tinymath::Color(0.5f, 0.5f, 1.0f, 1.0f));
+			for (auto& tri : wireframes)
+			{
+				for (size_t idx = 0; idx < 3; ++idx)
 				{
-					draw_screen_segment(task.triangle[0].position, task.triangle[1].position, tinymath::Color(0.5f, 0.5f, 1.0f, 1.0f));
-					draw_screen_segment(task.triangle[0].position, task.triangle[2].position, tinymath::Color(0.5f, 0.5f, 1.0f, 1.0f));
-					draw_screen_segment(task.triangle[2].position, task.triangle[1].position, tinymath::Color(0.5f, 0.5f, 1.0f, 1.0f));
+					auto& start = tri[idx].position;
+					auto& end = tri[(idx + 1) % 3].position;
+					SegmentDrawer::bresenham(rt.get_color_raw_buffer(), (int)start.x, (int)start.y, (int)end.x, (int)end.y, wire_color, rect.min().y, rect.max().y, rect.min().x, rect.max().x);
 				}
 			}
 		}
+		else
+		{
+			// untouched tile, the pending clear is filled in here
+			rt.resolve_pending_clear(rect);
+			if (msaa_on)
+			{
+				resolve_tile(rt, rect, *rt.get_msaa_framebuffer(), 0, 0);
+			}
+		}
 
 		if ((CpuRasterSharedData.debug_flag & RenderFlag::kFrameTile) != RenderFlag::kNone)
 		{
@@ -530,145 +892,256 @@ namespace CpuRasterizer
 		}
 	}
 
-	void GraphicsDevice::resolve_tile(const tinymath::Rect& rect, SafeQueue<TileTask>& task_queue)
+	TileTarget GraphicsDevice::load_tile(const RenderTexture& rt, const tinymath::Rect& rect, bool msaa_on)
 	{
-		UNUSED(task_queue);
-		if (!get_active_rendertexture()->has_msaa_buf())
-			return;
+		TileTarget target;
+		target.row = (size_t)rect.min().y;
+		target.col = (size_t)rect.min().x;
+		target.rows = kTileSize;
+		target.cols = kTileSize;
+		target.subsamples_per_axis = 1;
+		target.msaa_framebuffer = nullptr;
+
+		// contents with a pending clear are cleared locally instead of loaded
+		FrameBuffer& src = *rt.get_framebuffer();
+		FrameContent cleared = rt.consume_pending_clear(rect);
+		target.framebuffer = acquire_tile_buffer(tile_framebuffer, kTileSize, src.get_flag(), src.get_layout());
+		target.framebuffer->copy_region(src, ~cleared, target.row, target.col, 0, 0, target.rows, target.cols);
+		target.framebuffer->set_clear_color(src.get_clear_color());
+		target.framebuffer->clear(cleared);
+
+		FrameContent msaa_cleared = rt.consume_pending_msaa_clear(rect);
+		if (msaa_on)
+		{
+			size_t axis = (size_t)rt.get_subsamples_per_axis();
+			FrameBuffer& msaa_src = *rt.get_msaa_framebuffer();
+			target.subsamples_per_axis = axis;
+			target.msaa_framebuffer = acquire_tile_buffer(tile_msaa_framebuffer, kTileSize * axis, msaa_src.get_flag(), msaa_src.get_layout());
+			target.msaa_framebuffer->copy_region(msaa_src, ~msaa_cleared, target.row * axis, target.col * axis, 0, 0, target.rows * axis, target.cols * axis);
+			target.msaa_framebuffer->set_clear_color(msaa_src.get_clear_color());
+			target.msaa_framebuffer->clear(msaa_cleared);
+		}
+		else if (msaa_cleared != FrameContent::kNone)
+		{
+			// msaa is off for this pass, keep the sample buffer cleared for later passes
+			rt.get_msaa_framebuffer()->clear(msaa_cleared, target.row * rt.get_subsamples_per_axis(), target.col * rt.get_subsamples_per_axis(), kTileSize * rt.get_subsamples_per_axis(), kTileSize * rt.get_subsamples_per_axis());
+		}
 
-		get_active_rendertexture()->foreach_pixel(
-			rect,
-			[this](auto&& buffer, auto&& pixel)
+		return target;
+	}
+
+	void GraphicsDevice::store_tile(RenderTexture& rt, const tinymath::Rect& rect, const TileTarget& target)
+	{
+		rt.get_framebuffer()->copy_region(*target.framebuffer, target.framebuffer->get_flag(), 0, 0, target.row, target.col, target.rows, target.cols);
+
+		if (target.msaa_framebuffer != nullptr)
 		{
-			tinymath::Color pixel_color = { 0.0f, 0.0f, 0.0f, 1.0f };
+			size_t axis = target.subsamples_per_axis;
+			rt.get_msaa_framebuffer()->copy_region(*target.msaa_framebuffer, target.msaa_framebuffer->get_flag(), 0, 0, target.row * axis, target.col * axis, target.rows * axis, target.cols * axis);
+			resolve_tile(rt, rect, *target.msaa_framebuffer, target.row * axis, target.col * axis);
+		}
+	}
 
-			for (uint8_t x_subsample_idx = 0; x_subsample_idx < buffer.get_subsamples_per_axis(); ++x_subsample_idx)
+	// average of packed rgba8 samples, two channels per 32-bit lane so the sums can not overflow
+	static uint32_t average_samples(const RawBuffer<tinymath::color_rgba>& samples, size_t row, size_t col, size_t axis, uint32_t shift)
+	{
+		uint32_t rb = 0;
+		uint32_t ga = 0;
+		for (size_t r = row; r < row + axis; ++r)
+		{
+			for (size_t c = col; c < col + axis; ++c)
 			{
-				for (uint8_t y_subsample_idx = 0; y_subsample_idx < buffer.get_subsamples_per_axis(); ++y_subsample_idx)
-				{
-					auto subpixel = buffer.get_subpixel(pixel.row, pixel.col, x_subsample_idx, y_subsample_idx);
-					uint8_t coverage = 0;
-					if (buffer.get_msaa_framebuffer()->read_coverage(subpixel.row, subpixel.col, coverage) && coverage > 0)
-					{
-						tinymath::color_rgba msaa_color;
-						buffer.get_msaa_framebuffer()->read_color(subpixel.row, subpixel.col, msaa_color);
-						pixel_color += ColorEncoding::decode(msaa_color);
-					}
-				}
+				uint32_t packed;
+				memcpy(&packed, &samples.at(r, c), sizeof(uint32_t));
+				rb += packed & 0x00FF00FFu;
+				ga += (packed >> 8) & 0x00FF00FFu;
 			}
-
-			float weight = 1.0f / (float)buffer.get_subsample_count();
-			pixel_color *= weight;
-			pixel_color.a = 1.0f;
-			buffer.get_framebuffer()->write_color(pixel.row, pixel.col, ColorEncoding::encode_rgba(pixel_color));
 		}
-		);
+
+		uint32_t round = (1u << shift) >> 1;
+		rb = ((rb + round * 0x00010001u) >> shift) & 0x00FF00FFu;
+		ga = ((ga + round * 0x00010001u) >> shift) & 0x00FF00FFu;
+		return rb | (ga << 8);
 	}
 
-	void GraphicsDevice::rasterize(const tinymath::Rect& rect, const GraphicsContext& ctx, const Triangle& tri)
+	void GraphicsDevice::resolve_tile(RenderTexture& rt, const tinymath::Rect& rect, FrameBuffer& msaa_buffer, size_t origin_row, size_t origin_col)
 	{
-		auto bounds = tri.get_bounds();
-		int padding = kBoundsPadding;
-		int row_start = bounds.min().y - padding;
-		int row_end = bounds.max().y + padding;
-		int col_start = bounds.min().x - padding;
-		int col_end = bounds.max().x + padding;
+		const RawBuffer<tinymath::color_rgba>& samples = *msaa_buffer.get_color_raw_buffer();
+		const RawBuffer<coverage_t>& states = *msaa_buffer.get_coverage_raw_buffer();
+		RawBuffer<tinymath::color_rgba>& target = *rt.get_color_raw_buffer();
+
+		size_t axis = (size_t)rt.get_subsamples_per_axis();
+		uint32_t shift = axis == 2 ? 2 : 4;
+		bool encode = resolve_encoding != ResolveEncoding::kNone;
 
-		row_start = tinymath::clamp(row_start, rect.y(), rect.y() + rect.size().y);
-		row_end = tinymath::clamp(row_end, rect.y(), rect.y() + rect.size().y);
-		col_start = tinymath::clamp(col_start, rect.x(), rect.x() + rect.size().x);
-		col_end = tinymath::clamp(col_end, rect.y(), rect.x() + rect.size().x);
+		size_t row_end = tinymath::min((size_t)rect.max().y, target.get_height());
+		size_t col_end = tinymath::min((size_t)rect.max().x, target.get_width());
 
-		if (is_flag_enabled(ctx, PipelineFeature::kMSAA) && get_active_rendertexture()->has_msaa_buf())
+		for (size_t row = (size_t)rect.min().y; row < row_end; ++row)
 		{
-			// msaa on
-			get_active_rendertexture()->foreach_pixel_block(
-				rect,
-				[this, tri, &ctx](auto&& buffer, auto&& block)
+			for (size_t col = (size_t)rect.min().x; col < col_end; ++col)
 			{
-				SubsampleParam sp1 = { {0, 0, 0, 1}, false };
-				SubsampleParam sp2 = { {0, 0, 0, 1}, false };
-				SubsampleParam sp3 = { {0, 0, 0, 1}, false };
-				SubsampleParam sp4 = { {0, 0, 0, 1}, false };
+				size_t sample_row = row * axis - origin_row;
+				size_t sample_col = col * axis - origin_col;
 
-				for (uint8_t x_subsample_idx = 0; x_subsample_idx < buffer.get_subsamples_per_axis(); ++x_subsample_idx)
+				// compressed pixels are a straight copy, only edge pixels are averaged
+				tinymath::color_rgba color;
+				if (states.at(sample_row, sample_col) == kSamplesCompressed)
 				{
-					for (uint8_t y_subsample_idx = 0; y_subsample_idx < buffer.get_subsamples_per_axis(); ++y_subsample_idx)
-					{
-						auto px1 = buffer.get_subpixel(block.top_left.row, block.top_left.col, x_subsample_idx, y_subsample_idx);
-						auto px2 = buffer.get_subpixel(block.top_right.row, block.top_right.col, x_subsample_idx, y_subsample_idx);
-						auto px3 = buffer.get_subpixel(block.bottom_left.row, block.bottom_left.col, x_subsample_idx, y_subsample_idx);
-						auto px4 = buffer.get_subpixel(block.bottom_right.row, block.bottom_right.col, x_subsample_idx, y_subsample_idx);
-						rasterize_pixel_block(tri, ctx, buffer, px1, px2, px3, px4, sp1, sp2, sp3, sp4);
-					}
+					color = samples.at(sample_row, sample_col);
 				}
-			});
-		}
-		else
-		{
-			// msaa off
-			get_active_rendertexture()->foreach_pixel_block(
-				rect,
-				[this, &tri, &ctx](auto&& buffer, auto&& block)
-			{
-				SubsampleParam sp;
-				Pixel p1, p2, p3, p4;
-				p1 = block.top_left;
-				p2 = block.top_right;
-				p3 = block.bottom_left;
-				p4 = block.bottom_right;
-				rasterize_pixel_block(tri, ctx, buffer, p1, p2, p3, p4, sp, sp, sp, sp);
-			});
+				else
+				{
+					uint32_t packed = average_samples(samples, sample_row, sample_col, axis, shift);
+					memcpy(&color, &packed, sizeof(uint32_t));
+				}
+
+				if (encode)
+				{
+					color.r = resolve_lut[color.r];
+					color.g = resolve_lut[color.g];
+					color.b = resolve_lut[color.b];
+				}
+
+				color.a = 255;
+				target.at(row, col) = color;
+			}
 		}
 	}
 
-	void GraphicsDevice::rasterize_pixel_block(const Triangle& tri,
-											   const GraphicsContext& ctx,
-											   const RenderTexture& rt, 
-											   const Pixel& px1,
-											   const Pixel& px2,
-											   const Pixel& px3,
-											   const Pixel& px4,
-											   SubsampleParam& p1,
-											   SubsampleParam& p2,
-											   SubsampleParam& p3,
-											   SubsampleParam& p4)
+	void GraphicsDevice::rasterize(const TileTarget& target, const tinymath::Rect& rect, const GraphicsContext& ctx, const Triangle& tri)
 	{
-		Fragment frag1, frag2, frag3, frag4;
-
-		bool px1_inside = tri.barycentric_interpolate(px1.pos, frag1);
-		bool px2_inside = tri.barycentric_interpolate(px2.pos, frag2);
-		bool px3_inside = tri.barycentric_interpolate(px3.pos, frag3);
-		bool px4_inside = tri.barycentric_interpolate(px4.pos, frag4);
+		int row_start = tinymath::max(tri.raster_bounds.min_y, rect.min().y);
+		int row_end = tinymath::min(tri.raster_bounds.max_y, rect.max().y);
+		int col_start = tinymath::max(tri.raster_bounds.min_x, rect.min().x);
+		int col_end = tinymath::min(tri.raster_bounds.max_x, rect.max().x);
 
-		frag1 = Pipeline::reverse_perspective_division(frag1);
-		frag2 = Pipeline::reverse_perspective_division(frag2);
-		frag3 = Pipeline::reverse_perspective_division(frag3);
-		frag4 = Pipeline::reverse_perspective_division(frag4);
+		if (row_start >= row_end || col_start >= col_end)
+		{
+			return;
+		}
 
-		Fragment ddx = Pipeline::substract(frag1, frag2);
-		Fragment ddy = Pipeline::substract(frag1, frag3);
+		// align to 2x2 pixel blocks of the tile, derivatives are calculated per block
+		row_start -= (row_start - rect.min().y) & 1;
+		col_start -= (col_start - rect.min().x) & 1;
+		auto bounds = tinymath::Rect(col_start, row_start, tinymath::round_up(col_end - col_start, 2), tinymath::round_up(row_end - row_start, 2));
 
-		FrameBuffer& fb = (is_flag_enabled(ctx, PipelineFeature::kMSAA) && rt.has_msaa_buf()) ? *rt.get_msaa_framebuffer() : *rt.get_framebuffer();
+		get_active_rendertexture()->foreach_pixel_block(
+			bounds,
+			[this, &target, &tri, &ctx](auto&& buffer, auto&& block)
+		{
+			rasterize_block(target, buffer, ctx, tri, block);
+		});
+	}
 
-		if (px1_inside)
+	void GraphicsDevice::rasterize_micro(const TileTarget& target, const tinymath::Rect& rect, const GraphicsContext& ctx, const Triangle& tri)
+	{
+		// one or two 2x2 blocks, tiles are block aligned so the blocks can be walked directly
+		RenderTexture& rt = *get_active_rendertexture();
+		int row_start = tinymath::max(tri.raster_bounds.min_y & ~1, rect.min().y);
+		int row_end = tinymath::min(tri.raster_bounds.max_y, rect.max().y);
+		int col_start = tinymath::max(tri.raster_bounds.min_x & ~1, rect.min().x);
+		int col_end = tinymath::min(tri.raster_bounds.max_x, rect.max().x);
+
+		for (int row = row_start; row < row_end; row += 2)
 		{
-			multisample_fragment_stage(fb, frag1, ddx, ddy, px1.row, px1.col, ctx, p1);
+			for (int col = col_start; col < col_end; col += 2)
+			{
+				rasterize_block(target, rt, ctx, tri, RenderTexture::get_pixel_block((size_t)row, (size_t)col));
+			}
 		}
+	}
+
+	void GraphicsDevice::rasterize_block(const TileTarget& target, RenderTexture& buffer, const GraphicsContext& ctx, const Triangle& tri, const PixelBlock& block)
+	{
+		if (is_flag_enabled(ctx, PipelineFeature::kMSAA) && target.msaa_framebuffer != nullptr)
+		{
+			// msaa on, coverage is tested per sample against the edge functions
+			uint8_t subsample_count = buffer.get_subsample_count();
+			const tinymath::vec2i* sample_offsets = RenderTexture::get_sample_offsets(subsample_count);
+			const Pixel* pixels[4] = { &block.top_left, &block.top_right, &block.bottom_left, &block.bottom_right };
+
+			SampleCoverage coverage[4];
+			bool covered = false;
+			for (int i = 0; i < 4; ++i)
+			{
+				coverage[i].subsample_count = subsample_count;
+				coverage[i].subsamples_per_axis = buffer.get_subsamples_per_axis();
+				coverage[i].mask = tri.coverage_mask(pixels[i]->row, pixels[i]->col, sample_offsets, subsample_count, coverage[i].depths);
+				covered = covered || coverage[i].mask != 0;
+			}
 
-		if (px2_inside)
+			if (covered)
+			{
+				rasterize_pixel_block(tri, ctx, *target.msaa_framebuffer, target.row, target.col, block, coverage);
+			}
+		}
+		else
 		{
-			multisample_fragment_stage(fb, frag2, ddx, ddy, px2.row, px2.col, ctx, p2);
+			// msaa off
+			rasterize_pixel_block(tri, ctx, *target.framebuffer, target.row, target.col, block, nullptr);
 		}
+	}
 
-		if (px3_inside)
+	void GraphicsDevice::rasterize_pixel_block(const Triangle& tri,
+											   const GraphicsContext& ctx,
+											   FrameBuffer& fb,
+											   size_t origin_row,
+											   size_t origin_col,
+											   const PixelBlock& block,
+											   const SampleCoverage* coverage)
+	{
+		const Pixel* pixels[4] = { &block.top_left, &block.top_right, &block.bottom_left, &block.bottom_right };
+		Fragment frags[4];
+		bool inside[4];
+
+		// attributes at pixel centers, also used for derivatives
+		for (int i = 0; i < 4; ++i)
 		{
-			multisample_fragment_stage(fb, frag3, ddx, ddy, px3.row, px3.col, ctx, p3);
+			inside[i] = tri.edge_interpolate(pixels[i]->pos, frags[i]);
+			frags[i] = Pipeline::reverse_perspective_division(frags[i]);
 		}
 
-		if (px4_inside)
+		Fragment ddx = Pipeline::substract(frags[0], frags[1]);
+		Fragment ddy = Pipeline::substract(frags[0], frags[2]);
+
+		// fb is the tile working buffer, rows and cols are relative to its origin
+		for (int i = 0; i < 4; ++i)
 		{
-			multisample_fragment_stage(fb, frag4, ddx, ddy, px4.row, px4.col, ctx, p4);
+			size_t row = pixels[i]->row - origin_row;
+			size_t col = pixels[i]->col - origin_col;
+
+			if (coverage == nullptr)
+			{
+				if (inside[i])
+				{
+					fragment_stage(fb, frags[i], ddx, ddy, row, col, ctx);
+				}
+			}
+			else if (coverage[i].mask != 0)
+			{
+				if (ctx.multi_sample_frequency == MultiSampleFrequency::kSubsampleFrequency)
+				{
+					// sample rate shading, attributes are interpolated at every covered sample
+					const tinymath::vec2i* sample_offsets = RenderTexture::get_sample_offsets(coverage[i].subsample_count);
+					for (uint8_t idx = 0; idx < coverage[i].subsample_count; ++idx)
+					{
+						if ((coverage[i].mask & (1u << idx)) != 0)
+						{
+							tinymath::vec2f pos((float)pixels[i]->col + (float)sample_offsets[idx].x / kSubpixelStep, (float)pixels[i]->row + (float)sample_offsets[idx].y / kSubpixelStep);
+							Fragment frag;
+							tri.edge_interpolate(pos, frag);
+							SampleCoverage sample = coverage[i];
+							sample.mask = 1u << idx;
+							multisample_fragment_stage(fb, Pipeline::reverse_perspective_division(frag), ddx, ddy, row, col, sample, ctx);
+						}
+					}
+				}
+				else
+				{
+					multisample_fragment_stage(fb, frags[i], ddx, ddy, row, col, coverage[i], ctx);
+				}
+			}
 		}
 	}
 
@@ -759,169 +1232,216 @@ namespace CpuRasterizer
 		}
 	}
 
-	bool GraphicsDevice::fragment_stage(FrameBuffer& rt, const Fragment& frag, const Fragment& ddx, const Fragment& ddy, size_t row, size_t col, const GraphicsContext& ctx)
-	{
-		SubsampleParam subsample_param;
-		return multisample_fragment_stage(rt, frag, ddx, ddy, row, col, ctx, subsample_param);
-	}
-
-	bool GraphicsDevice::multisample_fragment_stage(FrameBuffer& buffer, const Fragment& frag, const Fragment& ddx, const Fragment& ddy, size_t row, size_t col, const GraphicsContext& ctx, SubsampleParam& subsample_param)
+	bool GraphicsDevice::fragment_stage(FrameBuffer& buffer, const Fragment& frag, const Fragment& ddx, const Fragment& ddy, size_t row, size_t col, const GraphicsContext& ctx)
 	{
 		auto& shader = *ctx.shader;
 
-		tinymath::color_rgba pixel_color;
-
-		bool enable_scissor_test = is_flag_enabled(ctx, PipelineFeature::kScissorTest);
 		bool enable_alpha_test = is_flag_enabled(ctx, PipelineFeature::kAlphaTest); 
 		bool enable_stencil_test = is_flag_enabled(ctx, PipelineFeature::kStencilTest); 
 		bool enable_depth_test = is_flag_enabled(ctx, PipelineFeature::kDepthTest);
 
-		PipelineFeature op_pass = PipelineFeature::kScissorTest | PipelineFeature::kAlphaTest | PipelineFeature::kStencilTest | PipelineFeature::kDepthTest;
-
 		float z = frag.position.z / frag.position.w;
 
-		ColorMask color_mask = ctx.color_mask;
-		CompareFunc stencil_func = ctx.stencil_func;
-		StencilOp stencil_pass_op = ctx.stencil_pass_op;
-		StencilOp stencil_fail_op = ctx.stencil_fail_op;
-		StencilOp stencil_zfail_op = ctx.stencil_zfail_op;
-		uint8_t stencil_read_mask = ctx.stencil_read_mask;
-		uint8_t stencil_write_mask = ctx.stencil_write_mask;
-		uint8_t stencil_ref_val = ctx.stencil_ref_val;
-		CompareFunc ztest_func = ctx.ztest_func;
-		bool zwrite_on = is_flag_enabled(ctx, PipelineFeature::kZWrite);
-		BlendFactor src_factor = ctx.src_factor;
-		BlendFactor dst_factor = ctx.dst_factor;
-		BlendFunc blend_op = ctx.blend_op;
-		bool enable_blending = is_flag_enabled(ctx, PipelineFeature::kBlending);
-
-		UNUSED(stencil_write_mask);
-
 		// early-z
 		if (enable_depth_test && !enable_alpha_test && !enable_stencil_test)
 		{
-			if (!buffer.perform_depth_test(ztest_func, row, col, z))
+			if (!buffer.perform_depth_test(ctx.ztest_func, row, col, z))
 			{
-				op_pass &= ~PipelineFeature::kDepthTest;
 				statistics.earlyz_optimized++;
 				return false; // assume fragment shader will not modify depth. todo: notify depth modification
 			}
 		}
 
 		// fragment shader
-		tinymath::Color fragment_result = tinymath::kColorBlack;
+		v2f v_out = frag_to_v2f(frag);
+		v_out.ddx = ddx;
+		v_out.ddy = ddy;
+		tinymath::Color fragment_result = shader.fragment_shader(v_out);
+
+		// acctually alpha test is a deprecated feature in newer graphics API, cuz it can be emulated by discard() or clip()
+		if (enable_alpha_test && shader.discarded)
+		{
+			return false;
+		}
 
-		if (!is_flag_enabled(ctx, PipelineFeature::kMSAA) || 
-			!subsample_param.pixel_color_calculated ||
-			ctx.multi_sample_frequency == MultiSampleFrequency::kSubsampleFrequency)
+		if (!depth_stencil_stage(buffer, row, col, z, ctx))
 		{
-			v2f v_out = frag_to_v2f(frag);
+			return false;
+		}
+
+		if (is_oit_fragment(ctx) && append_oit_fragment(row, col, z, ColorEncoding::encode_rgba(fragment_result), ctx))
+		{
+			return true;
+		}
+
+		buffer.write_color(row, col, output_merge(buffer, row, col, fragment_result, ctx));
+		return true;
+	}
+
+	bool GraphicsDevice::multisample_fragment_stage(FrameBuffer& buffer, const Fragment& frag, const Fragment& ddx, const Fragment& ddy, size_t row, size_t col, const SampleCoverage& coverage, const GraphicsContext& ctx)
+	{
+		auto& shader = *ctx.shader;
+
+		bool enable_alpha_test = is_flag_enabled(ctx, PipelineFeature::kAlphaTest); 
+		bool enable_stencil_test = is_flag_enabled(ctx, PipelineFeature::kStencilTest); 
+		bool enable_depth_test = is_flag_enabled(ctx, PipelineFeature::kDepthTest);
+
+		// samples of pixel (row, col) are stored in an axis x axis block of the msaa buffer
+		size_t axis = coverage.subsamples_per_axis;
+		size_t sample_row = row * axis;
+		size_t sample_col = col * axis;
+		uint32_t mask = coverage.mask;
+
+		// early-z per sample, the shader is skipped when no sample survives
+		if (enable_depth_test && !enable_alpha_test && !enable_stencil_test)
+		{
+			for (uint8_t idx = 0; idx < coverage.subsample_count; ++idx)
+			{
+				uint32_t bit = 1u << idx;
+				if ((mask & bit) != 0 && !buffer.perform_depth_test(ctx.ztest_func, sample_row + idx / axis, sample_col + idx % axis, coverage.depths[idx]))
+				{
+					mask &= ~bit;
+				}
+			}
 
-			v_out.ddx = ddx;
-			v_out.ddy = ddy;
+			if (mask == 0)
+			{
+				statistics.earlyz_optimized++;
+				return false;
+			}
+		}
+
+		// fragment shader, once for all covered samples
+		v2f v_out = frag_to_v2f(frag);
+		v_out.ddx = ddx;
+		v_out.ddy = ddy;
+		tinymath::Color fragment_result = shader.fragment_shader(v_out);
 
-			fragment_result = shader.fragment_shader(v_out);
-			pixel_color = ColorEncoding::encode_rgba(fragment_result);
-			subsample_param.pixel_color = pixel_color;
-			subsample_param.pixel_color_calculated = true;
+		if (enable_alpha_test && shader.discarded)
+		{
+			return false;
 		}
-		else
+
+		// stencil and depth per sample
+		uint32_t passed = 0;
+		for (uint8_t idx = 0; idx < coverage.subsample_count; ++idx)
 		{
-			pixel_color = subsample_param.pixel_color;
+			uint32_t bit = 1u << idx;
+			if ((mask & bit) != 0 && depth_stencil_stage(buffer, sample_row + idx / axis, sample_col + idx % axis, coverage.depths[idx], ctx))
+			{
+				passed |= bit;
+			}
 		}
 
-		// todo: scissor test
-		if (enable_scissor_test)
+		if (passed == 0)
 		{
+			return false;
+		}
+
+		// the first sample holds the state of the pixel, a compressed pixel only stores the first sample's color
+		coverage_t state = kSamplesCompressed;
+		buffer.read_coverage(sample_row, sample_col, state);
 
+		uint32_t full_mask = (1u << coverage.subsample_count) - 1u;
+		bool overwrite = !is_flag_enabled(ctx, PipelineFeature::kBlending) && ctx.color_mask == (ColorMask::kRed | ColorMask::kGreen | ColorMask::kBlue | ColorMask::kAlpha);
+
+		// sorted fragments are kept per sample, so the pixel is always expanded
+		bool oit = is_oit_fragment(ctx) && oit_pool.active;
+
+		// every sample ends up with the same color
+		if (!oit && passed == full_mask && (overwrite || state == kSamplesCompressed))
+		{
+			buffer.write_color(sample_row, sample_col, output_merge(buffer, sample_row, sample_col, fragment_result, ctx));
+			buffer.write_coverage(sample_row, sample_col, kSamplesCompressed);
+			return true;
 		}
 
-		// acctually alpha test is a deprecated feature in newer graphics API, cuz it can be emulated by discard() or clip()
-		if (enable_alpha_test)
+		// partial coverage, expand the pixel before writing single samples
+		if (state == kSamplesCompressed)
 		{
-			if (shader.discarded)
+			tinymath::color_rgba first;
+			buffer.read_color(sample_row, sample_col, first);
+			for (uint8_t idx = 1; idx < coverage.subsample_count; ++idx)
 			{
-				return false;
+				buffer.write_color(sample_row + idx / axis, sample_col + idx % axis, first);
 			}
+			buffer.write_coverage(sample_row, sample_col, kSamplesExpanded);
+		}
+
+		tinymath::color_rgba oit_color = oit ? ColorEncoding::encode_rgba(fragment_result) : tinymath::color_rgba();
+		for (uint8_t idx = 0; idx < coverage.subsample_count; ++idx)
+		{
+			if ((passed & (1u << idx)) != 0)
+			{
+				size_t r = sample_row + idx / axis;
+				size_t c = sample_col + idx % axis;
+				if (!oit || !append_oit_fragment(r, c, coverage.depths[idx], oit_color, ctx))
+				{
+					buffer.write_color(r, c, output_merge(buffer, r, c, fragment_result, ctx));
+				}
+			}
+		}
+
+		return true;
+	}
+
+	bool GraphicsDevice::depth_stencil_stage(FrameBuffer& buffer, size_t row, size_t col, float z, const GraphicsContext& ctx)
+	{
+		PipelineFeature op_pass = PipelineFeature::kScissorTest | PipelineFeature::kAlphaTest | PipelineFeature::kStencilTest | PipelineFeature::kDepthTest;
+
+		// todo: scissor test
+		if (is_flag_enabled(ctx, PipelineFeature::kScissorTest))
+		{
+
 		}
 
 		// stencil test
-		if (enable_stencil_test)
+		if (is_flag_enabled(ctx, PipelineFeature::kStencilTest))
 		{
-			if (!buffer.perform_stencil_test(stencil_ref_val, stencil_read_mask, stencil_func, row, col))
+			if (!buffer.perform_stencil_test(ctx.stencil_ref_val, ctx.stencil_read_mask, ctx.stencil_func, row, col))
 			{
 				op_pass &= ~PipelineFeature::kStencilTest;
 			}
-			buffer.update_stencil_buffer(row, col, op_pass, stencil_pass_op, stencil_fail_op, stencil_zfail_op, stencil_ref_val);
+			buffer.update_stencil_buffer(row, col, op_pass, ctx.stencil_pass_op, ctx.stencil_fail_op, ctx.stencil_zfail_op, ctx.stencil_ref_val);
 		}
 
 		// depth test
-		if (enable_depth_test)
+		if (is_flag_enabled(ctx, PipelineFeature::kDepthTest))
 		{
-			if (!buffer.perform_depth_test(ztest_func, row, col, z))
+			if (!buffer.perform_depth_test(ctx.ztest_func, row, col, z))
 			{
 				op_pass &= ~PipelineFeature::kDepthTest;
 			}
 		}
 
-		// write depth
-		if (zwrite_on && (op_pass & PipelineFeature::kDepthTest) != PipelineFeature::kNone)
+		// write depth, sorted transparent fragments never occlude each other
+		if (is_flag_enabled(ctx, PipelineFeature::kZWrite) && !is_oit_fragment(ctx) && (op_pass & PipelineFeature::kDepthTest) != PipelineFeature::kNone)
 		{
 			buffer.write_depth(row, col, z);
 		}
 
-		// blending
-		if (enable_blending)
-		{
-			tinymath::color_rgba dst;
-			if (buffer.read_color(row, col, dst))
-			{
-				tinymath::Color dst_color = ColorEncoding::decode(dst);
-				tinymath::Color src_color = fragment_result;
-				tinymath::Color blended_color = FrameBuffer::blend(src_color, dst_color, src_factor, dst_factor, blend_op);
-				pixel_color = ColorEncoding::encode_rgba(blended_color.r, blended_color.g, blended_color.b, blended_color.a);
-			}
-		}
+		return validate_fragment(op_pass);
+	}
 
-		bool fragment_passed = validate_fragment(op_pass);
+	tinymath::color_rgba GraphicsDevice::output_merge(FrameBuffer& buffer, size_t row, size_t col, const tinymath::Color& fragment_result, const GraphicsContext& ctx)
+	{
+		tinymath::color_rgba pixel_color = ColorEncoding::encode_rgba(fragment_result);
+		bool enable_blending = is_flag_enabled(ctx, PipelineFeature::kBlending);
+		bool masked = ctx.color_write_mask != 0xFFFFFFFFu;
 
-		if (fragment_passed)
+		if (!enable_blending && !masked)
 		{
-			buffer.write_coverage(row, col, (uint8_t)1); // pixel is guarantee to be covered here
+			return pixel_color;
 		}
 
-		// write color
-		if (fragment_passed)
+		// one destination read serves both blending and the color mask
+		tinymath::color_rgba dst;
+		if (!buffer.read_color(row, col, dst))
 		{
-			if (color_mask != (ColorMask::kRed | ColorMask::kGreen | ColorMask::kBlue | ColorMask::kAlpha))
-			{
-				tinymath::color_rgba cur;
-				if (buffer.read_color(row, col, cur))
-				{
-					if ((color_mask & ColorMask::kRed) == ColorMask::kZero)
-					{
-						pixel_color.r = cur.r;
-					}
-					if ((color_mask & ColorMask::kGreen) == ColorMask::kZero)
-					{
-						pixel_color.g = cur.g;
-					}
-					if ((color_mask & ColorMask::kBlue) == ColorMask::kZero)
-					{
-						pixel_color.b = cur.b;
-					}
-					if ((color_mask & ColorMask::kAlpha) == ColorMask::kZero)
-					{
-						pixel_color.a = cur.a;
-					}
-				}
-			}
-
-			buffer.write_color(row, col, pixel_color);
-			return true;
+			return pixel_color;
 		}
 
-		return false;
+		return merge_color(pixel_color, dst, enable_blending ? ctx.blend_function : nullptr, ctx.color_write_mask);
 	}
 
 	bool GraphicsDevice::validate_fragment(PipelineFeature op_pass) const
@@ -963,6 +1483,7 @@ namespace CpuRasterizer
 			s1 = translation * s1;
 			s2 = translation * s2;
 
+			get_active_rendertexture()->resolve_pending_clears();
 			SegmentDrawer::bresenham(get_active_rendertexture()->get_color_raw_buffer(), (int)s1.x, (int)s1.y, (int)s2.x, (int)s2.y, ColorEncoding::encode_rgba(col));
 		}
 	}
@@ -1015,6 +1536,7 @@ namespace CpuRasterizer
 			tinymath::vec4f s1 = Pipeline::ndc2screen(w, h, n1);
 			tinymath::vec4f s2 = Pipeline::ndc2screen(w, h, n2);
 
+			get_active_rendertexture()->resolve_pending_clears();
 			SegmentDrawer::bresenham(get_active_rendertexture()->get_color_raw_buffer(), (int)s1.x, (int)s1.y, (int)s2.x, (int)s2.y, ColorEncoding::encode_rgba(col));
 		}
 	}
@@ -0,0 +1,129 @@
+#include "PostProcess.hpp"
+
+namespace CpuRasterizer
+{
+	constexpr float kEdgeThreshold = 0.125f;
+	constexpr float kEdgeThresholdMin = 0.0312f;
+	constexpr float kSubpixelQuality = 0.75f;
+	constexpr int kEdgeSearchSteps = 8;
+
+	float PostProcess::luma(const tinymath::color_rgba& c)
+	{
+		return (0.299f * (float)c.r + 0.587f * (float)c.g + 0.114f * (float)c.b) * (1.0f / 255.0f);
+	}
+
+	const tinymath::color_rgba& PostProcess::fetch(const RawBuffer<tinymath::color_rgba>& src, int row, int col)
+	{
+		row = tinymath::clamp(row, 0, (int)src.get_height() - 1);
+		col = tinymath::clamp(col, 0, (int)src.get_width() - 1);
+		return src.at((size_t)row, (size_t)col);
+	}
+
+	tinymath::color_rgba PostProcess::lerp(const tinymath::color_rgba& lhs, const tinymath::color_rgba& rhs, float t)
+	{
+		tinymath::color_rgba ret;
+		ret.r = (uint8_t)((float)lhs.r + ((float)rhs.r - (float)lhs.r) * t + 0.5f);
+		ret.g = (uint8_t)((float)lhs.g + ((float)rhs.g - (float)lhs.g) * t + 0.5f);
+		ret.b = (uint8_t)((float)lhs.b + ((float)rhs.b - (float)lhs.b) * t + 0.5f);
+		ret.a = (uint8_t)((float)lhs.a + ((float)rhs.a - (float)lhs.a) * t + 0.5f);
+		return ret;
+	}
+
+	// fxaa 3.11 quality path, reduced to whole-pixel neighbor fetches
+	void PostProcess::fxaa(const RawBuffer<tinymath::color_rgba>& src, RawBuffer<tinymath::color_rgba>& dst, const tinymath::Rect& rect)
+	{
+		int row_end = tinymath::min(rect.max().y, (int)src.get_height());
+		int col_end = tinymath::min(rect.max().x, (int)src.get_width());
+
+		for (int row = rect.min().y; row < row_end; ++row)
+		{
+			for (int col = rect.min().x; col < col_end; ++col)
+			{
+				const tinymath::color_rgba& center = fetch(src, row, col);
+				float luma_m = luma(center);
+				float luma_n = luma(fetch(src, row - 1, col));
+				float luma_s = luma(fetch(src, row + 1, col));
+				float luma_w = luma(fetch(src, row, col - 1));
+				float luma_e = luma(fetch(src, row, col + 1));
+
+				float luma_min = tinymath::min(luma_m, tinymath::min(tinymath::min(luma_n, luma_s), tinymath::min(luma_w, luma_e)));
+				float luma_max = tinymath::max(luma_m, tinymath::max(tinymath::max(luma_n, luma_s), tinymath::max(luma_w, luma_e)));
+				float range = luma_max - luma_min;
+
+				// no visible edge
+				if (range < tinymath::max(kEdgeThresholdMin, luma_max * kEdgeThreshold))
+				{
+					dst.at((size_t)row, (size_t)col) = center;
+					continue;
+				}
+
+				float luma_nw = luma(fetch(src, row - 1, col - 1));
+				float luma_ne = luma(fetch(src, row - 1, col + 1));
+				float luma_sw = luma(fetch(src, row + 1, col - 1));
+				float luma_se = luma(fetch(src, row + 1, col + 1));
+
+				// edge orientation
+				float edge_horizontal = tinymath::abs(luma_nw + luma_sw - 2.0f * luma_w) + 2.0f * tinymath::abs(luma_n + luma_s - 2.0f * luma_m) + tinymath::abs(luma_ne + luma_se - 2.0f * luma_e);
+				float edge_vertical = tinymath::abs(luma_nw + luma_ne - 2.0f * luma_n) + 2.0f * tinymath::abs(luma_w + luma_e - 2.0f * luma_m) + tinymath::abs(luma_sw + luma_se - 2.0f * luma_s);
+				bool horizontal = edge_horizontal >= edge_vertical;
+
+				// the side of the edge with the steeper gradient
+				float luma_1 = horizontal ? luma_n : luma_w;
+				float luma_2 = horizontal ? luma_s : luma_e;
+				float gradient_1 = tinymath::abs(luma_1 - luma_m);
+				float gradient_2 = tinymath::abs(luma_2 - luma_m);
+				bool steeper_1 = gradient_1 >= gradient_2;
+				int side = steeper_1 ? -1 : 1;
+				float luma_local_average = 0.5f * ((steeper_1 ? luma_1 : luma_2) + luma_m);
+				float gradient_scaled = 0.25f * tinymath::max(gradient_1, gradient_2);
+
+				// walk along the edge in both directions until the luma pair leaves the edge
+				int side_row = horizontal ? row + side : row;
+				int side_col = horizontal ? col : col + side;
+				int step_row = horizontal ? 0 : 1;
+				int step_col = horizontal ? 1 : 0;
+
+				float luma_end_1 = 0.0f;
+				float luma_end_2 = 0.0f;
+				int distance_1 = kEdgeSearchSteps;
+				int distance_2 = kEdgeSearchSteps;
+
+				for (int step = 1; step <= kEdgeSearchSteps; ++step)
+				{
+					luma_end_1 = 0.5f * (luma(fetch(src, row - step * step_row, col - step * step_col)) + luma(fetch(src, side_row - step * step_row, side_col - step * step_col))) - luma_local_average;
+					if (tinymath::abs(luma_end_1) >= gradient_scaled)
+					{
+						distance_1 = step;
+						break;
+					}
+				}
+
+				for (int step = 1; step <= kEdgeSearchSteps; ++step)
+				{
+					luma_end_2 = 0.5f * (luma(fetch(src, row + step * step_row, col + step * step_col)) + luma(fetch(src, side_row + step * step_row, side_col + step * step_col))) - luma_local_average;
+					if (tinymath::abs(luma_end_2) >= gradient_scaled)
+					{
+						distance_2 = step;
+						break;
+					}
+				}
+
+				// only blend when the closer edge end bends towards the center pixel
+				bool closer_1 = distance_1 < distance_2;
+				float distance = (float)tinymath::min(distance_1, distance_2);
+				float luma_end = closer_1 ? luma_end_1 : luma_end_2;
+				bool center_smaller = luma_m < luma_local_average;
+				float edge_offset = ((luma_end < 0.0f) != center_smaller) ? 0.5f - distance / (float)(distance_1 + distance_2) : 0.0f;
+
+				// sub-pixel aliasing, thin features that the edge walk misses
+				float luma_average = (2.0f * (luma_n + luma_s + luma_w + luma_e) + luma_nw + luma_ne + luma_sw + luma_se) * (1.0f / 12.0f);
+				float subpixel = tinymath::clamp(tinymath::abs(luma_average - luma_m) / range, 0.0f, 1.0f);
+				subpixel = (-2.0f * subpixel + 3.0f) * subpixel * subpixel;
+				float subpixel_offset = subpixel * subpixel * kSubpixelQuality;
+
+				float offset = tinymath::max(edge_offset, subpixel_offset);
+				dst.at((size_t)row, (size_t)col) = lerp(center, fetch(src, side_row, side_col), offset);
+			}
+		}
+	}
+}
@@ -1,17 +1,37 @@
 #include "RenderTexture.hpp"
-#include "Sampling.hpp"
 #include "TileBasedManager.hpp"
 
 namespace CpuRasterizer
 {
+	// standard 4x and 16x sample patterns, in 1/16 pixel from the pixel center
+	static const int kSamplePattern4[4][2] = { {-2, -6}, {6, -2}, {-6, 2}, {2, 6} };
+	static const int kSamplePattern16[16][2] = 
+	{ 
+		{1, 1}, {-1, -3}, {-3, 2}, {4, -1}, {-5, -2}, {2, 5}, {5, 3}, {3, -5},
+		{-2, 6}, {0, -7}, {-4, -6}, {-6, 4}, {-8, 0}, {7, -4}, {6, 7}, {-7, -8}
+	};
+
+	static std::vector<tinymath::vec2i> make_sample_offsets(const int pattern[][2], size_t count)
+	{
+		std::vector<tinymath::vec2i> offsets(count);
+		for (size_t idx = 0; idx < count; ++idx)
+		{
+			offsets[idx] = tinymath::vec2i((8 + pattern[idx][0]) * (kSubpixelStep / 16), (8 + pattern[idx][1]) * (kSubpixelStep / 16));
+		}
+		return offsets;
+	}
+
 	RenderTexture::RenderTexture(size_t w, size_t h, FrameContent flag, bool msaa_on, uint8_t subsample_count) :
 		has_msaa_buffer(msaa_on),
-		msaa_subsample_count(tinymath::round_up_to_power_of_two(subsample_count)),
+		layout(MemoryLayout::kLinear),
+		msaa_subsample_count(normalize_subsample_count(subsample_count)),
 		multi_sample_frequency(MultiSampleFrequency::kPixelFrequency)
 	{
+		subsamples_per_axis = (uint8_t)tinymath::sqrt(msaa_subsample_count);
 		framebuffer = std::make_unique<FrameBuffer>(w, h, flag & ~FrameContent::kCoverage);
 		tile_based_manager = std::make_unique<TileBasedManager>(w, h);
 		reset_msaa_buffer();
+		reset_pending_clears();
 	}
 
 	RenderTexture::RenderTexture(size_t w, size_t h, FrameContent flag) : RenderTexture(w, h, flag, false, 0) {}
@@ -50,47 +70,140 @@ namespace CpuRasterizer
 		{
 			for (size_t col = rect.min().x; col < rect.max().x; col += 2)
 			{
-				tinymath::vec2f p1((float)col + 0.5f, (float)row + 0.5f);
-				Pixel top_left = { row, col, p1 };
+				pixel_block_func(*this, get_pixel_block(row, col));
+			}
+		}
+	}
 
-				tinymath::vec2f p2((float)col + 1.5f, (float)row + 0.5f);
-				Pixel top_right = { row, col + 1, p2 };
+	PixelBlock RenderTexture::get_pixel_block(size_t row, size_t col)
+	{
+		tinymath::vec2f p1((float)col + 0.5f, (float)row + 0.5f);
+		Pixel top_left = { row, col, p1 };
 
-				tinymath::vec2f p3((float)col + 0.5f, (float)row + 1.5f);
-				Pixel bottom_left = { row + 1, col, p3 };
+		tinymath::vec2f p2((float)col + 1.5f, (float)row + 0.5f);
+		Pixel top_right = { row, col + 1, p2 };
 
-				tinymath::vec2f p4((float)col + 1.5f, (float)row + 1.5f);
-				Pixel bottom_right = { row + 1, col + 1, p4 };
+		tinymath::vec2f p3((float)col + 0.5f, (float)row + 1.5f);
+		Pixel bottom_left = { row + 1, col, p3 };
 
-				PixelBlock block = { top_left, top_right, bottom_left, bottom_right };
+		tinymath::vec2f p4((float)col + 1.5f, (float)row + 1.5f);
+		Pixel bottom_right = { row + 1, col + 1, p4 };
 
-				pixel_block_func(*this, block);
-			}
-		}
+		PixelBlock block = { top_left, top_right, bottom_left, bottom_right };
+		return block;
 	}
 
-	Pixel RenderTexture::get_subpixel(size_t row, size_t col, uint8_t x_subsample_idx, uint8_t y_subsample_idx)
+	const tinymath::vec2i* RenderTexture::get_sample_offsets(uint8_t subsample_count)
 	{
-		uint8_t index = x_subsample_idx * subsamples_per_axis + y_subsample_idx;
-		size_t subsample_row = (size_t)(row * subsamples_per_axis + x_subsample_idx);
-		size_t subsample_col = (size_t)(col * subsamples_per_axis + y_subsample_idx);
-		auto local_pos = hammersley((uint32_t)index, (uint32_t)msaa_subsample_count);
-		tinymath::vec2f screen_pos((float)col + local_pos.x, (float)row + local_pos.y);
-		Pixel subpixel = { subsample_row, subsample_col, screen_pos };
-		return subpixel;
+		static const std::vector<tinymath::vec2i> offsets4 = make_sample_offsets(kSamplePattern4, 4);
+		static const std::vector<tinymath::vec2i> offsets16 = make_sample_offsets(kSamplePattern16, 16);
+		return subsample_count <= 4 ? offsets4.data() : offsets16.data();
+	}
+
+	uint8_t RenderTexture::normalize_subsample_count(uint8_t subsample_count)
+	{
+		// samples are stored as a square block per pixel, only 4x and 16x have a pattern
+		return subsample_count <= 4 ? 4 : kMaxSubsampleCount;
 	}
 
 	void RenderTexture::clear(FrameContent flag)
 	{
-		framebuffer->clear(flag & ~FrameContent::kCoverage);
+		for (auto& pending : pending_clears)
+		{
+			pending |= flag & ~FrameContent::kCoverage;
+		}
+
 		if (has_msaa_buffer)
 		{
-			msaa_framebuffer->clear(flag | FrameContent::kCoverage);
+			for (auto& pending : pending_msaa_clears)
+			{
+				pending |= flag | FrameContent::kCoverage;
+			}
+		}
+
+		has_pending_clear = true;
+	}
+
+	FrameContent RenderTexture::consume_pending_clear(const tinymath::Rect& tile)
+	{
+		size_t index = get_tile_index(tile);
+		FrameContent flag = pending_clears[index];
+		pending_clears[index] = FrameContent::kNone;
+		return flag;
+	}
+
+	FrameContent RenderTexture::consume_pending_msaa_clear(const tinymath::Rect& tile)
+	{
+		if (!has_msaa_buffer)
+		{
+			return FrameContent::kNone;
+		}
+
+		size_t index = get_tile_index(tile);
+		FrameContent flag = pending_msaa_clears[index];
+		pending_msaa_clears[index] = FrameContent::kNone;
+		return flag;
+	}
+
+	FrameContent RenderTexture::get_pending_msaa_clear(const tinymath::Rect& tile) const
+	{
+		return has_msaa_buffer ? pending_msaa_clears[get_tile_index(tile)] : FrameContent::kNone;
+	}
+
+	void RenderTexture::resolve_pending_clear(const tinymath::Rect& tile)
+	{
+		size_t row = (size_t)tile.min().y;
+		size_t col = (size_t)tile.min().x;
+
+		FrameContent flag = consume_pending_clear(tile);
+		if (flag != FrameContent::kNone)
+		{
+			framebuffer->clear(flag, row, col, kTileSize, kTileSize);
+		}
+
+		FrameContent msaa_flag = consume_pending_msaa_clear(tile);
+		if (msaa_flag != FrameContent::kNone)
+		{
+			msaa_framebuffer->clear(msaa_flag, row * subsamples_per_axis, col * subsamples_per_axis, kTileSize * subsamples_per_axis, kTileSize * subsamples_per_axis);
+		}
+	}
+
+	void RenderTexture::resolve_pending_clears()
+	{
+		if (!has_pending_clear)
+		{
+			return;
+		}
+
+		for (size_t row = 0; row < tile_rows; row++)
+		{
+			for (size_t col = 0; col < tile_cols; col++)
+			{
+				resolve_pending_clear(tinymath::Rect((int)(col * kTileSize), (int)(row * kTileSize), (int)kTileSize, (int)kTileSize));
+			}
 		}
+
+		has_pending_clear = false;
+	}
+
+	size_t RenderTexture::get_tile_index(const tinymath::Rect& tile) const
+	{
+		return ((size_t)tile.min().y >> kTileBits) * tile_cols + ((size_t)tile.min().x >> kTileBits);
+	}
+
+	void RenderTexture::reset_pending_clears()
+	{
+		tile_rows = (framebuffer->get_height() + kTileSize - 1) >> kTileBits;
+		tile_cols = (framebuffer->get_width() + kTileSize - 1) >> kTileBits;
+		pending_clears.assign(tile_rows * tile_cols, FrameContent::kNone);
+		pending_msaa_clears.assign(has_msaa_buffer ? tile_rows * tile_cols : 0, FrameContent::kNone);
+		has_pending_clear = false;
 	}
 
 	void RenderTexture::set_clear_color(const tinymath::color_rgba color)
 	{
+		// pending clears use the old color
+		resolve_pending_clears();
 		framebuffer->set_clear_color(color);
 		if (has_msaa_buffer)
 		{
@@ -100,20 +213,34 @@ namespace CpuRasterizer
 
 	void RenderTexture::resize(size_t w, size_t h)
 	{
+		resolve_pending_clears();
 		framebuffer->resize(w, h);
 		tile_based_manager->resize(w, h);
 		reset_msaa_buffer();
+		reset_pending_clears();
+	}
+
+	void RenderTexture::set_layout(MemoryLayout target_layout)
+	{
+		layout = target_layout;
+		framebuffer->set_layout(layout);
+		if (msaa_framebuffer != nullptr)
+		{
+			msaa_framebuffer->set_layout(layout);
+		}
 	}
 
 	void RenderTexture::set_msaa_param(bool msaa_on, uint8_t subsample_count)
 	{
-		uint8_t target_subsample_count = tinymath::round_up_to_power_of_two(subsample_count);
+		uint8_t target_subsample_count = normalize_subsample_count(subsample_count);
 		if (msaa_on != has_msaa_buffer || (msaa_on && target_subsample_count != msaa_subsample_count))
 		{
+			resolve_pending_clears();
 			msaa_subsample_count = target_subsample_count;
 			subsamples_per_axis = tinymath::sqrt(msaa_subsample_count);
 			has_msaa_buffer = msaa_on;
 			reset_msaa_buffer();
+			reset_pending_clears();
 		}
 	}
 
@@ -124,6 +251,7 @@ namespace CpuRasterizer
 			if (msaa_framebuffer == nullptr)
 			{
 				msaa_framebuffer = std::make_unique<FrameBuffer>(framebuffer->get_width() * subsamples_per_axis, framebuffer->get_height() * subsamples_per_axis, framebuffer->get_flag() | FrameContent::kCoverage);
+				msaa_framebuffer->set_layout(layout);
 			}
 			else if(msaa_framebuffer->get_width() != (framebuffer->get_width() * subsamples_per_axis) || msaa_framebuffer->get_height() != (framebuffer->get_height() * subsamples_per_axis))
 			{
@@ -0,0 +1,226 @@
+#include "Sampler.hpp"
+#include <cmath>
+#include <type_traits>
+#include "RawBuffer.hpp"
+#include "BlockCompression.hpp"
+#include "Sampling.hpp"
+
+namespace CpuRasterizer
+{
+	template<WrapMode kWrap>
+	static inline float wrap_uv(float x)
+	{
+		if constexpr (kWrap == WrapMode::kRepeat)
+		{
+			return x - std::floor(x);
+		}
+		else
+		{
+			return tinymath::clamp(x, 0.0f, 1.0f);
+		}
+	}
+
+	// x is at most one texel outside the level once the uv is wrapped
+	template<WrapMode kWrap>
+	static inline size_t wrap_texel(int64_t x, size_t size)
+	{
+		int64_t last = (int64_t)size - 1;
+		if constexpr (kWrap == WrapMode::kRepeat)
+		{
+			x += x < 0 ? (int64_t)size : 0;
+			x -= x > last ? (int64_t)size : 0;
+			return (size_t)x;
+		}
+		else
+		{
+			return (size_t)tinymath::clamp(x, (int64_t)0, last);
+		}
+	}
+
+	template<typename T>
+	constexpr bool kIsBlock = std::is_same_v<T, bc1_block> || std::is_same_v<T, bc3_block> || std::is_same_v<T, bc4_block> || std::is_same_v<T, bc5_block>;
+
+	// a texel is at texel_row + texel_col in both layouts, like RawBuffer::row_offset and col_offset.
+	// blocks keep the plain row and col, fetch splits them into a block and a texel in it
+	template<typename T, MemoryLayout kLayout>
+	static inline size_t texel_row(const Sampler& sampler, const SamplerLevel& level, size_t row)
+	{
+		if constexpr (kIsBlock<T>)
+		{
+			return row;
+		}
+		else if constexpr (kLayout == MemoryLayout::kLinear)
+		{
+			return row * level.width;
+		}
+		else
+		{
+			size_t mask = ((size_t)1 << sampler.tile_bits) - 1;
+			return (((row >> sampler.tile_bits) * level.tile_cols) << (sampler.tile_bits * 2)) | morton_encode(row & mask, 0);
+		}
+	}
+
+	template<typename T, MemoryLayout kLayout>
+	static inline size_t texel_col(const Sampler& sampler, size_t col)
+	{
+		if constexpr (kIsBlock<T> || kLayout == MemoryLayout::kLinear)
+		{
+			return col;
+		}
+		else
+		{
+			size_t mask = ((size_t)1 << sampler.tile_bits) - 1;
+			return ((col >> sampler.tile_bits) << (sampler.tile_bits * 2)) | morton_encode(0, col & mask);
+		}
+	}
+
+	template<typename T>
+	static inline tinymath::Color fetch(const SamplerLevel& level, size_t row, size_t col)
+	{
+		const T* data = (const T*)level.data;
+		if constexpr (kIsBlock<T>)
+		{
+			// blocks are stored row major, tile_cols is the number of blocks per row
+			const T& block = data[(row / kBlockDim) * level.tile_cols + col / kBlockDim];
+			return ColorEncoding::decode(decode_texel(block, (row % kBlockDim) * kBlockDim + col % kBlockDim));
+		}
+		else
+		{
+			return ColorEncoding::decode(data[row + col]);
+		}
+	}
+
+	template<typename T, WrapMode kWrap, Filtering kFilter, MemoryLayout kLayout>
+	static inline tinymath::Color filter_level(const Sampler& sampler, const SamplerLevel& level, float u, float v)
+	{
+		if constexpr (kFilter == Filtering::kBilinear)
+		{
+			float x = u * level.fwidth - 0.5f;
+			float y = v * level.fheight - 0.5f;
+			float x_floor = std::floor(x);
+			float y_floor = std::floor(y);
+			float tx = x - x_floor;
+			float ty = y - y_floor;
+			// the four taps share two rows and two cols, their parts of the address are computed once
+			size_t col0 = texel_col<T, kLayout>(sampler, wrap_texel<kWrap>((int64_t)x_floor, level.width));
+			size_t col1 = texel_col<T, kLayout>(sampler, wrap_texel<kWrap>((int64_t)x_floor + 1, level.width));
+			size_t row0 = texel_row<T, kLayout>(sampler, level, wrap_texel<kWrap>((int64_t)y_floor, level.height));
+			size_t row1 = texel_row<T, kLayout>(sampler, level, wrap_texel<kWrap>((int64_t)y_floor + 1, level.height));
+
+			tinymath::Color c00, c01, c10, c11;
+			bool in_block = false;
+			if constexpr (kIsBlock<T>)
+			{
+				// texel_row and texel_col keep block rows and cols as they are
+				if (row1 == row0 + 1 && col1 == col0 + 1 && row0 % kBlockDim != kBlockDim - 1 && col0 % kBlockDim != kBlockDim - 1)
+				{
+					const T& block = ((const T*)level.data)[(row0 / kBlockDim) * level.tile_cols + col0 / kBlockDim];
+					typename T::pixel_type quad[4];
+					decode_quad(block, (row0 % kBlockDim) * kBlockDim + col0 % kBlockDim, quad);
+					c00 = ColorEncoding::decode(quad[0]);
+					c01 = ColorEncoding::decode(quad[1]);
+					c10 = ColorEncoding::decode(quad[2]);
+					c11 = ColorEncoding::decode(quad[3]);
+					in_block = true;
+				}
+			}
+
+			if (!in_block)
+			{
+				c00 = fetch<T>(level, row0, col0);
+				c01 = fetch<T>(level, row0, col1);
+				c10 = fetch<T>(level, row1, col0);
+				c11 = fetch<T>(level, row1, col1);
+			}
+
+			tinymath::Color top = c00 + (c01 - c00) * tx;
+			tinymath::Color bottom = c10 + (c11 - c10) * tx;
+			return top + (bottom - top) * ty;
+		}
+		else
+		{
+			size_t col = tinymath::min((size_t)(u * level.fwidth), level.width - 1);
+			size_t row = tinymath::min((size_t)(v * level.fheight), level.height - 1);
+			return fetch<T>(level, texel_row<T, kLayout>(sampler, level, row), texel_col<T, kLayout>(sampler, col));
+		}
+	}
+
+	// one instance per texture state, the level index is the only thing decided per sample
+	template<typename T, WrapMode kWrap, Filtering kFilter, MemoryLayout kLayout>
+	static void sample_kernel(const Sampler& sampler, float u, float v, float lod, tinymath::Color& ret)
+	{
+		u = wrap_uv<kWrap>(u);
+		v = wrap_uv<kWrap>(v);
+
+		// also maps a nan lod to the base level
+		lod = tinymath::min(lod > 0.0f ? lod : 0.0f, (float)(sampler.level_count - 1));
+		if (sampler.feedback != nullptr)
+		{
+			// the level that was wanted, before falling back to what is resident
+			record_level_request(*sampler.feedback, (size_t)lod);
+		}
+		lod = tinymath::max(lod, (float)sampler.base_level);
+		size_t mip = (size_t)lod;
+		float frac = lod - (float)mip;
+
+		ret = filter_level<T, kWrap, kFilter, kLayout>(sampler, sampler.levels[mip], u, v);
+		if (frac > 0.0f)
+		{
+			tinymath::Color next = filter_level<T, kWrap, kFilter, kLayout>(sampler, sampler.levels[mip + 1], u, v);
+			ret = ret + (next - ret) * frac;
+		}
+	}
+
+	template<typename T, WrapMode kWrap, Filtering kFilter>
+	static SampleFunction compile_layout(MemoryLayout layout)
+	{
+		// blocks have their own layout
+		if constexpr (kIsBlock<T>)
+		{
+			UNUSED(layout);
+			return &sample_kernel<T, kWrap, kFilter, MemoryLayout::kLinear>;
+		}
+		else
+		{
+			return layout == MemoryLayout::kTiled ? &sample_kernel<T, kWrap, kFilter, MemoryLayout::kTiled> : &sample_kernel<T, kWrap, kFilter, MemoryLayout::kLinear>;
+		}
+	}
+
+	template<typename T, WrapMode kWrap>
+	static SampleFunction compile_filter(Filtering filtering, MemoryLayout layout)
+	{
+		// max and min filtering have no kernel, they fall back to point like Texture::sample
+		return filtering == Filtering::kBilinear ? compile_layout<T, kWrap, Filtering::kBilinear>(layout) : compile_layout<T, kWrap, Filtering::kPoint>(layout);
+	}
+
+	template<typename T>
+	static SampleFunction compile_wrap(WrapMode wrap_mode, Filtering filtering, MemoryLayout layout)
+	{
+		// border is clamped like Texture::wrap does
+		return wrap_mode == WrapMode::kRepeat ? compile_filter<T, WrapMode::kRepeat>(filtering, layout) : compile_filter<T, WrapMode::kClampToEdge>(filtering, layout);
+	}
+
+	SampleFunction Sampler::compile(TextureFormat format, WrapMode wrap_mode, Filtering filtering, MemoryLayout layout)
+	{
+		switch (format)
+		{
+		case TextureFormat::kRGB: return compile_wrap<tinymath::color_rgb>(wrap_mode, filtering, layout);
+		case TextureFormat::kRGBA: return compile_wrap<tinymath::color_rgba>(wrap_mode, filtering, layout);
+		case TextureFormat::kRG: return compile_wrap<tinymath::color_rg>(wrap_mode, filtering, layout);
+		case TextureFormat::kGray: return compile_wrap<tinymath::color_gray>(wrap_mode, filtering, layout);
+		case TextureFormat::kRGB16: return compile_wrap<tinymath::color_rgb16f>(wrap_mode, filtering, layout);
+		case TextureFormat::kRGBA16: return compile_wrap<tinymath::color_rgba16f>(wrap_mode, filtering, layout);
+		case TextureFormat::kBC1: return compile_wrap<bc1_block>(wrap_mode, filtering, layout);
+		case TextureFormat::kBC3: return compile_wrap<bc3_block>(wrap_mode, filtering, layout);
+		case TextureFormat::kBC4: return compile_wrap<bc4_block>(wrap_mode, filtering, layout);
+		case TextureFormat::kBC5: return compile_wrap<bc5_block>(wrap_mode, filtering, layout);
+		}
+		return nullptr;
+	}
+
+	void Sampler::sample(float u, float v, const tinymath::vec2f& ddx, const tinymath::vec2f& ddy, tinymath::Color& ret) const
+	{
+		float lod = get_mip_level(ddx, ddy, levels[0].width, levels[0].height);
+		function(*this, u, v, lod, ret);
+	}
+}
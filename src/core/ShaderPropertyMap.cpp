@@ -80,6 +80,7 @@ namespace CpuRasterizer
 			return;
 		}
 		name2tex[name] = tex;
+		name2sampler[name] = tex->get_sampler();
 	}
 
 	void ShaderPropertyMap::set_cubemap(property_name name, std::shared_ptr<CubeMap> cubemap)
@@ -145,6 +146,16 @@ namespace CpuRasterizer
 		return nullptr;
 	}
 
+	const Sampler* ShaderPropertyMap::get_sampler(property_name name) const
+	{
+		auto it = name2sampler.find(name);
+		if (it != name2sampler.end() && it->second.valid())
+		{
+			return &it->second;
+		}
+		return nullptr;
+	}
+
 	std::shared_ptr<CubeMap> ShaderPropertyMap::get_cubemap(property_name name) const
 	{
 		if (name2cubemap.count(name) > 0)
@@ -170,6 +181,11 @@ namespace CpuRasterizer
 		this->name2mat4x4 = other.name2mat4x4;
 		this->name2int = other.name2int;
 		this->name2tex = other.name2tex;
+		this->name2sampler.clear();
+		for (auto& kv : name2tex)
+		{
+			name2sampler[kv.first] = kv.second->get_sampler();
+		}
 		this->name2cubemap = other.name2cubemap;
 		this->name2rendertexture = other.name2rendertexture;
 		this->keywords = other.keywords;
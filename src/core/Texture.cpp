@@ -1,6 +1,7 @@
 #include "Texture.hpp"
 #include <iostream>
 #include <filesystem>
+#include <mutex>
 #include "Singleton.hpp"
 #include "Cache.hpp"
 #include "Utility.hpp"
@@ -9,6 +10,11 @@
 #include "Serialization.hpp"
 #include "Sampling.hpp"
 #include "ImageUtil.hpp"
+#include "TextureCache.hpp"
+#include "MappedFile.hpp"
+#include "BlockCompression.hpp"
+#include "TextureStreamer.hpp"
+#include "KeyedMutex.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -22,6 +28,10 @@ constexpr uint8_t kChannelRGB = 3;
 constexpr uint8_t kChannelRGBA = 4;
 
 static Cache<CpuRasterizer::Texture> texture_cache;
+// textures are loaded and released on the asset loader workers as well
+static std::mutex texture_cache_mutex;
+// metas sharing a raw image are loaded in parallel, only one of them decodes and writes the cache
+static KeyedMutex cache_file_mutex;
 
 namespace CpuRasterizer
 {
@@ -29,7 +39,7 @@ namespace CpuRasterizer
 		format(TextureFormat::kInvalid), width(0), height(0), layer_count(0),
 		wrap_mode(WrapMode::kRepeat),
 		filtering(Filtering::kPoint),
-		mip_count(0), enable_mip(false)
+		mip_count(0), enable_mip(false), layout(MemoryLayout::kLinear), enable_compression(false), srgb(false), enable_streaming(false), stream_info(), resident_level(0), tail_level(0), level_requests(0)
 	{}
 
 	Texture::Texture(const Texture& other)
@@ -40,6 +50,7 @@ namespace CpuRasterizer
 	Texture::~Texture()
 	{
 		release();
+		std::lock_guard<std::mutex> lock(texture_cache_mutex);
 		texture_cache.free(this->raw_path);
 	}
 
@@ -47,7 +58,7 @@ namespace CpuRasterizer
 		format(_fmt), width(_width), height(_height), layer_count(_layer_count),
 		wrap_mode(WrapMode::kRepeat),
 		filtering(Filtering::kPoint),
-		mip_count(0), enable_mip(false)
+		mip_count(0), enable_mip(false), layout(MemoryLayout::kLinear), enable_compression(false), srgb(false), enable_streaming(false), stream_info(), resident_level(0), tail_level(0), level_requests(0)
 	{
 		release();
 		switch (format)
@@ -82,7 +93,7 @@ namespace CpuRasterizer
 		format(_fmt), width(_width), height(_height), layer_count(_layer_count),
 		wrap_mode(WrapMode::kRepeat),
 		filtering(Filtering::kPoint),
-		mip_count(0), enable_mip(false)
+		mip_count(0), enable_mip(false), layout(MemoryLayout::kLinear), enable_compression(false), srgb(false), enable_streaming(false), stream_info(), resident_level(0), tail_level(0), level_requests(0)
 	{
 		release();
 		switch (format)
@@ -134,14 +145,21 @@ namespace CpuRasterizer
 	std::shared_ptr<Texture> Texture::load_asset(const char* path)
 	{
 		std::shared_ptr<Texture> ret = nullptr;
-		if (texture_cache.get(path, ret) && ret != nullptr)
 		{
-			return ret;
+			std::lock_guard<std::mutex> lock(texture_cache_mutex);
+			if (texture_cache.get(path, ret) && ret != nullptr)
+			{
+				return ret;
+			}
 		}
 		Texture* tex = new Texture();
 		Serializer::deserialize(path, *tex);
 		ret = std::shared_ptr<Texture>(tex);
-		texture_cache.put(path, ret);
+		{
+			std::lock_guard<std::mutex> lock(texture_cache_mutex);
+			texture_cache.put(path, ret);
+		}
+		CpuRasterTextureStreamer.add(ret);
 		return ret;
 	}
 
@@ -168,6 +186,13 @@ namespace CpuRasterizer
 		release();
 
 		std::string abs_path = RES_PATH + texture_path;
+		std::lock_guard<std::mutex> cache_lock(cache_file_mutex.get(cache_path(texture_path)));
+		if (load_cache(texture_path))
+		{
+			LOG("cached texture loaded: {}", abs_path.c_str());
+			return;
+		}
+
 		int w, h, channels;
 		if (!std::filesystem::exists(abs_path))
 		{
@@ -265,142 +290,760 @@ namespace CpuRasterizer
 			generate_mipmap(kMaxMip);
 		}
 
+		if (enable_compression)
+		{
+			compress();
+		}
+
+		set_layout(layout);
+		save_cache(texture_path);
+		// the full chain was only decoded to build the cache, a streamed texture drops to its tail like a cached load
+		if (enable_streaming && enable_mip)
+		{
+			load_cache(texture_path);
+		}
 		LOG("raw texture loaded: {}", abs_path.c_str());
 	}
 
-	void Texture::generate_mipmap(int count)
+	template<typename T>
+	static std::vector<TextureLevel> cache_levels(const std::shared_ptr<RawBuffer<T>>& buffer, const std::vector<std::shared_ptr<RawBuffer<T>>>& mipmaps, bool enable_mip)
 	{
-		switch (this->format)
+		std::vector<TextureLevel> levels;
+		if (buffer == nullptr)
 		{
-		case TextureFormat::kRGB:
+			return levels;
+		}
+
+		const std::vector<std::shared_ptr<RawBuffer<T>>> base = { buffer };
+		for (auto& level : enable_mip && mipmaps.size() > 0 ? mipmaps : base)
 		{
-			for (int i = 1; i < rgb_mipmaps.size(); i++)
-			{
-				rgb_mipmaps[i].reset();
-			}
-			rgb_mipmaps.clear();
+			size_t size;
+			levels.push_back({ level->get_width(), level->get_height(), (void*)level->get_ptr(size) });
+		}
+		return levels;
+	}
 
-			rgb_mipmaps.emplace_back(rgb_buffer);
+	// the buffers borrow the mapped pixels, the texture keeps the mapping alive
+	template<typename T>
+	static void adopt_levels(const std::vector<TextureLevel>& levels, const TextureCacheInfo& info, bool enable_mip, std::shared_ptr<RawBuffer<T>>& buffer, std::vector<std::shared_ptr<RawBuffer<T>>>& mipmaps)
+	{
+		mipmaps.clear();
+		for (auto& level : levels)
+		{
+			auto mipmap = RawBuffer<T>::create(level.data, level.width, level.height, [](T* ptr) { UNUSED(ptr); });
+			mipmap->adopt_layout(info.layout, info.tile_bits);
+			mipmaps.emplace_back(mipmap);
+		}
+		buffer = mipmaps[0];
+		if (!enable_mip)
+		{
+			mipmaps.clear();
+		}
+	}
 
-			for (int i = 1; i < count; i++)
-			{
-				size_t w = this->width >> i;
-				size_t h = this->height >> i;
-				auto mipmap = std::make_shared<RawBuffer<tinymath::color_rgb>>(*rgb_buffer);
-				ImageUtil::resize(*mipmap, w, h, filtering);
-				rgb_mipmaps.emplace_back(mipmap);
-			}
+	// block levels are described by their size in texels, mip i of a generated chain is (width >> i, height >> i)
+	template<typename Block>
+	static std::vector<TextureLevel> cache_block_levels(const std::shared_ptr<RawBuffer<Block>>& buffer, const std::vector<std::shared_ptr<RawBuffer<Block>>>& mipmaps, bool enable_mip, size_t width, size_t height)
+	{
+		std::vector<TextureLevel> levels;
+		if (buffer == nullptr)
+		{
+			return levels;
+		}
 
-			break;
+		const std::vector<std::shared_ptr<RawBuffer<Block>>> base = { buffer };
+		auto& chain = enable_mip && mipmaps.size() > 0 ? mipmaps : base;
+		for (size_t i = 0; i < chain.size(); i++)
+		{
+			size_t size;
+			levels.push_back({ width >> i, height >> i, (void*)chain[i]->get_ptr(size) });
 		}
+		return levels;
+	}
+
+	template<typename Block>
+	static void adopt_block_levels(const std::vector<TextureLevel>& levels, bool enable_mip, std::shared_ptr<RawBuffer<Block>>& buffer, std::vector<std::shared_ptr<RawBuffer<Block>>>& mipmaps)
+	{
+		mipmaps.clear();
+		for (auto& level : levels)
+		{
+			mipmaps.emplace_back(RawBuffer<Block>::create(level.data, block_count(level.width), block_count(level.height), [](Block* ptr) { UNUSED(ptr); }));
+		}
+		buffer = mipmaps[0];
+		if (!enable_mip)
+		{
+			mipmaps.clear();
+		}
+	}
+
+	std::string Texture::cache_path(const char* texture_path)
+	{
+		return CACHE_PATH + texture_path + ".tex";
+	}
+
+	bool Texture::load_cache(const char* texture_path)
+	{
+		std::string cache_file = cache_path(texture_path);
+		if (!is_cache_current(RES_PATH + texture_path, cache_file))
+		{
+			return false;
+		}
+
+		TextureCacheInfo info;
+		std::vector<TextureLevel> levels;
+		std::shared_ptr<MappedFile> file;
+		if (!TextureCache::load(cache_file, info, levels, file))
+		{
+			WARN("texture cache is outdated or invalid, decoding again: {}", cache_file);
+			return false;
+		}
+
+		// the stored chain has to be the one generate_mipmap and set_layout would build
+		if (enable_mip && (levels.size() != kMaxMip || info.srgb != srgb))
+		{
+			return false;
+		}
+		// compressed caches only serve textures that ask for compression, blocks are never tiled
+		if (enable_compression ? compressed_format(info.format) != info.format : is_block_format(info.format))
+		{
+			return false;
+		}
+		MemoryLayout expected_layout = is_block_format(info.format) ? MemoryLayout::kLinear : layout;
+		if (info.layout != expected_layout || (expected_layout == MemoryLayout::kTiled && info.tile_bits != kTextureTileBits))
+		{
+			return false;
+		}
+
+		switch (info.format)
+		{
+		case TextureFormat::kRGB:
+			adopt_levels(levels, info, enable_mip, rgb_buffer, rgb_mipmaps);
+			break;
 		case TextureFormat::kRGBA:
+			adopt_levels(levels, info, enable_mip, rgba_buffer, rgba_mipmaps);
+			break;
+		case TextureFormat::kRG:
+			adopt_levels(levels, info, enable_mip, rg_buffer, rg_mipmaps);
+			break;
+		case TextureFormat::kGray:
+			adopt_levels(levels, info, enable_mip, gray_buffer, gray_mipmaps);
+			break;
+		case TextureFormat::kRGB16:
+			adopt_levels(levels, info, enable_mip, rgb16f_buffer, rgb16f_mipmaps);
+			break;
+		case TextureFormat::kRGBA16:
+			adopt_levels(levels, info, enable_mip, rgba16f_buffer, rgba16f_mipmaps);
+			break;
+		case TextureFormat::kBC1:
+			adopt_block_levels(levels, enable_mip, bc1_buffer, bc1_mipmaps);
+			break;
+		case TextureFormat::kBC3:
+			adopt_block_levels(levels, enable_mip, bc3_buffer, bc3_mipmaps);
+			break;
+		case TextureFormat::kBC4:
+			adopt_block_levels(levels, enable_mip, bc4_buffer, bc4_mipmaps);
+			break;
+		case TextureFormat::kBC5:
+			adopt_block_levels(levels, enable_mip, bc5_buffer, bc5_mipmaps);
+			break;
+		default:
+			return false;
+		}
+
+		this->format = info.format;
+		this->width = levels[0].width;
+		this->height = levels[0].height;
+		this->layer_count = 1;
+		if (enable_mip)
+		{
+			this->mip_count = kMaxMip;
+		}
+		cache_storage = file;
+		if (enable_streaming && enable_mip)
+		{
+			begin_streaming(cache_file, info, levels);
+		}
+		return true;
+	}
+
+	// copies levels out of the mapping they were adopted from
+	template<typename T>
+	static void own_levels(std::shared_ptr<RawBuffer<T>>& buffer, std::vector<std::shared_ptr<RawBuffer<T>>>& mipmaps)
+	{
+		for (auto& mipmap : mipmaps)
 		{
-			for (int i = 1; i < rgba_mipmaps.size(); i++)
+			if (mipmap != nullptr)
 			{
-				rgba_mipmaps[i].reset();
+				mipmap = RawBuffer<T>::create(*mipmap);
 			}
-			rgba_mipmaps.clear();
+		}
+		if (mipmaps.size() > 0)
+		{
+			buffer = mipmaps[0];
+		}
+	}
 
-			rgba_mipmaps.emplace_back(rgba_buffer);
+	template<typename T>
+	static void drop_level(std::shared_ptr<RawBuffer<T>>& buffer, std::vector<std::shared_ptr<RawBuffer<T>>>& mipmaps, size_t level)
+	{
+		mipmaps[level].reset();
+		if (level == 0)
+		{
+			buffer.reset();
+		}
+	}
 
-			for (int i = 1; i < count; i++)
-			{
-				size_t w = this->width >> i;
-				size_t h = this->height >> i;
-				auto mipmap = std::make_shared<RawBuffer<tinymath::color_rgba>>(*rgba_buffer);
-				ImageUtil::resize(*mipmap, w, h, filtering);
-				rgba_mipmaps.emplace_back(mipmap);
-			}
+	// width and height are in elements, blocks for block formats
+	template<typename T>
+	static void adopt_level(std::shared_ptr<RawBuffer<T>>& buffer, std::vector<std::shared_ptr<RawBuffer<T>>>& mipmaps, size_t level, size_t width, size_t height, MemoryLayout layout, uint8_t* data)
+	{
+		auto mipmap = RawBuffer<T>::create(data, width, height, [](T* ptr) { delete[] (uint8_t*)ptr; });
+		mipmap->adopt_layout(layout, layout == MemoryLayout::kTiled ? kTextureTileBits : 0);
+		mipmaps[level] = mipmap;
+		if (level == 0)
+		{
+			buffer = mipmap;
+		}
+	}
 
-			break;
+	void Texture::begin_streaming(const std::string& cache_file, const TextureCacheInfo& info, const std::vector<TextureLevel>& levels)
+	{
+		// the tail starts at the first level that fits kStreamingTailSize, or at the last level that has texels
+		size_t tail = 0;
+		while (tail + 1 < levels.size() && levels[tail + 1].width > 0 && levels[tail + 1].height > 0 &&
+			(levels[tail].width > kStreamingTailSize || levels[tail].height > kStreamingTailSize))
+		{
+			tail++;
+		}
+		if (tail == 0)
+		{
+			return;
+		}
+
+		stream_levels = levels;
+		for (auto& level : stream_levels)
+		{
+			level.data = nullptr;
+		}
+		stream_file = cache_file;
+		stream_info = info;
+		resident_level = 0;
+		tail_level = tail;
+		while (resident_level < tail_level)
+		{
+			stream_out();
 		}
+
+		// only the tail is copied, the mapping goes away and the other levels are read from the file on demand
+		switch (format)
+		{
+		case TextureFormat::kRGB:
+			own_levels(rgb_buffer, rgb_mipmaps);
+			break;
+		case TextureFormat::kRGBA:
+			own_levels(rgba_buffer, rgba_mipmaps);
+			break;
 		case TextureFormat::kRG:
+			own_levels(rg_buffer, rg_mipmaps);
+			break;
+		case TextureFormat::kGray:
+			own_levels(gray_buffer, gray_mipmaps);
+			break;
+		case TextureFormat::kRGB16:
+			own_levels(rgb16f_buffer, rgb16f_mipmaps);
+			break;
+		case TextureFormat::kRGBA16:
+			own_levels(rgba16f_buffer, rgba16f_mipmaps);
+			break;
+		case TextureFormat::kBC1:
+			own_levels(bc1_buffer, bc1_mipmaps);
+			break;
+		case TextureFormat::kBC3:
+			own_levels(bc3_buffer, bc3_mipmaps);
+			break;
+		case TextureFormat::kBC4:
+			own_levels(bc4_buffer, bc4_mipmaps);
+			break;
+		case TextureFormat::kBC5:
+			own_levels(bc5_buffer, bc5_mipmaps);
+			break;
+		}
+		cache_storage.reset();
+	}
+
+	size_t Texture::get_streamed_bytes() const
+	{
+		size_t bytes = 0;
+		for (size_t level = resident_level; level < tail_level; level++)
 		{
-			for (int i = 1; i < rg_mipmaps.size(); i++)
-			{
-				rg_mipmaps[i].reset();
-			}
-			rg_mipmaps.clear();
+			bytes += stream_levels[level].size;
+		}
+		return bytes;
+	}
 
-			rg_mipmaps.emplace_back(rg_buffer);
+	void Texture::stream_in(size_t level, uint8_t* data)
+	{
+		if (level + 1 != resident_level)
+		{
+			delete[] data;
+			return;
+		}
 
-			for (int i = 1; i < count; i++)
-			{
-				size_t w = this->width >> i;
-				size_t h = this->height >> i;
-				auto mipmap = std::make_shared<RawBuffer<tinymath::color_rg>>(*rg_buffer);
-				ImageUtil::resize(*mipmap, w, h, filtering);
-				rg_mipmaps.emplace_back(mipmap);
-			}
+		size_t w = stream_levels[level].width;
+		size_t h = stream_levels[level].height;
+		switch (format)
+		{
+		case TextureFormat::kRGB:
+			adopt_level(rgb_buffer, rgb_mipmaps, level, w, h, layout, data);
 			break;
+		case TextureFormat::kRGBA:
+			adopt_level(rgba_buffer, rgba_mipmaps, level, w, h, layout, data);
+			break;
+		case TextureFormat::kRG:
+			adopt_level(rg_buffer, rg_mipmaps, level, w, h, layout, data);
+			break;
+		case TextureFormat::kGray:
+			adopt_level(gray_buffer, gray_mipmaps, level, w, h, layout, data);
+			break;
+		case TextureFormat::kRGB16:
+			adopt_level(rgb16f_buffer, rgb16f_mipmaps, level, w, h, layout, data);
+			break;
+		case TextureFormat::kRGBA16:
+			adopt_level(rgba16f_buffer, rgba16f_mipmaps, level, w, h, layout, data);
+			break;
+		case TextureFormat::kBC1:
+			adopt_level(bc1_buffer, bc1_mipmaps, level, block_count(w), block_count(h), MemoryLayout::kLinear, data);
+			break;
+		case TextureFormat::kBC3:
+			adopt_level(bc3_buffer, bc3_mipmaps, level, block_count(w), block_count(h), MemoryLayout::kLinear, data);
+			break;
+		case TextureFormat::kBC4:
+			adopt_level(bc4_buffer, bc4_mipmaps, level, block_count(w), block_count(h), MemoryLayout::kLinear, data);
+			break;
+		case TextureFormat::kBC5:
+			adopt_level(bc5_buffer, bc5_mipmaps, level, block_count(w), block_count(h), MemoryLayout::kLinear, data);
+			break;
+		default:
+			delete[] data;
+			return;
 		}
+		resident_level = level;
+	}
+
+	void Texture::stream_out()
+	{
+		if (resident_level >= tail_level)
+		{
+			return;
+		}
+
+		switch (format)
+		{
+		case TextureFormat::kRGB:
+			drop_level(rgb_buffer, rgb_mipmaps, resident_level);
+			break;
+		case TextureFormat::kRGBA:
+			drop_level(rgba_buffer, rgba_mipmaps, resident_level);
+			break;
+		case TextureFormat::kRG:
+			drop_level(rg_buffer, rg_mipmaps, resident_level);
+			break;
 		case TextureFormat::kGray:
+			drop_level(gray_buffer, gray_mipmaps, resident_level);
+			break;
+		case TextureFormat::kRGB16:
+			drop_level(rgb16f_buffer, rgb16f_mipmaps, resident_level);
+			break;
+		case TextureFormat::kRGBA16:
+			drop_level(rgba16f_buffer, rgba16f_mipmaps, resident_level);
+			break;
+		case TextureFormat::kBC1:
+			drop_level(bc1_buffer, bc1_mipmaps, resident_level);
+			break;
+		case TextureFormat::kBC3:
+			drop_level(bc3_buffer, bc3_mipmaps, resident_level);
+			break;
+		case TextureFormat::kBC4:
+			drop_level(bc4_buffer, bc4_mipmaps, resident_level);
+			break;
+		case TextureFormat::kBC5:
+			drop_level(bc5_buffer, bc5_mipmaps, resident_level);
+			break;
+		default:
+			return;
+		}
+		resident_level++;
+	}
+
+	void Texture::save_cache(const char* texture_path)
+	{
+		std::vector<TextureLevel> levels;
+		switch (format)
 		{
-			for (int i = 1; i < gray_mipmaps.size(); i++)
-			{
-				gray_mipmaps[i].reset();
-			}
-			gray_mipmaps.clear();
+		case TextureFormat::kRGB:
+			levels = cache_levels(rgb_buffer, rgb_mipmaps, enable_mip);
+			break;
+		case TextureFormat::kRGBA:
+			levels = cache_levels(rgba_buffer, rgba_mipmaps, enable_mip);
+			break;
+		case TextureFormat::kRG:
+			levels = cache_levels(rg_buffer, rg_mipmaps, enable_mip);
+			break;
+		case TextureFormat::kGray:
+			levels = cache_levels(gray_buffer, gray_mipmaps, enable_mip);
+			break;
+		case TextureFormat::kRGB16:
+			levels = cache_levels(rgb16f_buffer, rgb16f_mipmaps, enable_mip);
+			break;
+		case TextureFormat::kRGBA16:
+			levels = cache_levels(rgba16f_buffer, rgba16f_mipmaps, enable_mip);
+			break;
+		case TextureFormat::kBC1:
+			levels = cache_block_levels(bc1_buffer, bc1_mipmaps, enable_mip, width, height);
+			break;
+		case TextureFormat::kBC3:
+			levels = cache_block_levels(bc3_buffer, bc3_mipmaps, enable_mip, width, height);
+			break;
+		case TextureFormat::kBC4:
+			levels = cache_block_levels(bc4_buffer, bc4_mipmaps, enable_mip, width, height);
+			break;
+		case TextureFormat::kBC5:
+			levels = cache_block_levels(bc5_buffer, bc5_mipmaps, enable_mip, width, height);
+			break;
+		default:
+			return;
+		}
 
-			gray_mipmaps.emplace_back(gray_buffer);
+		if (levels.size() != 0)
+		{
+			TextureCacheInfo info = { format, filtering, layout, layout == MemoryLayout::kTiled ? kTextureTileBits : 0, srgb };
+			TextureCache::save(cache_path(texture_path), info, levels);
+		}
+	}
 
-			for (int i = 1; i < count; i++)
+	template<typename T>
+	static void set_levels_layout(std::shared_ptr<RawBuffer<T>>& buffer, std::vector<std::shared_ptr<RawBuffer<T>>>& mipmaps, MemoryLayout layout)
+	{
+		size_t tile_bits = layout == MemoryLayout::kTiled ? kTextureTileBits : 0;
+		if (buffer != nullptr)
+		{
+			buffer->set_layout(layout, tile_bits);
+		}
+		for (auto& mipmap : mipmaps)
+		{
+			if (mipmap != nullptr)
 			{
-				size_t w = this->width >> i;
-				size_t h = this->height >> i;
-				auto mipmap = std::make_shared<RawBuffer<tinymath::color_gray>>(*gray_buffer);
-				ImageUtil::resize(*mipmap, w, h, filtering);
-				gray_mipmaps.emplace_back(mipmap);
+				mipmap->set_layout(layout, tile_bits);
 			}
-			break;
 		}
+	}
+
+	void Texture::set_layout(MemoryLayout target_layout)
+	{
+		// layered textures stay linear, tiles only cover a single layer. blocks are 4x4 tiles already
+		layout = layer_count > 1 || is_block_format(format) ? MemoryLayout::kLinear : target_layout;
+		switch (format)
+		{
+		case TextureFormat::kRGB:
+			set_levels_layout(rgb_buffer, rgb_mipmaps, layout);
+			break;
+		case TextureFormat::kRGBA:
+			set_levels_layout(rgba_buffer, rgba_mipmaps, layout);
+			break;
+		case TextureFormat::kRG:
+			set_levels_layout(rg_buffer, rg_mipmaps, layout);
+			break;
+		case TextureFormat::kGray:
+			set_levels_layout(gray_buffer, gray_mipmaps, layout);
+			break;
 		case TextureFormat::kRGB16:
+			set_levels_layout(rgb16f_buffer, rgb16f_mipmaps, layout);
+			break;
+		case TextureFormat::kRGBA16:
+			set_levels_layout(rgba16f_buffer, rgba16f_mipmaps, layout);
+			break;
+		default:
+			break;
+		}
+	}
+
+	template<typename Block>
+	static bool compress_levels(std::shared_ptr<RawBuffer<typename Block::pixel_type>>& buffer, std::vector<std::shared_ptr<RawBuffer<typename Block::pixel_type>>>& mipmaps, std::shared_ptr<RawBuffer<Block>>& block_buffer, std::vector<std::shared_ptr<RawBuffer<Block>>>& block_mipmaps)
+	{
+		if (buffer == nullptr)
 		{
-			for (int i = 1; i < rgb16f_mipmaps.size(); i++)
-			{
-				rgb16f_mipmaps[i].reset();
-			}
-			rgb16f_mipmaps.clear();
+			return false;
+		}
 
-			rgb16f_mipmaps.emplace_back(rgb16f_buffer);
+		block_mipmaps.clear();
+		for (auto& mipmap : mipmaps)
+		{
+			block_mipmaps.emplace_back(BlockCompression::compress<Block>(*mipmap));
+		}
+		block_buffer = block_mipmaps.size() > 0 ? block_mipmaps[0] : BlockCompression::compress<Block>(*buffer);
+		buffer.reset();
+		mipmaps.clear();
+		return true;
+	}
 
-			for (int i = 1; i < count; i++)
+	void Texture::compress()
+	{
+		TextureFormat target = compressed_format(format);
+		if (target == format || layer_count > 1)
+		{
+			return;
+		}
+
+		bool ok = false;
+		switch (format)
+		{
+		case TextureFormat::kRGB:
+			ok = compress_levels(rgb_buffer, rgb_mipmaps, bc1_buffer, bc1_mipmaps);
+			break;
+		case TextureFormat::kRGBA:
+			ok = compress_levels(rgba_buffer, rgba_mipmaps, bc3_buffer, bc3_mipmaps);
+			break;
+		case TextureFormat::kGray:
+			ok = compress_levels(gray_buffer, gray_mipmaps, bc4_buffer, bc4_mipmaps);
+			break;
+		case TextureFormat::kRG:
+			ok = compress_levels(rg_buffer, rg_mipmaps, bc5_buffer, bc5_mipmaps);
+			break;
+		default:
+			break;
+		}
+
+		if (ok)
+		{
+			format = target;
+			layout = MemoryLayout::kLinear;
+		}
+	}
+
+	template<typename Block>
+	static bool read_block_texel(const std::shared_ptr<RawBuffer<Block>>& buffer, const std::vector<std::shared_ptr<RawBuffer<Block>>>& mipmaps, bool enable_mip, int mip, size_t width, size_t height, size_t row, size_t col, tinymath::Color& ret)
+	{
+		const auto& level = enable_mip ? mipmaps[mip] : buffer;
+		size_t level_width = enable_mip ? width >> mip : width;
+		size_t level_height = enable_mip ? height >> mip : height;
+		if (level == nullptr || row >= level_height || col >= level_width)
+		{
+			return false;
+		}
+
+		const Block& block = level->at(row / kBlockDim, col / kBlockDim);
+		ret = ColorEncoding::decode(decode_texel(block, (row % kBlockDim) * kBlockDim + col % kBlockDim));
+		return true;
+	}
+
+	bool Texture::read_block(size_t row, size_t col, int mip, tinymath::Color& ret) const
+	{
+		switch (format)
+		{
+		case TextureFormat::kBC1:
+			return read_block_texel(bc1_buffer, bc1_mipmaps, enable_mip, mip, width, height, row, col, ret);
+		case TextureFormat::kBC3:
+			return read_block_texel(bc3_buffer, bc3_mipmaps, enable_mip, mip, width, height, row, col, ret);
+		case TextureFormat::kBC4:
+			return read_block_texel(bc4_buffer, bc4_mipmaps, enable_mip, mip, width, height, row, col, ret);
+		case TextureFormat::kBC5:
+			return read_block_texel(bc5_buffer, bc5_mipmaps, enable_mip, mip, width, height, row, col, ret);
+		default:
+			return false;
+		}
+	}
+
+	template<typename T>
+	static void generate_levels(const std::shared_ptr<RawBuffer<T>>& buffer, std::vector<std::shared_ptr<RawBuffer<T>>>& mipmaps, size_t width, size_t height, int count, bool srgb)
+	{
+		mipmaps.clear();
+		if (buffer == nullptr)
+		{
+			return;
+		}
+		mipmaps.emplace_back(buffer);
+		size_t layer_count = buffer->get_layer_count();
+
+		// levels are filtered linear, a tiled chain is moved back into its layout afterwards
+		MemoryLayout layout = buffer->get_layout();
+		size_t tile_bits = buffer->get_tile_bits();
+		std::shared_ptr<RawBuffer<T>> prev = buffer;
+		if (layout != MemoryLayout::kLinear)
+		{
+			prev = RawBuffer<T>::create(*buffer);
+			prev->set_layout(MemoryLayout::kLinear, 0);
+		}
+
+		// each level is filtered from the previous one instead of the full resolution image
+		for (int i = 1; i < count; i++)
+		{
+			auto mipmap = RawBuffer<T>::create(width >> i, height >> i, layer_count);
+			ImageUtil::downsample(*prev, *mipmap, srgb);
+			mipmaps.emplace_back(mipmap);
+			prev = mipmap;
+		}
+
+		if (layout != MemoryLayout::kLinear)
+		{
+			for (size_t i = 1; i < mipmaps.size(); i++)
 			{
-				size_t w = this->width >> i;
-				size_t h = this->height >> i;
-				auto mipmap = std::make_shared<RawBuffer<tinymath::color_rgb16f>>(*rgb16f_buffer);
-				ImageUtil::resize(*mipmap, w, h, filtering);
-				rgb16f_mipmaps.emplace_back(mipmap);
+				mipmaps[i]->set_layout(layout, tile_bits);
 			}
-			break;
 		}
+	}
+
+	void Texture::generate_mipmap(int count)
+	{
+		switch (this->format)
+		{
+		case TextureFormat::kRGB:
+			generate_levels(rgb_buffer, rgb_mipmaps, width, height, count, srgb);
+			break;
+		case TextureFormat::kRGBA:
+			generate_levels(rgba_buffer, rgba_mipmaps, width, height, count, srgb);
+			break;
+		case TextureFormat::kRG:
+			generate_levels(rg_buffer, rg_mipmaps, width, height, count, srgb);
+			break;
+		case TextureFormat::kGray:
+			generate_levels(gray_buffer, gray_mipmaps, width, height, count, srgb);
+			break;
+		case TextureFormat::kRGB16:
+			generate_levels(rgb16f_buffer, rgb16f_mipmaps, width, height, count, srgb);
+			break;
 		case TextureFormat::kRGBA16:
+			generate_levels(rgba16f_buffer, rgba16f_mipmaps, width, height, count, srgb);
+			break;
+		default:
+			// block formats are compressed from an existing chain
+			return;
+		}
+
+		this->mip_count = count;
+	}
+
+	// levels streamed out before resident_level only keep their size, the kernels never go below base_level
+	template<typename T>
+	static void resolve_levels(const std::shared_ptr<RawBuffer<T>>& buffer, const std::vector<std::shared_ptr<RawBuffer<T>>>& mipmaps, bool enable_mip, size_t resident_level, size_t width, size_t height, Sampler& sampler)
+	{
+		bool use_mip = enable_mip && mipmaps.size() > resident_level;
+		const auto& base = use_mip ? mipmaps[resident_level] : buffer;
+		if (base == nullptr)
 		{
-			for (int i = 1; i < rgba16f_mipmaps.size(); i++)
+			return;
+		}
+
+		sampler.tile_bits = base->get_tile_bits();
+		sampler.base_level = use_mip ? resident_level : 0;
+		size_t tile_size = (size_t)1 << sampler.tile_bits;
+		size_t count = use_mip ? tinymath::min(mipmaps.size(), (size_t)kMaxMip) : 1;
+		for (size_t i = 0; i < count; i++)
+		{
+			// the chain of a non square texture can run out of rows before it runs out of levels
+			if ((width >> i) == 0 || (height >> i) == 0)
 			{
-				rgba16f_mipmaps[i].reset();
+				break;
 			}
-			rgba16f_mipmaps.clear();
+			SamplerLevel& dst = sampler.levels[i];
+			dst.data = i < sampler.base_level ? nullptr : (use_mip ? mipmaps[i] : buffer)->get_ptr();
+			dst.width = width >> i;
+			dst.height = height >> i;
+			dst.tile_cols = (dst.width + tile_size - 1) >> sampler.tile_bits;
+			dst.fwidth = (float)dst.width;
+			dst.fheight = (float)dst.height;
+			sampler.level_count = i + 1;
+		}
+	}
 
-			rgba16f_mipmaps.emplace_back(rgba16f_buffer);
+	// tile_cols of a block level is its number of blocks per row
+	template<typename Block>
+	static void resolve_block_levels(const std::shared_ptr<RawBuffer<Block>>& buffer, const std::vector<std::shared_ptr<RawBuffer<Block>>>& mipmaps, bool enable_mip, size_t resident_level, size_t width, size_t height, Sampler& sampler)
+	{
+		bool use_mip = enable_mip && mipmaps.size() > resident_level;
+		if ((use_mip ? mipmaps[resident_level] : buffer) == nullptr)
+		{
+			return;
+		}
 
-			for (int i = 1; i < count; i++)
+		sampler.tile_bits = 0;
+		sampler.base_level = use_mip ? resident_level : 0;
+		size_t count = use_mip ? tinymath::min(mipmaps.size(), (size_t)kMaxMip) : 1;
+		for (size_t i = 0; i < count; i++)
+		{
+			if ((width >> i) == 0 || (height >> i) == 0)
 			{
-				size_t w = this->width >> i;
-				size_t h = this->height >> i;
-				auto mipmap = std::make_shared<RawBuffer<tinymath::color_rgba16f>>(*rgba16f_buffer);
-				ImageUtil::resize(*mipmap, w, h, filtering);
-				rgba16f_mipmaps.emplace_back(mipmap);
+				break;
 			}
-			break;
+			SamplerLevel& dst = sampler.levels[i];
+			dst.data = i < sampler.base_level ? nullptr : (use_mip ? mipmaps[i] : buffer)->get_ptr();
+			dst.width = width >> i;
+			dst.height = height >> i;
+			dst.tile_cols = block_count(dst.width);
+			dst.fwidth = (float)dst.width;
+			dst.fheight = (float)dst.height;
+			sampler.level_count = i + 1;
 		}
+	}
+
+	Sampler Texture::get_sampler() const
+	{
+		Sampler sampler;
+		if (layer_count > 1)
+		{
+			return sampler;
 		}
 
-		this->mip_count = count;
+		switch (format)
+		{
+		case TextureFormat::kRGB:
+			resolve_levels(rgb_buffer, rgb_mipmaps, enable_mip, resident_level, width, height, sampler);
+			break;
+		case TextureFormat::kRGBA:
+			resolve_levels(rgba_buffer, rgba_mipmaps, enable_mip, resident_level, width, height, sampler);
+			break;
+		case TextureFormat::kRG:
+			resolve_levels(rg_buffer, rg_mipmaps, enable_mip, resident_level, width, height, sampler);
+			break;
+		case TextureFormat::kGray:
+			resolve_levels(gray_buffer, gray_mipmaps, enable_mip, resident_level, width, height, sampler);
+			break;
+		case TextureFormat::kRGB16:
+			resolve_levels(rgb16f_buffer, rgb16f_mipmaps, enable_mip, resident_level, width, height, sampler);
+			break;
+		case TextureFormat::kRGBA16:
+			resolve_levels(rgba16f_buffer, rgba16f_mipmaps, enable_mip, resident_level, width, height, sampler);
+			break;
+		case TextureFormat::kBC1:
+			resolve_block_levels(bc1_buffer, bc1_mipmaps, enable_mip, resident_level, width, height, sampler);
+			break;
+		case TextureFormat::kBC3:
+			resolve_block_levels(bc3_buffer, bc3_mipmaps, enable_mip, resident_level, width, height, sampler);
+			break;
+		case TextureFormat::kBC4:
+			resolve_block_levels(bc4_buffer, bc4_mipmaps, enable_mip, resident_level, width, height, sampler);
+			break;
+		case TextureFormat::kBC5:
+			resolve_block_levels(bc5_buffer, bc5_mipmaps, enable_mip, resident_level, width, height, sampler);
+			break;
+		}
+
+		if (sampler.level_count > 0)
+		{
+			// the level buffers know their layout, tiled ones have tile bits
+			MemoryLayout buffer_layout = sampler.tile_bits > 0 ? MemoryLayout::kTiled : MemoryLayout::kLinear;
+			sampler.function = Sampler::compile(format, wrap_mode, filtering, buffer_layout);
+			sampler.feedback = is_streamed() ? &level_requests : nullptr;
+		}
+		return sampler;
 	}
 
 	bool Texture::sample(float u, float v, tinymath::Color& ret) const
 	{
+		if (is_streamed())
+		{
+			record_level_request(level_requests, 0);
+		}
+
 		if (filtering == Filtering::kPoint)
 		{
 			return read(u, v, ret);
@@ -422,6 +1065,11 @@ namespace CpuRasterizer
 
 	bool Texture::sample_mip(float u, float v, int mip, tinymath::Color& ret) const
 	{
+		if (is_streamed())
+		{
+			record_level_request(level_requests, (size_t)tinymath::clamp(mip, 0, kMaxMip - 1));
+		}
+
 		if (filtering == Filtering::kPoint)
 		{
 			return read_mip(u, v, mip, ret);
@@ -526,13 +1174,15 @@ namespace CpuRasterizer
 
 	bool Texture::linear_mip(float u, float v, int mip, tinymath::Color& ret) const
 	{
+		// streamed out levels fall back to the finest resident one
+		mip = tinymath::max(mip, (int)resident_level);
 		this->wrap(u, v);
 		bool use_mip = enable_mip;
 		switch (format)
 		{
 		case TextureFormat::kRGB:
 		{
-			auto buffer = use_mip ? rgb_mipmaps[mip] : rgb_buffer;
+			const auto& buffer = use_mip ? rgb_mipmaps[mip] : rgb_buffer;
 			tinymath::color_rgb pixel;
 			bool ok = ImageUtil::linear(*buffer, u, v, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -540,7 +1190,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGBA:
 		{
-			auto buffer = use_mip ? rgba_mipmaps[mip] : rgba_buffer;
+			const auto& buffer = use_mip ? rgba_mipmaps[mip] : rgba_buffer;
 			tinymath::color_rgba pixel;
 			bool ok = ImageUtil::linear(*buffer, u, v, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -548,7 +1198,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRG:
 		{
-			auto buffer = use_mip ? rg_mipmaps[mip] : rg_buffer;
+			const auto& buffer = use_mip ? rg_mipmaps[mip] : rg_buffer;
 			tinymath::color_rg pixel;
 			bool ok = ImageUtil::linear(*buffer, u, v, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -556,7 +1206,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kGray:
 		{
-			auto buffer = use_mip ? gray_mipmaps[mip] : gray_buffer;
+			const auto& buffer = use_mip ? gray_mipmaps[mip] : gray_buffer;
 			tinymath::color_gray pixel;
 			bool ok = ImageUtil::linear(*buffer, u, v, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -564,7 +1214,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGB16:
 		{
-			auto buffer = use_mip ? rgb16f_mipmaps[mip] : rgb16f_buffer;
+			const auto& buffer = use_mip ? rgb16f_mipmaps[mip] : rgb16f_buffer;
 			tinymath::color_rgb16f pixel;
 			bool ok = ImageUtil::linear(*buffer, u, v, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -572,12 +1222,32 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGBA16:
 		{
-			auto buffer = use_mip ? rgba16f_mipmaps[mip] : rgba16f_buffer;
+			const auto& buffer = use_mip ? rgba16f_mipmaps[mip] : rgba16f_buffer;
 			tinymath::color_rgba16f pixel;
 			bool ok = ImageUtil::linear(*buffer, u, v, pixel);
 			ret = ColorEncoding::decode(pixel);
 			return ok;
 		}
+		case TextureFormat::kBC1:
+		case TextureFormat::kBC3:
+		case TextureFormat::kBC4:
+		case TextureFormat::kBC5:
+		{
+			size_t level_width = enable_mip ? width >> mip : width;
+			size_t level_height = enable_mip ? height >> mip : height;
+			size_t row, col;
+			float frac_row, frac_col;
+			uv2pixel(level_width, level_height, u, v, row, col, frac_row, frac_col);
+			size_t next_row = tinymath::min(row + 1, level_height - 1);
+			size_t next_col = tinymath::min(col + 1, level_width - 1);
+			tinymath::Color c00, c01, c10, c11;
+			bool ok = read_block(row, col, mip, c00) && read_block(row, next_col, mip, c01) &&
+				read_block(next_row, col, mip, c10) && read_block(next_row, next_col, mip, c11);
+			tinymath::Color top = c00 + (c01 - c00) * frac_col;
+			tinymath::Color bottom = c10 + (c11 - c10) * frac_col;
+			ret = top + (bottom - top) * frac_row;
+			return ok;
+		}
 		}
 		return false;
 	}
@@ -590,7 +1260,7 @@ namespace CpuRasterizer
 		{
 		case TextureFormat::kRGB:
 		{
-			auto buffer = use_mip ? rgb_mipmaps[mip] : rgb_buffer;
+			const auto& buffer = use_mip ? rgb_mipmaps[mip] : rgb_buffer;
 			tinymath::color_rgb pixel;
 			bool ok = ImageUtil::linear(*buffer, u, v, w, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -598,7 +1268,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGBA:
 		{
-			auto buffer = use_mip ? rgba_mipmaps[mip] : rgba_buffer;
+			const auto& buffer = use_mip ? rgba_mipmaps[mip] : rgba_buffer;
 			tinymath::color_rgba pixel;
 			bool ok = ImageUtil::linear(*buffer, u, v, w, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -606,7 +1276,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRG:
 		{
-			auto buffer = use_mip ? rg_mipmaps[mip] : rg_buffer;
+			const auto& buffer = use_mip ? rg_mipmaps[mip] : rg_buffer;
 			tinymath::color_rg pixel;
 			bool ok = ImageUtil::linear(*buffer, u, v, w, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -614,7 +1284,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kGray:
 		{
-			auto buffer = use_mip ? gray_mipmaps[mip] : gray_buffer;
+			const auto& buffer = use_mip ? gray_mipmaps[mip] : gray_buffer;
 			tinymath::color_gray pixel;
 			bool ok = ImageUtil::linear(*buffer, u, v, w, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -622,7 +1292,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGB16:
 		{
-			auto buffer = use_mip ? rgb16f_mipmaps[mip] : rgb16f_buffer;
+			const auto& buffer = use_mip ? rgb16f_mipmaps[mip] : rgb16f_buffer;
 			tinymath::color_rgb16f pixel;
 			bool ok = ImageUtil::linear(*buffer, u, v, w, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -630,7 +1300,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGBA16:
 		{
-			auto buffer = use_mip ? rgba16f_mipmaps[mip] : rgba16f_buffer;
+			const auto& buffer = use_mip ? rgba16f_mipmaps[mip] : rgba16f_buffer;
 			tinymath::color_rgba16f pixel;
 			bool ok = ImageUtil::linear(*buffer, u, v, w, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -662,13 +1332,14 @@ namespace CpuRasterizer
 
 	bool Texture::read_mip(float u, float v, int mip, tinymath::Color& ret) const
 	{
+		mip = tinymath::max(mip, (int)resident_level);
 		this->wrap(u, v);
 		bool use_mip = enable_mip;
 		switch (format)
 		{
 		case TextureFormat::kRGB:
 		{
-			auto buffer = use_mip ? rgb_mipmaps[mip] : rgb_buffer;
+			const auto& buffer = use_mip ? rgb_mipmaps[mip] : rgb_buffer;
 			tinymath::color_rgb pixel;
 			bool ok = buffer->read(u, v, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -676,7 +1347,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGBA:
 		{
-			auto buffer = use_mip ? rgba_mipmaps[mip] : rgba_buffer;
+			const auto& buffer = use_mip ? rgba_mipmaps[mip] : rgba_buffer;
 			tinymath::color_rgba pixel;
 			bool ok = buffer->read(u, v, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -684,7 +1355,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRG:
 		{
-			auto buffer = use_mip ? rg_mipmaps[mip] : rg_buffer;
+			const auto& buffer = use_mip ? rg_mipmaps[mip] : rg_buffer;
 			tinymath::color_rg pixel;
 			bool ok = buffer->read(u, v, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -692,7 +1363,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kGray:
 		{
-			auto buffer = use_mip ? gray_mipmaps[mip] : gray_buffer;
+			const auto& buffer = use_mip ? gray_mipmaps[mip] : gray_buffer;
 			tinymath::color_gray pixel;
 			bool ok = buffer->read(u, v, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -700,7 +1371,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGB16:
 		{
-			auto buffer = use_mip ? rgb16f_mipmaps[mip] : rgb16f_buffer;
+			const auto& buffer = use_mip ? rgb16f_mipmaps[mip] : rgb16f_buffer;
 			tinymath::color_rgb16f pixel;
 			bool ok = buffer->read(u, v, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -708,12 +1379,21 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGBA16:
 		{
-			auto buffer = use_mip ? rgba16f_mipmaps[mip] : rgba16f_buffer;
+			const auto& buffer = use_mip ? rgba16f_mipmaps[mip] : rgba16f_buffer;
 			tinymath::color_rgba16f pixel;
 			bool ok = buffer->read(u, v, pixel);
 			ret = ColorEncoding::decode(pixel);
 			return ok;
 		}
+		case TextureFormat::kBC1:
+		case TextureFormat::kBC3:
+		case TextureFormat::kBC4:
+		case TextureFormat::kBC5:
+		{
+			size_t row, col;
+			uv2pixel(enable_mip ? width >> mip : width, enable_mip ? height >> mip : height, u, v, row, col);
+			return read_block(row, col, mip, ret);
+		}
 		}
 		return false;
 	}
@@ -726,7 +1406,7 @@ namespace CpuRasterizer
 		{
 		case TextureFormat::kRGB:
 		{
-			auto buffer = use_mip ? rgb_mipmaps[mip] : rgb_buffer;
+			const auto& buffer = use_mip ? rgb_mipmaps[mip] : rgb_buffer;
 			tinymath::color_rgb pixel;
 			bool ok = buffer->read(u, v, w, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -734,7 +1414,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGBA:
 		{
-			auto buffer = use_mip ? rgba_mipmaps[mip] : rgba_buffer;
+			const auto& buffer = use_mip ? rgba_mipmaps[mip] : rgba_buffer;
 			tinymath::color_rgba pixel;
 			bool ok = buffer->read(u, v, w, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -742,7 +1422,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRG:
 		{
-			auto buffer = use_mip ? rg_mipmaps[mip] : rg_buffer;
+			const auto& buffer = use_mip ? rg_mipmaps[mip] : rg_buffer;
 			tinymath::color_rg pixel;
 			bool ok = buffer->read(u, v, w, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -750,7 +1430,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kGray:
 		{
-			auto buffer = use_mip ? gray_mipmaps[mip] : gray_buffer;
+			const auto& buffer = use_mip ? gray_mipmaps[mip] : gray_buffer;
 			tinymath::color_gray pixel;
 			bool ok = buffer->read(u, v, w, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -758,7 +1438,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGB16:
 		{
-			auto buffer = use_mip ? rgb16f_mipmaps[mip] : rgb16f_buffer;
+			const auto& buffer = use_mip ? rgb16f_mipmaps[mip] : rgb16f_buffer;
 			tinymath::color_rgb16f pixel;
 			bool ok = buffer->read(u, v, w, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -766,7 +1446,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGBA16:
 		{
-			auto buffer = use_mip ? rgba16f_mipmaps[mip] : rgba16f_buffer;
+			const auto& buffer = use_mip ? rgba16f_mipmaps[mip] : rgba16f_buffer;
 			tinymath::color_rgba16f pixel;
 			bool ok = buffer->read(u, v, w, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -782,7 +1462,7 @@ namespace CpuRasterizer
 		{
 		case TextureFormat::kRGB:
 		{
-			auto buffer = enable_mip ? rgb_mipmaps[mip] : rgb_buffer;
+			const auto& buffer = enable_mip ? rgb_mipmaps[mip] : rgb_buffer;
 			tinymath::color_rgb pixel;
 			bool ok = buffer->read(row, col, layer, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -790,7 +1470,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGBA:
 		{
-			auto buffer = enable_mip ? rgba_mipmaps[mip] : rgba_buffer;
+			const auto& buffer = enable_mip ? rgba_mipmaps[mip] : rgba_buffer;
 			tinymath::color_rgba pixel;
 			bool ok = buffer->read(row, col, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -798,7 +1478,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRG:
 		{
-			auto buffer = enable_mip ? rg_mipmaps[mip] : rg_buffer;
+			const auto& buffer = enable_mip ? rg_mipmaps[mip] : rg_buffer;
 			tinymath::color_rg pixel;
 			bool ok = buffer->read(row, col, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -806,7 +1486,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kGray:
 		{
-			auto buffer = enable_mip ? gray_mipmaps[mip] : gray_buffer;
+			const auto& buffer = enable_mip ? gray_mipmaps[mip] : gray_buffer;
 			tinymath::color_gray pixel;
 			bool ok = buffer->read(row, col, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -814,7 +1494,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGB16:
 		{
-			auto buffer = enable_mip ? rgb16f_mipmaps[mip] : rgb16f_buffer;
+			const auto& buffer = enable_mip ? rgb16f_mipmaps[mip] : rgb16f_buffer;
 			tinymath::color_rgb16f pixel;
 			bool ok = buffer->read(row, col, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -822,7 +1502,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGBA16:
 		{
-			auto buffer = enable_mip ? rgba16f_mipmaps[mip] : rgba16f_buffer;
+			const auto& buffer = enable_mip ? rgba16f_mipmaps[mip] : rgba16f_buffer;
 			tinymath::color_rgba16f pixel;
 			bool ok = buffer->read(row, col, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -834,11 +1514,17 @@ namespace CpuRasterizer
 
 	bool Texture::read_mip(size_t row, size_t col, int mip, tinymath::Color& ret) const
 	{
+		// texel coordinates belong to one level, a streamed out one can't be read
+		if (enable_mip && (size_t)mip < resident_level)
+		{
+			return false;
+		}
+
 		switch (format)
 		{
 		case TextureFormat::kRGB:
 		{
-			auto buffer = enable_mip ? rgb_mipmaps[mip] : rgb_buffer;
+			const auto& buffer = enable_mip ? rgb_mipmaps[mip] : rgb_buffer;
 			tinymath::color_rgb pixel;
 			bool ok = buffer->read(row, col, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -846,7 +1532,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGBA:
 		{
-			auto buffer = enable_mip ? rgba_mipmaps[mip] : rgba_buffer;
+			const auto& buffer = enable_mip ? rgba_mipmaps[mip] : rgba_buffer;
 			tinymath::color_rgba pixel;
 			bool ok = buffer->read(row, col, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -854,7 +1540,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRG:
 		{
-			auto buffer = enable_mip ? rg_mipmaps[mip] : rg_buffer;
+			const auto& buffer = enable_mip ? rg_mipmaps[mip] : rg_buffer;
 			tinymath::color_rg pixel;
 			bool ok = buffer->read(row, col, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -862,7 +1548,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kGray:
 		{
-			auto buffer = enable_mip ? gray_mipmaps[mip] : gray_buffer;
+			const auto& buffer = enable_mip ? gray_mipmaps[mip] : gray_buffer;
 			tinymath::color_gray pixel;
 			bool ok = buffer->read(row, col, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -870,7 +1556,7 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGB16:
 		{
-			auto buffer = enable_mip ? rgb16f_mipmaps[mip] : rgb16f_buffer;
+			const auto& buffer = enable_mip ? rgb16f_mipmaps[mip] : rgb16f_buffer;
 			tinymath::color_rgb16f pixel;
 			bool ok = buffer->read(row, col, pixel);
 			ret = ColorEncoding::decode(pixel);
@@ -878,12 +1564,17 @@ namespace CpuRasterizer
 		}
 		case TextureFormat::kRGBA16:
 		{
-			auto buffer = enable_mip ? rgba16f_mipmaps[mip] : rgba16f_buffer;
+			const auto& buffer = enable_mip ? rgba16f_mipmaps[mip] : rgba16f_buffer;
 			tinymath::color_rgba16f pixel;
 			bool ok = buffer->read(row, col, pixel);
 			ret = ColorEncoding::decode(pixel);
 			return ok;
 		}
+		case TextureFormat::kBC1:
+		case TextureFormat::kBC3:
+		case TextureFormat::kBC4:
+		case TextureFormat::kBC5:
+			return read_block(row, col, mip, ret);
 		}
 		return false;
 	}
@@ -1127,31 +1818,41 @@ namespace CpuRasterizer
 		rgba_buffer.reset();
 		rgb16f_buffer.reset();
 		rgba16f_buffer.reset();
+		bc1_buffer.reset();
+		bc3_buffer.reset();
+		bc4_buffer.reset();
+		bc5_buffer.reset();
+		bc1_mipmaps.clear();
+		bc3_mipmaps.clear();
+		bc4_mipmaps.clear();
+		bc5_mipmaps.clear();
+		// the chains are cleared whatever mip_count says, it is set even when the raw image was missing and there was nothing to filter
+		gray_mipmaps.clear();
+		rg_mipmaps.clear();
+		rgb_mipmaps.clear();
+		rgba_mipmaps.clear();
+		rgb16f_mipmaps.clear();
+		rgba16f_mipmaps.clear();
+		stream_levels.clear();
+		stream_file.clear();
+		resident_level = 0;
+		tail_level = 0;
+	}
 
-		for (size_t i = 1; i < this->mip_count; i++)
+	// stb writes linear rows, tiled textures are linearized into a temporary copy
+	template<typename T>
+	static std::shared_ptr<T> linear_pixels(RawBuffer<T>& buffer)
+	{
+		size_t size;
+		T* data = buffer.get_ptr(size);
+		if (buffer.get_layout() == MemoryLayout::kLinear)
 		{
-			switch (this->format)
-			{
-			case TextureFormat::kRGB:
-				this->rgb_mipmaps[i].reset();
-				break;
-			case TextureFormat::kRGBA:
-				this->rgba_mipmaps[i].reset();
-				break;
-			case TextureFormat::kRG:
-				this->rg_mipmaps[i].reset();
-				break;
-			case TextureFormat::kGray:
-				this->gray_mipmaps[i].reset();
-				break;
-			case TextureFormat::kRGB16:
-				this->rgb16f_mipmaps[i].reset();
-				break;
-			case TextureFormat::kRGBA16:
-				this->rgba16f_mipmaps[i].reset();
-				break;
-			}
+			return std::shared_ptr<T>(data, [](T* ptr) { UNUSED(ptr); });
 		}
+
+		std::shared_ptr<T> linear(new T[buffer.get_width() * buffer.get_height()], [](T* ptr) { delete[] ptr; });
+		buffer.linearize(linear.get());
+		return linear;
 	}
 
 	void Texture::export_image(const Texture& tex, const std::string& path)
@@ -1164,44 +1865,62 @@ namespace CpuRasterizer
 		{
 		case TextureFormat::kRGB:
 		{
-			size_t size;
-			auto data = (*tex.rgb_buffer).get_ptr(size);
-			ret = stbi_write_png(dest, (int)tex.width, (int)tex.height, 3, data, 0);
+			auto data = linear_pixels(*tex.rgb_buffer);
+			ret = stbi_write_png(dest, (int)tex.width, (int)tex.height, 3, data.get(), 0);
 		}
 		break;
 		case TextureFormat::kRGBA:
 		{
-			size_t size;
-			auto data = (*tex.rgba_buffer).get_ptr(size);
-			ret = stbi_write_png(dest, (int)tex.width, (int)tex.height, 4, data, 0);
+			auto data = linear_pixels(*tex.rgba_buffer);
+			ret = stbi_write_png(dest, (int)tex.width, (int)tex.height, 4, data.get(), 0);
 		}
 		break;
 		case TextureFormat::kRG:
 		{
-			size_t size;
-			auto data = (*tex.rg_buffer).get_ptr(size);
-			ret = stbi_write_png(dest, (int)tex.width, (int)tex.height, 2, data, 0);
+			auto data = linear_pixels(*tex.rg_buffer);
+			ret = stbi_write_png(dest, (int)tex.width, (int)tex.height, 2, data.get(), 0);
 		}
 		break;
 		case TextureFormat::kGray:
 		{
-			size_t size;
-			auto data = (*tex.gray_buffer).get_ptr(size);
-			ret = stbi_write_png(dest, (int)tex.width, (int)tex.height, 1, data, 0);
+			auto data = linear_pixels(*tex.gray_buffer);
+			ret = stbi_write_png(dest, (int)tex.width, (int)tex.height, 1, data.get(), 0);
 		}
 		break;
 		case TextureFormat::kRGB16:
 		{
-			size_t size;
-			auto data = (*tex.rgb16f_buffer).get_ptr(size);
-			ret = stbi_write_hdr(dest, (int)tex.width, (int)tex.height, 3, (float*)data);
+			auto data = linear_pixels(*tex.rgb16f_buffer);
+			ret = stbi_write_hdr(dest, (int)tex.width, (int)tex.height, 3, (float*)data.get());
 		}
 		break;
 		case TextureFormat::kRGBA16:
 		{
-			size_t size;
-			auto data = (*tex.rgba16f_buffer).get_ptr(size);
-			ret = stbi_write_hdr(dest, (int)tex.width, (int)tex.height, 4, (float*)data);
+			auto data = linear_pixels(*tex.rgba16f_buffer);
+			ret = stbi_write_hdr(dest, (int)tex.width, (int)tex.height, 4, (float*)data.get());
+		}
+		break;
+		case TextureFormat::kBC1:
+		{
+			auto data = BlockCompression::decompress(*tex.bc1_buffer, tex.width, tex.height);
+			ret = stbi_write_png(dest, (int)tex.width, (int)tex.height, 3, data.data(), 0);
+		}
+		break;
+		case TextureFormat::kBC3:
+		{
+			auto data = BlockCompression::decompress(*tex.bc3_buffer, tex.width, tex.height);
+			ret = stbi_write_png(dest, (int)tex.width, (int)tex.height, 4, data.data(), 0);
+		}
+		break;
+		case TextureFormat::kBC4:
+		{
+			auto data = BlockCompression::decompress(*tex.bc4_buffer, tex.width, tex.height);
+			ret = stbi_write_png(dest, (int)tex.width, (int)tex.height, 1, data.data(), 0);
+		}
+		break;
+		case TextureFormat::kBC5:
+		{
+			auto data = BlockCompression::decompress(*tex.bc5_buffer, tex.width, tex.height);
+			ret = stbi_write_png(dest, (int)tex.width, (int)tex.height, 2, data.data(), 0);
 		}
 		break;
 		}
@@ -1341,6 +2060,25 @@ namespace CpuRasterizer
 		this->rgb_mipmaps = other.rgb_mipmaps;
 		this->rgb16f_mipmaps = other.rgb16f_mipmaps;
 		this->rgba16f_mipmaps = other.rgba16f_mipmaps;
+		this->bc1_buffer = other.bc1_buffer;
+		this->bc3_buffer = other.bc3_buffer;
+		this->bc4_buffer = other.bc4_buffer;
+		this->bc5_buffer = other.bc5_buffer;
+		this->bc1_mipmaps = other.bc1_mipmaps;
+		this->bc3_mipmaps = other.bc3_mipmaps;
+		this->bc4_mipmaps = other.bc4_mipmaps;
+		this->bc5_mipmaps = other.bc5_mipmaps;
+		this->enable_compression = other.enable_compression;
+		this->srgb = other.srgb;
+		this->layout = other.layout;
+		this->cache_storage = other.cache_storage;
+		this->enable_streaming = other.enable_streaming;
+		this->stream_levels = other.stream_levels;
+		this->stream_file = other.stream_file;
+		this->stream_info = other.stream_info;
+		this->resident_level = other.resident_level;
+		this->tail_level = other.tail_level;
+		this->level_requests.store(0, std::memory_order_relaxed);
 	}
 
 	void* Texture::get_ptr()
@@ -1360,6 +2098,14 @@ namespace CpuRasterizer
 			return rgb16f_buffer->get_ptr(size);
 		case TextureFormat::kRGBA16:
 			return rgba16f_buffer->get_ptr(size);
+		case TextureFormat::kBC1:
+			return bc1_buffer->get_ptr(size);
+		case TextureFormat::kBC3:
+			return bc3_buffer->get_ptr(size);
+		case TextureFormat::kBC4:
+			return bc4_buffer->get_ptr(size);
+		case TextureFormat::kBC5:
+			return bc5_buffer->get_ptr(size);
 		}
 
 		return (void*)nullptr;
@@ -0,0 +1,218 @@
+#include "TextureCache.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include "tinymath.h"
+#include "RawBuffer.hpp"
+#include "BlockCompression.hpp"
+#include "MappedFile.hpp"
+#include "Logger.hpp"
+
+namespace CpuRasterizer
+{
+	size_t TextureCache::pixel_size(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::kRGB: return sizeof(tinymath::color_rgb);
+		case TextureFormat::kRGBA: return sizeof(tinymath::color_rgba);
+		case TextureFormat::kRG: return sizeof(tinymath::color_rg);
+		case TextureFormat::kGray: return sizeof(tinymath::color_gray);
+		case TextureFormat::kRGB16: return sizeof(tinymath::color_rgb16f);
+		case TextureFormat::kRGBA16: return sizeof(tinymath::color_rgba16f);
+		case TextureFormat::kBC1: return sizeof(bc1_block);
+		case TextureFormat::kBC3: return sizeof(bc3_block);
+		case TextureFormat::kBC4: return sizeof(bc4_block);
+		case TextureFormat::kBC5: return sizeof(bc5_block);
+		default: return 0;
+		}
+	}
+
+	size_t TextureCache::level_size(TextureFormat format, size_t width, size_t height, MemoryLayout layout, size_t tile_bits)
+	{
+		if (is_block_format(format))
+		{
+			return block_count(width) * block_count(height) * pixel_size(format);
+		}
+		return layout_length(width, height, 1, layout, tile_bits) * pixel_size(format);
+	}
+
+	bool TextureCache::save(const std::string& path, const TextureCacheInfo& info, const std::vector<TextureLevel>& levels)
+	{
+		size_t texel_size = pixel_size(info.format);
+		if (texel_size == 0 || levels.size() == 0)
+		{
+			return false;
+		}
+
+		TextureCacheHeader header = {};
+		header.magic = kTextureCacheMagic;
+		header.version = kTextureCacheVersion;
+		header.format = (uint32_t)info.format;
+		header.filtering = (uint32_t)info.filtering;
+		header.layout = (uint16_t)info.layout;
+		header.tile_bits = (uint8_t)info.tile_bits;
+		header.srgb = info.srgb ? 1 : 0;
+		header.width = (uint32_t)levels[0].width;
+		header.height = (uint32_t)levels[0].height;
+		header.level_count = (uint32_t)levels.size();
+
+		std::vector<TextureCacheLevel> table(levels.size());
+		size_t offset = sizeof(TextureCacheHeader) + sizeof(TextureCacheLevel) * levels.size();
+		for (size_t idx = 0; idx < levels.size(); ++idx)
+		{
+			table[idx].width = (uint32_t)levels[idx].width;
+			table[idx].height = (uint32_t)levels[idx].height;
+			table[idx].offset = tinymath::round_up(offset, kTextureCacheAlignment);
+			table[idx].size = level_size(info.format, levels[idx].width, levels[idx].height, info.layout, info.tile_bits);
+			offset = table[idx].offset + table[idx].size;
+		}
+
+		std::filesystem::path abs_path(path);
+		if (!std::filesystem::exists(abs_path.parent_path()))
+		{
+			std::filesystem::create_directories(abs_path.parent_path());
+		}
+
+		// written aside and renamed over the cache, so instances still mapping the old file keep reading it
+		std::string temp_path = path + ".tmp";
+		std::FILE* fd = fopen(temp_path.c_str(), "wb");
+		if (fd == nullptr)
+		{
+			ERROR("cannot write texture cache: {}", path);
+			return false;
+		}
+
+		static const uint8_t zeros[kTextureCacheAlignment] = {};
+		bool ok = fwrite(&header, sizeof(header), 1, fd) == 1;
+		ok = ok && fwrite(table.data(), sizeof(TextureCacheLevel), table.size(), fd) == table.size();
+		size_t position = sizeof(TextureCacheHeader) + sizeof(TextureCacheLevel) * table.size();
+		for (size_t idx = 0; idx < levels.size() && ok; ++idx)
+		{
+			size_t padding = (size_t)table[idx].offset - position;
+			ok = padding == 0 || fwrite(zeros, 1, padding, fd) == padding;
+			ok = ok && (table[idx].size == 0 || fwrite(levels[idx].data, 1, (size_t)table[idx].size, fd) == table[idx].size);
+			position = (size_t)(table[idx].offset + table[idx].size);
+		}
+		ok = fclose(fd) == 0 && ok;
+
+		std::error_code error;
+		if (ok)
+		{
+			std::filesystem::rename(temp_path, abs_path, error);
+			ok = !error;
+		}
+		if (!ok)
+		{
+			// never leave a truncated cache behind
+			std::filesystem::remove(temp_path, error);
+			ERROR("cannot write texture cache: {}", path);
+			return false;
+		}
+		return true;
+	}
+
+	bool TextureCache::load(const std::string& path, TextureCacheInfo& info, std::vector<TextureLevel>& levels, std::shared_ptr<MappedFile>& file)
+	{
+		// copy on write, textures can be written after loading without touching the file
+		auto mapped = MappedFile::open(path, true);
+		if (mapped == nullptr || mapped->size() < sizeof(TextureCacheHeader))
+		{
+			return false;
+		}
+
+		TextureCacheHeader header;
+		memcpy(&header, mapped->data(), sizeof(header));
+		size_t texel_size = pixel_size((TextureFormat)header.format);
+		size_t file_size = mapped->size();
+		MemoryLayout layout = (MemoryLayout)header.layout;
+		if (header.magic != kTextureCacheMagic || header.version != kTextureCacheVersion || texel_size == 0 || header.level_count == 0 ||
+			(layout != MemoryLayout::kLinear && layout != MemoryLayout::kTiled) || header.tile_bits > 8 ||
+			header.level_count > (file_size - sizeof(TextureCacheHeader)) / sizeof(TextureCacheLevel))
+		{
+			return false;
+		}
+
+		std::vector<TextureLevel> loaded(header.level_count);
+		for (size_t idx = 0; idx < header.level_count; ++idx)
+		{
+			TextureCacheLevel level;
+			memcpy(&level, mapped->data() + sizeof(TextureCacheHeader) + sizeof(TextureCacheLevel) * idx, sizeof(level));
+			uint64_t size = (uint64_t)level_size((TextureFormat)header.format, level.width, level.height, layout, header.tile_bits);
+			if (level.size != size || level.offset % kTextureCacheAlignment != 0 || level.offset > file_size || size > file_size - level.offset)
+			{
+				return false;
+			}
+
+			loaded[idx].width = level.width;
+			loaded[idx].height = level.height;
+			loaded[idx].data = mapped->writable_data() + level.offset;
+			loaded[idx].offset = (size_t)level.offset;
+			loaded[idx].size = (size_t)level.size;
+		}
+
+		if (loaded[0].width != header.width || loaded[0].height != header.height)
+		{
+			return false;
+		}
+
+		info.format = (TextureFormat)header.format;
+		info.filtering = (Filtering)header.filtering;
+		info.layout = layout;
+		info.tile_bits = layout == MemoryLayout::kTiled ? header.tile_bits : 0;
+		info.srgb = header.srgb != 0;
+		levels = std::move(loaded);
+		file = mapped;
+		return true;
+	}
+
+	static bool seek(std::FILE* fd, size_t offset)
+	{
+#if (defined(WIN32) || defined(_WIN32))
+		return _fseeki64(fd, (int64_t)offset, SEEK_SET) == 0;
+#else
+		return fseeko(fd, (off_t)offset, SEEK_SET) == 0;
+#endif
+	}
+
+	bool TextureCache::read_level(const std::string& path, const TextureCacheInfo& info, size_t index, const TextureLevel& level, void* dst)
+	{
+		if (level.size == 0)
+		{
+			return true;
+		}
+
+		std::FILE* fd = fopen(path.c_str(), "rb");
+		if (fd == nullptr)
+		{
+			return false;
+		}
+
+		// the cache is replaced whenever its texture is imported again, the header and the table entry have to still match
+		TextureCacheHeader header;
+		TextureCacheLevel entry;
+		bool ok = fread(&header, sizeof(header), 1, fd) == 1;
+		MemoryLayout layout = (MemoryLayout)header.layout;
+		ok = ok && header.magic == kTextureCacheMagic && header.version == kTextureCacheVersion &&
+			(TextureFormat)header.format == info.format && layout == info.layout &&
+			(layout == MemoryLayout::kTiled ? (size_t)header.tile_bits : 0) == info.tile_bits &&
+			(header.srgb != 0) == info.srgb && index < header.level_count;
+		ok = ok && seek(fd, sizeof(TextureCacheHeader) + sizeof(TextureCacheLevel) * index) && fread(&entry, sizeof(entry), 1, fd) == 1;
+		ok = ok && entry.width == level.width && entry.height == level.height && entry.offset == level.offset && entry.size == level.size;
+		if (!ok)
+		{
+			fclose(fd);
+			WARN("texture cache changed since it was loaded, level not streamed: {}", path);
+			return false;
+		}
+
+		ok = seek(fd, level.offset) && fread(dst, 1, level.size, fd) == level.size;
+		fclose(fd);
+
+		if (!ok)
+		{
+			ERROR("cannot read texture cache level: {}", path);
+		}
+		return ok;
+	}
+}
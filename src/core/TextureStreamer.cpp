@@ -0,0 +1,221 @@
+#include "TextureStreamer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include "Texture.hpp"
+#include "TextureCache.hpp"
+#include "GlobalShaderParams.hpp"
+
+namespace CpuRasterizer
+{
+	TextureStreamer::TextureStreamer() : frame(0), resident_bytes(0), loading_bytes(0)
+	{}
+
+	TextureStreamer::~TextureStreamer()
+	{
+		for (auto& load : loads)
+		{
+			if (load.data.valid())
+			{
+				load.data.wait();
+			}
+		}
+	}
+
+	void TextureStreamer::add(const std::shared_ptr<Texture>& texture)
+	{
+		if (texture == nullptr || !texture->is_streamed())
+		{
+			return;
+		}
+
+		StreamedTexture entry;
+		entry.key = texture.get();
+		entry.texture = texture;
+		std::fill(std::begin(entry.last_requested), std::end(entry.last_requested), (uint64_t)0);
+		entry.wanted_level = texture->get_tail_level();
+		entry.loading = false;
+		entry.stale = false;
+		std::lock_guard<std::mutex> lock(added_mutex);
+		added.emplace_back(entry);
+	}
+
+	void TextureStreamer::update()
+	{
+		frame++;
+		{
+			std::lock_guard<std::mutex> lock(added_mutex);
+			textures.insert(textures.end(), added.begin(), added.end());
+			added.clear();
+		}
+		finish_loads();
+		read_feedback();
+		evict_unused();
+		start_loads();
+	}
+
+	void TextureStreamer::finish_loads()
+	{
+		for (auto it = loads.begin(); it != loads.end();)
+		{
+			if (it->data.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				++it;
+				continue;
+			}
+
+			std::unique_ptr<uint8_t[]> data = it->data.get();
+			bool failed = data == nullptr;
+			auto texture = it->texture.lock();
+			if (texture != nullptr && data != nullptr)
+			{
+				texture->stream_in(it->level, data.release());
+			}
+			for (auto& entry : textures)
+			{
+				if (entry.key == it->key)
+				{
+					entry.loading = false;
+					entry.stale = entry.stale || failed;
+				}
+			}
+			loading_bytes -= it->size;
+			it = loads.erase(it);
+		}
+	}
+
+	void TextureStreamer::read_feedback()
+	{
+		textures.erase(std::remove_if(textures.begin(), textures.end(), [](const StreamedTexture& entry) { return entry.texture.expired(); }), textures.end());
+
+		resident_bytes = 0;
+		for (auto& entry : textures)
+		{
+			auto texture = entry.texture.lock();
+			uint32_t requests = texture->take_level_requests();
+			for (size_t level = 0; level < (size_t)kMaxMip; level++)
+			{
+				if ((requests >> level) & 1u)
+				{
+					entry.last_requested[level] = frame;
+				}
+			}
+
+			entry.wanted_level = texture->get_tail_level();
+			for (size_t level = 0; level < texture->get_tail_level(); level++)
+			{
+				if (entry.last_requested[level] != 0 && frame - entry.last_requested[level] <= kStreamingKeepFrames)
+				{
+					entry.wanted_level = level;
+					break;
+				}
+			}
+			resident_bytes += texture->get_streamed_bytes();
+		}
+	}
+
+	void TextureStreamer::evict_unused()
+	{
+		for (auto& entry : textures)
+		{
+			auto texture = entry.texture.lock();
+			while (texture->get_resident_level() < entry.wanted_level)
+			{
+				size_t level = texture->get_resident_level();
+				if (entry.last_requested[level] != 0 && frame - entry.last_requested[level] <= kStreamingEvictFrames)
+				{
+					break;
+				}
+				resident_bytes -= texture->get_stream_level(level).size;
+				texture->stream_out();
+			}
+		}
+	}
+
+	bool TextureStreamer::make_room(size_t size, const Texture* keep)
+	{
+		while (resident_bytes + loading_bytes + size > CpuRasterSharedData.texture_streaming_budget)
+		{
+			std::shared_ptr<Texture> victim;
+			uint64_t oldest = UINT64_MAX;
+			for (auto& entry : textures)
+			{
+				auto texture = entry.texture.lock();
+				if (texture == nullptr || texture.get() == keep)
+				{
+					continue;
+				}
+				size_t level = texture->get_resident_level();
+				if (level < entry.wanted_level && entry.last_requested[level] < oldest)
+				{
+					victim = texture;
+					oldest = entry.last_requested[level];
+				}
+			}
+
+			if (victim == nullptr)
+			{
+				return false;
+			}
+			resident_bytes -= victim->get_stream_level(victim->get_resident_level()).size;
+			victim->stream_out();
+		}
+		return true;
+	}
+
+	void TextureStreamer::start_loads()
+	{
+		// textures furthest from the level they want go first
+		std::vector<StreamedTexture*> candidates;
+		for (auto& entry : textures)
+		{
+			auto texture = entry.texture.lock();
+			if (!entry.loading && !entry.stale && texture->get_resident_level() > entry.wanted_level)
+			{
+				candidates.push_back(&entry);
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const StreamedTexture* a, const StreamedTexture* b)
+		{
+			auto ta = a->texture.lock();
+			auto tb = b->texture.lock();
+			return ta->get_resident_level() - a->wanted_level > tb->get_resident_level() - b->wanted_level;
+		});
+
+		for (StreamedTexture* entry : candidates)
+		{
+			if (loads.size() >= kMaxStreamingLoads)
+			{
+				break;
+			}
+
+			auto texture = entry->texture.lock();
+			size_t level = texture->get_resident_level() - 1;
+			TextureLevel desc = texture->get_stream_level(level);
+			if (!make_room(desc.size, texture.get()))
+			{
+				continue;
+			}
+
+			std::string path = texture->get_stream_file();
+			TextureCacheInfo info = texture->get_stream_info();
+			LevelLoad load;
+			load.key = entry->key;
+			load.texture = texture;
+			load.level = level;
+			load.size = desc.size;
+			load.data = std::async(std::launch::async, [path, info, level, desc]()
+			{
+				std::unique_ptr<uint8_t[]> data(new uint8_t[desc.size]);
+				if (!TextureCache::read_level(path, info, level, desc, data.get()))
+				{
+					return std::unique_ptr<uint8_t[]>();
+				}
+				return data;
+			});
+			loading_bytes += desc.size;
+			entry->loading = true;
+			loads.emplace_back(std::move(load));
+		}
+	}
+}
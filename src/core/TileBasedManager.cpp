@@ -102,12 +102,12 @@ namespace CpuRasterizer
 
 	void TileBasedManager::push_draw_task(const Triangle& tri, const GraphicsContext& ctx)
 	{
-		auto bounds = tri.get_bounds();
-		int padding = kBoundsPadding;
-		int row_start = bounds.min().y - padding;
-		int row_end = bounds.max().y + padding;
-		int col_start = bounds.min().x - padding;
-		int col_end = bounds.max().x + padding;
+		// raster bounds come from the snapped triangle, max is exclusive
+		const auto& bounds = tri.raster_bounds;
+		int row_start = bounds.min_y;
+		int row_end = bounds.max_y - 1;
+		int col_start = bounds.min_x;
+		int col_end = bounds.max_x - 1;
 
 		int w = (int)width;
 		int h = (int)height;
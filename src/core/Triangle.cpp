@@ -1,5 +1,7 @@
 #include "Triangle.hpp"
 #include <assert.h>
+#include <cmath>
+#include "Define.hpp"
 #include "Pipeline.hpp"
 
 namespace CpuRasterizer
@@ -7,12 +9,16 @@ namespace CpuRasterizer
 	Triangle::Triangle()
 	{
 		culled = false;
+		fixed_area = 0;
+		micro = false;
 		flip = false;
 	}
 
 	Triangle::Triangle(const Vertex verts[3])
 	{
 		culled = false;
+		fixed_area = 0;
+		micro = false;
 		flip = false;
 		for (int i = 0; i < 3; i++)
 		{
@@ -23,6 +29,8 @@ namespace CpuRasterizer
 	Triangle::Triangle(const Vertex& v1, const Vertex& v2, const Vertex& v3)
 	{
 		culled = false;
+		fixed_area = 0;
+		micro = false;
 		flip = false;
 		vertices[0] = v1;
 		vertices[1] = v2;
@@ -32,6 +40,8 @@ namespace CpuRasterizer
 	Triangle::Triangle(const Vertex& v1, const Vertex& v2, const Vertex& v3, const bool& flip)
 	{
 		culled = false;
+		fixed_area = 0;
+		micro = false;
 		vertices[0] = v1;
 		vertices[1] = v2;
 		vertices[2] = v3;
@@ -232,6 +242,129 @@ namespace CpuRasterizer
 		}
 	}
 
+	// snaps vertices to sub-pixel fixed point and builds the edge functions.
+	// vertices are reordered so that the snapped area is positive, returns false for degenerate triangles.
+	// without multisampling the bounds only include pixels whose center lies inside the snapped bounding box,
+	// so they are empty for triangles that can not produce any fragment
+	bool Triangle::setup_edges(bool multisample)
+	{
+		tinymath::vec2i p0 = snap(vertices[0].position.xy);
+		tinymath::vec2i p1 = snap(vertices[1].position.xy);
+		tinymath::vec2i p2 = snap(vertices[2].position.xy);
+
+		fixed_area = (int64_t)(p1.x - p0.x) * (int64_t)(p2.y - p0.y) - (int64_t)(p1.y - p0.y) * (int64_t)(p2.x - p0.x);
+
+		if (fixed_area == 0)
+		{
+			return false;
+		}
+
+		if (fixed_area < 0)
+		{
+			std::swap(vertices[1], vertices[2]);
+			std::swap(p1, p2);
+			fixed_area = -fixed_area;
+		}
+
+		edges[0].setup(p1, p2);
+		edges[1].setup(p2, p0);
+		edges[2].setup(p0, p1);
+
+		int min_x = tinymath::min(p0.x, tinymath::min(p1.x, p2.x));
+		int min_y = tinymath::min(p0.y, tinymath::min(p1.y, p2.y));
+		int max_x = tinymath::max(p0.x, tinymath::max(p1.x, p2.x));
+		int max_y = tinymath::max(p0.y, tinymath::max(p1.y, p2.y));
+
+		if (multisample)
+		{
+			// any sample inside pixel (row, col) lies in [col, col + 1) * kSubpixelStep
+			raster_bounds.min_x = min_x >> kSubpixelBits;
+			raster_bounds.min_y = min_y >> kSubpixelBits;
+			raster_bounds.max_x = (max_x >> kSubpixelBits) + 1;
+			raster_bounds.max_y = (max_y >> kSubpixelBits) + 1;
+		}
+		else
+		{
+			// pixel centers lie at col * kSubpixelStep + kSubpixelStep / 2
+			constexpr int half = kSubpixelStep / 2;
+			raster_bounds.min_x = (min_x - half + kSubpixelStep - 1) >> kSubpixelBits;
+			raster_bounds.min_y = (min_y - half + kSubpixelStep - 1) >> kSubpixelBits;
+			raster_bounds.max_x = ((max_x - half) >> kSubpixelBits) + 1;
+			raster_bounds.max_y = ((max_y - half) >> kSubpixelBits) + 1;
+		}
+
+		// count the 2x2 blocks touched by the bounds
+		int block_cols = ((raster_bounds.max_x + 1) >> 1) - (raster_bounds.min_x >> 1);
+		int block_rows = ((raster_bounds.max_y + 1) >> 1) - (raster_bounds.min_y >> 1);
+		micro = !raster_bounds.empty() && block_cols * block_rows <= 2;
+
+		return true;
+	}
+
+	// coverage test against the snapped edge functions, a sample on a shared edge is owned by exactly one triangle
+	bool Triangle::edge_interpolate(const tinymath::vec2f& pos, Vertex& interpolated_vert) const
+	{
+		tinymath::vec2i p = snap(pos);
+
+		int64_t e0 = edges[0].evaluate(p.x, p.y);
+		int64_t e1 = edges[1].evaluate(p.x, p.y);
+		int64_t e2 = edges[2].evaluate(p.x, p.y);
+
+		float inv_area = 1.0f / (float)fixed_area;
+		float w0 = (float)e0 * inv_area;
+		float w1 = (float)e1 * inv_area;
+		float w2 = (float)e2 * inv_area;
+
+		interpolated_vert = Pipeline::barycentric_interpolate(vertices[0], vertices[1], vertices[2], w0, w1, w2);
+
+		return (e0 + edges[0].bias) >= 0 && (e1 + edges[1].bias) >= 0 && (e2 + edges[2].bias) >= 0;
+	}
+
+	// bit i is set when sample i of pixel (row, col) is covered, sample offsets are in sub-pixel units from the pixel corner.
+	// screen depth is linear in screen space, so it comes straight from the edge values
+	uint32_t Triangle::coverage_mask(size_t row, size_t col, const tinymath::vec2i* sample_offsets, uint8_t sample_count, float* sample_depths) const
+	{
+		int64_t px = (int64_t)col << kSubpixelBits;
+		int64_t py = (int64_t)row << kSubpixelBits;
+		float inv_area = 1.0f / (float)fixed_area;
+		uint32_t mask = 0;
+
+		for (uint8_t idx = 0; idx < sample_count; ++idx)
+		{
+			int64_t x = px + sample_offsets[idx].x;
+			int64_t y = py + sample_offsets[idx].y;
+
+			int64_t e0 = edges[0].evaluate(x, y);
+			int64_t e1 = edges[1].evaluate(x, y);
+			int64_t e2 = edges[2].evaluate(x, y);
+
+			if ((e0 + edges[0].bias) >= 0 && (e1 + edges[1].bias) >= 0 && (e2 + edges[2].bias) >= 0)
+			{
+				mask |= 1u << idx;
+				sample_depths[idx] = ((float)e0 * vertices[0].position.z + (float)e1 * vertices[1].position.z + (float)e2 * vertices[2].position.z) * inv_area;
+			}
+		}
+
+		return mask;
+	}
+
+	tinymath::vec2i Triangle::snap(const tinymath::vec2f& pos)
+	{
+		return tinymath::vec2i((int)std::floor(pos.x * (float)kSubpixelStep + 0.5f), (int)std::floor(pos.y * (float)kSubpixelStep + 0.5f));
+	}
+
+	void EdgeFunction::setup(const tinymath::vec2i& v0, const tinymath::vec2i& v1)
+	{
+		a = (int64_t)v0.y - (int64_t)v1.y;
+		b = (int64_t)v1.x - (int64_t)v0.x;
+		c = -(a * v0.x + b * v0.y);
+
+		// screen y points down, interior is on the positive side.
+		// top edge: horizontal with the interior below, left edge: interior to its right
+		bool top_left = a > 0 || (a == 0 && b > 0);
+		bias = top_left ? 0 : -1;
+	}
+
 	float Triangle::area_double(const tinymath::vec2f& v1, const tinymath::vec2f& v2, const tinymath::vec2f& v3)
 	{
 		return (v3.x - v1.x) * (v2.y - v1.y) - (v3.y - v1.y) * (v2.x - v1.x);
@@ -0,0 +1,388 @@
+#include "VertexBuffer.hpp"
+#include <cstring>
+#include <cmath>
+
+namespace CpuRasterizer
+{
+	static uint16_t float_to_half(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		uint32_t sign = (bits >> 16) & 0x8000u;
+		int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 127 + 15;
+		uint32_t mantissa = bits & 0x7fffffu;
+
+		if (((bits >> 23) & 0xff) == 0xff)
+		{
+			return (uint16_t)(sign | 0x7c00u | (mantissa != 0 ? 0x200u : 0u));
+		}
+		if (exponent >= 31)
+		{
+			return (uint16_t)(sign | 0x7c00u);
+		}
+		if (exponent <= 0)
+		{
+			// denormal, or zero below the smallest one
+			if (exponent < -10)
+			{
+				return (uint16_t)sign;
+			}
+			mantissa |= 0x800000u;
+			uint32_t shift = (uint32_t)(14 - exponent);
+			uint32_t half_mantissa = mantissa >> shift;
+			uint32_t round = (mantissa >> (shift - 1)) & 1u;
+			return (uint16_t)(sign | (half_mantissa + round));
+		}
+
+		// round to nearest, a carry into the exponent is still the right value
+		uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+		return (uint16_t)(half + ((mantissa >> 12) & 1u));
+	}
+
+	static float half_to_float(uint16_t value)
+	{
+		uint32_t sign = (uint32_t)(value & 0x8000u) << 16;
+		uint32_t exponent = (value >> 10) & 0x1fu;
+		uint32_t mantissa = value & 0x3ffu;
+		uint32_t bits;
+
+		if (exponent == 0)
+		{
+			if (mantissa == 0)
+			{
+				bits = sign;
+			}
+			else
+			{
+				// renormalize the denormal
+				exponent = 127 - 15 + 1;
+				while ((mantissa & 0x400u) == 0)
+				{
+					mantissa <<= 1;
+					exponent--;
+				}
+				bits = sign | (exponent << 23) | ((mantissa & 0x3ffu) << 13);
+			}
+		}
+		else if (exponent == 31)
+		{
+			bits = sign | 0x7f800000u | (mantissa << 13);
+		}
+		else
+		{
+			bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+		}
+
+		float ret;
+		memcpy(&ret, &bits, sizeof(ret));
+		return ret;
+	}
+
+	static int16_t float_to_snorm16(float value)
+	{
+		return (int16_t)std::round(tinymath::clamp(value, -1.0f, 1.0f) * 32767.0f);
+	}
+
+	static float snorm16_to_float(int16_t value)
+	{
+		return tinymath::max((float)value / 32767.0f, -1.0f);
+	}
+
+	static uint16_t float_to_unorm16(float value)
+	{
+		return (uint16_t)std::round(tinymath::clamp(value, 0.0f, 1.0f) * 65535.0f);
+	}
+
+	static uint8_t float_to_unorm8(float value)
+	{
+		return (uint8_t)std::round(tinymath::clamp(value, 0.0f, 1.0f) * 255.0f);
+	}
+
+	// zero vectors come back as +z
+	static void encode_octahedral(const tinymath::vec3f& v, int16_t* dst)
+	{
+		float l1 = tinymath::abs(v.x) + tinymath::abs(v.y) + tinymath::abs(v.z);
+		float x = l1 > 0.0f ? v.x / l1 : 0.0f;
+		float y = l1 > 0.0f ? v.y / l1 : 0.0f;
+		if (v.z < 0.0f)
+		{
+			float fx = (1.0f - tinymath::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			float fy = (1.0f - tinymath::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x = fx;
+			y = fy;
+		}
+		dst[0] = float_to_snorm16(x);
+		dst[1] = float_to_snorm16(y);
+	}
+
+	static tinymath::vec3f decode_octahedral(const int16_t* src)
+	{
+		float x = snorm16_to_float(src[0]);
+		float y = snorm16_to_float(src[1]);
+		float z = 1.0f - tinymath::abs(x) - tinymath::abs(y);
+		if (z < 0.0f)
+		{
+			float fx = (1.0f - tinymath::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			float fy = (1.0f - tinymath::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x = fx;
+			y = fy;
+		}
+		return tinymath::normalize(tinymath::vec3f(x, y, z));
+	}
+
+	static void encode_attribute(VertexFormat format, const tinymath::vec4f& value, uint8_t* dst)
+	{
+		switch (format)
+		{
+		case VertexFormat::kFloat2:
+		case VertexFormat::kFloat3:
+		case VertexFormat::kFloat4:
+		{
+			const float components[4] = { value.x, value.y, value.z, value.w };
+			memcpy(dst, components, VertexLayout::format_size(format));
+			break;
+		}
+		case VertexFormat::kHalf2:
+		case VertexFormat::kHalf4:
+		{
+			const uint16_t components[4] = { float_to_half(value.x), float_to_half(value.y), float_to_half(value.z), float_to_half(value.w) };
+			memcpy(dst, components, VertexLayout::format_size(format));
+			break;
+		}
+		case VertexFormat::kSnorm16x4:
+		{
+			const int16_t components[4] = { float_to_snorm16(value.x), float_to_snorm16(value.y), float_to_snorm16(value.z), float_to_snorm16(value.w) };
+			memcpy(dst, components, sizeof(components));
+			break;
+		}
+		case VertexFormat::kUnorm16x2:
+		{
+			const uint16_t components[2] = { float_to_unorm16(value.x), float_to_unorm16(value.y) };
+			memcpy(dst, components, sizeof(components));
+			break;
+		}
+		case VertexFormat::kUnorm8x4:
+		{
+			const uint8_t components[4] = { float_to_unorm8(value.x), float_to_unorm8(value.y), float_to_unorm8(value.z), float_to_unorm8(value.w) };
+			memcpy(dst, components, sizeof(components));
+			break;
+		}
+		case VertexFormat::kOctahedral16:
+		{
+			int16_t components[2];
+			encode_octahedral(value.xyz, components);
+			memcpy(dst, components, sizeof(components));
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	static tinymath::vec4f decode_attribute(VertexFormat format, const uint8_t* src)
+	{
+		switch (format)
+		{
+		case VertexFormat::kFloat2:
+		case VertexFormat::kFloat3:
+		case VertexFormat::kFloat4:
+		{
+			float components[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+			memcpy(components, src, VertexLayout::format_size(format));
+			return tinymath::vec4f(components[0], components[1], components[2], components[3]);
+		}
+		case VertexFormat::kHalf2:
+		case VertexFormat::kHalf4:
+		{
+			uint16_t components[4] = { 0, 0, 0, 0x3c00u };
+			memcpy(components, src, VertexLayout::format_size(format));
+			return tinymath::vec4f(half_to_float(components[0]), half_to_float(components[1]), half_to_float(components[2]), half_to_float(components[3]));
+		}
+		case VertexFormat::kSnorm16x4:
+		{
+			int16_t components[4];
+			memcpy(components, src, sizeof(components));
+			return tinymath::vec4f(snorm16_to_float(components[0]), snorm16_to_float(components[1]), snorm16_to_float(components[2]), snorm16_to_float(components[3]));
+		}
+		case VertexFormat::kUnorm16x2:
+		{
+			uint16_t components[2];
+			memcpy(components, src, sizeof(components));
+			return tinymath::vec4f((float)components[0] / 65535.0f, (float)components[1] / 65535.0f, 0.0f, 1.0f);
+		}
+		case VertexFormat::kUnorm8x4:
+		{
+			uint8_t components[4];
+			memcpy(components, src, sizeof(components));
+			return tinymath::vec4f((float)components[0] / 255.0f, (float)components[1] / 255.0f, (float)components[2] / 255.0f, (float)components[3] / 255.0f);
+		}
+		case VertexFormat::kOctahedral16:
+		{
+			int16_t components[2];
+			memcpy(components, src, sizeof(components));
+			tinymath::vec3f v = decode_octahedral(components);
+			return tinymath::vec4f(v.x, v.y, v.z, 0.0f);
+		}
+		default:
+			return tinymath::kVec4fZero;
+		}
+	}
+
+	VertexLayout::VertexLayout() : VertexLayout(VertexFormat::kFloat3, VertexFormat::kOctahedral16, VertexFormat::kFloat2, VertexFormat::kOctahedral16, VertexFormat::kHalf4)
+	{}
+
+	VertexLayout::VertexLayout(VertexFormat position, VertexFormat normal, VertexFormat uv, VertexFormat tangent, VertexFormat color)
+	{
+		formats[(size_t)VertexAttribute::kPosition] = position;
+		formats[(size_t)VertexAttribute::kNormal] = normal;
+		formats[(size_t)VertexAttribute::kUV] = uv;
+		formats[(size_t)VertexAttribute::kTangent] = tangent;
+		formats[(size_t)VertexAttribute::kColor] = color;
+
+		stride = 0;
+		for (size_t idx = 0; idx < kVertexAttributeCount; ++idx)
+		{
+			offsets[idx] = stride;
+			stride += (uint32_t)format_size(formats[idx]);
+		}
+	}
+
+	size_t VertexLayout::format_size(VertexFormat format)
+	{
+		switch (format)
+		{
+		case VertexFormat::kFloat2: return 8;
+		case VertexFormat::kFloat3: return 12;
+		case VertexFormat::kFloat4: return 16;
+		case VertexFormat::kHalf2: return 4;
+		case VertexFormat::kHalf4: return 8;
+		case VertexFormat::kSnorm16x4: return 8;
+		case VertexFormat::kUnorm16x2: return 4;
+		case VertexFormat::kUnorm8x4: return 4;
+		case VertexFormat::kOctahedral16: return 4;
+		default: return 0;
+		}
+	}
+
+	VertexLayout VertexLayout::full()
+	{
+		return VertexLayout(VertexFormat::kFloat3, VertexFormat::kFloat3, VertexFormat::kFloat2, VertexFormat::kFloat3, VertexFormat::kFloat4);
+	}
+
+	VertexLayout VertexLayout::standard()
+	{
+		return VertexLayout();
+	}
+
+	VertexLayout VertexLayout::compact()
+	{
+		return VertexLayout(VertexFormat::kFloat3, VertexFormat::kOctahedral16, VertexFormat::kUnorm16x2, VertexFormat::kOctahedral16, VertexFormat::kUnorm8x4);
+	}
+
+	void VertexLayout::encode(const Vertex& vertex, uint8_t* dst) const
+	{
+		encode_attribute(formats[(size_t)VertexAttribute::kPosition], vertex.position, dst + offsets[(size_t)VertexAttribute::kPosition]);
+		encode_attribute(formats[(size_t)VertexAttribute::kNormal], tinymath::vec4f(vertex.normal.x, vertex.normal.y, vertex.normal.z, 0.0f), dst + offsets[(size_t)VertexAttribute::kNormal]);
+		encode_attribute(formats[(size_t)VertexAttribute::kUV], tinymath::vec4f(vertex.uv.x, vertex.uv.y, 0.0f, 0.0f), dst + offsets[(size_t)VertexAttribute::kUV]);
+		encode_attribute(formats[(size_t)VertexAttribute::kTangent], tinymath::vec4f(vertex.tangent.x, vertex.tangent.y, vertex.tangent.z, 0.0f), dst + offsets[(size_t)VertexAttribute::kTangent]);
+		encode_attribute(formats[(size_t)VertexAttribute::kColor], vertex.color, dst + offsets[(size_t)VertexAttribute::kColor]);
+	}
+
+	void VertexLayout::decode(const uint8_t* src, Vertex& vertex) const
+	{
+		tinymath::vec4f position = decode_attribute(formats[(size_t)VertexAttribute::kPosition], src + offsets[(size_t)VertexAttribute::kPosition]);
+		vertex.position = tinymath::vec4f(position.x, position.y, position.z, 1.0f);
+		vertex.world_pos = position.xyz;
+		vertex.normal = decode_attribute(formats[(size_t)VertexAttribute::kNormal], src + offsets[(size_t)VertexAttribute::kNormal]).xyz;
+		vertex.uv = decode_attribute(formats[(size_t)VertexAttribute::kUV], src + offsets[(size_t)VertexAttribute::kUV]).xy;
+		vertex.tangent = decode_attribute(formats[(size_t)VertexAttribute::kTangent], src + offsets[(size_t)VertexAttribute::kTangent]).xyz;
+		vertex.color = decode_attribute(formats[(size_t)VertexAttribute::kColor], src + offsets[(size_t)VertexAttribute::kColor]);
+	}
+
+	tinymath::vec3f VertexLayout::decode_position(const uint8_t* src) const
+	{
+		VertexFormat format = formats[(size_t)VertexAttribute::kPosition];
+		if (format == VertexFormat::kFloat3 || format == VertexFormat::kFloat4)
+		{
+			float components[3];
+			memcpy(components, src + offsets[(size_t)VertexAttribute::kPosition], sizeof(components));
+			return tinymath::vec3f(components[0], components[1], components[2]);
+		}
+		return decode_attribute(format, src + offsets[(size_t)VertexAttribute::kPosition]).xyz;
+	}
+
+	VertexBuffer::VertexBuffer() : data(nullptr), count(0)
+	{}
+
+	VertexBuffer::VertexBuffer(const std::vector<Vertex>& vertices, const VertexLayout& _layout) : layout(_layout), count(vertices.size())
+	{
+		auto packed = std::make_shared<std::vector<uint8_t>>(vertices.size() * layout.stride);
+		for (size_t idx = 0; idx < vertices.size(); ++idx)
+		{
+			layout.encode(vertices[idx], packed->data() + idx * layout.stride);
+		}
+		data = packed->data();
+		storage = packed;
+	}
+
+	VertexBuffer::VertexBuffer(const VertexLayout& _layout, const uint8_t* _data, size_t _count, std::shared_ptr<const void> _storage) :
+		layout(_layout), data(_data), count(_count), storage(_storage)
+	{}
+
+	Vertex VertexBuffer::operator[](size_t index) const
+	{
+		Vertex ret;
+		layout.decode(data + index * layout.stride, ret);
+		return ret;
+	}
+
+	std::vector<Vertex> VertexBuffer::decode() const
+	{
+		std::vector<Vertex> ret(count);
+		for (size_t idx = 0; idx < count; ++idx)
+		{
+			layout.decode(data + idx * layout.stride, ret[idx]);
+		}
+		return ret;
+	}
+
+	IndexBuffer::IndexBuffer() : format(IndexFormat::kUInt16), data(nullptr), count(0)
+	{}
+
+	IndexBuffer::IndexBuffer(const std::vector<size_t>& indices) : count(indices.size())
+	{
+		size_t max_index = 0;
+		for (size_t index : indices)
+		{
+			max_index = tinymath::max(max_index, index);
+		}
+
+		format = max_index <= UINT16_MAX ? IndexFormat::kUInt16 : IndexFormat::kUInt32;
+		if (format == IndexFormat::kUInt16)
+		{
+			auto packed = std::make_shared<std::vector<uint16_t>>(indices.begin(), indices.end());
+			data = packed->data();
+			storage = packed;
+		}
+		else
+		{
+			auto packed = std::make_shared<std::vector<uint32_t>>(indices.begin(), indices.end());
+			data = packed->data();
+			storage = packed;
+		}
+	}
+
+	IndexBuffer::IndexBuffer(IndexFormat _format, const void* _data, size_t _count, std::shared_ptr<const void> _storage) :
+		format(_format), data(_data), count(_count), storage(_storage)
+	{}
+
+	std::vector<size_t> IndexBuffer::decode() const
+	{
+		std::vector<size_t> ret(count);
+		for (size_t idx = 0; idx < count; ++idx)
+		{
+			ret[idx] = (*this)[idx];
+		}
+		return ret;
+	}
+}
@@ -13,6 +13,9 @@
 #include "Serialization.hpp"
 #include "Time.hpp"
 #include "CGL.h"
+#include "GraphicsDevice.hpp"
+#include "TextureStreamer.hpp"
+#include "AssetLoader.hpp"
 
 #undef near
 #undef far
@@ -54,6 +57,9 @@ namespace CpuRasterizer
 					transform_inspector.on_gui(*model->transform);
 				}
 
+				ImGui::Checkbox("Occluder", &model->occluder);
+				ImGui::Text("LOD Count: %zu", model->lod_count());
+
 				if (model->material != nullptr)
 				{
 					material_inspector.on_gui(*model->material);
@@ -77,6 +83,12 @@ namespace CpuRasterizer
 				rt_size[1] = (int)height;
 			}
 			ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+
+			static bool tiled_framebuffer = false;
+			if (ImGui::Checkbox("Tiled FrameBuffer", &tiled_framebuffer))
+			{
+				cglSetFrameBufferLayout(tiled_framebuffer ? cglMemoryLayout::kTiled : cglMemoryLayout::kLinear);
+			}
 		}
 
 		Scene& scene = *Scene::current();
@@ -114,6 +126,46 @@ namespace CpuRasterizer
 				}
 			}
 
+			static bool enable_post_aa = false;
+			if (ImGui::Checkbox("FXAA", &enable_post_aa))
+			{
+				if (enable_post_aa)
+				{
+					cglEnable(cglPipelineFeature::kPostAA);
+				}
+				else
+				{
+					cglDisable(cglPipelineFeature::kPostAA);
+				}
+			}
+
+			ImGui::Checkbox("OIT", &CpuRasterSharedData.enable_oit);
+			if (CpuRasterSharedData.enable_oit)
+			{
+				static int oit_pool_size = (int)kDefaultOITPoolSize;
+				if (ImGui::InputInt("OIT Pool Size", &oit_pool_size))
+				{
+					oit_pool_size = tinymath::max(oit_pool_size, 0);
+					cglSetOITPoolSize((size_t)oit_pool_size);
+				}
+
+				size_t oit_fragments, oit_overflows;
+				cglGetOITStatistics(oit_fragments, oit_overflows);
+				ImGui::Text("OIT Fragments: %zu, Early Flushes: %zu", oit_fragments, oit_overflows);
+			}
+
+			ImGui::Checkbox("Occlusion Culling", &CpuRasterSharedData.enable_occlusion_culling);
+			if (CpuRasterSharedData.enable_occlusion_culling)
+			{
+				ImGui::Text("Occluded Renderers: %zu", CpuRasterDevice.statistics.occluded_renderer_count);
+			}
+
+			int shadow_lod_bias = (int)CpuRasterSharedData.shadow_lod_bias;
+			if (ImGui::SliderInt("Shadow LOD Bias", &shadow_lod_bias, 0, (int)kMaxLODCount - 1))
+			{
+				CpuRasterSharedData.shadow_lod_bias = (size_t)shadow_lod_bias;
+			}
+
 			if (enable_msaa)
 			{
 				const char* frequencies[] = {
@@ -218,6 +270,22 @@ namespace CpuRasterizer
 
 			ImGui::Checkbox("Mipmap", &CpuRasterSharedData.enable_mipmap);
 
+			// only textures loaded afterwards pick up the layout
+			bool tiled_textures = CpuRasterSharedData.texture_layout == MemoryLayout::kTiled;
+			if (ImGui::Checkbox("Tiled Textures", &tiled_textures))
+			{
+				CpuRasterSharedData.texture_layout = tiled_textures ? MemoryLayout::kTiled : MemoryLayout::kLinear;
+			}
+			ImGui::Checkbox("Compressed Textures", &CpuRasterSharedData.texture_compression);
+			ImGui::Checkbox("Texture Streaming", &CpuRasterSharedData.texture_streaming);
+			int streaming_budget = (int)(CpuRasterSharedData.texture_streaming_budget >> 20);
+			if (ImGui::SliderInt("Streaming Budget (MB)", &streaming_budget, 16, 2048))
+			{
+				CpuRasterSharedData.texture_streaming_budget = (size_t)streaming_budget << 20;
+			}
+			ImGui::Text("Loading Assets: %zu", CpuRasterAssetLoader.get_pending_count());
+			ImGui::Text("Streamed Textures: %zu, %.1f MB", CpuRasterTextureStreamer.get_texture_count(), (double)CpuRasterTextureStreamer.get_resident_bytes() / (1024.0 * 1024.0));
+
 			const char* debug_views[] = {
 				"None",
 				"WireFrame",
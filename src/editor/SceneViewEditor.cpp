@@ -1,6 +1,11 @@
 #include "SceneViewEditor.hpp"
 #include "imgui/imgui.h"
 #include "Window.hpp"
+#include "Scene.hpp"
+#include "Camera.hpp"
+#include "Renderer.hpp"
+#include "Model.hpp"
+#include "Transform.hpp"
 
 namespace CpuRasterizer
 {
@@ -31,9 +36,28 @@ namespace CpuRasterizer
 #pragma warning(disable : 4312)
 				ImGui::Image((ImTextureID)Window::main()->get_fbo(), ImVec2((float)this->rect.w(), (float)this->rect.h()), ImVec2(0, 1), ImVec2(1, 0));
 #pragma warning(pop)
+				if (ImGui::IsItemClicked(ImGuiMouseButton_Left))
+				{
+					pick(ImGui::GetMousePos(), ImGui::GetItemRectMin(), ImGui::GetItemRectSize());
+				}
 				ImGui::EndTabItem();
 			}
 			ImGui::EndTabBar();
 		}
 	}
+
+	// selects the renderer under the cursor, the image shows the frame with its origin at the bottom left
+	void SceneViewEditor::pick(const ImVec2& mouse, const ImVec2& image_min, const ImVec2& image_size)
+	{
+		Scene* scene = Scene::current();
+		if (scene == nullptr || scene->main_cam == nullptr || image_size.x <= 0.0f || image_size.y <= 0.0f)
+		{
+			return;
+		}
+
+		tinymath::vec2f viewport_pos((mouse.x - image_min.x) / image_size.x, 1.0f - (mouse.y - image_min.y) / image_size.y);
+		float distance;
+		Renderer* hit = scene->pick(scene->main_cam->viewport_point_to_ray(viewport_pos), distance);
+		scene->selection = hit != nullptr ? hit->target->transform.get() : nullptr;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "AssetLoader.hpp"
+#include "Texture.hpp"
+#include "CubeMap.hpp"
+#include "Model.hpp"
+#include "Material.hpp"
+#include "Serialization.hpp"
+
+namespace CpuRasterizer
+{
+	AssetLoader::AssetLoader() : AssetLoader((size_t)std::thread::hardware_concurrency())
+	{}
+
+	AssetLoader::AssetLoader(size_t worker_count) : stopping(false)
+	{
+		size_t count = tinymath::max(worker_count, (size_t)1);
+		for (size_t idx = 0; idx < count; idx++)
+		{
+			workers.emplace_back([this]() { work(); });
+		}
+	}
+
+	AssetLoader::~AssetLoader()
+	{
+		{
+			std::lock_guard<std::mutex> lock(task_mutex);
+			stopping = true;
+		}
+		task_ready.notify_all();
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	template<typename R>
+	std::future<R> AssetLoader::submit(std::function<R()> task)
+	{
+		// std::function needs a copyable target
+		auto packaged = std::make_shared<std::packaged_task<R()>>(std::move(task));
+		std::future<R> ret = packaged->get_future();
+		{
+			std::lock_guard<std::mutex> lock(task_mutex);
+			tasks.emplace_back([packaged]() { (*packaged)(); });
+		}
+		task_ready.notify_one();
+		return ret;
+	}
+
+	void AssetLoader::work()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(task_mutex);
+				task_ready.wait(lock, [this]() { return stopping || !tasks.empty(); });
+				if (stopping)
+				{
+					return;
+				}
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			task();
+		}
+	}
+
+	AssetHandle<Model> AssetLoader::load_model(const std::string& path)
+	{
+		auto load = std::make_shared<ModelLoad>();
+		AssetHandle<Model> handle = load->model.get_future().share();
+
+		// imports of the same raw model are serialized on its cache file by Model::load_raw
+		std::lock_guard<std::mutex> lock(request_mutex);
+		load->result = submit<ModelResult>([this, path]()
+		{
+			ModelResult ret;
+			std::vector<std::pair<property_name, std::string>> textures;
+			ret.model = std::make_shared<Model>();
+			Serializer::deserialize(path, *ret.model, &textures);
+			if (ret.model->material == nullptr)
+			{
+				// the meta couldn't be read, deserialize already logged it
+				ret.model = nullptr;
+				return ret;
+			}
+			for (auto& texture : textures)
+			{
+				ret.textures.emplace_back(texture.first, load_texture(texture.second));
+			}
+			return ret;
+		}).share();
+		model_loads.emplace_back(load);
+		return handle;
+	}
+
+	AssetHandle<Texture> AssetLoader::load_texture(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(request_mutex);
+		auto it = texture_loads.find(path);
+		if (it != texture_loads.end())
+		{
+			return it->second;
+		}
+
+		AssetHandle<Texture> handle = submit<std::shared_ptr<Texture>>([path]() { return Texture::load_asset(path); }).share();
+		texture_loads[path] = handle;
+		return handle;
+	}
+
+	AssetHandle<CubeMap> AssetLoader::load_cubemap(const std::string& path)
+	{
+		return submit<std::shared_ptr<CubeMap>>([path]() { return CubeMap::load_asset(path); }).share();
+	}
+
+	void AssetLoader::update()
+	{
+		std::lock_guard<std::mutex> lock(request_mutex);
+		for (auto it = model_loads.begin(); it != model_loads.end();)
+		{
+			if ((*it)->result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				++it;
+				continue;
+			}
+
+			const ModelResult& result = (*it)->result.get();
+			if (result.model == nullptr)
+			{
+				(*it)->model.set_value(nullptr);
+				it = model_loads.erase(it);
+				continue;
+			}
+
+			// creates the shader programs, which only the main thread may do
+			result.model->material->initialize();
+			for (auto& texture : result.textures)
+			{
+				bindings.push_back({ result.model->material, texture.first, texture.second });
+			}
+			(*it)->model.set_value(result.model);
+			it = model_loads.erase(it);
+		}
+
+		for (auto it = bindings.begin(); it != bindings.end();)
+		{
+			if (!is_ready(it->texture))
+			{
+				++it;
+				continue;
+			}
+
+			auto material = it->material.lock();
+			if (material != nullptr)
+			{
+				material->local_properties.set_texture(it->name, it->texture.get());
+			}
+			it = bindings.erase(it);
+		}
+
+		// later requests of a loaded texture are served by the texture cache
+		for (auto it = texture_loads.begin(); it != texture_loads.end();)
+		{
+			it = is_ready(it->second) ? texture_loads.erase(it) : std::next(it);
+		}
+	}
+
+	size_t AssetLoader::get_pending_count()
+	{
+		std::lock_guard<std::mutex> lock(request_mutex);
+		return model_loads.size() + texture_loads.size();
+	}
+}
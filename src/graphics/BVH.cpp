@@ -0,0 +1,447 @@
+#include "BVH.hpp"
+#include <assert.h>
+#include "Renderer.hpp"
+
+namespace CpuRasterizer
+{
+	constexpr float kFatMargin = 0.1f; // absolute part of the leaf margin
+	constexpr float kFatMarginScale = 0.1f; // part of the margin relative to the box extents
+
+	static tinymath::vec3f min3(const tinymath::vec3f& lhs, const tinymath::vec3f& rhs)
+	{
+		return tinymath::vec3f(tinymath::min(lhs.x, rhs.x), tinymath::min(lhs.y, rhs.y), tinymath::min(lhs.z, rhs.z));
+	}
+
+	static tinymath::vec3f max3(const tinymath::vec3f& lhs, const tinymath::vec3f& rhs)
+	{
+		return tinymath::vec3f(tinymath::max(lhs.x, rhs.x), tinymath::max(lhs.y, rhs.y), tinymath::max(lhs.z, rhs.z));
+	}
+
+	static float surface(const tinymath::vec3f& min, const tinymath::vec3f& max)
+	{
+		tinymath::vec3f d = max - min;
+		return 2.0f * (d.x * d.y + d.x * d.z + d.y * d.z);
+	}
+
+	static bool overlap(const tinymath::vec3f& min_a, const tinymath::vec3f& max_a, const tinymath::vec3f& min_b, const tinymath::vec3f& max_b)
+	{
+		return min_a.x <= max_b.x && max_a.x >= min_b.x &&
+			   min_a.y <= max_b.y && max_a.y >= min_b.y &&
+			   min_a.z <= max_b.z && max_a.z >= min_b.z;
+	}
+
+	BVH::BVH() : root(kNullProxy), free_list(kNullProxy), leaf_count(0)
+	{}
+
+	int32_t BVH::allocate_node()
+	{
+		int32_t node;
+		if (free_list != kNullProxy)
+		{
+			node = free_list;
+			free_list = nodes[node].parent;
+		}
+		else
+		{
+			node = (int32_t)nodes.size();
+			nodes.emplace_back();
+		}
+
+		nodes[node].parent = kNullProxy;
+		nodes[node].left = kNullProxy;
+		nodes[node].right = kNullProxy;
+		nodes[node].height = 0;
+		nodes[node].renderer = nullptr;
+		return node;
+	}
+
+	void BVH::free_node(int32_t node)
+	{
+		nodes[node].parent = free_list;
+		nodes[node].height = -1;
+		free_list = node;
+	}
+
+	void BVH::clear()
+	{
+		nodes.clear();
+		root = kNullProxy;
+		free_list = kNullProxy;
+		leaf_count = 0;
+	}
+
+	int32_t BVH::insert(Renderer* renderer, const tinymath::AxisAlignedBoundingBox& bounds)
+	{
+		int32_t leaf = allocate_node();
+		tinymath::vec3f margin = bounds.extents * kFatMarginScale + tinymath::vec3f(kFatMargin, kFatMargin, kFatMargin);
+		nodes[leaf].min = bounds.min() - margin;
+		nodes[leaf].max = bounds.max() + margin;
+		nodes[leaf].renderer = renderer;
+		insert_leaf(leaf);
+		leaf_count++;
+		return leaf;
+	}
+
+	void BVH::remove(int32_t proxy)
+	{
+		assert(proxy >= 0 && proxy < (int32_t)nodes.size() && nodes[proxy].is_leaf());
+		remove_leaf(proxy);
+		free_node(proxy);
+		leaf_count--;
+	}
+
+	bool BVH::move(int32_t proxy, const tinymath::AxisAlignedBoundingBox& bounds)
+	{
+		assert(proxy >= 0 && proxy < (int32_t)nodes.size() && nodes[proxy].is_leaf());
+		tinymath::vec3f min = bounds.min();
+		tinymath::vec3f max = bounds.max();
+		Node& leaf = nodes[proxy];
+		if (leaf.min.x <= min.x && leaf.min.y <= min.y && leaf.min.z <= min.z &&
+			leaf.max.x >= max.x && leaf.max.y >= max.y && leaf.max.z >= max.z)
+		{
+			return false;
+		}
+
+		remove_leaf(proxy);
+		tinymath::vec3f margin = bounds.extents * kFatMarginScale + tinymath::vec3f(kFatMargin, kFatMargin, kFatMargin);
+		nodes[proxy].min = min - margin;
+		nodes[proxy].max = max + margin;
+		insert_leaf(proxy);
+		return true;
+	}
+
+	// the sibling is picked by the surface area the insertion adds to the tree
+	void BVH::insert_leaf(int32_t leaf)
+	{
+		if (root == kNullProxy)
+		{
+			root = leaf;
+			nodes[root].parent = kNullProxy;
+			return;
+		}
+
+		tinymath::vec3f leaf_min = nodes[leaf].min;
+		tinymath::vec3f leaf_max = nodes[leaf].max;
+		int32_t index = root;
+		while (!nodes[index].is_leaf())
+		{
+			const Node& node = nodes[index];
+			float area = surface(node.min, node.max);
+			float combined_area = surface(min3(node.min, leaf_min), max3(node.max, leaf_max));
+
+			// cost of a new parent for this node and the leaf, and the cost pushed down to the children
+			float cost = 2.0f * combined_area;
+			float inheritance_cost = 2.0f * (combined_area - area);
+
+			auto child_cost = [&](int32_t child_index) {
+				const Node& child = nodes[child_index];
+				float merged = surface(min3(child.min, leaf_min), max3(child.max, leaf_max));
+				return (child.is_leaf() ? merged : merged - surface(child.min, child.max)) + inheritance_cost;
+			};
+			float left_cost = child_cost(node.left);
+			float right_cost = child_cost(node.right);
+
+			if (cost < left_cost && cost < right_cost)
+			{
+				break;
+			}
+			index = left_cost < right_cost ? node.left : node.right;
+		}
+
+		int32_t sibling = index;
+		int32_t old_parent = nodes[sibling].parent;
+		int32_t new_parent = allocate_node();
+		nodes[new_parent].parent = old_parent;
+		nodes[new_parent].min = min3(leaf_min, nodes[sibling].min);
+		nodes[new_parent].max = max3(leaf_max, nodes[sibling].max);
+		nodes[new_parent].height = nodes[sibling].height + 1;
+		nodes[new_parent].left = sibling;
+		nodes[new_parent].right = leaf;
+		nodes[sibling].parent = new_parent;
+		nodes[leaf].parent = new_parent;
+
+		if (old_parent != kNullProxy)
+		{
+			if (nodes[old_parent].left == sibling)
+			{
+				nodes[old_parent].left = new_parent;
+			}
+			else
+			{
+				nodes[old_parent].right = new_parent;
+			}
+		}
+		else
+		{
+			root = new_parent;
+		}
+
+		index = nodes[leaf].parent;
+		while (index != kNullProxy)
+		{
+			index = balance(index);
+			refit(index);
+			index = nodes[index].parent;
+		}
+	}
+
+	void BVH::remove_leaf(int32_t leaf)
+	{
+		if (leaf == root)
+		{
+			root = kNullProxy;
+			return;
+		}
+
+		int32_t parent = nodes[leaf].parent;
+		int32_t grand_parent = nodes[parent].parent;
+		int32_t sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+		if (grand_parent != kNullProxy)
+		{
+			if (nodes[grand_parent].left == parent)
+			{
+				nodes[grand_parent].left = sibling;
+			}
+			else
+			{
+				nodes[grand_parent].right = sibling;
+			}
+			nodes[sibling].parent = grand_parent;
+			free_node(parent);
+
+			int32_t index = grand_parent;
+			while (index != kNullProxy)
+			{
+				index = balance(index);
+				refit(index);
+				index = nodes[index].parent;
+			}
+		}
+		else
+		{
+			root = sibling;
+			nodes[sibling].parent = kNullProxy;
+			free_node(parent);
+		}
+	}
+
+	void BVH::refit(int32_t index)
+	{
+		Node& node = nodes[index];
+		const Node& left = nodes[node.left];
+		const Node& right = nodes[node.right];
+		node.min = min3(left.min, right.min);
+		node.max = max3(left.max, right.max);
+		node.height = 1 + tinymath::max(left.height, right.height);
+	}
+
+	// rotates the taller child up when the heights of the children differ by more than one
+	int32_t BVH::balance(int32_t a)
+	{
+		if (nodes[a].is_leaf() || nodes[a].height < 2)
+		{
+			return a;
+		}
+
+		int32_t b = nodes[a].left;
+		int32_t c = nodes[a].right;
+		int32_t diff = nodes[c].height - nodes[b].height;
+
+		if (diff > 1 || diff < -1)
+		{
+			// up is promoted to the place of a, a takes over one child of up
+			int32_t up = diff > 1 ? c : b;
+			int32_t stay = diff > 1 ? b : c;
+			int32_t f = nodes[up].left;
+			int32_t g = nodes[up].right;
+
+			nodes[up].left = a;
+			nodes[up].parent = nodes[a].parent;
+			nodes[a].parent = up;
+
+			if (nodes[up].parent != kNullProxy)
+			{
+				Node& parent = nodes[nodes[up].parent];
+				if (parent.left == a)
+				{
+					parent.left = up;
+				}
+				else
+				{
+					parent.right = up;
+				}
+			}
+			else
+			{
+				root = up;
+			}
+
+			// the taller grand child stays under up, the other one moves to a
+			int32_t keep = nodes[f].height > nodes[g].height ? f : g;
+			int32_t give = keep == f ? g : f;
+			nodes[up].right = keep;
+			if (diff > 1)
+			{
+				nodes[a].left = stay;
+				nodes[a].right = give;
+			}
+			else
+			{
+				nodes[a].left = give;
+				nodes[a].right = stay;
+			}
+			nodes[give].parent = a;
+
+			refit(a);
+			refit(up);
+			return up;
+		}
+
+		return a;
+	}
+
+	void BVH::collect(int32_t index, std::vector<Renderer*>& out) const
+	{
+		std::vector<int32_t> stack;
+		stack.push_back(index);
+		while (!stack.empty())
+		{
+			const Node& node = nodes[stack.back()];
+			stack.pop_back();
+			if (node.is_leaf())
+			{
+				out.push_back(node.renderer);
+			}
+			else
+			{
+				stack.push_back(node.left);
+				stack.push_back(node.right);
+			}
+		}
+	}
+
+	void BVH::query(const tinymath::AxisAlignedBoundingBox& box, std::vector<Renderer*>& out) const
+	{
+		if (root == kNullProxy)
+		{
+			return;
+		}
+
+		tinymath::vec3f min = box.min();
+		tinymath::vec3f max = box.max();
+		std::vector<int32_t> stack;
+		stack.push_back(root);
+		while (!stack.empty())
+		{
+			const Node& node = nodes[stack.back()];
+			stack.pop_back();
+			if (!overlap(node.min, node.max, min, max))
+			{
+				continue;
+			}
+
+			if (node.is_leaf())
+			{
+				out.push_back(node.renderer);
+			}
+			else
+			{
+				stack.push_back(node.left);
+				stack.push_back(node.right);
+			}
+		}
+	}
+
+	void BVH::query(const tinymath::Frustum& frustum, std::vector<Renderer*>& out) const
+	{
+		if (root == kNullProxy)
+		{
+			return;
+		}
+
+		std::vector<int32_t> stack;
+		stack.push_back(root);
+		while (!stack.empty())
+		{
+			int32_t index = stack.back();
+			const Node& node = nodes[index];
+			stack.pop_back();
+
+			// the corner furthest along each normal decides outside, the nearest one decides fully inside
+			bool outside = false;
+			bool inside = true;
+			for (int i = 0; i < 6 && !outside; i++)
+			{
+				auto& plane = frustum[i];
+				tinymath::vec3f far_corner(plane.normal.x >= 0.0f ? node.max.x : node.min.x,
+										   plane.normal.y >= 0.0f ? node.max.y : node.min.y,
+										   plane.normal.z >= 0.0f ? node.max.z : node.min.z);
+				tinymath::vec3f near_corner(plane.normal.x >= 0.0f ? node.min.x : node.max.x,
+											plane.normal.y >= 0.0f ? node.min.y : node.max.y,
+											plane.normal.z >= 0.0f ? node.min.z : node.max.z);
+				outside = plane.distance(far_corner) < 0.0f;
+				inside = inside && plane.distance(near_corner) >= 0.0f;
+			}
+
+			if (outside)
+			{
+				continue;
+			}
+
+			if (inside)
+			{
+				collect(index, out);
+			}
+			else if (node.is_leaf())
+			{
+				// leaf boxes are fattened, the tight world bounds get the last word
+				if (!node.renderer->frustum_culling(frustum))
+				{
+					out.push_back(node.renderer);
+				}
+			}
+			else
+			{
+				stack.push_back(node.left);
+				stack.push_back(node.right);
+			}
+		}
+	}
+
+	void BVH::query(const tinymath::Ray& ray, std::vector<std::pair<float, Renderer*>>& out) const
+	{
+		if (root == kNullProxy)
+		{
+			return;
+		}
+
+		std::vector<int32_t> stack;
+		stack.push_back(root);
+		while (!stack.empty())
+		{
+			const Node& node = nodes[stack.back()];
+			stack.pop_back();
+
+			// slab test
+			tinymath::vec3f t0 = (node.min - ray.origin) * ray.inversed_direction;
+			tinymath::vec3f t1 = (node.max - ray.origin) * ray.inversed_direction;
+			float t_enter = tinymath::max(tinymath::max(tinymath::min(t0.x, t1.x), tinymath::min(t0.y, t1.y)), tinymath::min(t0.z, t1.z));
+			float t_exit = tinymath::min(tinymath::min(tinymath::max(t0.x, t1.x), tinymath::max(t0.y, t1.y)), tinymath::max(t0.z, t1.z));
+			if (t_exit < tinymath::max(t_enter, 0.0f))
+			{
+				continue;
+			}
+
+			if (node.is_leaf())
+			{
+				out.emplace_back(tinymath::max(t_enter, 0.0f), node.renderer);
+			}
+			else
+			{
+				stack.push_back(node.left);
+				stack.push_back(node.right);
+			}
+		}
+	}
+}
@@ -41,6 +41,19 @@ namespace CpuRasterizer
 		return proj_matrix;
 	}
 
+	// viewport_pos is in [0, 1] from the bottom left corner
+	tinymath::Ray Camera::viewport_point_to_ray(const tinymath::vec2f& viewport_pos) const
+	{
+		tinymath::mat4x4 inv_vp = tinymath::inverse(projection_matrix() * view_matrix());
+		float x = viewport_pos.x * 2.0f - 1.0f;
+		float y = viewport_pos.y * 2.0f - 1.0f;
+		tinymath::vec4f p0 = inv_vp * tinymath::vec4f(x, y, 0.0f, 1.0f);
+		tinymath::vec4f p1 = inv_vp * tinymath::vec4f(x, y, 1.0f, 1.0f);
+		tinymath::vec3f start = p0.xyz / p0.w;
+		tinymath::vec3f end = p1.xyz / p1.w;
+		return tinymath::Ray(start, tinymath::normalize(end - start));
+	}
+
 	void Camera::focus(const tinymath::vec3f& position)
 	{
 		this->transform->lookat(position);
@@ -1,4 +1,6 @@
 #include "Mesh.hpp"
+#include "MeshSimplifier.hpp"
+#include "MeshOptimizer.hpp"
 
 namespace CpuRasterizer
 {
@@ -8,12 +10,26 @@ namespace CpuRasterizer
 	{
 		this->vertices = other.vertices;
 		this->indices = other.indices;
+		this->bounds = other.bounds;
+		this->bounding_sphere = other.bounding_sphere;
+		this->lods = other.lods;
 	}
 
-	Mesh::Mesh(const std::vector<Vertex>& _vertices, const std::vector<size_t>& _indices)
+	Mesh::Mesh(const std::vector<Vertex>& _vertices, const std::vector<size_t>& _indices, const VertexLayout& layout)
 	{
-		this->vertices = _vertices;
-		this->indices = _indices;
+		// out of range indices would read past the packed vertex data
+		std::vector<size_t> checked_indices(_indices);
+		for (auto& index : checked_indices)
+		{
+			if (index >= _vertices.size())
+			{
+				index = 0;
+			}
+		}
+
+		this->vertices = VertexBuffer(_vertices, layout);
+		this->indices = IndexBuffer(checked_indices);
+		compute_bounds();
 	}
 
 	Mesh::~Mesh()
@@ -23,6 +39,76 @@ namespace CpuRasterizer
 	{
 		this->vertices = other.vertices;
 		this->indices = other.indices;
+		this->bounds = other.bounds;
+		this->bounding_sphere = other.bounding_sphere;
+		this->lods = other.lods;
 		return *this;
 	}
+
+	void Mesh::compute_bounds()
+	{
+		if (vertices.size() == 0)
+		{
+			bounds = tinymath::AxisAlignedBoundingBox();
+			bounding_sphere = tinymath::Sphere();
+			return;
+		}
+
+		tinymath::vec3f min = vertices.position(0);
+		tinymath::vec3f max = min;
+		for (size_t idx = 0; idx < vertices.size(); ++idx)
+		{
+			tinymath::vec3f p = vertices.position(idx);
+			min = tinymath::vec3f(tinymath::min(min.x, p.x), tinymath::min(min.y, p.y), tinymath::min(min.z, p.z));
+			max = tinymath::vec3f(tinymath::max(max.x, p.x), tinymath::max(max.y, p.y), tinymath::max(max.z, p.z));
+		}
+		bounds.set_min_max(min, max);
+
+		// centered on the box, tighter than the half diagonal for most meshes
+		float radius = 0.0f;
+		for (size_t idx = 0; idx < vertices.size(); ++idx)
+		{
+			radius = tinymath::max(radius, tinymath::magnitude(vertices.position(idx) - bounds.center));
+		}
+		bounding_sphere = tinymath::Sphere(bounds.center, radius);
+	}
+
+	// each level is simplified from the previous one, the chain stops early once the mesh cannot lose more triangles
+	void Mesh::generate_lods(size_t max_lod_count)
+	{
+		lods.clear();
+
+		// the simplifier works on decoded copies, the levels are packed again as index buffers
+		std::vector<Vertex> decoded_vertices = vertices.decode();
+		std::vector<size_t> previous = indices.decode();
+		for (size_t lod = 1; lod < max_lod_count; ++lod)
+		{
+			size_t target = (size_t)((float)previous.size() * kLODTriangleRatio) / 3 * 3;
+			if (target < 3)
+			{
+				break;
+			}
+
+			float error;
+			std::vector<size_t> simplified = MeshSimplifier::simplify(decoded_vertices, previous, target, error);
+			if (simplified.size() == 0 || simplified.size() * 10 > previous.size() * 9)
+			{
+				break;
+			}
+
+			MeshOptimizer::optimize_vertex_cache(simplified, decoded_vertices.size());
+			lods.emplace_back(IndexBuffer(simplified));
+			previous = std::move(simplified);
+		}
+	}
+
+	size_t Mesh::byte_size() const
+	{
+		size_t size = vertices.byte_size() + indices.byte_size();
+		for (auto& lod : lods)
+		{
+			size += lod.byte_size();
+		}
+		return size;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "MeshCache.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include "MappedFile.hpp"
+#include "Logger.hpp"
+
+namespace CpuRasterizer
+{
+	static size_t align_offset(size_t offset)
+	{
+		return tinymath::round_up(offset, kMeshCacheAlignment);
+	}
+
+	// true when [offset, offset + count * element_size) lies inside the file
+	static bool in_range(uint64_t offset, uint64_t count, uint64_t element_size, size_t file_size)
+	{
+		if (offset > file_size || (element_size != 0 && count > (file_size - offset) / element_size))
+		{
+			return false;
+		}
+		return true;
+	}
+
+	static bool valid_format(uint8_t format)
+	{
+		return format <= (uint8_t)VertexFormat::kOctahedral16;
+	}
+
+	static bool valid_indices(const IndexBuffer& indices, size_t vertex_count)
+	{
+		for (size_t idx = 0; idx < indices.size(); ++idx)
+		{
+			if (indices[idx] >= vertex_count)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static bool write_stream(std::FILE* fd, size_t& position, size_t offset, const void* data, size_t size)
+	{
+		static const uint8_t zeros[kMeshCacheAlignment] = {};
+		if (offset > position && fwrite(zeros, 1, offset - position, fd) != offset - position)
+		{
+			return false;
+		}
+		position = offset + size;
+		return size == 0 || fwrite(data, 1, size, fd) == size;
+	}
+
+	bool MeshCache::save(const std::string& path, const std::vector<Mesh>& meshes)
+	{
+		MeshCacheHeader header = {};
+		header.magic = kMeshCacheMagic;
+		header.version = kMeshCacheVersion;
+		header.mesh_count = (uint32_t)meshes.size();
+
+		size_t lod_total = 0;
+		for (auto& mesh : meshes)
+		{
+			lod_total += mesh.lods.size();
+		}
+
+		// tables first, then every stream at its aligned offset
+		std::vector<MeshCacheEntry> entries(meshes.size());
+		std::vector<MeshCacheLOD> lods;
+		lods.reserve(lod_total);
+		size_t lod_offset = sizeof(MeshCacheHeader) + sizeof(MeshCacheEntry) * meshes.size();
+		size_t offset = lod_offset + sizeof(MeshCacheLOD) * lod_total;
+		for (size_t mesh_idx = 0; mesh_idx < meshes.size(); ++mesh_idx)
+		{
+			auto& mesh = meshes[mesh_idx];
+			auto& entry = entries[mesh_idx];
+			auto& layout = mesh.vertices.get_layout();
+			for (size_t attribute = 0; attribute < kVertexAttributeCount; ++attribute)
+			{
+				entry.vertex_formats[attribute] = (uint8_t)layout.formats[attribute];
+			}
+			entry.vertex_stride = layout.stride;
+			entry.vertex_count = mesh.vertices.size();
+			entry.vertex_offset = align_offset(offset);
+			offset = entry.vertex_offset + mesh.vertices.byte_size();
+
+			entry.index_format = (uint8_t)mesh.indices.get_format();
+			entry.index_count = mesh.indices.size();
+			entry.index_offset = align_offset(offset);
+			offset = entry.index_offset + mesh.indices.byte_size();
+
+			entry.lod_count = (uint32_t)mesh.lods.size();
+			entry.lod_offset = lod_offset + sizeof(MeshCacheLOD) * lods.size();
+			for (auto& lod_indices : mesh.lods)
+			{
+				MeshCacheLOD lod = {};
+				lod.index_format = (uint8_t)lod_indices.get_format();
+				lod.index_count = lod_indices.size();
+				lod.index_offset = align_offset(offset);
+				offset = lod.index_offset + lod_indices.byte_size();
+				lods.emplace_back(lod);
+			}
+
+			tinymath::vec3f min = mesh.bounds.min();
+			tinymath::vec3f max = mesh.bounds.max();
+			entry.bounds_min[0] = min.x; entry.bounds_min[1] = min.y; entry.bounds_min[2] = min.z;
+			entry.bounds_max[0] = max.x; entry.bounds_max[1] = max.y; entry.bounds_max[2] = max.z;
+			entry.sphere[0] = mesh.bounding_sphere.center.x;
+			entry.sphere[1] = mesh.bounding_sphere.center.y;
+			entry.sphere[2] = mesh.bounding_sphere.center.z;
+			entry.sphere[3] = mesh.bounding_sphere.radius;
+		}
+
+		std::filesystem::path abs_path(path);
+		if (!std::filesystem::exists(abs_path.parent_path()))
+		{
+			std::filesystem::create_directories(abs_path.parent_path());
+		}
+
+		// written aside and renamed over the cache, so instances still mapping the old file keep reading it
+		std::string temp_path = path + ".tmp";
+		std::FILE* fd = fopen(temp_path.c_str(), "wb");
+		if (fd == nullptr)
+		{
+			ERROR("cannot write mesh cache: {}", path);
+			return false;
+		}
+
+		size_t position = 0;
+		bool ok = write_stream(fd, position, 0, &header, sizeof(header));
+		ok = ok && write_stream(fd, position, position, entries.data(), sizeof(MeshCacheEntry) * entries.size());
+		ok = ok && write_stream(fd, position, position, lods.data(), sizeof(MeshCacheLOD) * lods.size());
+		size_t lod_idx = 0;
+		for (size_t mesh_idx = 0; mesh_idx < meshes.size() && ok; ++mesh_idx)
+		{
+			auto& mesh = meshes[mesh_idx];
+			auto& entry = entries[mesh_idx];
+			ok = ok && write_stream(fd, position, entry.vertex_offset, mesh.vertices.get_data(), mesh.vertices.byte_size());
+			ok = ok && write_stream(fd, position, entry.index_offset, mesh.indices.get_data(), mesh.indices.byte_size());
+			for (auto& lod_indices : mesh.lods)
+			{
+				ok = ok && write_stream(fd, position, lods[lod_idx++].index_offset, lod_indices.get_data(), lod_indices.byte_size());
+			}
+		}
+		ok = fclose(fd) == 0 && ok;
+
+		std::error_code error;
+		if (ok)
+		{
+			std::filesystem::rename(temp_path, abs_path, error);
+			ok = !error;
+		}
+		if (!ok)
+		{
+			// never leave a truncated cache behind
+			std::filesystem::remove(temp_path, error);
+			ERROR("cannot write mesh cache: {}", path);
+			return false;
+		}
+		return true;
+	}
+
+	bool MeshCache::load(const std::string& path, std::vector<Mesh>& meshes)
+	{
+		auto file = MappedFile::open(path);
+		if (file == nullptr || file->size() < sizeof(MeshCacheHeader))
+		{
+			return false;
+		}
+
+		MeshCacheHeader header;
+		memcpy(&header, file->data(), sizeof(header));
+		if (header.magic != kMeshCacheMagic || header.version != kMeshCacheVersion)
+		{
+			return false;
+		}
+
+		size_t file_size = file->size();
+		if (!in_range(sizeof(MeshCacheHeader), header.mesh_count, sizeof(MeshCacheEntry), file_size))
+		{
+			return false;
+		}
+
+		std::vector<Mesh> loaded(header.mesh_count);
+		for (size_t mesh_idx = 0; mesh_idx < header.mesh_count; ++mesh_idx)
+		{
+			MeshCacheEntry entry;
+			memcpy(&entry, file->data() + sizeof(MeshCacheHeader) + sizeof(MeshCacheEntry) * mesh_idx, sizeof(entry));
+
+			for (size_t attribute = 0; attribute < kVertexAttributeCount; ++attribute)
+			{
+				if (!valid_format(entry.vertex_formats[attribute]))
+				{
+					return false;
+				}
+			}
+			VertexLayout layout((VertexFormat)entry.vertex_formats[0], (VertexFormat)entry.vertex_formats[1], (VertexFormat)entry.vertex_formats[2], (VertexFormat)entry.vertex_formats[3], (VertexFormat)entry.vertex_formats[4]);
+			if (layout.stride != entry.vertex_stride || entry.index_format > (uint8_t)IndexFormat::kUInt32)
+			{
+				return false;
+			}
+
+			IndexFormat index_format = (IndexFormat)entry.index_format;
+			if (!in_range(entry.vertex_offset, entry.vertex_count, layout.stride, file_size) ||
+				!in_range(entry.index_offset, entry.index_count, IndexBuffer::index_size(index_format), file_size) ||
+				!in_range(entry.lod_offset, entry.lod_count, sizeof(MeshCacheLOD), file_size) ||
+				entry.index_offset % kMeshCacheAlignment != 0)
+			{
+				return false;
+			}
+
+			// the buffers point into the mapping and keep it alive
+			Mesh& mesh = loaded[mesh_idx];
+			mesh.vertices = VertexBuffer(layout, file->data() + entry.vertex_offset, (size_t)entry.vertex_count, file);
+			mesh.indices = IndexBuffer(index_format, file->data() + entry.index_offset, (size_t)entry.index_count, file);
+			if (!valid_indices(mesh.indices, mesh.vertices.size()))
+			{
+				return false;
+			}
+
+			for (size_t lod_idx = 0; lod_idx < entry.lod_count; ++lod_idx)
+			{
+				MeshCacheLOD lod;
+				memcpy(&lod, file->data() + entry.lod_offset + sizeof(MeshCacheLOD) * lod_idx, sizeof(lod));
+				if (lod.index_format > (uint8_t)IndexFormat::kUInt32)
+				{
+					return false;
+				}
+
+				IndexFormat lod_format = (IndexFormat)lod.index_format;
+				if (!in_range(lod.index_offset, lod.index_count, IndexBuffer::index_size(lod_format), file_size) || lod.index_offset % kMeshCacheAlignment != 0)
+				{
+					return false;
+				}
+
+				IndexBuffer lod_indices(lod_format, file->data() + lod.index_offset, (size_t)lod.index_count, file);
+				if (!valid_indices(lod_indices, mesh.vertices.size()))
+				{
+					return false;
+				}
+				mesh.lods.emplace_back(lod_indices);
+			}
+
+			mesh.bounds.set_min_max(tinymath::vec3f(entry.bounds_min[0], entry.bounds_min[1], entry.bounds_min[2]), tinymath::vec3f(entry.bounds_max[0], entry.bounds_max[1], entry.bounds_max[2]));
+			mesh.bounding_sphere = tinymath::Sphere(tinymath::vec3f(entry.sphere[0], entry.sphere[1], entry.sphere[2]), entry.sphere[3]);
+		}
+
+		meshes = std::move(loaded);
+		return true;
+	}
+}
@@ -0,0 +1,520 @@
+#include "MeshOptimizer.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <cmath>
+#include "Logger.hpp"
+
+namespace CpuRasterizer
+{
+	constexpr size_t kForsythCacheSize = 32; // lru cache the triangle scores are simulated with
+	constexpr size_t kVertexKeySize = 17;
+	constexpr size_t kTangentKeyOffset = 8; // the key up to here holds position, normal and uv
+	constexpr int kOverdrawGridSize = 256;
+	constexpr size_t kNoTriangle = SIZE_MAX;
+
+	// compared bitwise, -0 and 0 stay apart but nothing that renders differently is merged
+	static void vertex_key(const Vertex& v, float* key)
+	{
+		const float values[kVertexKeySize] = {
+			v.position.x, v.position.y, v.position.z,
+			v.normal.x, v.normal.y, v.normal.z,
+			v.uv.x, v.uv.y,
+			v.tangent.x, v.tangent.y, v.tangent.z,
+			v.bitangent.x, v.bitangent.y, v.bitangent.z,
+			v.color.x, v.color.y, v.color.z };
+		memcpy(key, values, sizeof(values));
+	}
+
+	static size_t hash_key(const float* key, size_t size)
+	{
+		size_t h = 14695981039346656037ull;
+		for (size_t idx = 0; idx < size; ++idx)
+		{
+			uint32_t bits;
+			memcpy(&bits, key + idx, sizeof(bits));
+			h = (h ^ bits) * 1099511628211ull;
+		}
+		return h;
+	}
+
+	std::vector<size_t> MeshOptimizer::generate_vertex_remap(const std::vector<Vertex>& vertices, bool match_tangents)
+	{
+		size_t key_size = match_tangents ? kVertexKeySize : kTangentKeyOffset;
+		std::vector<float> keys(vertices.size() * kVertexKeySize);
+		std::vector<size_t> hashes(vertices.size());
+		std::vector<size_t> order(vertices.size());
+		for (size_t idx = 0; idx < vertices.size(); ++idx)
+		{
+			vertex_key(vertices[idx], keys.data() + idx * kVertexKeySize);
+			hashes[idx] = hash_key(keys.data() + idx * kVertexKeySize, key_size);
+			order[idx] = idx;
+		}
+
+		std::sort(order.begin(), order.end(), [&hashes](size_t lhs, size_t rhs)
+		{
+			return hashes[lhs] < hashes[rhs] || (hashes[lhs] == hashes[rhs] && lhs < rhs);
+		});
+
+		// runs of equal hashes are compared in full, the first vertex of each distinct key is kept
+		std::vector<size_t> remap(vertices.size());
+		for (size_t begin = 0; begin < order.size();)
+		{
+			size_t end = begin + 1;
+			while (end < order.size() && hashes[order[end]] == hashes[order[begin]])
+			{
+				++end;
+			}
+
+			for (size_t i = begin; i < end; ++i)
+			{
+				remap[order[i]] = order[i];
+				for (size_t j = begin; j < i; ++j)
+				{
+					if (remap[order[j]] == order[j] && memcmp(keys.data() + order[i] * kVertexKeySize, keys.data() + order[j] * kVertexKeySize, key_size * sizeof(float)) == 0)
+					{
+						remap[order[i]] = order[j];
+						break;
+					}
+				}
+			}
+			begin = end;
+		}
+		return remap;
+	}
+
+	void MeshOptimizer::optimize(std::vector<Vertex>& vertices, std::vector<size_t>& indices)
+	{
+		if (indices.size() < 3)
+		{
+			return;
+		}
+
+		size_t vertex_count = vertices.size();
+		float acmr = analyze_vertex_cache(indices, vertices.size(), kVertexCacheSize);
+		float overdraw = analyze_overdraw(indices, vertices);
+
+		std::vector<size_t> remap = generate_vertex_remap(vertices, true);
+		for (auto& index : indices)
+		{
+			index = remap[index];
+		}
+
+		optimize_vertex_cache(indices, vertices.size());
+		optimize_overdraw(indices, vertices, kOverdrawThreshold);
+		optimize_vertex_fetch(vertices, indices);
+
+		LOG("optimize mesh: triangles: {}, vertices: {} -> {}, acmr: {} -> {}, overdraw: {} -> {}",
+			indices.size() / 3, vertex_count, vertices.size(),
+			acmr, analyze_vertex_cache(indices, vertices.size(), kVertexCacheSize),
+			overdraw, analyze_overdraw(indices, vertices));
+	}
+
+	static float forsyth_vertex_score(int cache_position, size_t remaining)
+	{
+		if (remaining == 0)
+		{
+			return -1.0f;
+		}
+
+		// the last triangle's vertices score a little lower so the next triangle does not repeat its edges
+		float score = 0.0f;
+		if (cache_position >= 0)
+		{
+			score = cache_position < 3 ? 0.75f : powf(1.0f - (float)(cache_position - 3) / (float)(kForsythCacheSize - 3), 1.5f);
+		}
+
+		// vertices with few triangles left are finished early
+		return score + 2.0f / sqrtf((float)remaining);
+	}
+
+	void MeshOptimizer::optimize_vertex_cache(std::vector<size_t>& indices, size_t vertex_count)
+	{
+		size_t triangle_count = indices.size() / 3;
+		if (triangle_count == 0)
+		{
+			return;
+		}
+
+		// live triangles per vertex, an emitted triangle is swapped past the live range
+		std::vector<size_t> remaining(vertex_count, 0);
+		std::vector<size_t> offsets(vertex_count + 1, 0);
+		for (size_t v : indices)
+		{
+			remaining[v]++;
+		}
+		for (size_t v = 0; v < vertex_count; ++v)
+		{
+			offsets[v + 1] = offsets[v] + remaining[v];
+		}
+		std::vector<size_t> adjacency(indices.size());
+		{
+			std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+			for (size_t idx = 0; idx < triangle_count * 3; ++idx)
+			{
+				adjacency[cursor[indices[idx]]++] = idx / 3;
+			}
+		}
+
+		std::vector<int> cache_position(vertex_count, -1);
+		std::vector<float> vertex_scores(vertex_count);
+		for (size_t v = 0; v < vertex_count; ++v)
+		{
+			vertex_scores[v] = forsyth_vertex_score(-1, remaining[v]);
+		}
+
+		std::vector<float> triangle_scores(triangle_count);
+		std::vector<bool> emitted(triangle_count, false);
+		size_t best = 0;
+		for (size_t t = 0; t < triangle_count; ++t)
+		{
+			triangle_scores[t] = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+			best = triangle_scores[t] > triangle_scores[best] ? t : best;
+		}
+
+		std::vector<size_t> result;
+		result.reserve(triangle_count * 3);
+		std::vector<size_t> cache;
+		std::vector<size_t> next_cache;
+		size_t input_cursor = 0;
+
+		while (result.size() < triangle_count * 3)
+		{
+			// nothing in the cache has triangles left, continue with the next one in input order
+			if (best == kNoTriangle)
+			{
+				while (emitted[input_cursor])
+				{
+					++input_cursor;
+				}
+				best = input_cursor;
+			}
+
+			const size_t* tri = indices.data() + best * 3;
+			emitted[best] = true;
+			next_cache.clear();
+			for (size_t k = 0; k < 3; ++k)
+			{
+				size_t v = tri[k];
+				result.push_back(v);
+				next_cache.push_back(v);
+
+				size_t* live = adjacency.data() + offsets[v];
+				for (size_t i = 0; i < remaining[v]; ++i)
+				{
+					if (live[i] == best)
+					{
+						std::swap(live[i], live[remaining[v] - 1]);
+						break;
+					}
+				}
+				remaining[v]--;
+			}
+
+			for (size_t v : cache)
+			{
+				if (v != tri[0] && v != tri[1] && v != tri[2])
+				{
+					next_cache.push_back(v);
+				}
+			}
+
+			// evicted vertices are rescored as well, then only triangles around the cache are candidates
+			for (size_t i = 0; i < next_cache.size(); ++i)
+			{
+				size_t v = next_cache[i];
+				cache_position[v] = i < kForsythCacheSize ? (int)i : -1;
+				float score = forsyth_vertex_score(cache_position[v], remaining[v]);
+				float delta = score - vertex_scores[v];
+				vertex_scores[v] = score;
+				for (size_t j = 0; j < remaining[v]; ++j)
+				{
+					triangle_scores[adjacency[offsets[v] + j]] += delta;
+				}
+			}
+
+			if (next_cache.size() > kForsythCacheSize)
+			{
+				next_cache.resize(kForsythCacheSize);
+			}
+			std::swap(cache, next_cache);
+
+			best = kNoTriangle;
+			float best_score = -FLT_MAX;
+			for (size_t v : cache)
+			{
+				for (size_t j = 0; j < remaining[v]; ++j)
+				{
+					size_t t = adjacency[offsets[v] + j];
+					if (triangle_scores[t] > best_score)
+					{
+						best_score = triangle_scores[t];
+						best = t;
+					}
+				}
+			}
+		}
+
+		indices.swap(result);
+	}
+
+	// fifo simulation with timestamps, a vertex is cached while fewer than cache_size misses happened since its own
+	static size_t count_misses(const size_t* tri, std::vector<size_t>& timestamps, size_t& time, size_t cache_size)
+	{
+		size_t misses = 0;
+		for (size_t k = 0; k < 3; ++k)
+		{
+			if (time - timestamps[tri[k]] > cache_size)
+			{
+				timestamps[tri[k]] = time++;
+				misses++;
+			}
+		}
+		return misses;
+	}
+
+	float MeshOptimizer::analyze_vertex_cache(const std::vector<size_t>& indices, size_t vertex_count, size_t cache_size)
+	{
+		size_t triangle_count = indices.size() / 3;
+		if (triangle_count == 0)
+		{
+			return 0.0f;
+		}
+
+		std::vector<size_t> timestamps(vertex_count, 0);
+		size_t time = cache_size + 1;
+		size_t misses = 0;
+		for (size_t t = 0; t < triangle_count; ++t)
+		{
+			misses += count_misses(indices.data() + t * 3, timestamps, time, cache_size);
+		}
+		return (float)misses / (float)triangle_count;
+	}
+
+	void MeshOptimizer::optimize_overdraw(std::vector<size_t>& indices, const std::vector<Vertex>& vertices, float threshold)
+	{
+		size_t triangle_count = indices.size() / 3;
+		if (triangle_count < 2)
+		{
+			return;
+		}
+
+		// hard boundaries where the cache starts over, every vertex of the triangle misses
+		std::vector<size_t> timestamps(vertices.size(), 0);
+		size_t time = kVertexCacheSize + 1;
+		std::vector<size_t> hard_clusters;
+		for (size_t t = 0; t < triangle_count; ++t)
+		{
+			if (count_misses(indices.data() + t * 3, timestamps, time, kVertexCacheSize) == 3)
+			{
+				hard_clusters.push_back(t);
+			}
+		}
+		hard_clusters.push_back(triangle_count);
+
+		// soft boundaries inside them, wherever the acmr so far stays within the threshold of the whole cluster
+		std::vector<size_t> clusters;
+		for (size_t c = 0; c + 1 < hard_clusters.size(); ++c)
+		{
+			size_t start = hard_clusters[c];
+			size_t end = hard_clusters[c + 1];
+
+			time += kVertexCacheSize + 1;
+			size_t cluster_misses = 0;
+			for (size_t t = start; t < end; ++t)
+			{
+				cluster_misses += count_misses(indices.data() + t * 3, timestamps, time, kVertexCacheSize);
+			}
+			float cluster_threshold = threshold * (float)cluster_misses / (float)(end - start);
+
+			time += kVertexCacheSize + 1;
+			clusters.push_back(start);
+			size_t running_start = start;
+			size_t running_misses = 0;
+			for (size_t t = start; t < end; ++t)
+			{
+				running_misses += count_misses(indices.data() + t * 3, timestamps, time, kVertexCacheSize);
+				if (t + 1 < end && (float)running_misses <= cluster_threshold * (float)(t + 1 - running_start))
+				{
+					clusters.push_back(t + 1);
+					running_start = t + 1;
+					running_misses = 0;
+					time += kVertexCacheSize + 1;
+				}
+			}
+		}
+		clusters.push_back(triangle_count);
+
+		// area weighted centroid and normal per cluster
+		size_t cluster_count = clusters.size() - 1;
+		std::vector<tinymath::vec3f> centroids(cluster_count, tinymath::kVec3fZero);
+		std::vector<tinymath::vec3f> normals(cluster_count, tinymath::kVec3fZero);
+		tinymath::vec3f mesh_centroid = tinymath::kVec3fZero;
+		float mesh_area = 0.0f;
+		for (size_t c = 0; c < cluster_count; ++c)
+		{
+			float cluster_area = 0.0f;
+			for (size_t t = clusters[c]; t < clusters[c + 1]; ++t)
+			{
+				tinymath::vec3f p0 = vertices[indices[t * 3]].position.xyz;
+				tinymath::vec3f p1 = vertices[indices[t * 3 + 1]].position.xyz;
+				tinymath::vec3f p2 = vertices[indices[t * 3 + 2]].position.xyz;
+				tinymath::vec3f normal = tinymath::cross(p1 - p0, p2 - p0);
+				float area = tinymath::magnitude(normal);
+				centroids[c] = centroids[c] + (p0 + p1 + p2) * (area / 3.0f);
+				normals[c] = normals[c] + normal;
+				cluster_area += area;
+			}
+
+			mesh_centroid = mesh_centroid + centroids[c];
+			mesh_area += cluster_area;
+			centroids[c] = cluster_area > 0.0f ? centroids[c] / cluster_area : vertices[indices[clusters[c] * 3]].position.xyz;
+		}
+		mesh_centroid = mesh_area > 0.0f ? mesh_centroid / mesh_area : tinymath::kVec3fZero;
+
+		// clusters facing away from the center are likely in front of the rest from any view direction
+		std::vector<float> sort_keys(cluster_count);
+		std::vector<size_t> order(cluster_count);
+		for (size_t c = 0; c < cluster_count; ++c)
+		{
+			float length = tinymath::magnitude(normals[c]);
+			sort_keys[c] = length > 0.0f ? tinymath::dot(centroids[c] - mesh_centroid, normals[c] / length) : 0.0f;
+			order[c] = c;
+		}
+
+		std::stable_sort(order.begin(), order.end(), [&sort_keys](size_t lhs, size_t rhs)
+		{
+			return sort_keys[lhs] > sort_keys[rhs];
+		});
+
+		std::vector<size_t> result;
+		result.reserve(indices.size());
+		for (size_t c : order)
+		{
+			result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+		}
+		indices.swap(result);
+	}
+
+	void MeshOptimizer::optimize_vertex_fetch(std::vector<Vertex>& vertices, std::vector<size_t>& indices)
+	{
+		std::vector<size_t> remap(vertices.size(), SIZE_MAX);
+		std::vector<Vertex> result;
+		result.reserve(vertices.size());
+		for (auto& index : indices)
+		{
+			if (remap[index] == SIZE_MAX)
+			{
+				remap[index] = result.size();
+				result.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+		vertices.swap(result);
+	}
+
+	static float axis_value(const tinymath::vec3f& v, int axis)
+	{
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+
+	// orthographic views along +-x, +-y, +-z, back faces are culled like the pipeline does
+	float MeshOptimizer::analyze_overdraw(const std::vector<size_t>& indices, const std::vector<Vertex>& vertices)
+	{
+		if (indices.size() < 3)
+		{
+			return 0.0f;
+		}
+
+		tinymath::vec3f bmin = vertices[indices[0]].position.xyz;
+		tinymath::vec3f bmax = bmin;
+		for (size_t index : indices)
+		{
+			tinymath::vec3f p = vertices[index].position.xyz;
+			bmin = tinymath::vec3f(tinymath::min(bmin.x, p.x), tinymath::min(bmin.y, p.y), tinymath::min(bmin.z, p.z));
+			bmax = tinymath::vec3f(tinymath::max(bmax.x, p.x), tinymath::max(bmax.y, p.y), tinymath::max(bmax.z, p.z));
+		}
+
+		tinymath::vec3f extent = bmax - bmin;
+		float max_extent = tinymath::max(extent.x, tinymath::max(extent.y, extent.z));
+		if (max_extent <= 0.0f)
+		{
+			return 0.0f;
+		}
+
+		float scale = (float)(kOverdrawGridSize - 1) / max_extent;
+		std::vector<float> depth(kOverdrawGridSize * kOverdrawGridSize);
+		size_t shaded = 0;
+		size_t covered = 0;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			int u_axis = (axis + 1) % 3;
+			int v_axis = (axis + 2) % 3;
+			for (float sign = -1.0f; sign <= 1.0f; sign += 2.0f)
+			{
+				std::fill(depth.begin(), depth.end(), FLT_MAX);
+				for (size_t idx = 0; idx + 2 < indices.size(); idx += 3)
+				{
+					tinymath::vec3f p[3];
+					float x[3], y[3], z[3];
+					for (size_t k = 0; k < 3; ++k)
+					{
+						p[k] = vertices[indices[idx + k]].position.xyz - bmin;
+						x[k] = axis_value(p[k], u_axis) * scale;
+						y[k] = axis_value(p[k], v_axis) * scale;
+						z[k] = axis_value(p[k], axis) * sign;
+					}
+
+					// the view looks along sign * axis
+					if (axis_value(tinymath::cross(p[1] - p[0], p[2] - p[0]), axis) * sign >= 0.0f)
+					{
+						continue;
+					}
+
+					float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+					if (tinymath::abs(area) < EPSILON)
+					{
+						continue;
+					}
+					float inv_area = 1.0f / area;
+
+					int min_x = tinymath::max((int)tinymath::floor(tinymath::min(x[0], tinymath::min(x[1], x[2]))), 0);
+					int max_x = tinymath::min((int)tinymath::ceil(tinymath::max(x[0], tinymath::max(x[1], x[2]))), kOverdrawGridSize - 1);
+					int min_y = tinymath::max((int)tinymath::floor(tinymath::min(y[0], tinymath::min(y[1], y[2]))), 0);
+					int max_y = tinymath::min((int)tinymath::ceil(tinymath::max(y[0], tinymath::max(y[1], y[2]))), kOverdrawGridSize - 1);
+					for (int py = min_y; py <= max_y; ++py)
+					{
+						for (int px = min_x; px <= max_x; ++px)
+						{
+							float cx = (float)px + 0.5f;
+							float cy = (float)py + 0.5f;
+							float w0 = ((x[1] - cx) * (y[2] - cy) - (y[1] - cy) * (x[2] - cx)) * inv_area;
+							float w1 = ((x[2] - cx) * (y[0] - cy) - (y[2] - cy) * (x[0] - cx)) * inv_area;
+							float w2 = 1.0f - w0 - w1;
+							if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+							{
+								continue;
+							}
+
+							float d = w0 * z[0] + w1 * z[1] + w2 * z[2];
+							float& dst = depth[py * kOverdrawGridSize + px];
+							if (d < dst)
+							{
+								dst = d;
+								shaded++;
+							}
+						}
+					}
+				}
+
+				for (float d : depth)
+				{
+					covered += d != FLT_MAX ? 1 : 0;
+				}
+			}
+		}
+
+		return covered > 0 ? (float)shaded / (float)covered : 0.0f;
+	}
+}
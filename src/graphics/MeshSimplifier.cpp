@@ -0,0 +1,267 @@
+#include "MeshSimplifier.hpp"
+#include <algorithm>
+#include "MeshOptimizer.hpp"
+
+namespace CpuRasterizer
+{
+	constexpr size_t kMaxSimplifyPasses = 64;
+
+	// plane quadric, the symmetric 4x4 matrix stored as its upper triangle
+	struct Quadric
+	{
+		double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+		Quadric() : a2(0), ab(0), ac(0), ad(0), b2(0), bc(0), bd(0), c2(0), cd(0), d2(0) {}
+
+		Quadric(double a, double b, double c, double d, double w)
+		{
+			a2 = a * a * w; ab = a * b * w; ac = a * c * w; ad = a * d * w;
+			b2 = b * b * w; bc = b * c * w; bd = b * d * w;
+			c2 = c * c * w; cd = c * d * w;
+			d2 = d * d * w;
+		}
+
+		Quadric& operator+=(const Quadric& q)
+		{
+			a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+			b2 += q.b2; bc += q.bc; bd += q.bd;
+			c2 += q.c2; cd += q.cd;
+			d2 += q.d2;
+			return *this;
+		}
+
+		double evaluate(const tinymath::vec3f& p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			return a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+				+ b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+				+ c2 * z * z + 2.0 * cd * z
+				+ d2;
+		}
+	};
+
+	struct Collapse
+	{
+		size_t from;
+		size_t to;
+		float cost;
+	};
+
+	std::vector<size_t> MeshSimplifier::simplify(const std::vector<Vertex>& vertices, const std::vector<size_t>& indices, size_t target_index_count, float& error)
+	{
+		error = 0.0f;
+		// imported meshes are not indexed, identical vertices have to share an index before any edge can collapse
+		// tangents are derived and often left unset by the importer, they do not take part
+		std::vector<size_t> remap = MeshOptimizer::generate_vertex_remap(vertices, false);
+		std::vector<size_t> result(indices.size());
+		for (size_t idx = 0; idx < indices.size(); ++idx)
+		{
+			result[idx] = remap[indices[idx]];
+		}
+
+		if (result.size() <= target_index_count)
+		{
+			return result;
+		}
+
+		size_t vertex_count = vertices.size();
+		auto position = [&vertices](size_t v) { return vertices[v].position.xyz; };
+
+		// area weighted face quadrics
+		std::vector<Quadric> quadrics(vertex_count);
+		for (size_t idx = 0; idx + 2 < result.size(); idx += 3)
+		{
+			tinymath::vec3f p0 = position(result[idx]);
+			tinymath::vec3f normal = tinymath::cross(position(result[idx + 1]) - p0, position(result[idx + 2]) - p0);
+			float length = tinymath::magnitude(normal);
+			if (length < EPSILON)
+			{
+				continue;
+			}
+
+			normal = normal / length;
+			Quadric q(normal.x, normal.y, normal.z, -tinymath::dot(normal, p0), length * 0.5f);
+			quadrics[result[idx]] += q;
+			quadrics[result[idx + 1]] += q;
+			quadrics[result[idx + 2]] += q;
+		}
+
+		// open and non-manifold edges keep their vertices, this also pins uv and normal seams
+		std::vector<bool> locked(vertex_count, false);
+		{
+			std::vector<std::pair<size_t, size_t>> edges;
+			edges.reserve(result.size());
+			for (size_t idx = 0; idx + 2 < result.size(); idx += 3)
+			{
+				for (size_t e = 0; e < 3; ++e)
+				{
+					size_t a = result[idx + e];
+					size_t b = result[idx + (e + 1) % 3];
+					edges.emplace_back(std::min(a, b), std::max(a, b));
+				}
+			}
+			std::sort(edges.begin(), edges.end());
+
+			for (size_t begin = 0; begin < edges.size();)
+			{
+				size_t end = begin + 1;
+				while (end < edges.size() && edges[end] == edges[begin])
+				{
+					++end;
+				}
+
+				if (end - begin != 2)
+				{
+					locked[edges[begin].first] = true;
+					locked[edges[begin].second] = true;
+				}
+				begin = end;
+			}
+		}
+
+		std::vector<size_t> offsets(vertex_count + 1);
+		std::vector<size_t> adjacency;
+		std::vector<Collapse> collapses;
+		std::vector<bool> touched(vertex_count);
+		std::vector<size_t> collapse_remap(vertex_count);
+
+		for (size_t pass = 0; pass < kMaxSimplifyPasses && result.size() > target_index_count; ++pass)
+		{
+			// triangles around each vertex
+			std::fill(offsets.begin(), offsets.end(), 0);
+			for (size_t v : result)
+			{
+				offsets[v + 1]++;
+			}
+			for (size_t v = 0; v < vertex_count; ++v)
+			{
+				offsets[v + 1] += offsets[v];
+			}
+			adjacency.resize(result.size());
+			{
+				std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+				for (size_t idx = 0; idx < result.size(); ++idx)
+				{
+					adjacency[cursor[result[idx]]++] = idx / 3;
+				}
+			}
+
+			collapses.clear();
+			for (size_t idx = 0; idx + 2 < result.size(); idx += 3)
+			{
+				for (size_t e = 0; e < 3; ++e)
+				{
+					size_t a = result[idx + e];
+					size_t b = result[idx + (e + 1) % 3];
+					for (int dir = 0; dir < 2; ++dir)
+					{
+						size_t from = dir == 0 ? a : b;
+						size_t to = dir == 0 ? b : a;
+						if (locked[from])
+						{
+							continue;
+						}
+
+						Quadric q = quadrics[from];
+						q += quadrics[to];
+						collapses.push_back({ from, to, (float)tinymath::max(q.evaluate(position(to)), 0.0) });
+					}
+				}
+			}
+
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs)
+			{
+				return lhs.cost < rhs.cost;
+			});
+
+			// independent collapses only, a vertex whose triangles changed this pass waits for the next one
+			std::fill(touched.begin(), touched.end(), false);
+			for (size_t v = 0; v < vertex_count; ++v)
+			{
+				collapse_remap[v] = v;
+			}
+
+			size_t triangles_to_remove = (result.size() - target_index_count + 2) / 3;
+			size_t removed = 0;
+			for (auto& collapse : collapses)
+			{
+				if (removed >= triangles_to_remove)
+				{
+					break;
+				}
+
+				if (touched[collapse.from] || touched[collapse.to])
+				{
+					continue;
+				}
+
+				// moving the vertex must not fold any of the remaining triangles over
+				bool flipped = false;
+				size_t collapsed_triangles = 0;
+				tinymath::vec3f target = position(collapse.to);
+				for (size_t i = offsets[collapse.from]; i < offsets[collapse.from + 1] && !flipped; ++i)
+				{
+					const size_t* tri = result.data() + adjacency[i] * 3;
+					if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to)
+					{
+						collapsed_triangles++;
+						continue;
+					}
+
+					tinymath::vec3f p[3] = { position(tri[0]), position(tri[1]), position(tri[2]) };
+					tinymath::vec3f before = tinymath::cross(p[1] - p[0], p[2] - p[0]);
+					for (size_t k = 0; k < 3; ++k)
+					{
+						if (tri[k] == collapse.from)
+						{
+							p[k] = target;
+						}
+					}
+					tinymath::vec3f after = tinymath::cross(p[1] - p[0], p[2] - p[0]);
+					flipped = tinymath::dot(before, after) <= 0.0f;
+				}
+
+				if (flipped || collapsed_triangles == 0)
+				{
+					continue;
+				}
+
+				collapse_remap[collapse.from] = collapse.to;
+				quadrics[collapse.to] += quadrics[collapse.from];
+				error = tinymath::max(error, collapse.cost);
+				removed += collapsed_triangles;
+
+				for (size_t i = offsets[collapse.from]; i < offsets[collapse.from + 1]; ++i)
+				{
+					const size_t* tri = result.data() + adjacency[i] * 3;
+					touched[tri[0]] = true;
+					touched[tri[1]] = true;
+					touched[tri[2]] = true;
+				}
+			}
+
+			if (removed == 0)
+			{
+				break;
+			}
+
+			size_t write = 0;
+			for (size_t idx = 0; idx + 2 < result.size(); idx += 3)
+			{
+				size_t a = collapse_remap[result[idx]];
+				size_t b = collapse_remap[result[idx + 1]];
+				size_t c = collapse_remap[result[idx + 2]];
+				if (a == b || b == c || a == c)
+				{
+					continue;
+				}
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+			result.resize(write);
+		}
+
+		return result;
+	}
+}
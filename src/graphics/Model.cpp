@@ -7,11 +7,17 @@
 #include "Utility.hpp"
 #include "Logger.hpp"
 #include "Mesh.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshCache.hpp"
 #include "Material.hpp"
 #include "Transform.hpp"
+#include "KeyedMutex.hpp"
 
 namespace CpuRasterizer
 {
+	// metas sharing a raw model are loaded in parallel, only one of them imports and writes the cache
+	static KeyedMutex cache_file_mutex;
+
 	Model::Model()
 	{
 		transform = std::make_unique<Transform>();
@@ -19,6 +25,7 @@ namespace CpuRasterizer
 		raw_path = "";
 		meta_path = "";
 		flip_uv = false;
+		occluder = false;
 	}
 
 	Model::Model(const std::vector<Vertex>& vertices, const std::vector<size_t>& indices, std::shared_ptr<Material> _material) : Model()
@@ -26,6 +33,7 @@ namespace CpuRasterizer
 		assert(vertices.size() != 0 && indices.size() != 0);
 		assert(indices.size() % 3 == 0);
 		meshes.emplace_back(Mesh(vertices, indices));
+		compute_bounds();
 		if (_material == nullptr)
 		{
 			material = std::make_shared<Material>();
@@ -46,6 +54,10 @@ namespace CpuRasterizer
 		this->raw_path = other.raw_path;
 		this->meta_path = other.meta_path;
 		this->flip_uv = other.flip_uv;
+		this->bounds = other.bounds;
+		this->bounding_sphere = other.bounding_sphere;
+		this->occluder = other.occluder;
+		this->occluder_mesh = other.occluder_mesh;
 	}
 
 	Model::~Model()
@@ -60,6 +72,10 @@ namespace CpuRasterizer
 		this->raw_path = other.raw_path;
 		this->meta_path = other.meta_path;
 		this->flip_uv = other.flip_uv;
+		this->bounds = other.bounds;
+		this->bounding_sphere = other.bounding_sphere;
+		this->occluder = other.occluder;
+		this->occluder_mesh = other.occluder_mesh;
 		return *this;
 	}
 
@@ -71,6 +87,13 @@ namespace CpuRasterizer
 	void Model::load_raw(std::string path, bool flip)
 	{
 		std::string abs_path = RES_PATH + path;
+		std::lock_guard<std::mutex> cache_lock(cache_file_mutex.get(cache_path(path, flip)));
+		if (load_cache(path, flip))
+		{
+			LOG("load model cache: {}, mesh count: {}, lod count: {}, geometry bytes: {}", abs_path, meshes.size(), lod_count(), byte_size());
+			return;
+		}
+
 		Assimp::Importer importer;
 		auto flag = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace;
 		if (flip)
@@ -90,8 +113,39 @@ namespace CpuRasterizer
 		flip_uv = flip;
 		meshes.clear();
 		reload_mesh(Scene->mRootNode, Scene);
-		LOG("load model: {}, mesh count: {}", abs_path, meshes.size());
+		compute_bounds();
+		generate_lods();
+		LOG("load model: {}, mesh count: {}, lod count: {}, geometry bytes: {}", abs_path, meshes.size(), lod_count(), byte_size());
 		importer.FreeScene();
+		MeshCache::save(cache_path(path, flip), meshes);
+	}
+
+	std::string Model::cache_path(const std::string& path, bool flip)
+	{
+		return CACHE_PATH + path + (flip ? ".flip.mesh" : ".mesh");
+	}
+
+	bool Model::load_cache(const std::string& path, bool flip)
+	{
+		std::string cache_file = cache_path(path, flip);
+		if (!is_cache_current(RES_PATH + path, cache_file))
+		{
+			return false;
+		}
+
+		std::vector<Mesh> cached;
+		if (!MeshCache::load(cache_file, cached))
+		{
+			WARN("mesh cache is outdated or invalid, reimporting: {}", cache_file);
+			return false;
+		}
+
+		raw_path = path;
+		material = std::make_shared<Material>();
+		flip_uv = flip;
+		meshes = std::move(cached);
+		compute_bounds();
+		return true;
 	}
 
 	const Transform* Model::get_transform() const 
@@ -102,6 +156,58 @@ namespace CpuRasterizer
 	void Model::set_transform(Transform* _transform)
 	{
 		transform.reset();  transform = std::unique_ptr<Transform>(_transform); transform->set_model(this);
+		transform->set_local_bounds(bounds, bounding_sphere);
+	}
+
+	void Model::compute_bounds()
+	{
+		bounds = tinymath::AxisAlignedBoundingBox();
+		bounding_sphere = tinymath::Sphere();
+		if (meshes.size() != 0)
+		{
+			bounds = meshes[0].bounds;
+			for (auto& mesh : meshes)
+			{
+				bounds.expand(mesh.bounds);
+			}
+
+			float radius = 0.0f;
+			for (auto& mesh : meshes)
+			{
+				radius = tinymath::max(radius, tinymath::magnitude(mesh.bounding_sphere.center - bounds.center) + mesh.bounding_sphere.radius);
+			}
+			bounding_sphere = tinymath::Sphere(bounds.center, radius);
+		}
+
+		transform->set_local_bounds(bounds, bounding_sphere);
+	}
+
+	void Model::generate_lods()
+	{
+		for (auto& mesh : meshes)
+		{
+			mesh.generate_lods(kMaxLODCount);
+		}
+	}
+
+	size_t Model::byte_size() const
+	{
+		size_t size = 0;
+		for (auto& mesh : meshes)
+		{
+			size += mesh.byte_size();
+		}
+		return size;
+	}
+
+	size_t Model::lod_count() const
+	{
+		size_t count = 1;
+		for (auto& mesh : meshes)
+		{
+			count = tinymath::max(count, mesh.lod_count());
+		}
+		return count;
 	}
 
 	void Model::reload_mesh(aiNode* node, const aiScene* Scene)
@@ -159,7 +265,11 @@ namespace CpuRasterizer
 				Vertex.bitangent = vector;
 			}
 			else
+			{
 				Vertex.uv = tinymath::vec2f(0.0f, 0.0f);
+				Vertex.tangent = tinymath::kVec3fZero;
+				Vertex.bitangent = tinymath::kVec3fZero;
+			}
 
 			Vertex.color = Vertex.tangent;
 			vertices.emplace_back(Vertex);
@@ -172,6 +282,7 @@ namespace CpuRasterizer
 				indices.emplace_back(face.mIndices[j]);
 		}
 
+		MeshOptimizer::optimize(vertices, indices);
 		meshes.emplace_back(Mesh(vertices, indices));
 	}
 }
\ No newline at end of file
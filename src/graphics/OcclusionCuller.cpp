@@ -0,0 +1,218 @@
+#include "OcclusionCuller.hpp"
+#include <cfloat>
+#include "Mesh.hpp"
+
+// sse2 is part of every x64 target, other targets take the scalar loops
+#if defined(_M_X64) || defined(__SSE2__)
+#define OCCLUSION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace CpuRasterizer
+{
+	constexpr float kOccluderMinW = 1e-4f; // triangles and boxes reaching behind this w are treated as unknown
+
+	// one row of a triangle, e and z are the values at the first pixel and a and dzdx their steps per pixel
+	static void write_depth_span(float* row, int span, float e0, float e1, float e2, float a0, float a1, float a2, float z, float dzdx)
+	{
+		int i = 0;
+#ifdef OCCLUSION_SSE2
+		// four pixels per step, the lanes evaluate exactly what the scalar tail does
+		const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+		const __m128 zero = _mm_setzero_ps();
+		for (; i + 4 <= span; i += 4)
+		{
+			__m128 fi = _mm_add_ps(_mm_set1_ps((float)i), lane);
+			__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_set1_ps(e0), _mm_mul_ps(_mm_set1_ps(a0), fi)), zero);
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_set1_ps(e1), _mm_mul_ps(_mm_set1_ps(a1), fi)), zero));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_set1_ps(e2), _mm_mul_ps(_mm_set1_ps(a2), fi)), zero));
+
+			__m128 pixel_z = _mm_add_ps(_mm_set1_ps(z), _mm_mul_ps(_mm_set1_ps(dzdx), fi));
+			__m128 dst = _mm_loadu_ps(row + i);
+			__m128 closer = _mm_and_ps(inside, _mm_cmplt_ps(pixel_z, dst));
+			_mm_storeu_ps(row + i, _mm_or_ps(_mm_and_ps(closer, pixel_z), _mm_andnot_ps(closer, dst)));
+		}
+#endif
+		for (; i < span; ++i)
+		{
+			float fi = (float)i;
+			bool inside = (e0 + a0 * fi) >= 0.0f && (e1 + a1 * fi) >= 0.0f && (e2 + a2 * fi) >= 0.0f;
+			float pixel_z = z + dzdx * fi;
+			float& dst = row[i];
+			dst = inside && pixel_z < dst ? pixel_z : dst;
+		}
+	}
+
+	// true when any depth in the span is at or behind min_z
+	static bool any_depth_behind(const float* row, int span, float min_z)
+	{
+		int i = 0;
+#ifdef OCCLUSION_SSE2
+		const __m128 z = _mm_set1_ps(min_z);
+		for (; i + 4 <= span; i += 4)
+		{
+			if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + i), z)) != 0)
+			{
+				return true;
+			}
+		}
+#endif
+		for (; i < span; ++i)
+		{
+			if (row[i] >= min_z)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	OcclusionCuller::OcclusionCuller() : OcclusionCuller(kOcclusionBufferWidth, kOcclusionBufferWidth / 2)
+	{}
+
+	OcclusionCuller::OcclusionCuller(size_t width, size_t height) : width(0), height(0), view_projection(tinymath::kMat4x4Identity)
+	{
+		resize(width, height);
+	}
+
+	void OcclusionCuller::resize(size_t w, size_t h)
+	{
+		width = tinymath::max(w, (size_t)1);
+		height = tinymath::max(h, (size_t)1);
+		depth.assign(width * height, FLT_MAX);
+	}
+
+	void OcclusionCuller::begin(const tinymath::mat4x4& vp)
+	{
+		view_projection = vp;
+		std::fill(depth.begin(), depth.end(), FLT_MAX);
+	}
+
+	tinymath::vec3f OcclusionCuller::to_screen(const tinymath::vec4f& clip) const
+	{
+		float inv_w = 1.0f / clip.w;
+		return tinymath::vec3f((clip.x * inv_w * 0.5f + 0.5f) * (float)width, (clip.y * inv_w * 0.5f + 0.5f) * (float)height, clip.z * inv_w);
+	}
+
+	void OcclusionCuller::rasterize_occluder(const Mesh& mesh, const tinymath::mat4x4& model)
+	{
+		tinymath::mat4x4 mvp = view_projection * model;
+		std::vector<tinymath::vec4f> clip(mesh.vertices.size());
+		for (size_t idx = 0; idx < mesh.vertices.size(); ++idx)
+		{
+			tinymath::vec3f pos = mesh.vertices.position(idx);
+			clip[idx] = mvp * tinymath::vec4f(pos.x, pos.y, pos.z, 1.0f);
+		}
+
+		for (size_t idx = 0; idx + 2 < mesh.indices.size(); idx += 3)
+		{
+			rasterize_triangle(clip[mesh.indices[idx]], clip[mesh.indices[idx + 1]], clip[mesh.indices[idx + 2]]);
+		}
+	}
+
+	// depth only, every row is one span written four pixels at a time
+	void OcclusionCuller::rasterize_triangle(const tinymath::vec4f& c0, const tinymath::vec4f& c1, const tinymath::vec4f& c2)
+	{
+		// no near clipping, dropping an occluder only makes the culling less effective
+		if (c0.w < kOccluderMinW || c1.w < kOccluderMinW || c2.w < kOccluderMinW)
+		{
+			return;
+		}
+
+		tinymath::vec3f v0 = to_screen(c0);
+		tinymath::vec3f v1 = to_screen(c1);
+		tinymath::vec3f v2 = to_screen(c2);
+
+		float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+		if (tinymath::abs(area) < EPSILON)
+		{
+			return;
+		}
+
+		// both windings are accepted, occluders are solid from either side
+		if (area < 0.0f)
+		{
+			std::swap(v1, v2);
+			area = -area;
+		}
+
+		int min_x = tinymath::max((int)tinymath::floor(tinymath::min(v0.x, tinymath::min(v1.x, v2.x))), 0);
+		int max_x = tinymath::min((int)tinymath::ceil(tinymath::max(v0.x, tinymath::max(v1.x, v2.x))), (int)width);
+		int min_y = tinymath::max((int)tinymath::floor(tinymath::min(v0.y, tinymath::min(v1.y, v2.y))), 0);
+		int max_y = tinymath::min((int)tinymath::ceil(tinymath::max(v0.y, tinymath::max(v1.y, v2.y))), (int)height);
+		if (min_x >= max_x || min_y >= max_y)
+		{
+			return;
+		}
+
+		// edge functions a * x + b * y + c, positive inside
+		float a0 = v1.y - v2.y, b0 = v2.x - v1.x, k0 = v1.x * v2.y - v1.y * v2.x;
+		float a1 = v2.y - v0.y, b1 = v0.x - v2.x, k1 = v2.x * v0.y - v2.y * v0.x;
+		float a2 = v0.y - v1.y, b2 = v1.x - v0.x, k2 = v0.x * v1.y - v0.y * v1.x;
+
+		// coverage is sampled at the pixel center, requiring full coverage would leave a seam along every edge the
+		// triangles of one mesh share. pixels on a silhouette may be partly open, is_occluded grows its rect to cover that
+		// depth plane, moved to the farthest corner of each pixel
+		float inv_area = 1.0f / area;
+		float dzdx = (a0 * v0.z + a1 * v1.z + a2 * v2.z) * inv_area;
+		float dzdy = (b0 * v0.z + b1 * v1.z + b2 * v2.z) * inv_area;
+		float z_far_offset = 0.5f * (tinymath::abs(dzdx) + tinymath::abs(dzdy));
+
+		for (int y = min_y; y < max_y; ++y)
+		{
+			float py = (float)y + 0.5f;
+			float px = (float)min_x + 0.5f;
+			float e0 = a0 * px + b0 * py + k0;
+			float e1 = a1 * px + b1 * py + k1;
+			float e2 = a2 * px + b2 * py + k2;
+			float z = v0.z + dzdx * (px - v0.x) + dzdy * (py - v0.y) + z_far_offset;
+			write_depth_span(depth.data() + (size_t)y * width + min_x, max_x - min_x, e0, e1, e2, a0, a1, a2, z, dzdx);
+		}
+	}
+
+	bool OcclusionCuller::is_occluded(const tinymath::AxisAlignedBoundingBox& world_bounds) const
+	{
+		tinymath::vec3f bmin = world_bounds.min();
+		tinymath::vec3f bmax = world_bounds.max();
+
+		float min_x = FLT_MAX, min_y = FLT_MAX, max_x = -FLT_MAX, max_y = -FLT_MAX;
+		float min_z = FLT_MAX;
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			tinymath::vec4f p((corner & 1) ? bmax.x : bmin.x, (corner & 2) ? bmax.y : bmin.y, (corner & 4) ? bmax.z : bmin.z, 1.0f);
+			tinymath::vec4f clip = view_projection * p;
+
+			// the box reaches the camera plane
+			if (clip.w < kOccluderMinW)
+			{
+				return false;
+			}
+
+			tinymath::vec3f screen = to_screen(clip);
+			min_x = tinymath::min(min_x, screen.x);
+			max_x = tinymath::max(max_x, screen.x);
+			min_y = tinymath::min(min_y, screen.y);
+			max_y = tinymath::max(max_y, screen.y);
+			min_z = tinymath::min(min_z, screen.z);
+		}
+
+		// every pixel the box touches and their neighbours have to be hidden
+		int x0 = tinymath::max((int)tinymath::floor(min_x) - 1, 0);
+		int x1 = tinymath::min((int)tinymath::ceil(max_x) + 1, (int)width);
+		int y0 = tinymath::max((int)tinymath::floor(min_y) - 1, 0);
+		int y1 = tinymath::min((int)tinymath::ceil(max_y) + 1, (int)height);
+		if (x0 >= x1 || y0 >= y1)
+		{
+			return false;
+		}
+
+		for (int y = y0; y < y1; ++y)
+		{
+			if (any_depth_behind(depth.data() + (size_t)y * width + x0, x1 - x0, min_z))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
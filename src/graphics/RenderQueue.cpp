@@ -0,0 +1,114 @@
+#include "RenderQueue.hpp"
+#include <algorithm>
+#include "Renderer.hpp"
+#include "Model.hpp"
+#include "Material.hpp"
+#include "Transform.hpp"
+
+namespace CpuRasterizer
+{
+	constexpr uint64_t kDepthBits = 24;
+	constexpr uint64_t kShaderBits = 12;
+	constexpr uint64_t kMaterialBits = 11;
+	constexpr uint64_t kQueueShift = 48;
+	constexpr uint64_t kPassShift = 47;
+
+	RenderQueue::RenderQueue(bool transparent) : transparent(transparent)
+	{}
+
+	const std::vector<uint32_t>& RenderQueue::sort(const std::vector<Renderer*>& renderers, const tinymath::mat4x4& view, float z_near, float z_far)
+	{
+		keys.resize(renderers.size());
+		for (size_t idx = 0; idx < renderers.size(); ++idx)
+		{
+			auto& model = renderers[idx]->target;
+			auto& material = model->material;
+
+			// tinymath is left handed, view space looks down +z
+			tinymath::vec3f pos = model->transform->world_position();
+			tinymath::vec4f view_pos = view * tinymath::vec4f(pos.x, pos.y, pos.z, 1.0f);
+			keys[idx] = make_key(material->render_queue, transparent, (uint64_t)material->target_shader_id, (uint64_t)material->get_id(), view_pos.z, z_near, z_far);
+		}
+
+		// static scenes and a still camera keep the previous order
+		if (keys != sorted_keys)
+		{
+			radix_sort();
+			sorted_keys = keys;
+		}
+
+		return order;
+	}
+
+	uint64_t RenderQueue::make_key(int32_t render_queue, bool transparent, uint64_t shader_id, uint64_t material_id, float view_depth, float z_near, float z_far)
+	{
+		uint64_t queue = (uint64_t)(tinymath::clamp(render_queue, (int32_t)INT16_MIN, (int32_t)INT16_MAX) - INT16_MIN);
+		uint64_t shader = shader_id & ((1ull << kShaderBits) - 1);
+		uint64_t material = material_id & ((1ull << kMaterialBits) - 1);
+
+		float range = tinymath::max(z_far - z_near, EPSILON);
+		float normalized_depth = tinymath::clamp((view_depth - z_near) / range, 0.0f, 1.0f);
+		uint64_t depth_max = (1ull << kDepthBits) - 1;
+		uint64_t depth = (uint64_t)(normalized_depth * (float)depth_max);
+
+		uint64_t key = (queue << kQueueShift) | ((uint64_t)transparent << kPassShift);
+		if (transparent)
+		{
+			// far draws first
+			key |= (depth_max - depth) << (kShaderBits + kMaterialBits);
+			key |= (shader << kMaterialBits) | material;
+		}
+		else
+		{
+			// batched by shader and material, near draws first inside a batch for early-z
+			key |= (shader << (kMaterialBits + kDepthBits)) | (material << kDepthBits);
+			key |= depth;
+		}
+		return key;
+	}
+
+	// lsd radix sort on bytes, stable so equal keys keep the order the renderers were added in
+	void RenderQueue::radix_sort()
+	{
+		size_t count = keys.size();
+		key_scratch.resize(count);
+		order_scratch.resize(count);
+		order.resize(count);
+		for (size_t idx = 0; idx < count; ++idx)
+		{
+			order[idx] = (uint32_t)idx;
+		}
+
+		// the key buffers are members so repeated sorts reuse their storage
+		sort_keys.assign(keys.begin(), keys.end());
+		for (uint32_t shift = 0; shift < 64; shift += 8)
+		{
+			size_t histogram[257] = { 0 };
+			for (size_t idx = 0; idx < count; ++idx)
+			{
+				histogram[((sort_keys[idx] >> shift) & 0xFF) + 1]++;
+			}
+
+			// all keys share this byte
+			if (std::any_of(histogram + 1, histogram + 257, [count](size_t bucket) { return bucket == count; }))
+			{
+				continue;
+			}
+
+			for (size_t bucket = 1; bucket < 257; ++bucket)
+			{
+				histogram[bucket] += histogram[bucket - 1];
+			}
+
+			for (size_t idx = 0; idx < count; ++idx)
+			{
+				size_t dst = histogram[(sort_keys[idx] >> shift) & 0xFF]++;
+				key_scratch[dst] = sort_keys[idx];
+				order_scratch[dst] = order[idx];
+			}
+
+			sort_keys.swap(key_scratch);
+			order.swap(order_scratch);
+		}
+	}
+}
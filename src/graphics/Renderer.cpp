@@ -8,10 +8,11 @@
 #include "Transform.hpp"
 #include "Mesh.hpp"
 #include "CGL.h"
+#include "Clipper.hpp"
 
 namespace CpuRasterizer
 {
-	Renderer::Renderer() : gizmos(true)
+	Renderer::Renderer() : bvh_proxy(-1), lod(0), gizmos(true)
 	{}
 
 	Renderer::Renderer(std::shared_ptr<Model> model) : Renderer()
@@ -20,7 +21,7 @@ namespace CpuRasterizer
 		upload_mesh();
 	}
 
-	Renderer::Renderer(const Renderer& other)
+	Renderer::Renderer(const Renderer& other) : bvh_proxy(-1), lod(0), gizmos(true)
 	{
 		copy(other);
 	}
@@ -34,9 +35,12 @@ namespace CpuRasterizer
 				cglFreeVertexBuffer(vid);
 			}
 
-			for (auto& iid : index_buffer_ids)
+			for (auto& lod_ids : index_buffer_ids)
 			{
-				cglFreeIndexBuffer(iid);
+				for (auto& iid : lod_ids)
+				{
+					cglFreeIndexBuffer(iid);
+				}
 			}
 		}
 	}
@@ -47,18 +51,16 @@ namespace CpuRasterizer
 		{
 			for (auto& mesh : target->meshes)
 			{
-				// check indices
-				for (int idx = 0; idx < mesh.indices.size(); ++idx)
+				auto vid = cglBindPackedVertexBuffer(mesh.vertices);
+				vertex_buffer_ids.emplace_back(vid);
+
+				// every level indexes the same vertex buffer
+				std::vector<size_t> lod_ids;
+				for (size_t lod = 0; lod < mesh.lod_count(); ++lod)
 				{
-					if (mesh.indices[idx] < 0 || mesh.indices[idx] >= mesh.vertices.size())
-					{
-						mesh.indices[idx] = 0;
-					}
+					lod_ids.emplace_back(cglBindPackedIndexBuffer(mesh.lod_indices(lod)));
 				}
-				auto vid = cglBindVertexBuffer(mesh.vertices);
-				auto iid = cglBindIndexBuffer(mesh.indices);
-				vertex_buffer_ids.emplace_back(vid);
-				index_buffer_ids.emplace_back(iid);
+				index_buffer_ids.emplace_back(lod_ids);
 			}
 		}
 	}
@@ -97,6 +99,93 @@ namespace CpuRasterizer
 		return target->transform->world_trs;
 	}
 
+	// true when the world bounds of the model lie outside the frustum
+	bool Renderer::frustum_culling(const tinymath::Frustum& frustum) const
+	{
+		auto& transform = *target->transform;
+		return Clipper::frustum_culling_sphere(frustum, transform.world_sphere) || Clipper::frustum_culling_aabb(frustum, transform.world_bounds);
+	}
+
+	// nearest hit against the mesh triangles, the ray is taken into model space
+	bool Renderer::raycast(const tinymath::Ray& ray, float& distance) const
+	{
+		tinymath::mat4x4 inv_m = tinymath::inverse(model_matrix());
+		tinymath::vec4f origin = inv_m * tinymath::vec4f(ray.origin.x, ray.origin.y, ray.origin.z, 1.0f);
+		tinymath::vec4f direction = inv_m * tinymath::vec4f(ray.direction.x, ray.direction.y, ray.direction.z, 0.0f);
+		tinymath::vec3f o = origin.xyz;
+		tinymath::vec3f d = direction.xyz;
+
+		// the direction keeps its model space length, so t is still a world space distance
+		bool hit = false;
+		for (auto& mesh : target->meshes)
+		{
+			for (size_t idx = 0; idx + 2 < mesh.indices.size(); idx += 3)
+			{
+				tinymath::vec3f v0 = mesh.vertices.position(mesh.indices[idx]);
+				tinymath::vec3f e1 = mesh.vertices.position(mesh.indices[idx + 1]) - v0;
+				tinymath::vec3f e2 = mesh.vertices.position(mesh.indices[idx + 2]) - v0;
+				tinymath::vec3f p = tinymath::cross(d, e2);
+				float det = tinymath::dot(e1, p);
+				if (tinymath::abs(det) < EPSILON)
+				{
+					continue;
+				}
+
+				float inv_det = 1.0f / det;
+				tinymath::vec3f s = o - v0;
+				float u = tinymath::dot(s, p) * inv_det;
+				if (u < 0.0f || u > 1.0f)
+				{
+					continue;
+				}
+
+				tinymath::vec3f q = tinymath::cross(s, e1);
+				float v = tinymath::dot(d, q) * inv_det;
+				if (v < 0.0f || u + v > 1.0f)
+				{
+					continue;
+				}
+
+				float t = tinymath::dot(e2, q) * inv_det;
+				if (t > 0.0f && (!hit || t < distance))
+				{
+					distance = t;
+					hit = true;
+				}
+			}
+		}
+		return hit;
+	}
+
+	// picks the level from the projected size of the world bounding sphere, as a fraction of the screen height
+	void Renderer::update_lod(const tinymath::vec3f& camera_pos, float projection_scale)
+	{
+		size_t count = target->lod_count();
+		auto& sphere = target->transform->world_sphere;
+		float distance = tinymath::magnitude(sphere.center - camera_pos);
+		if (count <= 1 || distance <= sphere.radius)
+		{
+			lod = 0;
+			return;
+		}
+
+		auto threshold = [](size_t level)
+		{
+			return kLODScreenSize / (float)(1 << (level - 1));
+		};
+
+		float screen_size = sphere.radius * projection_scale / distance;
+		lod = tinymath::min(lod, count - 1);
+		while (lod + 1 < count && screen_size < threshold(lod + 1) * (1.0f - kLODHysteresis))
+		{
+			++lod;
+		}
+		while (lod > 0 && screen_size > threshold(lod) * (1.0f + kLODHysteresis))
+		{
+			--lod;
+		}
+	}
+
 	void Renderer::render_shadow() const
 	{
 		render_internal(RenderPass::kShadow);
@@ -128,9 +217,16 @@ namespace CpuRasterizer
 
 		target->material->use(render_pass);
 
+		// the shadow pass can go coarser than the camera
+		size_t level = lod;
+		if (render_pass == RenderPass::kShadow)
+		{
+			level += CpuRasterSharedData.shadow_lod_bias;
+		}
+
 		for(size_t i = 0; i < index_buffer_ids.size(); ++i)
 		{
-			auto iid = index_buffer_ids[i];
+			auto iid = index_buffer_ids[i][tinymath::min(level, index_buffer_ids[i].size() - 1)];
 			auto vid = vertex_buffer_ids[i];
 			cglUseVertexBuffer(vid);
 			cglUseIndexBuffer(iid);
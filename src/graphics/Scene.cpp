@@ -1,6 +1,8 @@
 #include "Scene.hpp"
 #include <filesystem>
 #include <iostream>
+#include <future>
+#include <algorithm>
 #include "Marcos.h"
 #include "Singleton.hpp"
 #include "GlobalShaderParams.hpp"
@@ -17,9 +19,13 @@
 #include "Transform.hpp"
 #include "Model.hpp"
 #include "CubeMap.hpp"
+#include "RenderQueue.hpp"
+#include "BVH.hpp"
+#include "OcclusionCuller.hpp"
 #include "Pipeline.hpp"
 #include "CGL.h"
 #include "GraphicsDevice.hpp"
+#include "TextureStreamer.hpp"
 
 #define CAMERA_ROTATE_SPEED 0.25f
 #define CAMERA_MOVE_SPEED 0.2f
@@ -44,6 +50,11 @@ namespace CpuRasterizer
 		main_light->ambient = tinymath::Color(0.1f, 0.05f, 0.2f, 1.0f);
 		main_light->specular = tinymath::Color(1.0f, 1.0f, 1.0f, 1.0f);
 		skybox = std::make_unique<SkyboxRenderer>();
+		opaque_queue = std::make_unique<RenderQueue>(false);
+		transparent_queue = std::make_unique<RenderQueue>(true);
+		opaque_bvh = std::make_unique<BVH>();
+		transparent_bvh = std::make_unique<BVH>();
+		occlusion_culler = std::make_unique<OcclusionCuller>();
 	}
 
 	Scene::Scene(std::string name) : Scene()
@@ -130,8 +141,52 @@ namespace CpuRasterizer
 		}
 	}
 
+	void Scene::add(const std::string& path, Transform* transform)
+	{
+		PendingModel pending;
+		pending.path = path;
+		pending.model = CpuRasterAssetLoader.load_model(path);
+		pending.transform = std::unique_ptr<Transform>(transform);
+		pending_models.emplace_back(std::move(pending));
+	}
+
+	void Scene::add_loaded_assets()
+	{
+		for (auto it = pending_models.begin(); it != pending_models.end();)
+		{
+			if (!is_ready(it->model))
+			{
+				++it;
+				continue;
+			}
+
+			std::shared_ptr<Model> model = it->model.get();
+			if (model != nullptr)
+			{
+				model->set_transform(it->transform.release());
+				add(model);
+			}
+			it = pending_models.erase(it);
+		}
+
+		if (is_ready(pending_cubemap))
+		{
+			cubemap = pending_cubemap.get();
+			pending_cubemap = AssetHandle<CubeMap>();
+			pending_cubemap_path = "";
+			if (cubemap != nullptr && this == current())
+			{
+				ShaderPropertyMap::global_shader_properties.set_cubemap(cubemap_prop, cubemap);
+			}
+		}
+	}
+
 	void Scene::update()
 	{
+		// nothing samples until render, so streamed levels and loaded assets can be swapped in here
+		CpuRasterTextureStreamer.update();
+		CpuRasterAssetLoader.update();
+		add_loaded_assets();
 		CpuRasterSharedData.cam_far = main_cam->frustum_param.perspective_param.far;
 		CpuRasterSharedData.cam_near = main_cam->frustum_param.perspective_param.near;
 		CpuRasterSharedData.view_matrix = main_cam->view_matrix();
@@ -184,6 +239,10 @@ namespace CpuRasterizer
 				if (remove_idx != -1)
 				{
 					LOG("remove: {}", objects[remove_idx]->target->name);
+					if (objects[remove_idx]->bvh_proxy != kNullProxy)
+					{
+						opaque_bvh->remove(objects[remove_idx]->bvh_proxy);
+					}
 					objects.erase(objects.begin() + remove_idx);
 					remove_idx = -1;
 				}
@@ -201,6 +260,10 @@ namespace CpuRasterizer
 				if (remove_idx != -1)
 				{
 					LOG("remove: {}", transparent_objects[remove_idx]->target->name);
+					if (transparent_objects[remove_idx]->bvh_proxy != kNullProxy)
+					{
+						transparent_bvh->remove(transparent_objects[remove_idx]->bvh_proxy);
+					}
 					transparent_objects.erase(transparent_objects.begin() + remove_idx);
 					remove_idx = -1;
 				}
@@ -222,6 +285,12 @@ namespace CpuRasterizer
 	void Scene::render()
 	{
 		cglClearBuffer(cglFrameContent::kColor | cglFrameContent::kDepth | cglFrameContent::kStencil | cglFrameContent::kCoverage);
+
+		update_bvh();
+		frustum_culling();
+		occlusion_culling();
+		select_lods();
+
 		if (CpuRasterSharedData.enable_shadow)
 		{
 			auto prev_enable_msaa = CpuRasterDevice.is_flag_enabled(PipelineFeature::kMSAA);
@@ -251,9 +320,9 @@ namespace CpuRasterizer
 			return;
 		}
 
-		for (auto& obj : objects)
+		for (auto caster : visible_shadow_casters)
 		{
-			obj->render_shadow();
+			caster->render_shadow();
 		}
 	}
 
@@ -269,26 +338,194 @@ namespace CpuRasterizer
 			skybox->render();
 		}
 
-		// sort by render queue
-		std::sort(objects.begin(), objects.end(), [](const std::shared_ptr<Renderer>& lhs, const std::shared_ptr<Renderer>& rhs) {
-			if (lhs->target->material->render_queue < rhs->target->material->render_queue)
-				return true;
+		// sort by render queue, then material batches front to back
+		auto& view = CpuRasterSharedData.view_matrix;
+		float z_near = CpuRasterSharedData.cam_near;
+		float z_far = CpuRasterSharedData.cam_far;
+		for (auto idx : opaque_queue->sort(visible_objects, view, z_near, z_far))
+		{
+			visible_objects[idx]->render();
+		}
+
+		// with oit the transparent objects are sorted per pixel while the tiles are rasterized
+		if (CpuRasterSharedData.enable_oit)
+		{
+			cglEnable(cglPipelineFeature::kOIT);
+		}
+
+		for (auto idx : transparent_queue->sort(visible_transparent_objects, view, z_near, z_far))
+		{
+			visible_transparent_objects[idx]->render();
+		}
+
+		cglDisable(cglPipelineFeature::kOIT);
+	}
+
+	// new renderers are inserted and moved ones refit, renderers that did not move cost one flag check
+	void Scene::update_bvh()
+	{
+		auto sync = [](BVH& bvh, std::vector<std::shared_ptr<Renderer>>& renderers)
+		{
+			for (auto& renderer : renderers)
+			{
+				Transform& transform = *renderer->target->transform;
+				if (renderer->bvh_proxy == kNullProxy)
+				{
+					renderer->bvh_proxy = bvh.insert(renderer.get(), transform.world_bounds);
+				}
+				else if (transform.world_bounds_dirty)
+				{
+					bvh.move(renderer->bvh_proxy, transform.world_bounds);
+				}
+				transform.world_bounds_dirty = false;
+			}
+		};
+
+		sync(*opaque_bvh, objects);
+		sync(*transparent_bvh, transparent_objects);
+	}
+
+	// gathers the renderers of both passes, the light query runs next to the camera queries
+	void Scene::frustum_culling()
+	{
+		tinymath::Frustum camera_frustum = tinymath::Frustum::create(CpuRasterSharedData.proj_matrix * CpuRasterSharedData.view_matrix);
+		tinymath::Frustum light_frustum = tinymath::Frustum::create(CpuRasterSharedData.main_light.projection_matrix() * CpuRasterSharedData.main_light.view_matrix());
+
+		visible_shadow_casters.clear();
+		std::future<void> shadow_query;
+		if (CpuRasterSharedData.enable_shadow)
+		{
+			shadow_query = std::async(std::launch::async, [this, &light_frustum]()
+			{
+				opaque_bvh->query(light_frustum, visible_shadow_casters);
+			});
+		}
+
+		visible_objects.clear();
+		visible_transparent_objects.clear();
+		opaque_bvh->query(camera_frustum, visible_objects);
+		transparent_bvh->query(camera_frustum, visible_transparent_objects);
+
+		if (shadow_query.valid())
+		{
+			shadow_query.wait();
+		}
+
+		auto& statistics = CpuRasterDevice.statistics;
+		statistics.culled_renderer_count = objects.size() + transparent_objects.size() - visible_objects.size() - visible_transparent_objects.size();
+		statistics.culled_shadow_caster_count = CpuRasterSharedData.enable_shadow ? objects.size() - visible_shadow_casters.size() : 0;
+	}
+
+	// rasterizes the visible occluders, then drops every visible renderer hidden behind them
+	// shadow casters are kept, the light does not see what the camera sees
+	void Scene::occlusion_culling()
+	{
+		auto& statistics = CpuRasterDevice.statistics;
+		statistics.occluded_renderer_count = 0;
+		if (!CpuRasterSharedData.enable_occlusion_culling)
+		{
+			return;
+		}
+
+		size_t screen_width = tinymath::max(CpuRasterSharedData.width, (size_t)1);
+		size_t buffer_height = tinymath::max(kOcclusionBufferWidth * CpuRasterSharedData.height / screen_width, (size_t)1);
+		if (occlusion_culler->get_width() != kOcclusionBufferWidth || occlusion_culler->get_height() != buffer_height)
+		{
+			occlusion_culler->resize(kOcclusionBufferWidth, buffer_height);
+		}
+
+		occlusion_culler->begin(CpuRasterSharedData.proj_matrix * CpuRasterSharedData.view_matrix);
+
+		bool has_occluder = false;
+		for (auto renderer : visible_objects)
+		{
+			const Model& model = *renderer->target;
+			if (!model.occluder)
+			{
+				continue;
+			}
+
+			has_occluder = true;
+			tinymath::mat4x4 m = renderer->model_matrix();
+			if (model.occluder_mesh != nullptr)
+			{
+				occlusion_culler->rasterize_occluder(*model.occluder_mesh, m);
+			}
 			else
-				return false;
-		});
+			{
+				for (auto& mesh : model.meshes)
+				{
+					occlusion_culler->rasterize_occluder(mesh, m);
+				}
+			}
+		}
 
-		for (auto& obj : objects)
+		if (!has_occluder)
 		{
-			obj->render();
+			return;
 		}
 
-		// todo: OIT
-		for (auto& obj : transparent_objects)
+		// occluders are never tested, they would hide themselves
+		auto occluded = [this](Renderer* renderer)
+		{
+			return !renderer->target->occluder && occlusion_culler->is_occluded(renderer->target->transform->world_bounds);
+		};
+
+		size_t visible_count = visible_objects.size() + visible_transparent_objects.size();
+		visible_objects.erase(std::remove_if(visible_objects.begin(), visible_objects.end(), occluded), visible_objects.end());
+		visible_transparent_objects.erase(std::remove_if(visible_transparent_objects.begin(), visible_transparent_objects.end(), occluded), visible_transparent_objects.end());
+		statistics.occluded_renderer_count = visible_count - visible_objects.size() - visible_transparent_objects.size();
+	}
+
+	// levels follow the camera in both passes, shadow casters the camera cannot see still get one
+	void Scene::select_lods()
+	{
+		auto& camera_pos = CpuRasterSharedData.camera_pos;
+		float projection_scale = CpuRasterSharedData.proj_matrix.at(1, 1);
+		for (auto renderers : { &visible_objects, &visible_transparent_objects, &visible_shadow_casters })
 		{
-			obj->render();
+			for (auto renderer : *renderers)
+			{
+				renderer->update_lod(camera_pos, projection_scale);
+			}
 		}
 	}
 
+	// nearest renderer hit by the ray, candidates are tested in the order the ray enters their boxes
+	Renderer* Scene::pick(const tinymath::Ray& ray, float& distance)
+	{
+		update_bvh();
+
+		std::vector<std::pair<float, Renderer*>> candidates;
+		opaque_bvh->query(ray, candidates);
+		transparent_bvh->query(ray, candidates);
+		std::sort(candidates.begin(), candidates.end(), [](const std::pair<float, Renderer*>& lhs, const std::pair<float, Renderer*>& rhs) { return lhs.first < rhs.first; });
+
+		Renderer* ret = nullptr;
+		for (auto& candidate : candidates)
+		{
+			if (ret != nullptr && candidate.first > distance)
+			{
+				break;
+			}
+
+			float t;
+			if (candidate.second->raycast(ray, t) && (ret == nullptr || t < distance))
+			{
+				distance = t;
+				ret = candidate.second;
+			}
+		}
+		return ret;
+	}
+
+	void Scene::query(const tinymath::AxisAlignedBoundingBox& box, std::vector<Renderer*>& out)
+	{
+		update_bvh();
+		opaque_bvh->query(box, out);
+		transparent_bvh->query(box, out);
+	}
+
 	void Scene::draw_gizmos()
 	{
 		for (auto& obj : objects)
@@ -376,11 +613,8 @@ namespace CpuRasterizer
 
 	void Scene::set_cubemap(std::string path)
 	{
-		cubemap = std::shared_ptr<CubeMap>(new CubeMap(path.c_str()));
-		if (cubemap != nullptr && this == current())
-		{
-			ShaderPropertyMap::global_shader_properties.set_cubemap(cubemap_prop, cubemap);
-		}
+		pending_cubemap = CpuRasterAssetLoader.load_cubemap(path);
+		pending_cubemap_path = path;
 	}
 
 	void Scene::open_scene(const char* path)
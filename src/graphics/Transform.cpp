@@ -14,6 +14,7 @@ namespace CpuRasterizer
 		local_scale = tinymath::kVec3fOne;
 		world_trs = tinymath::kMat4x4Identity;
 		selected = false;
+		world_bounds_dirty = true;
 	}
 
 	Transform::Transform(const Transform& other)
@@ -26,6 +27,8 @@ namespace CpuRasterizer
 		rotation_angle = other.rotation_angle;
 		world_trs = other.world_trs;
 		selected = other.selected;
+		world_bounds_dirty = true;
+		set_local_bounds(other.local_bounds, other.local_sphere);
 	}
 
 	tinymath::vec3f Transform::forward() const
@@ -106,6 +109,7 @@ namespace CpuRasterizer
 	void Transform::lookat(const tinymath::vec3f& target)
 	{
 		this->world_trs = tinymath::lookat(this->world_position(), target, tinymath::kVec3fUp);
+		update_world_bounds();
 	}
 
 	void Transform::set_parent(Transform* p)
@@ -242,6 +246,7 @@ namespace CpuRasterizer
 		auto tr = tinymath::lookat(pos, pos + forward, up);
 		auto s = tinymath::scale(world_scale());
 		this->world_trs = tr * s;
+		update_world_bounds();
 	}
 
 	void Transform::sync()
@@ -250,11 +255,40 @@ namespace CpuRasterizer
 		auto r = tinymath::from_euler(world_euler_angles());
 		auto s = tinymath::scale(world_scale());
 		this->world_trs = t * r * s;
+		update_world_bounds();
+	}
+
+	void Transform::set_local_bounds(const tinymath::AxisAlignedBoundingBox& bounds, const tinymath::Sphere& sphere)
+	{
+		local_bounds = bounds;
+		local_sphere = sphere;
+		update_world_bounds();
+	}
+
+	void Transform::update_world_bounds()
+	{
+		tinymath::vec4f center = world_trs * tinymath::vec4f(local_bounds.center.x, local_bounds.center.y, local_bounds.center.z, 1.0f);
+		auto extent = [this](size_t r) {
+			return tinymath::abs(world_trs.at(r, 0)) * local_bounds.extents.x + tinymath::abs(world_trs.at(r, 1)) * local_bounds.extents.y + tinymath::abs(world_trs.at(r, 2)) * local_bounds.extents.z;
+		};
+		world_bounds.center = center.xyz;
+		world_bounds.extents = tinymath::vec3f(extent(0), extent(1), extent(2));
+
+		// the radius grows with the largest axis scale
+		float scale = 0.0f;
+		for (size_t c = 0; c < 3; ++c)
+		{
+			scale = tinymath::max(scale, tinymath::magnitude(tinymath::vec3f(world_trs.at(0, c), world_trs.at(1, c), world_trs.at(2, c))));
+		}
+		tinymath::vec4f sphere_center = world_trs * tinymath::vec4f(local_sphere.center.x, local_sphere.center.y, local_sphere.center.z, 1.0f);
+		world_sphere = tinymath::Sphere(sphere_center.xyz, local_sphere.radius * scale);
+		world_bounds_dirty = true;
 	}
 
 	Transform& Transform::operator=(const Transform& other)
 	{
 		this->world_trs = other.world_trs;
+		update_world_bounds();
 		return *this;
 	}
 }
\ No newline at end of file
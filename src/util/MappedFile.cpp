@@ -0,0 +1,104 @@
+#include "MappedFile.hpp"
+#if (defined(WIN32) || defined(_WIN32))
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if (defined(WIN32) || defined(_WIN32))
+MappedFile::MappedFile() : view(nullptr), length(0), writable(false), file_handle(INVALID_HANDLE_VALUE), mapping_handle(nullptr)
+{}
+
+MappedFile::~MappedFile()
+{
+	if (view != nullptr)
+	{
+		UnmapViewOfFile(view);
+	}
+	if (mapping_handle != nullptr)
+	{
+		CloseHandle(mapping_handle);
+	}
+	if (file_handle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file_handle);
+	}
+}
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path, bool copy_on_write)
+{
+	std::shared_ptr<MappedFile> file(new MappedFile());
+	file->file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file->file_handle == INVALID_HANDLE_VALUE)
+	{
+		return nullptr;
+	}
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file->file_handle, &file_size) || file_size.QuadPart == 0)
+	{
+		return nullptr;
+	}
+
+	file->mapping_handle = CreateFileMappingA(file->file_handle, nullptr, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+	if (file->mapping_handle == nullptr)
+	{
+		return nullptr;
+	}
+
+	file->view = (uint8_t*)MapViewOfFile(file->mapping_handle, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+	if (file->view == nullptr)
+	{
+		return nullptr;
+	}
+
+	file->length = (size_t)file_size.QuadPart;
+	file->writable = copy_on_write;
+	return file;
+}
+#else
+MappedFile::MappedFile() : view(nullptr), length(0), writable(false)
+{}
+
+MappedFile::~MappedFile()
+{
+	if (view != nullptr)
+	{
+		munmap(view, length);
+	}
+}
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path, bool copy_on_write)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return nullptr;
+	}
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)
+	{
+		close(fd);
+		return nullptr;
+	}
+
+	// the mapping stays valid after the descriptor is closed
+	void* mapped = mmap(nullptr, (size_t)file_stat.st_size, copy_on_write ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED)
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<MappedFile> file(new MappedFile());
+	file->view = (uint8_t*)mapped;
+	file->length = (size_t)file_stat.st_size;
+	file->writable = copy_on_write;
+	return file;
+}
+#endif